@@ -252,6 +252,11 @@ static eFrameProcessingResult_t prvAllowIPPacket( const IPPacket_t * const pxIPP
 /* The queue used to pass events into the IP-task for processing. */
 QueueHandle_t xNetworkEventQueue = NULL;
 
+/* Events taken from xNetworkEventQueue by the IP-task in one go, the events
+from uxEventBatchNext up to uxEventBatchCount are still to be processed. */
+static IPStackEvent_t xEventBatch[ ipconfigEVENT_BATCH_LENGTH ];
+static UBaseType_t uxEventBatchCount = 0u, uxEventBatchNext = 0u;
+
 /*_RB_ Requires comment. */
 uint16_t usPacketIdentifier = 0U;
 
@@ -359,9 +364,28 @@ struct freertos_sockaddr xAddress;
 
 		/* Wait until there is something to do.  The event is initialised to "no
 		event" in case the following call exits due to a time out rather than a
-		message being received. */
+		message being received.  All events that are waiting are taken under
+		one critical section, up to ipconfigEVENT_BATCH_LENGTH, and processed
+		one per loop so that the timers are still checked in between. */
 		xReceivedEvent.eEventType = eNoEvent;
-		xQueueReceive( xNetworkEventQueue, ( void * ) &xReceivedEvent, xNextIPSleep );
+
+		if( uxEventBatchNext == uxEventBatchCount )
+		{
+			uxEventBatchNext = 0u;
+			uxEventBatchCount = ( UBaseType_t ) xQueueReceiveMultiple( xNetworkEventQueue, ( void * ) xEventBatch, ( UBaseType_t ) ipconfigEVENT_BATCH_LENGTH, xNextIPSleep );
+		}
+
+		if( uxEventBatchNext < uxEventBatchCount )
+		{
+			xReceivedEvent = xEventBatch[ uxEventBatchNext ];
+			uxEventBatchNext++;
+
+			#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+			{
+				iptraceEVENT_LATENCY( xReceivedEvent.eEventType, ipconfigEVENT_TIMESTAMP() - xReceivedEvent.ullSentAt );
+			}
+			#endif
+		}
 
 		#if( ipconfigCHECK_IP_QUEUE_SPACE != 0 )
 		{
@@ -389,10 +413,13 @@ struct freertos_sockaddr xAddress;
 				break;
 
 			case eNetworkRxEvent:
-				/* The network hardware driver has received a new packet.  A
-				pointer to the received buffer is located in the pvData member
-				of the received event structure. */
-				prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				{
+					/* The network hardware driver has received a new packet.  A
+					pointer to the received buffer is located in the pvData member
+					of the received event structure. */
+					iptracePROBE_SCOPE( IP_PACKET );
+					prvHandleEthernetPacket( ( NetworkBufferDescriptor_t * ) ( xReceivedEvent.pvData ) );
+				}
 				break;
 
 			case eARPTimerEvent :
@@ -666,7 +693,7 @@ static void prvCheckNetworkTimers( void )
 	BaseType_t xCheckTCPSockets;
 	extern uint32_t ulNextInitialSequenceNumber;
 
-		if( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u )
+		if( ( uxQueueMessagesWaiting( xNetworkEventQueue ) == 0u ) && ( uxEventBatchNext == uxEventBatchCount ) )
 		{
 			xWillSleep = pdTRUE;
 		}
@@ -788,9 +815,19 @@ const TickType_t xDontBlock = ( TickType_t ) 0;
 
 BaseType_t FreeRTOS_NetworkDownFromISR( void )
 {
-static const IPStackEvent_t xNetworkDownEvent = { eNetworkDownEvent, NULL };
+#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+	IPStackEvent_t xNetworkDownEvent = { eNetworkDownEvent, NULL };
+#else
+	static const IPStackEvent_t xNetworkDownEvent = { eNetworkDownEvent, NULL };
+#endif
 BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
+	#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+	{
+		xNetworkDownEvent.ullSentAt = ipconfigEVENT_TIMESTAMP();
+	}
+	#endif
+
 	/* Simply send the network task the appropriate event. */
 	if( xQueueSendToBackFromISR( xNetworkEventQueue, &xNetworkDownEvent, &xHigherPriorityTaskWoken ) != pdPASS )
 	{
@@ -1169,6 +1206,9 @@ const TickType_t xDontBlock = ( TickType_t ) 0;
 BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout )
 {
 BaseType_t xReturn, xSendMessage;
+#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+	IPStackEvent_t xStamped;
+#endif
 
 	if( ( xIPIsNetworkTaskReady() == pdFALSE ) && ( pxEvent->eEventType != eNetworkDownEvent ) )
 	{
@@ -1208,6 +1248,15 @@ BaseType_t xReturn, xSendMessage;
 				xTimeout = ( TickType_t ) 0;
 			}
 
+			#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+			{
+				/* The event may be const, the stamp goes on a copy. */
+				xStamped = *pxEvent;
+				xStamped.ullSentAt = ipconfigEVENT_TIMESTAMP();
+				pxEvent = &xStamped;
+			}
+			#endif
+
 			xReturn = xQueueSendToBack( xNetworkEventQueue, pxEvent, xTimeout );
 
 			if( xReturn == pdFAIL )
@@ -1229,6 +1278,74 @@ BaseType_t xReturn, xSendMessage;
 }
 /*-----------------------------------------------------------*/
 
+UBaseType_t uxSendEventStructsToIPTask( const IPStackEvent_t *pxEvents, UBaseType_t uxCount, TickType_t xTimeout )
+{
+UBaseType_t uxSent;
+#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+	IPStackEvent_t xStamped[ ipconfigEVENT_BATCH_LENGTH ];
+	UBaseType_t ux, uxChunk, uxChunkSent;
+	uint64_t ullNow;
+#endif
+
+	if( xIPIsNetworkTaskReady() == pdFALSE )
+	{
+		uxSent = 0u;
+	}
+	else
+	{
+		/* The IP task cannot block itself while waiting for itself to
+		respond. */
+		if( ( xIsCallingFromIPTask() == pdTRUE ) && ( xTimeout > ( TickType_t ) 0 ) )
+		{
+			xTimeout = ( TickType_t ) 0;
+		}
+
+		#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+		{
+			/* The events may be const, the stamps go on copies which are sent
+			ipconfigEVENT_BATCH_LENGTH at a time. */
+			uxSent = 0u;
+			while( uxSent < uxCount )
+			{
+				uxChunk = uxCount - uxSent;
+				if( uxChunk > ( UBaseType_t ) ipconfigEVENT_BATCH_LENGTH )
+				{
+					uxChunk = ( UBaseType_t ) ipconfigEVENT_BATCH_LENGTH;
+				}
+
+				ullNow = ipconfigEVENT_TIMESTAMP();
+				for( ux = 0u; ux < uxChunk; ux++ )
+				{
+					xStamped[ ux ] = pxEvents[ uxSent + ux ];
+					xStamped[ ux ].ullSentAt = ullNow;
+				}
+
+				uxChunkSent = ( UBaseType_t ) xQueueSendMultiple( xNetworkEventQueue, ( const void * ) xStamped, uxChunk, xTimeout );
+				uxSent += uxChunkSent;
+
+				if( uxChunkSent < uxChunk )
+				{
+					break;
+				}
+			}
+		}
+		#else
+		{
+			uxSent = ( UBaseType_t ) xQueueSendMultiple( xNetworkEventQueue, ( const void * ) pxEvents, uxCount, xTimeout );
+		}
+		#endif
+
+		if( uxSent < uxCount )
+		{
+			FreeRTOS_debug_printf( ( "uxSendEventStructsToIPTask: CAN NOT ADD %u events\n", ( unsigned ) ( uxCount - uxSent ) ) );
+			iptraceSTACK_TX_EVENT_LOST( pxEvents[ uxSent ].eEventType );
+		}
+	}
+
+	return uxSent;
+}
+/*-----------------------------------------------------------*/
+
 eFrameProcessingResult_t eConsiderFrameForProcessing( const uint8_t * const pucEthernetBuffer )
 {
 eFrameProcessingResult_t eReturn;
@@ -1908,6 +2025,8 @@ xUnionPtr xSource;		/* Points to first byte */
 xUnionPtr xLastSource;	/* Points to last byte plus one */
 uint32_t ulAlignBits, ulCarry = 0ul;
 
+	iptracePROBE_SCOPE( CHECKSUM );
+
 	/* Small MCUs often spend up to 30% of the time doing checksum calculations
 	This function is optimised for 32-bit CPUs; Each time it will try to fetch
 	32-bits, sums it with an accumulator and counts the number of carries. */
@@ -206,7 +206,7 @@ void vNetworkSocketsInit( void )
 {
 const uint32_t ulAutoPortRange = socketAUTO_PORT_ALLOCATION_MAX_NUMBER - socketAUTO_PORT_ALLOCATION_RESET_NUMBER;
 uint32_t ulRandomPort;
-	FreeRTOS_printf("Prepare the sockets interface \n");
+	FreeRTOS_printf( ( "Prepare the sockets interface \n" ) );
 	vListInitialise( &xBoundUDPSocketsList );
 
 	/* Determine the first anonymous UDP port number to get assigned.  Give it
@@ -3619,6 +3619,11 @@ void vSocketWakeUpUser( FreeRTOS_Socket_t *pxSocket )
 
 		xEvent.eEventType = eSocketSignalEvent;
 		xEvent.pvData = ( void * )pxSocket;
+		#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+		{
+			xEvent.ullSentAt = ipconfigEVENT_TIMESTAMP();
+		}
+		#endif
 
 		/* The IP-task will call FreeRTOS_SignalSocket for this socket. */
 		xReturn = xQueueSendToBackFromISR( xNetworkEventQueue, &xEvent, pxHigherPriorityTaskWoken );
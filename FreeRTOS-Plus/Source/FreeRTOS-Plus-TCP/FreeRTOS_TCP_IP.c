@@ -2735,6 +2735,8 @@ UBaseType_t uxOptionsLength = 0u;
 uint8_t ucTCPFlags = pxTCPHeader->ucTCPFlags;
 TCPWindow_t *pxTCPWindow = &( pxSocket->u.xTCP.xTCPWindow );
 
+	iptracePROBE_SCOPE( TCP_STATE );
+
 	/* First get the length and the position of the received data, if any.
 	pucRecvData will point to the first byte of the TCP payload. */
 	ulReceiveLength = ( uint32_t ) prvCheckRxData( *ppxNetworkBuffer, &pucRecvData );
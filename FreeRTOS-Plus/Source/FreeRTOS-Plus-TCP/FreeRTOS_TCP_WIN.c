@@ -53,6 +53,10 @@
 #include "NetworkBufferManagement.h"
 #include "FreeRTOS_TCP_WIN.h"
 
+#if( ( ipconfigUSE_TCP_WIN == 1 ) && ( ipconfigTCP_WIN_USE_POOL != 0 ) )
+	#include "pool.h"
+#endif
+
 /* Constants used for Smoothed Round Trip Time (SRTT). */
 #define	winSRTT_INCREMENT_NEW 		2
 #define winSRTT_INCREMENT_CURRENT 	6
@@ -207,9 +211,15 @@ extern void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewL
 	static TCPSegment_t *xTCPSegments = NULL;
 #endif /* ipconfigUSE_TCP_WIN == 1 */
 
-/* List of free TCP segments. */
+/* List of free TCP segments, or the pool built on xTCPSegments that holds
+them. */
 #if( ipconfigUSE_TCP_WIN == 1 )
-	static List_t xSegmentList;
+	#if( ipconfigTCP_WIN_USE_POOL == 0 )
+		static List_t xSegmentList;
+	#else
+		static StaticPool_t xSegmentPoolStruct;
+		static PoolHandle_t xSegmentPool = NULL;
+	#endif
 #endif
 
 /* Logging verbosity level. */
@@ -309,7 +319,11 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 		/* Allocate space for 'xTCPSegments' and store them in 'xSegmentList'. */
 
-		vListInitialise( &xSegmentList );
+		#if( ipconfigTCP_WIN_USE_POOL == 0 )
+		{
+			vListInitialise( &xSegmentList );
+		}
+		#endif
 		xTCPSegments = ( TCPSegment_t * ) pvPortMallocLarge( ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
 
 		if( xTCPSegments == NULL )
@@ -324,16 +338,28 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			/* Clear the allocated space. */
 			memset( xTCPSegments, '\0', ipconfigTCP_WIN_SEG_COUNT * sizeof( xTCPSegments[ 0 ] ) );
 
-			for( xIndex = 0; xIndex < ipconfigTCP_WIN_SEG_COUNT; xIndex++ )
+			#if( ipconfigTCP_WIN_USE_POOL == 0 )
 			{
-				/* Could call vListInitialiseItem here but all data has been
-				nulled already.  Set the owner to a segment descriptor. */
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xListItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
-				listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xQueueItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
+				for( xIndex = 0; xIndex < ipconfigTCP_WIN_SEG_COUNT; xIndex++ )
+				{
+					/* Could call vListInitialiseItem here but all data has been
+					nulled already.  Set the owner to a segment descriptor. */
+					listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xListItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
+					listSET_LIST_ITEM_OWNER( &( xTCPSegments[ xIndex ].xQueueItem ), ( void* ) &( xTCPSegments[ xIndex ] ) );
 
-				/* And add it to the pool of available segments */
-				vListInsertFifo( &xSegmentList, &( xTCPSegments[xIndex].xListItem ) );
+					/* And add it to the pool of available segments */
+					vListInsertFifo( &xSegmentList, &( xTCPSegments[xIndex].xListItem ) );
+				}
 			}
+			#else
+			{
+				/* The segments are set up when they are taken from the pool. */
+				( void ) xIndex;
+				xSegmentPool = xPoolCreateStatic( sizeof( xTCPSegments[ 0 ] ), ( UBaseType_t ) ipconfigTCP_WIN_SEG_COUNT,
+												  ( uint8_t * ) xTCPSegments, &xSegmentPoolStruct );
+				configASSERT( xSegmentPool );
+			}
+			#endif /* ipconfigTCP_WIN_USE_POOL */
 
 			xReturn = pdPASS;
 		}
@@ -385,7 +411,27 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 
 		/* Allocate a new segment.  The socket will borrow all segments from a
 		common pool: 'xSegmentList', which is a list of 'TCPSegment_t' */
-		if( listLIST_IS_EMPTY( &xSegmentList ) != pdFALSE )
+		#if( ipconfigTCP_WIN_USE_POOL != 0 )
+		{
+			pxSegment = ( TCPSegment_t * ) pvPoolAlloc( xSegmentPool );
+
+			if( pxSegment != NULL )
+			{
+				/* The pool may have overwritten the segment while it was
+				free. */
+				memset( pxSegment, '\0', sizeof( *pxSegment ) );
+				listSET_LIST_ITEM_OWNER( &( pxSegment->xListItem ), ( void* ) pxSegment );
+				listSET_LIST_ITEM_OWNER( &( pxSegment->xQueueItem ), ( void* ) pxSegment );
+			}
+		}
+		#else
+		{
+			pxSegment = listLIST_IS_EMPTY( &xSegmentList ) ? NULL :
+				( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( listGET_HEAD_ENTRY( &xSegmentList ) );
+		}
+		#endif /* ipconfigTCP_WIN_USE_POOL */
+
+		if( pxSegment == NULL )
 		{
 			/* If the TCP-stack runs out of segments, you might consider
 			increasing 'ipconfigTCP_WIN_SEG_COUNT'. */
@@ -396,14 +442,14 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 		{
 			/* Pop the item at the head of the list.  Semaphore protection is
 			not required as only the IP task will call these functions.  */
-			pxItem = ( ListItem_t * ) listGET_HEAD_ENTRY( &xSegmentList );
-			pxSegment = ( TCPSegment_t * ) listGET_LIST_ITEM_OWNER( pxItem );
-
-			configASSERT( pxItem != NULL );
-			configASSERT( pxSegment != NULL );
+			pxItem = &( pxSegment->xListItem );
 
-			/* Remove the item from xSegmentList. */
-			uxListRemove( pxItem );
+			#if( ipconfigTCP_WIN_USE_POOL == 0 )
+			{
+				/* Remove the item from xSegmentList. */
+				uxListRemove( pxItem );
+			}
+			#endif
 
 			/* Add it to either the connections' Rx or Tx queue. */
 			vListInsertFifo( xIsForRx ? &pxWindow->xRxSegments : &pxWindow->xTxSegments, pxItem );
@@ -419,7 +465,11 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 			#if( ipconfigHAS_DEBUG_PRINTF != 0 )
 			{
 			static UBaseType_t xLowestLength = ipconfigTCP_WIN_SEG_COUNT;
-			UBaseType_t xLength = listCURRENT_LIST_LENGTH( &xSegmentList );
+			#if( ipconfigTCP_WIN_USE_POOL == 0 )
+				UBaseType_t xLength = listCURRENT_LIST_LENGTH( &xSegmentList );
+			#else
+				UBaseType_t xLength = uxPoolGetFreeCount( xSegmentPool );
+			#endif
 
 				if( xLowestLength > xLength )
 				{
@@ -545,7 +595,15 @@ void vListInsertGeneric( List_t * const pxList, ListItem_t * const pxNewListItem
 		}
 
 		/* Return it to xSegmentList */
-		vListInsertFifo( &xSegmentList, &( pxSegment->xListItem ) );
+		#if( ipconfigTCP_WIN_USE_POOL == 0 )
+		{
+			vListInsertFifo( &xSegmentList, &( pxSegment->xListItem ) );
+		}
+		#else
+		{
+			vPoolFree( xSegmentPool, pxSegment );
+		}
+		#endif
 	}
 
 #endif /* ipconfigUSE_TCP_WIN == 1 */
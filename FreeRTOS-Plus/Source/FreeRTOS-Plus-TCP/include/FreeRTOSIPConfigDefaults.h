@@ -302,6 +302,25 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigEVENT_QUEUE_LENGTH		( ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS + 5 )
 #endif
 
+/* The maximum number of events the IP-task takes from the event queue with one
+call to xQueueReceiveMultiple(). */
+#ifndef ipconfigEVENT_BATCH_LENGTH
+	#define ipconfigEVENT_BATCH_LENGTH		8
+#endif
+
+/* Set to 1 to measure how long events wait before the IP-task takes them.  Each
+event is stamped with ipconfigEVENT_TIMESTAMP() when it is sent, and the IP-task
+passes the time waited, in the units of the timestamp, to
+iptraceEVENT_LATENCY().  ipconfigEVENT_TIMESTAMP() must return a free running
+64-bit count and be callable from interrupts. */
+#ifndef ipconfigMEASURE_EVENT_LATENCY
+	#define ipconfigMEASURE_EVENT_LATENCY	0
+#endif
+
+#if( ipconfigMEASURE_EVENT_LATENCY == 1 ) && !defined( ipconfigEVENT_TIMESTAMP )
+	#error ipconfigMEASURE_EVENT_LATENCY needs ipconfigEVENT_TIMESTAMP()
+#endif
+
 #ifndef ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND
 	#define ipconfigALLOW_SOCKET_SEND_WITHOUT_BIND 1
 #endif
@@ -530,6 +549,17 @@ from the FreeRTOSIPConfig.h configuration header file. */
 	#define ipconfigTCP_IP_SANITY 0
 #endif
 
+/* When non-zero, BufferAllocation_1.c keeps the free network buffer
+descriptors, and FreeRTOS_TCP_WIN.c the free TCP segment descriptors, in a
+lock-free fixed-block pool (pool.h) instead of a List_t. */
+#ifndef ipconfigBUFFER_ALLOC_USE_POOL
+	#define ipconfigBUFFER_ALLOC_USE_POOL 0
+#endif
+
+#ifndef ipconfigTCP_WIN_USE_POOL
+	#define ipconfigTCP_WIN_USE_POOL 0
+#endif
+
 #ifndef ipconfigARP_STORES_REMOTE_ADDRESSES
 	#define ipconfigARP_STORES_REMOTE_ADDRESSES 0
 #endif
@@ -263,6 +263,9 @@ typedef struct IP_TASK_COMMANDS
 {
 	eIPEvent_t eEventType;
 	void *pvData;
+	#if( ipconfigMEASURE_EVENT_LATENCY == 1 )
+		uint64_t ullSentAt;	/* ipconfigEVENT_TIMESTAMP() when it was sent. */
+	#endif
 } IPStackEvent_t;
 
 #define ipBROADCAST_IP_ADDRESS 0xffffffffUL
@@ -748,6 +751,15 @@ BaseType_t xSendEventToIPTask( eIPEvent_t eEvent );
  */
 BaseType_t xSendEventStructToIPTask( const IPStackEvent_t *pxEvent, TickType_t xTimeout );
 
+/*
+ * Sends uxCount events to the IP-task with one call to xQueueSendMultiple(),
+ * e.g. the eNetworkRxEvent's of a burst of received frames.  Not for
+ * eNetworkDownEvent and eTCPTimerEvent, which xSendEventStructToIPTask()
+ * treats specially.  Returns the number of events sent, from the start of
+ * pxEvents.
+ */
+UBaseType_t uxSendEventStructsToIPTask( const IPStackEvent_t *pxEvents, UBaseType_t uxCount, TickType_t xTimeout );
+
 /*
  * Returns a pointer to the original NetworkBuffer from a pointer to a UDP
  * payload buffer.
@@ -125,6 +125,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceNETWORK_EVENT_RECEIVED( eEvent )
 #endif
 
+#ifndef iptraceEVENT_LATENCY
+	#define iptraceEVENT_LATENCY( eEvent, ullWaited )
+#endif
+
 #ifndef iptraceBIND_FAILED
 	#define iptraceBIND_FAILED( xSocket, usPort )
 #endif
@@ -193,4 +197,10 @@ http://www.FreeRTOS.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/TCP_IP_Trace.html */
 	#define iptraceSENDTO_DATA_TOO_LONG()
 #endif
 
+#ifndef iptracePROBE_SCOPE
+	/* Measures the rest of the enclosing block, xProbe names what is measured:
+	IP_PACKET, CHECKSUM or TCP_STATE. */
+	#define iptracePROBE_SCOPE( xProbe )
+#endif
+
 #endif /* UDP_TRACE_MACRO_DEFAULTS_H */
@@ -49,12 +49,29 @@
 #include "NetworkInterface.h"
 #include "NetworkBufferManagement.h"
 
+#if( ipconfigBUFFER_ALLOC_USE_POOL != 0 )
+	#include "pool.h"
+
+	#if( ipconfigTCP_IP_SANITY != 0 )
+		#error ipconfigTCP_IP_SANITY needs the list of free buffers, set ipconfigBUFFER_ALLOC_USE_POOL to 0
+	#endif
+#endif
+
 /* For an Ethernet interrupt to be able to obtain a network buffer there must
 be at least this number of buffers available. */
 #define baINTERRUPT_BUFFER_GET_THRESHOLD	( 3 )
 
-/* A list of free (available) NetworkBufferDescriptor_t structures. */
-static List_t xFreeBuffersList;
+#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
+	/* A list of free (available) NetworkBufferDescriptor_t structures. */
+	static List_t xFreeBuffersList;
+#else
+	/* The free NetworkBufferDescriptor_t structures are blocks of a pool built
+	on xNetworkBuffers.  A free block is overwritten by the pool, so the
+	Ethernet buffer of each descriptor is kept here. */
+	static StaticPool_t xNetworkBufferPoolStruct;
+	static PoolHandle_t xNetworkBufferPool = NULL;
+	static uint8_t *pucEthernetBuffers[ ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS ];
+#endif
 
 /* Some statistics about the use of buffers. */
 static UBaseType_t uxMinimumFreeNetworkBuffers = 0u;
@@ -83,6 +100,12 @@ static SemaphoreHandle_t xNetworkBufferSemaphore = NULL;
 
 static void prvShowWarnings( void );
 
+#if( ipconfigBUFFER_ALLOC_USE_POOL != 0 )
+	/* Take a descriptor from the pool and restore the fields the pool
+	overwrote while it was free. */
+	static NetworkBufferDescriptor_t *prvTakeFromPool( void );
+#endif
+
 /* The user can define their own ipconfigBUFFER_ALLOC_LOCK() and
 ipconfigBUFFER_ALLOC_UNLOCK() macros, especially for use form an ISR.  If these
 are not defined then default them to call the normal enter/exit critical
@@ -162,6 +185,27 @@ section macros. */
 
 #endif /* ipconfigTCP_IP_SANITY */
 
+#if( ipconfigBUFFER_ALLOC_USE_POOL != 0 )
+
+	static NetworkBufferDescriptor_t *prvTakeFromPool( void )
+	{
+	NetworkBufferDescriptor_t *pxReturn;
+
+		pxReturn = ( NetworkBufferDescriptor_t * ) pvPoolAlloc( xNetworkBufferPool );
+
+		if( pxReturn != NULL )
+		{
+			vListInitialiseItem( &( pxReturn->xBufferListItem ) );
+			listSET_LIST_ITEM_OWNER( &( pxReturn->xBufferListItem ), pxReturn );
+			pxReturn->pucEthernetBuffer = pucEthernetBuffers[ pxReturn - xNetworkBuffers ];
+		}
+
+		return pxReturn;
+	}
+	/*-----------------------------------------------------------*/
+
+#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
+
 BaseType_t xNetworkBuffersInitialise( void )
 {
 BaseType_t xReturn, x;
@@ -179,21 +223,38 @@ BaseType_t xReturn, x;
 
 		if( xNetworkBufferSemaphore != NULL )
 		{
-			vListInitialise( &xFreeBuffersList );
-
 			/* Initialise all the network buffers.  The buffer storage comes
 			from the network interface, and different hardware has different
 			requirements. */
 			vNetworkInterfaceAllocateRAMToBuffers( xNetworkBuffers );
-			for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+
+			#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
+			{
+				vListInitialise( &xFreeBuffersList );
+
+				for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+				{
+					/* Initialise and set the owner of the buffer list items. */
+					vListInitialiseItem( &( xNetworkBuffers[ x ].xBufferListItem ) );
+					listSET_LIST_ITEM_OWNER( &( xNetworkBuffers[ x ].xBufferListItem ), &xNetworkBuffers[ x ] );
+
+					/* Currently, all buffers are available for use. */
+					vListInsert( &xFreeBuffersList, &( xNetworkBuffers[ x ].xBufferListItem ) );
+				}
+			}
+			#else
 			{
-				/* Initialise and set the owner of the buffer list items. */
-				vListInitialiseItem( &( xNetworkBuffers[ x ].xBufferListItem ) );
-				listSET_LIST_ITEM_OWNER( &( xNetworkBuffers[ x ].xBufferListItem ), &xNetworkBuffers[ x ] );
+				for( x = 0; x < ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS; x++ )
+				{
+					pucEthernetBuffers[ x ] = xNetworkBuffers[ x ].pucEthernetBuffer;
+				}
 
 				/* Currently, all buffers are available for use. */
-				vListInsert( &xFreeBuffersList, &( xNetworkBuffers[ x ].xBufferListItem ) );
+				xNetworkBufferPool = xPoolCreateStatic( sizeof( xNetworkBuffers[ 0 ] ), ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS,
+														( uint8_t * ) xNetworkBuffers, &xNetworkBufferPoolStruct );
+				configASSERT( xNetworkBufferPool );
 			}
+			#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
 
 			uxMinimumFreeNetworkBuffers = ( UBaseType_t ) ipconfigNUM_NETWORK_BUFFER_DESCRIPTORS;
 		}
@@ -228,23 +289,38 @@ UBaseType_t uxCount;
 		available. */
 		if( xSemaphoreTake( xNetworkBufferSemaphore, xBlockTimeTicks ) == pdPASS )
 		{
-			/* Protect the structure as it is accessed from tasks and
-			interrupts. */
-			ipconfigBUFFER_ALLOC_LOCK();
+			#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
 			{
-				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
-
-				if( ( bIsValidNetworkDescriptor( pxReturn ) != pdFALSE_UNSIGNED ) &&
-					listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxReturn->xBufferListItem ) ) )
+				/* Protect the structure as it is accessed from tasks and
+				interrupts. */
+				ipconfigBUFFER_ALLOC_LOCK();
 				{
-					uxListRemove( &( pxReturn->xBufferListItem ) );
+					pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+
+					if( ( bIsValidNetworkDescriptor( pxReturn ) != pdFALSE_UNSIGNED ) &&
+						listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxReturn->xBufferListItem ) ) )
+					{
+						uxListRemove( &( pxReturn->xBufferListItem ) );
+					}
+					else
+					{
+						xInvalid = pdTRUE;
+					}
 				}
-				else
+				ipconfigBUFFER_ALLOC_UNLOCK();
+			}
+			#else
+			{
+				/* The pool needs no lock.  It can not be empty as the
+				semaphore was obtained. */
+				pxReturn = prvTakeFromPool();
+
+				if( pxReturn == NULL )
 				{
 					xInvalid = pdTRUE;
 				}
 			}
-			ipconfigBUFFER_ALLOC_UNLOCK();
+			#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
 
 			if( xInvalid == pdTRUE )
 			{
@@ -260,7 +336,7 @@ UBaseType_t uxCount;
 			else
 			{
 				/* Reading UBaseType_t, no critical section needed. */
-				uxCount = listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+				uxCount = uxGetNumberOfFreeNetworkBuffers();
 
 				/* For stats, latch the lowest number of network buffers since
 				booting. */
@@ -320,13 +396,21 @@ NetworkBufferDescriptor_t *pxReturn = NULL;
 	{
 		if( xSemaphoreTakeFromISR( xNetworkBufferSemaphore, NULL ) == pdPASS )
 		{
-			/* Protect the structure as it is accessed from tasks and interrupts. */
-			ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+			#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
+			{
+				/* Protect the structure as it is accessed from tasks and interrupts. */
+				ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+				{
+					pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
+					uxListRemove( &( pxReturn->xBufferListItem ) );
+				}
+				ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+			}
+			#else
 			{
-				pxReturn = ( NetworkBufferDescriptor_t * ) listGET_OWNER_OF_HEAD_ENTRY( &xFreeBuffersList );
-				uxListRemove( &( pxReturn->xBufferListItem ) );
+				pxReturn = prvTakeFromPool();
 			}
-			ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+			#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
 
 			iptraceNETWORK_BUFFER_OBTAINED_FROM_ISR( pxReturn );
 		}
@@ -347,11 +431,19 @@ BaseType_t xHigherPriorityTaskWoken = pdFALSE;
 
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
-	ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+	#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
+	{
+		ipconfigBUFFER_ALLOC_LOCK_FROM_ISR();
+		{
+			vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		}
+		ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+	}
+	#else
 	{
-		vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+		vPoolFree( xNetworkBufferPool, pxNetworkBuffer );
 	}
-	ipconfigBUFFER_ALLOC_UNLOCK_FROM_ISR();
+	#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
 
 	xSemaphoreGiveFromISR( xNetworkBufferSemaphore, &xHigherPriorityTaskWoken );
 	iptraceNETWORK_BUFFER_RELEASED( pxNetworkBuffer );
@@ -371,18 +463,29 @@ BaseType_t xListItemAlreadyInFreeList;
 	}
 	/* Ensure the buffer is returned to the list of free buffers before the
 	counting semaphore is 'given' to say a buffer is available. */
-	ipconfigBUFFER_ALLOC_LOCK();
+	#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
 	{
+		ipconfigBUFFER_ALLOC_LOCK();
 		{
-			xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
-
-			if( xListItemAlreadyInFreeList == pdFALSE )
 			{
-				vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+				xListItemAlreadyInFreeList = listIS_CONTAINED_WITHIN( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+
+				if( xListItemAlreadyInFreeList == pdFALSE )
+				{
+					vListInsertEnd( &xFreeBuffersList, &( pxNetworkBuffer->xBufferListItem ) );
+				}
 			}
 		}
+		ipconfigBUFFER_ALLOC_UNLOCK();
 	}
-	ipconfigBUFFER_ALLOC_UNLOCK();
+	#else
+	{
+		/* A pool can not tell a double release cheaply, with
+		configUSE_POOL_POISONING set to 1 vPoolFree() asserts on it. */
+		xListItemAlreadyInFreeList = pdFALSE;
+		vPoolFree( xNetworkBufferPool, pxNetworkBuffer );
+	}
+	#endif /* ipconfigBUFFER_ALLOC_USE_POOL */
 
 	if( xListItemAlreadyInFreeList )
 	{
@@ -411,7 +514,15 @@ UBaseType_t uxGetMinimumFreeNetworkBuffers( void )
 
 UBaseType_t uxGetNumberOfFreeNetworkBuffers( void )
 {
-	return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+	#if( ipconfigBUFFER_ALLOC_USE_POOL == 0 )
+	{
+		return listCURRENT_LIST_LENGTH( &xFreeBuffersList );
+	}
+	#else
+	{
+		return uxPoolGetFreeCount( xNetworkBufferPool );
+	}
+	#endif
 }
 
 NetworkBufferDescriptor_t *pxResizeNetworkBufferWithDescriptor( NetworkBufferDescriptor_t * pxNetworkBuffer, size_t xNewSizeBytes )
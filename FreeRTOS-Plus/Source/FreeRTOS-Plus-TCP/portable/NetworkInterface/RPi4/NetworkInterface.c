@@ -36,6 +36,7 @@
 #include "task.h"
 #include "queue.h"
 #include "semphr.h"
+#include "pointer_queue.h"
 
 /* FreeRTOS+TCP includes. */
 #include "FreeRTOS_IP.h"
@@ -89,6 +90,36 @@ typedef volatile u32 reg32;
 	#define PHY_LS_LOW_CHECK_TIME_MS	1000
 #endif
 
+#ifndef	ENC_RX_POLL_TIME_MS
+	// PKTIF is unreliable (errata 6) and a falling edge can be missed, so EPKTCNT
+	// is also checked when no interrupt arrived for this many milliseconds.
+	// Only while the link is up: without it no frame can arrive, and the task
+	// sleeps until the next PHY check so the idle core is not woken.
+	#define ENC_RX_POLL_TIME_MS		10
+#endif
+
+#ifndef	ENC_TX_QUEUE_LENGTH
+	// Number of outgoing frames which can wait while both TX slots of the
+	// ENC28J60 are busy.
+	#define ENC_TX_QUEUE_LENGTH		16
+#endif
+
+#ifndef	ENC_RX_EVENT_BATCH
+	// Number of received frames which are passed to the IP-task with one
+	// call to uxSendEventStructsToIPTask().
+	#define ENC_RX_EVENT_BATCH		8
+#endif
+
+/* Events notified to prvEMACHandlerTask(). */
+#define ENC_EVENT_IRQ			( 1UL << 0 )	/* enc28j60_isr() */
+#define ENC_EVENT_TX			( 1UL << 1 )	/* xNetworkInterfaceOutput() queued a frame */
+
+#ifndef	ENC_TX_QUEUE_WAIT_MS
+	// Maximum time the IP-task waits for room in the TX queue before a frame
+	// is dropped.
+	#define ENC_TX_QUEUE_WAIT_MS	20
+#endif
+
 // The size of each buffer when BufferAllocation_1 is used: http://www.freertos.org/FreeRTOS-Plus/FreeRTOS_Plus_TCP/Embedded_Ethernet_Buffer_Management.html
 #define niBUFFER_1_PACKET_SIZE		1536
 /*
@@ -120,6 +151,22 @@ static BaseType_t prvGMACWaitLS( TickType_t xMaxTime );
  */
 static void prvEMACHandlerTask( void *pvParameters );
 
+/*
+ * Called from enc28j60_isr() to wake up prvEMACHandlerTask.
+ */
+static void prvENCInterruptCallback( void );
+
+/*
+ * Read all frames pending in the ENC28J60 RX FIFO and pass them to the IP-task.
+ */
+static BaseType_t xNetworkInterfaceInput( void );
+
+/*
+ * Move queued frames into the free TX slots of the ENC28J60.  Only called by
+ * prvEMACHandlerTask().
+ */
+static void prvENCSendQueued( void );
+
 /*-----------------------------------------------------------*/
 
 /* EMAC data/descriptions. */
@@ -146,6 +193,13 @@ handle is used so direct notifications can be sent to the task for all EMAC/DMA
 related interrupts. */
 TaskHandle_t enc28j60TaskHandle = NULL;
 
+/* Network buffers waiting to be written to the ENC28J60, in the order they
+were passed to xNetworkInterfaceOutput().  Only the descriptor pointers are
+queued, the frames are not copied.  prvEMACHandlerTask() is the only receiver,
+it is also the only task which accesses the controller after initialisation,
+so the IP-task never waits for the SPI bus. */
+static PointerQueueHandle_t xTxQueue = NULL;
+
 
 /*-----------------------------------------------------------*/
 
@@ -157,8 +211,13 @@ const TickType_t xWaitLinkDelay = pdMS_TO_TICKS( 7000UL ), xWaitRelinkDelay = pd
 	/* Guard against the init function being called more than once. */
 	if( enc28j60TaskHandle == NULL )
 	{
+		/* The controller is started with its interrupt pin not connected yet,
+		prvEMACHandlerTask() connects it once it runs. */
 		init_network();
 		networkHandle = encspi_getHandle(); // Get pointer to the shared instance	
+		xTxQueue = xPointerQueueCreate( ENC_TX_QUEUE_LENGTH );
+		configASSERT( xTxQueue != NULL );
+		encspi_set_irq_callback( prvENCInterruptCallback );
 		/* The deferred interrupt networkHandler task is created at the highest
 		possible priority to ensure the interrupt networkHandler can return directly
 		to it.  The task's networkHandle is stored in enc28j60TaskHandle so interrupts can
@@ -179,42 +238,195 @@ const TickType_t xWaitLinkDelay = pdMS_TO_TICKS( 7000UL ), xWaitRelinkDelay = pd
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xNetworkInterfaceInput()
+static void prvENCInterruptCallback( void )
 {
-	while (!ENC_GetReceivedFrame(encspi_getHandle()));
-	return 1;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	if( enc28j60TaskHandle != NULL )
+	{
+		xTaskNotifyFromISR( enc28j60TaskHandle, ENC_EVENT_IRQ, eSetBits, &xHigherPriorityTaskWoken );
+	}
+
+	portYIELD_FROM_ISR( xHigherPriorityTaskWoken );
 }
 /*-----------------------------------------------------------*/
 
-BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxBuffer, BaseType_t bReleaseAfterSend )
+static BaseType_t prvPassFramesToIPTask( IPStackEvent_t *pxEvents, UBaseType_t uxCount )
 {
-	if( ( ulPHYLinkStatus & PHSTAT2_LSTAT ) != 0 )
+UBaseType_t uxSent, ux;
+
+	uxSent = uxSendEventStructsToIPTask( pxEvents, uxCount, ( TickType_t ) 0 );
+
+	for( ux = 0; ux < uxCount; ux++ )
 	{
-		iptraceNETWORK_INTERFACE_TRANSMIT();
-		// Fill enc28j60-struct
-		#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		if( ux < uxSent )
 		{
-			/* This driver wants to own all network buffers which are to be transmitted. */
-			configASSERT( iReleaseAfterSend != pdFALSE );
+			iptraceNETWORK_INTERFACE_RECEIVE();
 		}
-		#endif
+		else
+		{
+			/* The IP-task queue is full. */
+			iptraceETHERNET_RX_EVENT_LOST();
+			vReleaseNetworkBufferAndDescriptor( ( NetworkBufferDescriptor_t * ) pxEvents[ ux ].pvData );
+		}
+	}
 
-		//handle-> = pxBuffer->ulIPAddress;
+	return ( BaseType_t ) uxSent;
+}
+/*-----------------------------------------------------------*/
 
-		// Send the packet
-		/*
-		if (ENC_RestoreTXBuffer(&handle, sizeof(ARP)) == 0) {
-			FreeRTOS_printf("Sending Ethernet-package.\n");
-			
-		*/	
-			ENC_WriteBuffer(pxBuffer, sizeof(NetworkBufferDescriptor_t));
-			networkHandle->transmitLength = sizeof(NetworkBufferDescriptor_t);
+static BaseType_t xNetworkInterfaceInput( void )
+{
+NetworkBufferDescriptor_t *pxBuffer = NULL;
+IPStackEvent_t xRxEvents[ ENC_RX_EVENT_BATCH ];
+UBaseType_t uxPending = 0;
+BaseType_t xCount = 0;
+
+	/* Drain the RX FIFO: EPKTCNT is read again after every batch, so frames
+	which arrive while the previous ones are copied are handled in the same
+	wake-up. */
+	for( ENC_GetPkcnt( networkHandle ); networkHandle->pktCnt != 0; ENC_GetPkcnt( networkHandle ) )
+	{
+		while( networkHandle->pktCnt-- != 0 )
+		{
+			if( pxBuffer == NULL )
+			{
+				pxBuffer = pxGetNetworkBufferWithDescriptor( ipTOTAL_ETHERNET_FRAME_SIZE, ( TickType_t ) 0 );
+			}
+
+			if( pxBuffer == NULL )
+			{
+				/* No buffer available: the frame is read into the driver's own
+				buffer and dropped, otherwise the FIFO would overflow. */
+				ENC_GetReceivedFrame( networkHandle );
+				iptraceETHERNET_RX_EVENT_LOST();
+				FreeRTOS_debug_printf( ( "xNetworkInterfaceInput: no network buffer, frame dropped\n" ) );
+				continue;
+			}
 
-			ENC_Transmit(&networkHandle);
-		// }
+			if( ENC_GetReceivedFrameBuf( networkHandle, pxBuffer->pucEthernetBuffer ) == false )
+			{
+				/* Bad CRC or length, the buffer can be used for the next frame. */
+				continue;
+			}
 
+			if( eConsiderFrameForProcessing( pxBuffer->pucEthernetBuffer ) != eProcessBuffer )
+			{
+				continue;
+			}
 
-		//emacps_send_message( &xEMACpsif, pxBuffer, bReleaseAfterSend );
+			pxBuffer->xDataLength = networkHandle->RxFrameInfos.length;
+			xRxEvents[ uxPending ].eEventType = eNetworkRxEvent;
+			xRxEvents[ uxPending ].pvData = ( void * ) pxBuffer;
+			uxPending++;
+			pxBuffer = NULL;
+
+			if( uxPending == ENC_RX_EVENT_BATCH )
+			{
+				xCount += prvPassFramesToIPTask( xRxEvents, uxPending );
+				uxPending = 0;
+			}
+		}
+
+		/* The frames of one EPKTCNT batch go to the IP-task together, under
+		one critical section of the event queue. */
+		if( uxPending != 0 )
+		{
+			xCount += prvPassFramesToIPTask( xRxEvents, uxPending );
+			uxPending = 0;
+		}
+	}
+
+	if( pxBuffer != NULL )
+	{
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+
+	return xCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvENCSendQueued( void )
+{
+NetworkBufferDescriptor_t *pxBuffer;
+int8_t cResult;
+
+	while( ( pxBuffer = ( NetworkBufferDescriptor_t * ) pvPointerQueuePeek( xTxQueue ) ) != NULL )
+	{
+		cResult = ENC_RestoreTXBuffer( networkHandle, ( uint16_t ) pxBuffer->xDataLength );
+
+		if( cResult == ERR_TIMEOUT )
+		{
+			/* Both slots are busy, the TX completion interrupt wakes up
+			prvEMACHandlerTask() again. */
+			break;
+		}
+
+		( void ) xPointerQueueReceive( xTxQueue, ( void ** ) &pxBuffer, ( TickType_t ) 0 );
+
+		if( cResult == ERR_OK )
+		{
+			/* The frame is streamed from the network buffer straight into the
+			controller's buffer memory (WBM), there is no intermediate copy. */
+			ENC_WriteBuffer( pxBuffer->pucEthernetBuffer, ( uint16_t ) pxBuffer->xDataLength );
+			networkHandle->transmitLength = ( uint16_t ) pxBuffer->xDataLength;
+			ENC_Transmit( networkHandle );
+			iptraceNETWORK_INTERFACE_TRANSMIT();
+		}
+		else
+		{
+			FreeRTOS_debug_printf( ( "prvENCSendQueued: frame of %u bytes too long\n", ( unsigned ) pxBuffer->xDataLength ) );
+		}
+
+		/* Once the frame is in the ENC28J60 SRAM the network buffer is not
+		needed any more: a retransmission (errata 12/13/15) uses the copy in
+		the controller. */
+		vReleaseNetworkBufferAndDescriptor( pxBuffer );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxDescriptor, BaseType_t bReleaseAfterSend )
+{
+NetworkBufferDescriptor_t *pxBuffer = pxDescriptor;
+BaseType_t xReturn = pdFALSE;
+
+	if( ( ulPHYLinkStatus & PHSTAT2_LSTAT ) != 0 )
+	{
+		#if( ipconfigZERO_COPY_TX_DRIVER != 0 )
+		{
+			/* This driver wants to own all network buffers which are to be transmitted. */
+			configASSERT( bReleaseAfterSend != pdFALSE );
+		}
+		#else
+		{
+			if( bReleaseAfterSend == pdFALSE )
+			{
+				/* The caller keeps its buffer, so a copy has to wait in the TX
+				queue. */
+				pxBuffer = pxDuplicateNetworkBufferWithDescriptor( pxDescriptor, pxDescriptor->xDataLength );
+				bReleaseAfterSend = pdTRUE;
+			}
+		}
+		#endif
+
+		/* From here on the driver owns pxBuffer, it is released by
+		prvENCSendQueued() after it was written to the controller.  The IP-task
+		only queues the frame, the SPI transfers are done by
+		prvEMACHandlerTask(). */
+		if( pxBuffer != NULL )
+		{
+			if( xPointerQueueSend( xTxQueue, pxBuffer, pdMS_TO_TICKS( ENC_TX_QUEUE_WAIT_MS ) ) == pdPASS )
+			{
+				xTaskNotify( enc28j60TaskHandle, ENC_EVENT_TX, eSetBits );
+				xReturn = pdTRUE;
+			}
+			else
+			{
+				FreeRTOS_debug_printf( ( "xNetworkInterfaceOutput: TX queue full, frame dropped\n" ) );
+				vReleaseNetworkBufferAndDescriptor( pxBuffer );
+			}
+		}
 	}
 	else if( bReleaseAfterSend != pdFALSE )
 	{
@@ -222,7 +434,7 @@ BaseType_t xNetworkInterfaceOutput( NetworkBufferDescriptor_t * const pxBuffer,
 		vReleaseNetworkBufferAndDescriptor( pxBuffer );
 	}
 
-	return pdTRUE;
+	return xReturn;
 }
 /*-----------------------------------------------------------*/
 /*
@@ -308,7 +520,9 @@ UBaseType_t uxLastMinBufferCount = 0;
 UBaseType_t uxCurrentCount;
 BaseType_t xResult = 0;
 BaseType_t bStatus;
-const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
+uint32_t ulEvents;
+TickType_t xBlockTime;
+const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( ENC_RX_POLL_TIME_MS );
 
 	/* Remove compiler warnings about unused parameters. */
 	( void ) pvParameters;
@@ -320,6 +534,11 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 	vTaskSetTimeOutState( &xPhyTime );
 	xPhyRemTime = pdMS_TO_TICKS( PHY_LS_LOW_CHECK_TIME_MS );
 
+	/* Connect the interrupt pin only now that enc28j60TaskHandle and the
+	callback are set, so no falling edge is dropped.  Events which arrived
+	during the initialisation assert INT when INTIE is set. */
+	encspi_enable_irq();
+
 	for( ;; )
 	{
 		uxCurrentCount = uxGetMinimumFreeNetworkBuffers();
@@ -347,9 +566,52 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 		}
 		#endif /* ipconfigCHECK_IP_QUEUE_SPACE */
 		
-		// Polling for packet
-		xResult = xNetworkInterfaceInput();
-		FreeRTOS_debug_printf(("ENC-Packet received"));
+		/* Sleep until enc28j60_isr() or xNetworkInterfaceOutput() signals an
+		event.  The timeout is the bounded fall-back poll for a lost falling
+		edge / unreliable PKTIF, it is handled as an interrupt.  With the link
+		down nothing can be received: the task only wakes for the next PHY
+		check, which also catches a missed LINKIF. */
+		if( ( networkHandle->LinkStatus & PHSTAT2_LSTAT ) != 0 )
+		{
+			xBlockTime = ulMaxBlockTime;
+		}
+		else
+		{
+			xBlockTime = xPhyRemTime;
+		}
+
+		if( xTaskNotifyWait( 0UL, ENC_EVENT_IRQ | ENC_EVENT_TX, &ulEvents, xBlockTime ) == pdFALSE )
+		{
+			ulEvents = ENC_EVENT_IRQ;
+		}
+
+		if( ( ulEvents & ENC_EVENT_IRQ ) != 0 )
+		{
+			/* Read and acknowledge EIR, INTIE stays cleared while servicing.
+			ENC_IRQHandler() also checks EPKTCNT and sets EIR_PKTIF by software.
+			A TXIF/TXERIF completes the current transmission and starts the
+			next frame queued in the controller. */
+			ENC_IRQHandler( networkHandle );
+
+			/* Catch a TX completion whose falling edge was missed. */
+			ENC_TransmitPoll( networkHandle );
+		}
+
+		/* Write the frames queued by the IP-task into the free TX slots,
+		including those freed by the completions above. */
+		prvENCSendQueued();
+
+		if( ( ulEvents & ENC_EVENT_IRQ ) != 0 )
+		{
+			if( ( networkHandle->interruptFlags & EIR_PKTIF ) != 0 )
+			{
+				xResult = xNetworkInterfaceInput();
+			}
+
+			/* Re-arm the interrupt pin now that all pending events were
+			handled. */
+			ENC_EnableInterrupts( EIE_INTIE );
+		}
 
 		/*
 		if( ( xEMACpsif.isr_events & EMAC_IF_ALL_EVENT ) == 0 )
@@ -385,11 +647,6 @@ const TickType_t ulMaxBlockTime = pdMS_TO_TICKS( 100UL );
 			xPhyRemTime = pdMS_TO_TICKS( PHY_LS_HIGH_CHECK_TIME_MS );
 			xResult = 0;
 		}
-		else
-        {
-            /* Delay to avoid excessive CPU usage (adjust as needed) */
-            vTaskDelay(ulMaxBlockTime);
-        }
 
 		/* --- PHY LINK STATUS CHECK --- */
 		if( xTaskCheckForTimeOut( &xPhyTime, &xPhyRemTime ) != pdFALSE )
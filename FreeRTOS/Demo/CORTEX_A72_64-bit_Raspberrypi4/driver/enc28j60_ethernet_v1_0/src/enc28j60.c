@@ -80,6 +80,7 @@ Errata 18 is implemented in lwip stack
 
 /* Includes ------------------------------------------------------------------*/
 #include "enc28j60.h"
+#include "hrtimer.h"
 
 /** @addtogroup BSP
   * @{
@@ -105,6 +106,16 @@ Errata 18 is implemented in lwip stack
 
 #define ENC_POLLTIMEOUT 50
 
+/* Transmission timeout (ms) after which a frame still pending in the
+ * controller is considered stalled (errata 12) and restarted.
+ */
+
+#define ENC_TXTIMEOUT 20
+
+/* Number of transmission attempts for a frame (errata 12, 13 and 15) */
+
+#define ENC_TXRETRIES 16
+
 /**
   * @}
   */
@@ -124,9 +135,16 @@ Errata 18 is implemented in lwip stack
  */
 
 #  define PKTMEM_RX_START 0x0000                            /* RX buffer must be at addr 0 for errata 5 */
-#  define PKTMEM_RX_END   (PKTMEM_END-ALIGNED_BUFSIZE)      /* RX buffer length is total SRAM minus TX buffer */
+#  define PKTMEM_RX_END   (PKTMEM_END-ENC_TX_SLOTS*ALIGNED_BUFSIZE) /* RX buffer length is total SRAM minus TX buffers */
 #  define PKTMEM_TX_START (PKTMEM_RX_END+1)                 /* Start TX buffer after */
-#  define PKTMEM_TX_ENDP1 (PKTMEM_TX_START+ALIGNED_BUFSIZE) /* Allow TX buffer for two frames */
+#  define PKTMEM_TX_ENDP1 (PKTMEM_TX_START+ALIGNED_BUFSIZE) /* End of the first TX slot */
+
+/* Each TX slot holds the per packet control byte, the frame and the 7 byte
+ * transmit status vector written by the controller after the frame.  While
+ * one slot is being transmitted the next frame is copied into the other one.
+ */
+
+#define PKTMEM_TX_SLOT(slot) (PKTMEM_TX_START+(slot)*ALIGNED_BUFSIZE)
 
 /* Misc. Helper Macros ******************************************************/
 
@@ -139,16 +157,39 @@ Errata 18 is implemented in lwip stack
 #define enc_bfsgreg(ctrlreg,setbits) \
   enc_wrgreg2(ENC_BFS | GETADDR(ctrlreg), setbits)
 
-/**
-  * @}
-  */
+#define enc_batch_rdgreg(batch, ctrlreg) \
+  enc_batch_op(batch, ENC_RCR | GETADDR(ctrlreg), 0, 2)
+#define enc_batch_bfcgreg(batch, ctrlreg, clrbits) \
+  enc_batch_op(batch, ENC_BFC | GETADDR(ctrlreg), clrbits, 2)
+#define enc_batch_bfsgreg(batch, ctrlreg, setbits) \
+  enc_batch_op(batch, ENC_BFS | GETADDR(ctrlreg), setbits, 2)
 
-/** @defgroup ENC28J60_Private_Variables
-  * @{
-  */
+/* Command batching *********************************************************/
 
-  /* Stores how many iterations the microcontroller can do in 1 �s */
-static uint32_t iter_per_us=0;
+/* Maximum number of commands in a batch.  A full batch is sent before the
+ * next command is added.
+ */
+
+#define ENC_BATCH_MAXOPS 12
+
+/* A sequence of register commands sent in a single SPI transfer */
+
+struct enc_batch_s
+{
+  uint8_t buf[ENC_BATCH_MAXOPS * 3];  /* Commands, then the answers */
+  uint8_t oplen[ENC_BATCH_MAXOPS];    /* Length of each command */
+  uint8_t nops;                       /* Number of commands */
+  uint8_t nbytes;                     /* Bytes used in buf */
+  uint8_t nreads;                     /* Read commands, see enc_batch_op */
+};
+
+/* A broken invariant of the driver stops here, as configASSERT() does.  The
+ * driver does not depend on FreeRTOS.h, the host tools build it alone.
+ */
+
+#ifndef ENC_ASSERT
+#  define ENC_ASSERT(x) do { if (!(x)) { for (;;); } } while (0)
+#endif
 
 /**
   * @}
@@ -165,37 +206,13 @@ static uint32_t iter_per_us=0;
   * @{
   */
 
-/**
-   Calibrate the constant time
- **/
-
-static void calibrate(void)
-{
-    uint32_t time;
-    volatile uint32_t i;
-
-    iter_per_us = 1000000;
-
-    time = HAL_GetTick();
-    /* Wait for next tick */
-    while (HAL_GetTick() == time) {
-        /* wait */
-    }
-    for (i=0; i<iter_per_us; i++) {
-    }
-    iter_per_us /= ((HAL_GetTick()-time)*1000);
-}
-
 /**
  * Software delay in �s
  *  us: the number of �s to wait
  **/
 void up_udelay(uint32_t us)
 {
-    volatile uint32_t i;
-
-    for (i=0; i<us*iter_per_us; i++) {
-    }
+    hrtimer_delay_us(us);
 }
 /****************************************************************************
  * Function: enc_rdgreg2
@@ -261,88 +278,194 @@ static void enc_wrgreg2(uint8_t cmd, uint8_t wrdata)
     ENC_SPI_SendBuf(cmdpdata, NULL, 2);
 }
 
+/****************************************************************************
+ * Function: enc_batch_run
+ *
+ * Description:
+ *   Send all commands of a batch in one SPI transfer and empty it.  The
+ *   answers of the read commands are then available through the pointers
+ *   returned when they were added.
+ *
+ * Parameters:
+ *   batch  - The batch to send
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+static void enc_batch_run(struct enc_batch_s *batch)
+{
+  if (batch->nops != 0) {
+      ENC_SPI_SendOps(batch->buf, batch->oplen, batch->nops);
+  }
+
+  batch->nops = 0;
+  batch->nbytes = 0;
+  batch->nreads = 0;
+}
 
 /****************************************************************************
- * Function: enc_waitgreg
+ * Function: enc_batch_op
  *
  * Description:
- *   Wait until grouped register bit(s) take a specific value (or a timeout
- *   occurs).
+ *   Add a command to a batch.  A write or bit field operation on the same
+ *   register as the previous command is merged into it: WCR keeps the last
+ *   value, BFS and BFC combine their bits.
  *
  * Parameters:
- *   ctrlreg - Bit encoded address of banked register to check
- *   bits    - The bits to check (a mask)
- *   value   - The value of the bits to return (value under mask)
+ *   batch  - The batch to add to
+ *   cmd    - The full command (cmd | address)
+ *   data   - The data byte of the command
+ *   len    - 2, or 3 for a read of a MAC/MII register (dummy byte)
  *
  * Returned Value:
- *   OK on success, negated errno on failure
+ *   Where the last byte of the answer is stored after enc_batch_run
  *
  * Assumptions:
+ *   A full batch is sent and emptied before the command is added, which
+ *   would overwrite the answers of its read commands: a batch holding a read
+ *   must not reach ENC_BATCH_MAXOPS commands.  This is asserted.
  *
  ****************************************************************************/
 
-static bool enc_waitgreg(uint8_t ctrlreg,
-                        uint8_t bits, uint8_t value)
+static uint8_t *enc_batch_op(struct enc_batch_s *batch, uint8_t cmd,
+                             uint8_t data, uint8_t len)
 {
-  uint32_t start = HAL_GetTick();
-  uint32_t elapsed;
-  uint8_t  rddata;
+  uint8_t *op;
+
+  if (batch->nops != 0 && batch->oplen[batch->nops - 1] == 2 && len == 2) {
+      op = &batch->buf[batch->nbytes - 2];
+      if (op[0] == cmd) {
+          switch (cmd & 0xe0) {
+          case ENC_WCR:
+              op[1] = data;
+              return &op[1];
+          case ENC_BFS:
+          case ENC_BFC:
+              op[1] |= data;
+              return &op[1];
+          default:
+              break;
+          }
+      }
+  }
 
-  /* Loop until the exit condition is met */
+  if (batch->nops == ENC_BATCH_MAXOPS) {
+      ENC_ASSERT(batch->nreads == 0);
+      enc_batch_run(batch);
+  }
 
-  do
-    {
-      /* Read the byte from the requested banked register */
+  if ((cmd & 0xe0) == ENC_RCR) {
+      batch->nreads++;
+  }
 
-      rddata  = enc_rdgreg(ctrlreg);
-      elapsed = HAL_GetTick() - start;
-    }
-  while ((rddata & bits) != value && elapsed < ENC_POLLTIMEOUT);
+  op = &batch->buf[batch->nbytes];
+  op[0] = cmd;
+  op[1] = data;
+  if (len == 3) {
+      op[2] = 0;
+  }
+  batch->oplen[batch->nops++] = len;
+  batch->nbytes += len;
 
-  return (rddata & bits) == value;
+  return &op[len - 1];
 }
 
 /****************************************************************************
- * Function: enc_waitwhilegreg
+ * Function: enc_batch_setbank
  *
  * Description:
- *   Wait while grouped register bit(s) have a specific value (or a timeout
- *   occurs).
+ *   Add the ECON1 commands needed to select a bank.  Only the bank bits
+ *   which differ from the current bank are cleared or set, nothing is added
+ *   when the bank is already selected.
  *
  * Parameters:
- *   ctrlreg - Bit encoded address of banked register to check
- *   bits    - The bits to check (a mask)
- *   value   - The value of the bits to return (value under mask)
+ *   handle - Reference to the driver state structure
+ *   batch  - The batch to add to
+ *   bank   - The bank to select (0-3)
  *
  * Returned Value:
- *   OK on success, negated errno on failure
+ *   None
  *
  * Assumptions:
  *
  ****************************************************************************/
 
-#ifndef USE_PROTOTHREADS
-static bool enc_waitwhilegreg(uint8_t ctrlreg,
-                        uint8_t bits, uint8_t value)
+static void enc_batch_setbank(ENC_HandleTypeDef *handle,
+                              struct enc_batch_s *batch, uint8_t bank)
 {
-  uint32_t start = HAL_GetTick();
-  uint32_t elapsed;
-  uint8_t  rddata;
+  uint8_t clrbits = handle->bank & ~bank;
+  uint8_t setbits = bank & ~handle->bank;
 
-  /* Loop until the exit condition is met */
+  if (clrbits != 0) {
+      enc_batch_bfcgreg(batch, ENC_ECON1, clrbits << ECON1_BSEL_SHIFT);
+  }
 
-  do
-    {
-      /* Read the byte from the requested banked register */
+  if (setbits != 0) {
+      enc_batch_bfsgreg(batch, ENC_ECON1, setbits << ECON1_BSEL_SHIFT);
+  }
 
-      rddata  = enc_rdgreg(ctrlreg);
-      elapsed = HAL_GetTick() - start;
-    }
-  while ((rddata & bits) == value && elapsed < ENC_POLLTIMEOUT);
+  handle->bank = bank;
+}
+
+/****************************************************************************
+ * Function: enc_batch_wrbreg
+ *
+ * Description:
+ *   Add a write to a banked control register, with the bank selection if
+ *   needed.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   batch   - The batch to add to
+ *   ctrlreg - Bit encoded address of banked register to write
+ *   wrdata  - The data to send
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
 
-  return (rddata & bits) != value;
+static void enc_batch_wrbreg(ENC_HandleTypeDef *handle,
+                             struct enc_batch_s *batch, uint8_t ctrlreg,
+                             uint8_t wrdata)
+{
+  enc_batch_setbank(handle, batch, GETBANK(ctrlreg));
+  enc_batch_op(batch, ENC_WCR | GETADDR(ctrlreg), wrdata, 2);
 }
-#endif
+
+/****************************************************************************
+ * Function: enc_batch_rdbreg
+ *
+ * Description:
+ *   Add a read of a banked control register, with the bank selection if
+ *   needed.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   batch   - The batch to add to
+ *   ctrlreg - Bit encoded address of banked register to read
+ *
+ * Returned Value:
+ *   Where the value is stored after enc_batch_run
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+static uint8_t *enc_batch_rdbreg(ENC_HandleTypeDef *handle,
+                                 struct enc_batch_s *batch, uint8_t ctrlreg)
+{
+  enc_batch_setbank(handle, batch, GETBANK(ctrlreg));
+  return enc_batch_op(batch, ENC_RCR | GETADDR(ctrlreg), 0,
+                      ISPHYMAC(ctrlreg) ? 3 : 2);
+}
+
 
 /**
   * @brief  Perform a soft reset on enc28j60
@@ -400,23 +523,15 @@ void enc_reset(ENC_HandleTypeDef *handle) {
  ****************************************************************************/
 
 void enc_setbank(ENC_HandleTypeDef *handle, uint8_t bank) {
+  struct enc_batch_s batch;
 
-  if (bank != handle->bank) {
-      /* Select bank 0 (just so that all of the bits are cleared) */
-
-      enc_bfcgreg(ENC_ECON1, ECON1_BSEL_MASK);
-
-      /* Then OR in bits to get the correct bank */
-
-      if (bank != 0)
-        {
-          enc_bfsgreg(ENC_ECON1, (bank << ECON1_BSEL_SHIFT));
-        }
-
-      /* Then remember the bank setting */
+  /* Only clear and set the bank bits which differ, both in one transfer */
 
-      handle->bank = bank;
-    }
+  batch.nops = 0;
+  batch.nbytes = 0;
+  batch.nreads = 0;
+  enc_batch_setbank(handle, &batch, bank);
+  enc_batch_run(&batch);
 }
 
 /****************************************************************************
@@ -735,9 +850,6 @@ bool ENC_Start(ENC_HandleTypeDef *handle)
     /* register value */
     uint8_t regval;
 
-    /* Calibrate time constant */
-    calibrate();
-
     /* System reset */
 	enc_reset(handle);
 
@@ -785,6 +897,11 @@ bool ENC_Start(ENC_HandleTypeDef *handle)
     /* Set transmit buffer start. */
 
     handle->transmitLength = 0;
+    handle->txWriteSlot = 0;
+    handle->txActiveSlot = ENC_TX_IDLE;
+    handle->txSlotLength[0] = 0;
+    handle->txSlotLength[1] = 0;
+    handle->txCompleted = 0;
     enc_wrbreg(handle, ENC_ETXSTL, PKTMEM_TX_START & 0xff);
     enc_wrbreg(handle, ENC_ETXSTH, PKTMEM_TX_START >> 8);
 
@@ -1024,68 +1141,210 @@ static void enc_rdbuffer(void *buffer, int16_t buflen)
 }
 
 /****************************************************************************
- * Function: ENC_RestoreTXBuffer
+ * Function: enc_txstart
  *
  * Description:
- *   Prepare TX buffer
+ *   Start the transmission of the frame stored in a TX slot.  The transmit
+ *   logic is reset before every attempt (erratas 12, 13 and 15).
  *
  * Parameters:
  *   handle  - Reference to the driver state structure
- *   len     - length of buffer
+ *   slot    - TX slot holding the frame
  *
  * Returned Value:
- *    ERR_OK          0    No error, everything OK.
- *    ERR_MEM        -1    Out of memory error.
- *    ERR_TIMEOUT    -3    Timeout.
+ *   None
  *
  * Assumptions:
+ *   No transmission is in progress
  *
  ****************************************************************************/
 
-int8_t ENC_RestoreTXBuffer(ENC_HandleTypeDef *handle, uint16_t len)
+static void enc_txstart(ENC_HandleTypeDef *handle, uint8_t slot)
 {
-  uint16_t txend;
-  uint8_t control_write[2];
+  struct enc_batch_s batch;
+  uint16_t txstart = PKTMEM_TX_SLOT(slot);
+  uint16_t txend = txstart + handle->txSlotLength[slot];
 
-  /* Wait while TX is busy */
-  if (!enc_waitgreg(ENC_ECON1, ECON1_TXRTS, 0)) {
-    return ERR_TIMEOUT;
-  }
+  batch.nops = 0;
+  batch.nbytes = 0;
+  batch.nreads = 0;
 
-  /* Verify that the hardware is ready to send another packet.  The driver
-   * starts a transmission process by setting ECON1.TXRTS. When the packet is
-   * finished transmitting or is aborted due to an error/cancellation, the
-   * ECON1.TXRTS bit will be cleared.
-   *
-   * NOTE: If we got here, then we have committed to sending a packet.
-   * higher level logic must have assured that TX-related interrupts are disabled.
+  /* The offset of the TX end pointer accounts for the control byte at the
+   * beginning the slot plus the size of the packet data.
    */
 
-  /* Send the packet: address=priv->dev.d_buf, length=priv->dev.d_len */
+  enc_batch_wrbreg(handle, &batch, ENC_ETXSTL, txstart & 0xff);
+  enc_batch_wrbreg(handle, &batch, ENC_ETXSTH, txstart >> 8);
+  enc_batch_wrbreg(handle, &batch, ENC_ETXNDL, txend & 0xff);
+  enc_batch_wrbreg(handle, &batch, ENC_ETXNDH, txend >> 8);
 
-  /* Set transmit buffer start (is this necessary?). */
+  /* Reset transmit logic */
 
-  enc_wrbreg(handle, ENC_ETXSTL, PKTMEM_TX_START & 0xff);
-  enc_wrbreg(handle, ENC_ETXSTH, PKTMEM_TX_START >> 8);
+  enc_batch_bfsgreg(&batch, ENC_ECON1, ECON1_TXRST);
+  enc_batch_bfcgreg(&batch, ENC_ECON1, ECON1_TXRST);
+  enc_batch_bfcgreg(&batch, ENC_EIR, EIR_TXERIF | EIR_TXIF);
 
-  /* Reset the write pointer to start of transmit buffer */
+  /* Start transmission, completion is signalled by TXIF or TXERIF */
 
-  enc_wrbreg(handle, ENC_EWRPTL, PKTMEM_TX_START & 0xff);
-  enc_wrbreg(handle, ENC_EWRPTH, PKTMEM_TX_START >> 8);
+  enc_batch_bfsgreg(&batch, ENC_ECON1, ECON1_TXRTS);
+  enc_batch_run(&batch);
 
-  /* Set the TX End pointer based on the size of the packet to send. Note
-   * that the offset accounts for the control byte at the beginning the
-   * buffer plus the size of the packet data.
-   */
+  handle->txActiveSlot = slot;
+  handle->startTime = HAL_GetTick();
+}
+
+/****************************************************************************
+ * Function: enc_txcomplete
+ *
+ * Description:
+ *   Finish the transmission in progress after TXIF or TXERIF was raised.
+ *   A frame aborted by a late collision is sent again (errata 13 and 15),
+ *   otherwise the slot is released and the next queued frame is started.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   eir     - The EIR value which signalled the completion
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+static void enc_txcomplete(ENC_HandleTypeDef *handle, uint8_t eir)
+{
+  uint8_t slot = handle->txActiveSlot;
+  uint8_t next = slot ^ 1;
+
+  /* Stop transmission */
+
+  enc_bfcgreg(ENC_ECON1, ECON1_TXRTS);
+
+  if ((eir & EIR_TXERIF) != 0 && handle->retries > 1) {
+      uint16_t addtTsv4;
+      uint8_t tsv4;
+
+      /* read tsv */
+      addtTsv4 = PKTMEM_TX_SLOT(slot) + handle->txSlotLength[slot] + 4;
+
+      enc_wrbreg(handle, ENC_ERDPTL, addtTsv4 & 0xff);
+      enc_wrbreg(handle, ENC_ERDPTH, addtTsv4 >> 8);
+
+      enc_rdbuffer(&tsv4, 1);
+
+      if (tsv4 & TSV_LATECOL) {
+          handle->retries--;
+          enc_txstart(handle, slot);
+          return;
+      }
+  }
+
+  /* Transmission finished (but can be unsuccessful) */
+
+  handle->txSlotLength[slot] = 0;
+  handle->txActiveSlot = ENC_TX_IDLE;
+  handle->txCompleted++;
+
+  if (handle->txSlotLength[next] != 0) {
+      handle->retries = ENC_TXRETRIES;
+      enc_txstart(handle, next);
+  }
+}
+
+/****************************************************************************
+ * Function: ENC_TransmitPoll
+ *
+ * Description:
+ *   Check the transmission in progress without waiting, for callers which
+ *   do not service the TX interrupts.  A transmission which did not
+ *   complete within ENC_TXTIMEOUT is restarted (errata 12).
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+void ENC_TransmitPoll(ENC_HandleTypeDef *handle)
+{
+  uint8_t eir;
+
+  if (handle->txActiveSlot == ENC_TX_IDLE) {
+      return;
+  }
+
+  eir = enc_rdgreg(ENC_EIR);
+  if ((eir & (EIR_TXIF | EIR_TXERIF)) != 0) {
+      enc_bfcgreg(ENC_EIR, EIR_TXERIF | EIR_TXIF);
+      enc_txcomplete(handle, eir);
+  } else if ((enc_rdgreg(ENC_ECON1) & ECON1_TXRTS) == 0) {
+      /* TXRTS is cleared by hardware when the frame is done */
+      enc_txcomplete(handle, eir);
+  } else if (HAL_GetTick() - handle->startTime > ENC_TXTIMEOUT) {
+      if (handle->retries > 1) {
+          handle->retries--;
+          enc_txstart(handle, handle->txActiveSlot);
+      } else {
+          enc_txcomplete(handle, 0);
+      }
+  }
+}
+
+/****************************************************************************
+ * Function: ENC_RestoreTXBuffer
+ *
+ * Description:
+ *   Prepare TX buffer: select a free TX slot and write the per packet
+ *   control byte.  The frame itself is then written with ENC_WriteBuffer.
+ *   A free slot is available even while the previous frame is still being
+ *   transmitted, so this never waits for the controller.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   len     - length of buffer
+ *
+ * Returned Value:
+ *    ERR_OK          0    No error, everything OK.
+ *    ERR_MEM        -1    Out of memory error.
+ *    ERR_TIMEOUT    -3    Timeout, all TX slots are busy.
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
 
-  txend = PKTMEM_TX_START + len;
+int8_t ENC_RestoreTXBuffer(ENC_HandleTypeDef *handle, uint16_t len)
+{
+  struct enc_batch_s batch;
+  uint8_t slot;
 
-  if (txend+8>PKTMEM_TX_ENDP1) {
+  if (PKTMEM_TX_START + len + 8 > PKTMEM_TX_ENDP1) {
     return ERR_MEM;
   }
 
-  enc_wrbreg(handle, ENC_ETXNDL, txend & 0xff);
-  enc_wrbreg(handle, ENC_ETXNDH, txend >> 8);
+  /* Look for a slot which is neither queued nor being transmitted. */
+
+  ENC_TransmitPoll(handle);
+  slot = handle->txWriteSlot;
+  if (handle->txSlotLength[slot] != 0) {
+    slot ^= 1;
+    if (handle->txSlotLength[slot] != 0) {
+      return ERR_TIMEOUT;
+    }
+  }
+  handle->txWriteSlot = slot;
+
+  /* Reset the write pointer to start of the transmit slot */
+
+  batch.nops = 0;
+  batch.nbytes = 0;
+  batch.nreads = 0;
+  enc_batch_wrbreg(handle, &batch, ENC_EWRPTL, PKTMEM_TX_SLOT(slot) & 0xff);
+  enc_batch_wrbreg(handle, &batch, ENC_EWRPTH, PKTMEM_TX_SLOT(slot) >> 8);
 
   /* Send the write buffer memory command (ignoring the response)
    *
@@ -1108,9 +1367,8 @@ int8_t ENC_RestoreTXBuffer(ENC_HandleTypeDef *handle, uint16_t len)
    *   because POVERRIDE is zero).
    */
 
-  control_write[0] = ENC_WBM;
-  control_write[1] = PKTCTRL_PCRCEN | PKTCTRL_PPADEN | PKTCTRL_PHUGEEN;
-  ENC_SPI_SendBuf(control_write, control_write, 2);
+  enc_batch_op(&batch, ENC_WBM, PKTCTRL_PCRCEN | PKTCTRL_PPADEN | PKTCTRL_PHUGEEN, 2);
+  enc_batch_run(&batch);
 
   return ERR_OK;
 }
@@ -1119,20 +1377,20 @@ int8_t ENC_RestoreTXBuffer(ENC_HandleTypeDef *handle, uint16_t len)
  * Function: ENC_Transmit
  *
  * Description:
- *   Start hardware transmission.  Called either from:
- *
- *   -  pkif interrupt when an application responds to the receipt of data
- *      by trying to send something, or
- *   -  From watchdog based polling.
+ *   Queue the frame prepared with ENC_RestoreTXBuffer/ENC_WriteBuffer for
+ *   transmission.  The transmission is started immediately when the
+ *   controller is idle, otherwise as soon as the current one completes.
+ *   Completion is handled by ENC_IRQHandler (TXIF/TXERIF) or by
+ *   ENC_TransmitPoll; it increments handle->txCompleted.
  *
  * Parameters:
  *   handle  - Reference to the driver state structure
- *   len     - length of buffer
  *
  * Returned Value:
  *   none
  *
  * Assumptions:
+ *   handle->transmitLength holds the length of the frame
  *
  ****************************************************************************/
 
@@ -1146,56 +1404,14 @@ void ENC_Transmit(ENC_HandleTypeDef *handle)
 
     if (handle->transmitLength != 0) {
         /* A frame is ready for transmission */
-        /* Set TXRTS to send the packet in the transmit buffer */
-
-        //enc_bfsgreg(ENC_ECON1, ECON1_TXRTS);
-        /* Implement erratas 12, 13 and 15 */
-        /* Reset transmit logic */
-        handle->retries = 16;
-        do {
-            enc_bfsgreg(ENC_ECON1, ECON1_TXRST);
-            enc_bfcgreg(ENC_ECON1, ECON1_TXRST);
-            enc_bfcgreg(ENC_EIR, EIR_TXERIF | EIR_TXIF);
-
-            /* Start transmission */
-            enc_bfsgreg(ENC_ECON1, ECON1_TXRTS);
-
-#ifdef USE_PROTOTHREADS
-            handle->startTime = HAL_GetTick();
-            handle->duration = 20; /* Timeout after 20 ms */
-            PT_WAIT_UNTIL(pt, (((enc_rdgreg(ENC_EIR) & (EIR_TXIF | EIR_TXERIF)) != 0) ||
-                          (HAL_GetTick() - handle->startTime > handle->duration)));
-#else
-            /* Wait for end of transmission */
-            enc_waitwhilegreg(ENC_EIR, EIR_TXIF | EIR_TXERIF, 0);
-#endif
-
-            HAL_Delay(20); // Added by AGB - fixes weird timing bug
-
-            /* Stop transmission */
-            enc_bfcgreg(ENC_ECON1, ECON1_TXRTS);
-
-            {
-                uint16_t addtTsv4;
-                uint8_t tsv4, regval;
-
-                /* read tsv */
-                addtTsv4 = PKTMEM_TX_START + handle->transmitLength + 4;
-
-                enc_wrbreg(handle, ENC_ERDPTL, addtTsv4 & 0xff);
-                enc_wrbreg(handle, ENC_ERDPTH, addtTsv4 >> 8);
-
-                enc_rdbuffer(&tsv4, 1);
-
-                regval = enc_rdgreg(ENC_EIR);
-                if (!(regval & EIR_TXERIF) || !(tsv4 & TSV_LATECOL)) {
-                    break;
-                }
-            }
-            handle->retries--;
-        } while (handle->retries > 0);
-        /* Transmission finished (but can be unsuccessful) */
+        handle->txSlotLength[handle->txWriteSlot] = handle->transmitLength;
         handle->transmitLength = 0;
+
+        if (handle->txActiveSlot == ENC_TX_IDLE) {
+            handle->retries = ENC_TXRETRIES;
+            enc_txstart(handle, handle->txWriteSlot);
+        }
+        handle->txWriteSlot ^= 1;
     }
     PT_END(pt);
 }
@@ -1217,24 +1433,58 @@ void ENC_Transmit(ENC_HandleTypeDef *handle)
  ****************************************************************************/
 
 bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle)
+{
+    return ENC_GetReceivedFrameBuf(handle, handle->RxFrameInfos.buffer);
+}
+
+/****************************************************************************
+ * Function: ENC_GetReceivedFrameBuf
+ *
+ * Description:
+ *   Check if we have received packet, and if so, copy it straight into
+ *   the caller supplied buffer (e.g. a network buffer of the IP stack).
+ *   The length of the frame is stored in handle->RxFrameInfos.length.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   buffer  - Destination, must hold at least MAX_FRAMELEN bytes
+ *
+ * Returned Value:
+ *   true if new packet is available; false otherwise
+ *
+ * Assumptions:
+ *   A packet which is not valid is released from the RX FIFO as well, so
+ *   EPKTCNT is decremented on every call which finds a pending packet.
+ *
+ ****************************************************************************/
+
+bool ENC_GetReceivedFrameBuf(ENC_HandleTypeDef *handle, uint8_t *buffer)
 {
     uint8_t  rsv[6];
     uint16_t pktlen;
     uint16_t rxstat;
 
-    uint8_t pktcnt;
+    uint8_t *pktcnt;
+    struct enc_batch_s batch;
 
     bool result = true;
 
-    pktcnt = enc_rdbreg(handle, ENC_EPKTCNT);
-    if (pktcnt == 0) {
-        return false;
-    };
+    /* Check EPKTCNT and set the read pointer to the start of the received
+     * packet (ERDPT) in one transfer.  ERDPT is not used when there is no
+     * packet.
+     */
 
-    /* Set the read pointer to the start of the received packet (ERDPT) */
+    batch.nops = 0;
+    batch.nbytes = 0;
+    batch.nreads = 0;
+    pktcnt = enc_batch_rdbreg(handle, &batch, ENC_EPKTCNT);
+    enc_batch_wrbreg(handle, &batch, ENC_ERDPTL, (handle->nextpkt) & 0xff);
+    enc_batch_wrbreg(handle, &batch, ENC_ERDPTH, (handle->nextpkt) >> 8);
+    enc_batch_run(&batch);
 
-    enc_wrbreg(handle, ENC_ERDPTL, (handle->nextpkt) & 0xff);
-    enc_wrbreg(handle, ENC_ERDPTH, (handle->nextpkt) >> 8);
+    if (*pktcnt == 0) {
+        return false;
+    };
 
     /* Read the next packet pointer and the 4 byte read status vector (RSV)
     * at the beginning of the received packet. (ERDPT should auto-increment
@@ -1265,7 +1515,7 @@ bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle)
 #endif
         result = false;
     } else { /* Check for a usable packet length (4 added for the CRC) */
-        if (pktlen > (CONFIG_NET_ETH_MTU + 4) || pktlen <= (ETH_HDRLEN + 4)) {
+        if (pktlen > (CONFIG_NET_ETH_MTU + ETH_HDRLEN + 4) || pktlen <= (ETH_HDRLEN + 4)) {
     #ifdef CONFIG_ENC28J60_STATS
             priv->stats.rxpktlen++;
     #endif
@@ -1275,12 +1525,12 @@ bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle)
 
             handle->RxFrameInfos.length = pktlen - 4;
 
-            /* Copy the data data from the receive buffer to priv->dev.d_buf.
+            /* Copy the data data from the receive buffer to buffer.
             * ERDPT should be correctly positioned from the last call to to
             * end_rdbuffer (above).
             */
 
-            enc_rdbuffer(handle->RxFrameInfos.buffer, handle->RxFrameInfos.length);
+            enc_rdbuffer(buffer, handle->RxFrameInfos.length);
 
         }
     }
@@ -1296,8 +1546,8 @@ bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle)
     } else {
         rxstat--;
     }
-    enc_wrbreg(handle, ENC_ERXRDPTL, rxstat & 0xff);
-    enc_wrbreg(handle, ENC_ERXRDPTH, rxstat >> 8);
+    enc_batch_wrbreg(handle, &batch, ENC_ERXRDPTL, rxstat & 0xff);
+    enc_batch_wrbreg(handle, &batch, ENC_ERXRDPTH, rxstat >> 8);
 /*
     enc_wrbreg(handle, ENC_ERXRDPTL, (handle->nextpkt));
     enc_wrbreg(handle, ENC_ERXRDPTH, (handle->nextpkt) >> 8);
@@ -1305,7 +1555,8 @@ bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle)
 
     /* Decrement the packet counter indicate we are done with this packet */
 
-    enc_bfsgreg(ENC_ECON2, ECON2_PKTDEC);
+    enc_batch_bfsgreg(&batch, ENC_ECON2, ECON2_PKTDEC);
+    enc_batch_run(&batch);
 
     return result;
 }
@@ -1373,6 +1624,9 @@ void ENC_EnableInterrupts(uint8_t bits)
 
 void ENC_IRQHandler(ENC_HandleTypeDef *handle)
 {
+    struct enc_batch_s batch;
+    uint8_t *eirp;
+    uint8_t *pktcnt;
     uint8_t eir;
 
     /* Disable further interrupts by clearing the global interrupt enable bit.
@@ -1384,15 +1638,22 @@ void ENC_IRQHandler(ENC_HandleTypeDef *handle)
      * is being serviced."
      */
 
-    enc_bfcgreg(ENC_EIE, EIE_INTIE);
+    batch.nops = 0;
+    batch.nbytes = 0;
+    batch.nreads = 0;
+    enc_batch_bfcgreg(&batch, ENC_EIE, EIE_INTIE);
 
-    /* Read EIR for interrupt flags
+    /* Read EIR for interrupt flags, and EPKTCNT in the same transfer
      */
 
-    eir = enc_rdgreg(ENC_EIR) & EIR_ALLINTS;
+    eirp = enc_batch_rdgreg(&batch, ENC_EIR);
+    pktcnt = enc_batch_rdbreg(handle, &batch, ENC_EPKTCNT);
+    enc_batch_run(&batch);
+
+    eir = *eirp & EIR_ALLINTS;
 
     /* PKTIF is not reliable, check PKCNT instead */
-    if (enc_rdbreg(handle, ENC_EPKTCNT) != 0) {
+    if (*pktcnt != 0) {
         /* Manage EIR_PKTIF by software */
         eir |= EIR_PKTIF;
     }
@@ -1407,8 +1668,18 @@ void ENC_IRQHandler(ENC_HandleTypeDef *handle)
         enc_rdphy(handle, ENC_PHIR);  /* Clear the LINKIF interrupt */
     }
 
-    /* Reset ENC28J60 interrupt flags, except PKTIF form which interruption is deasserted when PKTCNT reaches 0 */
-    enc_bfcgreg(ENC_EIR, EIR_ALLINTS);
+    /* Complete the transmission in progress and start the next queued frame */
+    if ((eir & (EIR_TXIF | EIR_TXERIF)) != 0 && handle->txActiveSlot != ENC_TX_IDLE)
+    {
+        enc_bfcgreg(ENC_EIR, EIR_TXERIF | EIR_TXIF);
+        enc_txcomplete(handle, eir);
+        eir &= ~(EIR_TXERIF | EIR_TXIF);
+    }
+
+    /* Reset ENC28J60 interrupt flags, except PKTIF form which interruption is deasserted when PKTCNT reaches 0.
+     * Only the flags read above are cleared, so the completion of a frame started by enc_txcomplete is not lost.
+     */
+    enc_bfcgreg(ENC_EIR, eir & EIR_ALLINTS);
 
     /* Enable Ethernet interrupts */
     /* done after effective process on interrupts enc_bfsgreg(ENC_EIE, EIE_INTIE); */
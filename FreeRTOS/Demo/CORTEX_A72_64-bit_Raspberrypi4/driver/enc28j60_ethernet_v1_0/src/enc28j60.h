@@ -62,6 +62,12 @@
 #define MAX_FRAMELEN      1518
 
 
+/* Number of frames which can be stored in the controller for transmission:
+ * the next frame is copied while the previous one is being sent */
+
+#define ENC_TX_SLOTS      2
+#define ENC_TX_IDLE       0xff
+
 /* External functions --------------------------------------------------------*/
 void HAL_Delay(volatile uint32_t Delay);
 uint32_t HAL_GetTick(void);
@@ -103,6 +109,16 @@ void ENC_SPI_Send(uint8_t command);
 
 void ENC_SPI_SendBuf(uint8_t *master2slave, uint8_t *slave2master, uint16_t bufferSize);
 
+/**
+  * Implement several short SPI commands in a single transfer. Must be provided by user code
+  * param  buffer: the commands back to back, overwritten by the answers from ENC28J60
+  * param  oplen: length of each command, every command gets its own slave selection
+  * param  nops: number of commands
+  * retval none
+  */
+
+void ENC_SPI_SendOps(uint8_t *buffer, const uint8_t *oplen, uint8_t nops);
+
 /* Exported types ------------------------------------------------------------*/
 /** @defgroup ETH_Exported_Types ETH Exported Types
   * @{
@@ -155,6 +171,10 @@ typedef struct
   uint32_t                  startTime;     /*!< The start time of the current timer */
   uint32_t                  duration;      /*!< The duration of the current timer in ms */
   uint16_t                  retries;       /*!< The number of transmission retries left to do */
+  uint16_t                  txSlotLength[ENC_TX_SLOTS]; /*!< Length of the frame queued in each TX slot, 0 if free */
+  uint8_t                   txWriteSlot;   /*!< TX slot the next frame is written to */
+  uint8_t                   txActiveSlot;  /*!< TX slot being transmitted, ENC_TX_IDLE if none */
+  uint8_t                   txCompleted;   /*!< Number of completed transmissions, reset by the user */
 
   ENC_RxFrameInfos          RxFrameInfos;  /*!< last Rx frame infos         */
 } ENC_HandleTypeDef;
@@ -659,7 +679,7 @@ void ENC_SetMacAddr(ENC_HandleTypeDef *handle);
  * Returned Value:
  *    ERR_OK          0    No error, everything OK.
  *    ERR_MEM        -1    Out of memory error.
- *    ERR_TIMEOUT    -3    Timeout.
+ *    ERR_TIMEOUT    -3    Timeout, all TX slots are busy.
  *
  * Assumptions:
  *
@@ -691,11 +711,10 @@ void ENC_WriteBuffer(void *buffer, uint16_t buflen);
  * Function: ENC_Transmit
  *
  * Description:
- *   Start hardware transmission.  Called either from:
- *
- *   -  pkif interrupt when an application responds to the receipt of data
- *      by trying to send something, or
- *   -  From watchdog based polling.
+ *   Queue the frame written after ENC_RestoreTXBuffer for transmission.
+ *   Returns without waiting; the frame is started as soon as the
+ *   controller is idle and completion is handled by ENC_IRQHandler or
+ *   ENC_TransmitPoll, which increment handle->txCompleted.
  *
  * Parameters:
  *   handle  - Reference to the driver state structure
@@ -713,6 +732,25 @@ PT_THREAD(ENC_Transmit(struct pt *pt, ENC_HandleTypeDef *handle));
 void ENC_Transmit(ENC_HandleTypeDef *handle);
 #endif
 
+/****************************************************************************
+ * Function: ENC_TransmitPoll
+ *
+ * Description:
+ *   Check the transmission in progress without waiting, restart it when
+ *   it stalled.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *
+ * Returned Value:
+ *   none
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+void ENC_TransmitPoll(ENC_HandleTypeDef *handle);
+
  /**
   * @}
   */
@@ -739,6 +777,25 @@ void ENC_Transmit(ENC_HandleTypeDef *handle);
 
 bool ENC_GetReceivedFrame(ENC_HandleTypeDef *handle);
 
+/****************************************************************************
+ * Function: ENC_GetReceivedFrameBuf
+ *
+ * Description:
+ *   Check if we have received packet, and if so, copy it into buffer.
+ *
+ * Parameters:
+ *   handle  - Reference to the driver state structure
+ *   buffer  - Destination, must hold at least MAX_FRAMELEN bytes
+ *
+ * Returned Value:
+ *   true if new packet is available; false otherwise
+ *
+ * Assumptions:
+ *
+ ****************************************************************************/
+
+bool ENC_GetReceivedFrameBuf(ENC_HandleTypeDef *handle, uint8_t *buffer);
+
 /****************************************************************************
  * Function: ENC_IRQHandler
  *
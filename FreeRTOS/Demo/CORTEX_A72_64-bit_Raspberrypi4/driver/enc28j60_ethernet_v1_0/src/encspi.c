@@ -2,6 +2,10 @@
 #include "board.h"
 #include "interrupt.h"
 
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
 // MAC address to be assigned to the ENC28J60
 
 uint8_t myMAC[6] = { 0xc0, 0xff, 0xee, 0xc0, 0xff, 0xee };
@@ -21,6 +25,21 @@ uint8_t routerIP[4] = { 192, 168, 178, 1 };
 
 ENC_HandleTypeDef networkhandle;
 
+// Called from enc28j60_isr to wake up the task which services the ENC28J60
+static ENC_IRQCallback irq_callback = NULL;
+
+// Given by the SPI0 DMA interrupt when a buffer transfer has completed
+static SemaphoreHandle_t dma_done = NULL;
+
+static void encspi_dma_done(void *arg)
+{
+   BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+   (void)arg;
+   xSemaphoreGiveFromISR(dma_done, &xHigherPriorityTaskWoken);
+   portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+}
+
 void ENC_SPI_Select(bool select) {
     /*if (true == select)
     {
@@ -34,10 +53,22 @@ void ENC_SPI_Select(bool select) {
 
 void ENC_SPI_SendBuf(u8 *master2slave, u8 *slave2master, u16 bufferSize) {
     spi0_chip_select(0);
-    spi0_send_recv(0, master2slave, slave2master, bufferSize);
+    // Frame data is moved by DMA while the calling task sleeps, register
+    // accesses and transfers before the scheduler runs are polled.
+    if (bufferSize >= SPI0_DMA_THRESHOLD && dma_done != NULL &&
+        xTaskGetSchedulerState() == taskSCHEDULER_RUNNING &&
+        spi0_send_recv_async(0, master2slave, slave2master, bufferSize, encspi_dma_done, NULL) == 0) {
+        xSemaphoreTake(dma_done, portMAX_DELAY);
+    } else {
+        spi0_send_recv(0, master2slave, slave2master, bufferSize);
+    }
     spi0_chip_select(1);
 }
 
+void ENC_SPI_SendOps(u8 *buffer, const u8 *oplen, u8 nops) {
+    spi0_send_recv_ops(0, buffer, oplen, nops);
+}
+
 void ENC_SPI_Send(u8 command) {
     spi0_chip_select(0);
     spi0_send(0, &command, 1);
@@ -50,19 +81,28 @@ void ENC_SPI_SendWithoutSelection(u8 command) {
 
 void enc28j60_isr(void)
 {
-   uart_puts("enc28j60 interupt \n");
    gpio_pin_clear_ev_detection(ENC_INT_PIN);
-   ENC_IRQHandler(&networkhandle);
+
+   // No SPI traffic here: the registered task reads EIR/EPKTCNT itself
+   // (ENC_IRQHandler), so the bus is never shared with interrupt context.
+   if (irq_callback != NULL) {
+      irq_callback();
+   }
    return;
 
 }
 
+void encspi_set_irq_callback(ENC_IRQCallback callback)
+{
+   irq_callback = callback;
+}
+
 void init_network(void)
 {
    networkhandle.Init.DuplexMode = ETH_MODE_HALFDUPLEX;
    networkhandle.Init.MACAddr = myMAC;
    networkhandle.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
-   networkhandle.Init.InterruptEnableBits = EIE_LINKIE | EIE_PKTIE;
+   networkhandle.Init.InterruptEnableBits = EIE_LINKIE | EIE_PKTIE | EIE_TXIE | EIE_TXERIE;
 
    #if( ipconfigUSE_LLMNR == 1 )
 		{
@@ -71,6 +111,10 @@ void init_network(void)
 		}
 		#endif	/* ipconfigUSE_LLMNR == 1 */
 
+   // Completion interrupt of the SPI0 DMA transfers (enc_rdbuffer, ENC_WriteBuffer)
+   dma_done = xSemaphoreCreateBinary();
+   isr_register(IRQ_VC_DMA(SPI0_DMA_RX_CHANNEL), ETH_PRIORITY, RTOS_IRQ_CPUMASK, spi0_dma_isr);
+
    printf("Starting network up.\n");
    
    if (!ENC_Start(&networkhandle)) {
@@ -88,15 +132,21 @@ void init_network(void)
    printf("Waiting for ifup...\n");
    while (!(networkhandle.LinkStatus & PHSTAT2_LSTAT)) ENC_IRQHandler(&networkhandle);
    printf("network is up and running.\n");
-   
-   //register interrupt detection of incoming packets
-   isr_register(IRQ_SPI, ETH_PRIORITY, (0x1U << 0x3U), enc28j60_isr);
-
-   // Re-enable global interrupts
-   ENC_EnableInterrupts(EIE_INTIE);
 
    arp_test();
 
+   // The interrupt pin is connected later by encspi_enable_irq(), once the
+   // task which services it exists.
+}
+
+void encspi_enable_irq(void)
+{
+   //register interrupt detection of incoming packets
+   isr_register(IRQ_SPI, ETH_PRIORITY, RTOS_IRQ_CPUMASK, enc28j60_isr);
+
+   // Re-enable global interrupts: events which arrived since init_network()
+   // pull INT low now and are not lost
+   ENC_EnableInterrupts(EIE_INTIE);
 }
 
 // Function to return a pointer to the networkhandle
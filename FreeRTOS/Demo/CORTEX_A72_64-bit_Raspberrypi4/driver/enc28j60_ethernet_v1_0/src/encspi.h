@@ -19,7 +19,8 @@ typedef struct {
 #define ARPPACKET 0x0608
 #define IPPACKET  0x0008
 
-#define ETH_PRIORITY (0xA1)
+// Below the tick and the UART, which preempt the ENC28J60 and SPI DMA handlers
+#define ETH_PRIORITY (0xD0)
 
 // Structure for an ARP Packet
 
@@ -47,12 +48,17 @@ typedef struct {
 
 void ENC_SPI_Select(bool select);
 void ENC_SPI_SendBuf(u8 *master2slave, u8 *slave2master, u16 bufferSize);
+void ENC_SPI_SendOps(u8 *buffer, const u8 *oplen, u8 nops);
 void ENC_SPI_Send(u8 command);
 void ENC_SPI_SendWithoutSelection(u8 command);
 
+typedef void (*ENC_IRQCallback)(void);
+
 void enc28j60_isr(void);
+void encspi_set_irq_callback(ENC_IRQCallback callback);
 
 void init_network(void);
+void encspi_enable_irq(void);
 
 ENC_HandleTypeDef *encspi_getHandle(void);
 
@@ -4,6 +4,27 @@
 //Dev purpose
 #include "mini_uart.h"
 
+// From ../cache/cache.S
+extern void flush_dcache_range(unsigned long start, unsigned long end);
+extern void invalidate_dcache_range(unsigned long start, unsigned long end);
+
+// DMA state: control blocks and the header/fill/sink words must be visible
+// to the DMA engine, they are cleaned to memory before every transfer.
+static struct DmaControlBlock dma_tx_cbs[2];
+static struct DmaControlBlock dma_rx_cb;
+static u32 dma_words[8] __attribute__((aligned(32)));
+static volatile int dma_active = 0;
+static u8 *dma_rbuffer;
+static u32 dma_size;
+static spi0_callback dma_callback;
+static void *dma_callback_arg;
+
+static void spi0_dma_init(void) {
+    REGS_DMA_ENABLE |= (1 << SPI0_DMA_TX_CHANNEL) | (1 << SPI0_DMA_RX_CHANNEL);
+    REGS_DMA(SPI0_DMA_TX_CHANNEL)->cs = DMA_CS_RESET;
+    REGS_DMA(SPI0_DMA_RX_CHANNEL)->cs = DMA_CS_RESET;
+}
+
 
 void spi0_init() {
     gpio_pin_set_func(ENC_INT_PIN, GFInput);      // Interrupt pin for enc28j60
@@ -24,6 +45,8 @@ void spi0_init() {
     gpio_pin_enable(ENC_MISO_PIN);
     gpio_pin_enable(ENC_MOSI_PIN);
     gpio_pin_enable(ENC_SCLK_PIN);
+
+    spi0_dma_init();
 }
 
 void spi0_chip_select (u8 chip_select) {
@@ -39,6 +62,14 @@ void spi0_chip_deselect (u8 chip_select) {
 }
 
 void spi0_send_recv(u8 chip_select, u8 *sbuffer, u8 *rbuffer, u32 size) {
+    // Long transfers (frame data) go through DMA: the core only waits for
+    // the end instead of moving every byte through the FIFO registers.
+    if (size >= SPI0_DMA_THRESHOLD &&
+        spi0_send_recv_async(chip_select, sbuffer, rbuffer, size, NULL, NULL) == 0) {
+        while (spi0_dma_busy());
+        return;
+    }
+
     REGS_SPI0->data_length = size;
     REGS_SPI0->cs = (REGS_SPI0->cs & ~CS_CS) | (chip_select << CS_CS__SHIFT) |
         CS_CLEAR_RX | CS_CLEAR_TX | CS_TA;
@@ -89,6 +120,41 @@ void spi0_send_recv(u8 chip_select, u8 *sbuffer, u8 *rbuffer, u32 size) {
     REGS_SPI0->cs = (REGS_SPI0->cs & ~CS_TA);
 }
 
+void spi0_send_recv_ops(u8 chip_select, u8 *buffer, const u8 *oplen, u32 nops) {
+    u32 op;
+
+    // One transfer for all commands: the FIFO is set up once and only the
+    // chip select pin is toggled between the commands.
+    REGS_SPI0->cs = (REGS_SPI0->cs & ~CS_CS) | (chip_select << CS_CS__SHIFT) |
+        CS_CLEAR_RX | CS_CLEAR_TX | CS_TA;
+
+    for (op = 0; op < nops; op++) {
+        u32 size = oplen[op];
+        u32 read_count = 0;
+        u32 write_count = 0;
+
+        spi0_chip_select(0);
+
+        while(read_count < size || write_count < size) {
+            while(write_count < size && REGS_SPI0->cs & CS_TXD) {
+                REGS_SPI0->fifo = buffer[write_count++];
+            }
+
+            // The received bytes replace the bytes already sent
+            while(read_count < size && REGS_SPI0->cs & CS_RXD) {
+                buffer[read_count++] = REGS_SPI0->fifo;
+            }
+        }
+
+        while(!(REGS_SPI0->cs & CS_DONE));
+
+        spi0_chip_select(1);
+        buffer += size;
+    }
+
+    REGS_SPI0->cs = (REGS_SPI0->cs & ~CS_TA);
+}
+
 void spi0_send(u8 chip_select, u8 *data, u32 size) {
     spi0_send_recv(chip_select, data, 0, size);
 }
@@ -96,3 +162,123 @@ void spi0_send(u8 chip_select, u8 *data, u32 size) {
 void spi0_recv(u8 chip_select, u8 *data, u32 size) {
     spi0_send_recv(chip_select, 0, data, size);
 }
+
+void spi0_dma_build_cbs(struct DmaControlBlock tx[2], struct DmaControlBlock *rx,
+                        u32 header_bus, u32 sbuffer_bus, u32 rbuffer_bus, u32 size, int inten) {
+    u32 tx_ti = DMA_TI_DEST_DREQ | (DMA_PERMAP_SPI0_TX << DMA_TI_PERMAP__SHIFT) | DMA_TI_WAIT_RESP;
+    u32 rx_ti = DMA_TI_SRC_DREQ | (DMA_PERMAP_SPI0_RX << DMA_TI_PERMAP__SHIFT) | DMA_TI_WAIT_RESP;
+
+    // "DMA channel 1 control block ... should be set to write 'transfer
+    // length' + 1 words to SPI_FIFO": the header word first ...
+    tx[0].ti = tx_ti | DMA_TI_SRC_INC;
+    tx[0].source_ad = header_bus;
+    tx[0].dest_ad = SPI0_FIFO_BUS_ADDR;
+    tx[0].txfr_len = 4;
+    tx[0].stride = 0;
+    tx[0].nextconbk = DMA_BUS_ADDR(&tx[1]);
+
+    // ... then the data, or the same zero word over and over for a read
+    tx[1].ti = tx_ti | (sbuffer_bus != 0 ? DMA_TI_SRC_INC : 0);
+    tx[1].source_ad = sbuffer_bus != 0 ? sbuffer_bus : header_bus + 4;
+    tx[1].dest_ad = SPI0_FIFO_BUS_ADDR;
+    tx[1].txfr_len = size;
+    tx[1].stride = 0;
+    tx[1].nextconbk = 0;
+
+    // The received bytes, dropped into the sink word for a write
+    rx->ti = rx_ti | (rbuffer_bus != 0 ? DMA_TI_DEST_INC : 0) | (inten ? DMA_TI_INTEN : 0);
+    rx->source_ad = SPI0_FIFO_BUS_ADDR;
+    rx->dest_ad = rbuffer_bus != 0 ? rbuffer_bus : header_bus + 8;
+    rx->txfr_len = size;
+    rx->stride = 0;
+    rx->nextconbk = 0;
+}
+
+int spi0_send_recv_async(u8 chip_select, u8 *sbuffer, u8 *rbuffer, u32 size,
+                         spi0_callback callback, void *arg) {
+    u32 cs;
+
+    // DLEN of the header word is 16 bits wide
+    if (dma_active || size == 0 || size > 0xffff) {
+        return -1;
+    }
+
+    dma_active = 1;
+    dma_rbuffer = rbuffer;
+    dma_size = size;
+    dma_callback = callback;
+    dma_callback_arg = arg;
+
+    // "A word with the transfer length in bytes in the top sixteen bits, and
+    // the control register settings [7:0] in the bottom eight bits"
+    cs = (REGS_SPI0->cs & ~(CS_CS | CS_CLEAR_RX | CS_CLEAR_TX)) & 0xff;
+    dma_words[0] = (size << 16) | cs | (chip_select << CS_CS__SHIFT) | CS_TA;
+    dma_words[1] = 0;
+
+    spi0_dma_build_cbs(dma_tx_cbs, &dma_rx_cb, DMA_BUS_ADDR(dma_words),
+                       sbuffer ? DMA_BUS_ADDR(sbuffer) : 0,
+                       rbuffer ? DMA_BUS_ADDR(rbuffer) : 0,
+                       size, callback != NULL);
+
+    // The DMA engine reads and writes memory behind the data cache
+    flush_dcache_range((unsigned long)dma_words, (unsigned long)(dma_words + 8));
+    flush_dcache_range((unsigned long)dma_tx_cbs, (unsigned long)(dma_tx_cbs + 2));
+    flush_dcache_range((unsigned long)&dma_rx_cb, (unsigned long)(&dma_rx_cb + 1));
+    if (sbuffer) {
+        flush_dcache_range((unsigned long)sbuffer, (unsigned long)sbuffer + size);
+    }
+    if (rbuffer) {
+        flush_dcache_range((unsigned long)rbuffer, (unsigned long)rbuffer + size);
+    }
+
+    REGS_SPI0->cs = (REGS_SPI0->cs & ~(CS_TA | CS_CS)) | CS_CLEAR_RX | CS_CLEAR_TX | CS_DMAEN;
+
+    // RX first, so no received word is missed
+    REGS_DMA(SPI0_DMA_RX_CHANNEL)->conblk_ad = DMA_BUS_ADDR(&dma_rx_cb);
+    REGS_DMA(SPI0_DMA_RX_CHANNEL)->cs = DMA_CS_WAIT_WRITES | (8 << DMA_CS_PANIC_PRIORITY__SHIFT) |
+                                        (8 << DMA_CS_PRIORITY__SHIFT) | DMA_CS_ACTIVE;
+    REGS_DMA(SPI0_DMA_TX_CHANNEL)->conblk_ad = DMA_BUS_ADDR(&dma_tx_cbs[0]);
+    REGS_DMA(SPI0_DMA_TX_CHANNEL)->cs = DMA_CS_WAIT_WRITES | (8 << DMA_CS_PANIC_PRIORITY__SHIFT) |
+                                        (8 << DMA_CS_PRIORITY__SHIFT) | DMA_CS_ACTIVE;
+    return 0;
+}
+
+static void spi0_dma_complete(void) {
+    REGS_DMA(SPI0_DMA_RX_CHANNEL)->cs = DMA_CS_INT | DMA_CS_END;
+    REGS_DMA(SPI0_DMA_TX_CHANNEL)->cs = DMA_CS_INT | DMA_CS_END;
+
+    // "On receipt of an interrupt from DMA channel 2, the transfer is
+    // complete. Set TA = 0."
+    REGS_SPI0->cs = REGS_SPI0->cs & ~(CS_TA | CS_DMAEN);
+
+    if (dma_rbuffer) {
+        invalidate_dcache_range((unsigned long)dma_rbuffer, (unsigned long)dma_rbuffer + dma_size);
+    }
+    dma_active = 0;
+}
+
+int spi0_dma_busy(void) {
+    if (!dma_active) {
+        return 0;
+    }
+
+    // Completion of a transfer without callback is only detected here
+    if (dma_callback == NULL && (REGS_DMA(SPI0_DMA_RX_CHANNEL)->cs & DMA_CS_END)) {
+        spi0_dma_complete();
+        return 0;
+    }
+    return 1;
+}
+
+void spi0_dma_isr(void) {
+    spi0_callback callback = dma_callback;
+
+    if (!dma_active || !(REGS_DMA(SPI0_DMA_RX_CHANNEL)->cs & DMA_CS_INT)) {
+        return;
+    }
+
+    spi0_dma_complete();
+    if (callback != NULL) {
+        callback(dma_callback_arg);
+    }
+}
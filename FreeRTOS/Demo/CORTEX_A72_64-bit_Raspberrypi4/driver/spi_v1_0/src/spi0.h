@@ -48,6 +48,84 @@ struct Spi0Regs {
 #define CS_CS		(1 << 0)
 #define CS_CS__SHIFT	0
 
+// Legacy DMA engine (DMA0-6), used for long SPI0 transfers
+struct DmaChannelRegs {
+    reg32 cs;
+    reg32 conblk_ad;
+    reg32 ti;
+    reg32 source_ad;
+    reg32 dest_ad;
+    reg32 txfr_len;
+    reg32 stride;
+    reg32 nextconbk;
+    reg32 debug;
+};
+
+// Control block as read by the DMA engine, must be 32-byte aligned
+struct DmaControlBlock {
+    u32 ti;
+    u32 source_ad;
+    u32 dest_ad;
+    u32 txfr_len;
+    u32 stride;
+    u32 nextconbk;
+    u32 reserved[2];
+} __attribute__((aligned(32)));
+
+#define DMA_BASE        (BCM_RPI_PERIPHERAL_BASEADDR + 0x00007000)
+#define REGS_DMA(ch)    ((struct DmaChannelRegs *)(DMA_BASE + (ch) * 0x100))
+#define REGS_DMA_ENABLE (*(reg32 *)(DMA_BASE + 0xFF0))
+
+// Bus addresses as seen by the DMA engine: peripherals at 0x7E000000, the
+// first GB of SDRAM through the uncached alias at 0xC0000000.
+#define SPI0_FIFO_BUS_ADDR  (0x7E204004)
+#define DMA_BUS_ADDR(p)     ((u32)(unsigned long)(p) | 0xC0000000)
+
+// DMA CS Register
+#define DMA_CS_RESET        (1U << 31)
+#define DMA_CS_ABORT        (1 << 30)
+#define DMA_CS_WAIT_WRITES  (1 << 28)
+#define DMA_CS_PANIC_PRIORITY__SHIFT    20
+#define DMA_CS_PRIORITY__SHIFT          16
+#define DMA_CS_ERROR        (1 << 8)
+#define DMA_CS_INT          (1 << 2)
+#define DMA_CS_END          (1 << 1)
+#define DMA_CS_ACTIVE       (1 << 0)
+
+// DMA TI Register
+#define DMA_TI_NO_WIDE_BURSTS   (1 << 26)
+#define DMA_TI_PERMAP__SHIFT    16
+#define DMA_TI_SRC_DREQ     (1 << 10)
+#define DMA_TI_SRC_INC      (1 << 8)
+#define DMA_TI_DEST_DREQ    (1 << 6)
+#define DMA_TI_DEST_INC     (1 << 4)
+#define DMA_TI_WAIT_RESP    (1 << 3)
+#define DMA_TI_INTEN        (1 << 0)
+
+// DREQ peripheral numbers of SPI0
+#define DMA_PERMAP_SPI0_TX  6
+#define DMA_PERMAP_SPI0_RX  7
+
+// Linux owns the other channels: the device tree overlay (raspi4-rpmsg.dtso)
+// takes these two out of its brcm,dma-channel-mask.
+#ifndef SPI0_DMA_TX_CHANNEL
+#define SPI0_DMA_TX_CHANNEL 4
+#endif
+
+// The completion interrupt comes from the RX channel
+#ifndef SPI0_DMA_RX_CHANNEL
+#define SPI0_DMA_RX_CHANNEL 5
+#endif
+
+// Transfers shorter than this are done by polling the FIFO: setting up the
+// control blocks and the cache maintenance cost more than a register access.
+#ifndef SPI0_DMA_THRESHOLD
+#define SPI0_DMA_THRESHOLD  32
+#endif
+
+// Called from the DMA interrupt when an asynchronous transfer has completed
+typedef void (*spi0_callback)(void *arg);
+
 void spi0_init();
 void spi0_chip_select(u8 chip_select);
 void spi0_chip_deselect (u8 chip_select);
@@ -56,4 +134,25 @@ void spi0_send_recv(u8 chip_select, u8 *sbuffer, u8 *rbuffer, u32 size);
 void spi0_send(u8 chip_select, u8 *data, u32 size);
 void spi0_recv(u8 chip_select, u8 *data, u32 size);
 
+// Run nops short commands stored back to back in buffer, oplen[i] bytes
+// each, in a single transfer. Every command gets its own chip select cycle
+// and its received bytes overwrite it in buffer.
+void spi0_send_recv_ops(u8 chip_select, u8 *buffer, const u8 *oplen, u32 nops);
+
+// DMA transfers. spi0_send_recv_async() returns -1 when the size is out of
+// range or a transfer is still running. The callback is invoked from
+// spi0_dma_isr(), which must be registered for the RX channel interrupt; with
+// a NULL callback, completion is detected by polling spi0_dma_busy().
+int spi0_send_recv_async(u8 chip_select, u8 *sbuffer, u8 *rbuffer, u32 size,
+                         spi0_callback callback, void *arg);
+int spi0_dma_busy(void);
+void spi0_dma_isr(void);
+
+// Fill the TX (header + data) and RX control blocks of a transfer, all
+// addresses are bus addresses. header_bus points to three words: the SPI
+// header, a zero fill word and a sink word; a buffer address of 0 selects
+// the fill word (TX) or the sink word (RX). Kept free of register accesses.
+void spi0_dma_build_cbs(struct DmaControlBlock tx[2], struct DmaControlBlock *rx,
+                        u32 header_bus, u32 sbuffer_bus, u32 rbuffer_bus, u32 size, int inten);
+
 #endif
\ No newline at end of file
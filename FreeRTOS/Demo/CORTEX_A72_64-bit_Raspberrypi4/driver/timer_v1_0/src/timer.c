@@ -3,6 +3,7 @@
 #include "printf.h"
 #include "bparameters.h"
 #include "FreeRTOSConfig.h"
+#include "hrtimer.h"
 
 
 
@@ -55,13 +56,9 @@ u64 timer_get_ticks() {
 }
 
 
-//sleep in milliseconds.
+//sleep in milliseconds, other tasks run meanwhile.
 void timer_sleep(u32 ms) {
-    u64 start = timer_get_ticks();
-
-    while(timer_get_ticks() < start + (ms * 1000)) {
-
-    }
+    hrtimer_delay_us((uint64_t)ms * 1000U);
 }
 
 
@@ -79,7 +76,5 @@ u32 HAL_GetTick(void) {
 }
 
 void HAL_Delay(unsigned int ms) {
-    unsigned long start = HAL_GetTick();
-
-    while(HAL_GetTick() < start + (ms * 1000));
+    hrtimer_delay_us((uint64_t)ms * 1000U);
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 extern void invalidate_dcache_all(void);
 extern struct ptc_t pt_config[NUM_PT_CONFIGS];
 
+static void set_regs(void);
+static void enable_mmu(void);
+
 static volatile uint64_t sctlr_el1 = 0x0ULL;
 
 /* Page table descriptors and entries */
@@ -49,6 +52,16 @@ void init_regs(void)
     asm volatile ("dsb sy");
     asm volatile ("isb");
 
+    set_regs();
+
+    return;
+}
+
+/* MAIR, TTBR and TCR configuration, common to all cores */
+static void set_regs(void)
+{
+    volatile uint64_t reg;
+
     /* MAIR_EL1 configuration */
     reg = ((0xFFULL << (TYPE_MEM_CACHE_WB * 8)) |   /* Write-back cache enabled memory */
            (0xBBULL << (TYPE_MEM_CACHE_WT * 8)) |   /* Write-through cache enabled memory */
@@ -147,11 +160,19 @@ void set_pt(struct ptc_t *config)
 /* Update page tables */
 void update_pt(void)
 {
-    volatile uint64_t reg;
-
     /* Set page pables */
     set_pt(&pt_config[0]);
 
+    enable_mmu();
+
+    return;
+}
+
+/* Enable MMU with the page tables set by update_pt() */
+static void enable_mmu(void)
+{
+    volatile uint64_t reg;
+
     /* TTBR{0,1}_EL1 configuration */
     asm volatile ("msr ttbr0_el1, %0" : : "r" (0x0ULL));
     asm volatile ("msr ttbr0_el1, %0" : : "r" ((uint64_t)&l1ptd[0]));
@@ -182,5 +203,35 @@ void configure_mmu(void)
 
     return;
 }
+
+/*
+ * MMU configuration for the other cores, to be called after configure_mmu()
+ * has completed on the first core.  The page tables are shared, and the data
+ * cache is not invalidated by set/way here since that would discard lines
+ * the first core has not written back yet.
+ */
+void configure_mmu_secondary(void)
+{
+    volatile uint64_t reg;
+
+    /* Disable MMU */
+    reg = 0x0ULL;
+    asm volatile ("msr sctlr_el1, %0" : : "r" (reg));
+    asm volatile ("isb");
+
+    /* TLB invalidation */
+    asm volatile ("tlbi vmalle1");
+
+    /* Instruction cache flush */
+    asm volatile ("ic iallu");
+
+    asm volatile ("dsb sy");
+    asm volatile ("isb");
+
+    set_regs();
+    enable_mmu();
+
+    return;
+}
 /*-----------------------------------------------------------*/
 
@@ -0,0 +1,450 @@
+/* enc28j60_sim.c */
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "enc28j60.h"
+#include "enc28j60_sim.h"
+
+#define SIM_MEMSIZE         (PKTMEM_END + 1)
+#define SIM_REVID           (0x06U)
+
+/* Bit time on the wire at 10 Mb/s, and the preamble, CRC and gap of a frame */
+#define SIM_WIRE_NS         (100U)
+#define SIM_WIRE_EXTRA      (8U + 4U + 12U)
+
+/* Register numbers, without the bank and the PHY/MAC bit */
+#define R(reg)              GETADDR(reg)
+#define SIM_COMMON          (0x1bU)
+
+enum sim_state {
+    SIM_IDLE,       /* Chip select high */
+    SIM_CMD,        /* Next byte is a command */
+    SIM_RCR,
+    SIM_WCR,
+    SIM_BFS,
+    SIM_BFC,
+    SIM_RBM,
+    SIM_WBM,
+    SIM_DONE        /* Command complete, bytes until chip select are ignored */
+};
+
+struct enc_sim_stats enc_sim_stats;
+
+static struct {
+    uint8_t banks[4][SIM_COMMON];
+    uint8_t common[0x20U - SIM_COMMON];
+    uint16_t phy[0x20];
+    uint8_t mem[SIM_MEMSIZE];
+
+    enum sim_state state;
+    uint8_t addr;       /* Register of the command */
+    uint32_t index;     /* Bytes of the command after the opcode */
+
+    uint64_t now;
+    uint64_t tx_due;    /* Completion of the transmission, 0 when idle */
+    enc_sim_tx_fn tx_hook;
+} sim;
+/*-----------------------------------------------------------*/
+
+static uint8_t *reg(uint8_t bank, uint8_t addr)
+{
+    if (addr >= SIM_COMMON) {
+        return &sim.common[addr - SIM_COMMON];
+    }
+    return &sim.banks[bank][addr];
+}
+
+static uint8_t *greg(uint8_t ctrlreg)
+{
+    return reg(GETBANK(ctrlreg), GETADDR(ctrlreg));
+}
+
+static uint16_t greg16(uint8_t ctrlreg_low)
+{
+    return (uint16_t)(greg(ctrlreg_low)[0] | (greg(ctrlreg_low)[1] << 8)) & PKTMEM_END;
+}
+
+static void sreg16(uint8_t ctrlreg_low, uint16_t value)
+{
+    greg(ctrlreg_low)[0] = value & 0xffU;
+    greg(ctrlreg_low)[1] = value >> 8;
+}
+
+static uint8_t bank(void)
+{
+    return *reg(0, R(ENC_ECON1)) & ECON1_BSEL_MASK;
+}
+
+/* The MAC and MII registers answer RCR after a dummy byte */
+static bool is_phymac(uint8_t bank, uint8_t addr)
+{
+    return (bank == 2U && addr <= R(ENC_MIRDH)) ||
+           (bank == 3U && (addr <= R(ENC_MAADR2) || addr == R(ENC_MISTAT)));
+}
+/*-----------------------------------------------------------*/
+
+static void tick(uint64_t ns)
+{
+    sim.now += ns;
+    if (sim.tx_due != 0U && sim.now >= sim.tx_due) {
+        uint16_t txst = greg16(ENC_ETXSTL);
+        uint16_t txnd = greg16(ENC_ETXNDL);
+        uint16_t len = (uint16_t)(txnd - txst);
+        uint16_t tsv = (uint16_t)(txnd + 1U);
+        uint8_t status[7] = { len & 0xffU, len >> 8, 0x80U, 0, 0, 0, 0 };
+        unsigned i;
+
+        /* The transmit status vector follows the frame */
+        for (i = 0; i < sizeof(status); i++) {
+            sim.mem[(tsv + i) & PKTMEM_END] = status[i];
+        }
+        sim.tx_due = 0;
+        *reg(0, R(ENC_ECON1)) &= ~ECON1_TXRTS;
+        *reg(0, R(ENC_EIR)) |= EIR_TXIF;
+        enc_sim_stats.tx_frames++;
+        if (sim.tx_hook != NULL) {
+            sim.tx_hook(&sim.mem[(txst + 1U) & PKTMEM_END], len);
+        }
+    }
+}
+
+static void tx_start(void)
+{
+    uint16_t len = (uint16_t)(greg16(ENC_ETXNDL) - greg16(ENC_ETXSTL));
+
+    sim.tx_due = sim.now + (uint64_t)(len + SIM_WIRE_EXTRA) * 8U * SIM_WIRE_NS;
+}
+/*-----------------------------------------------------------*/
+
+static void wr(uint8_t addr, uint8_t value)
+{
+    uint8_t b = bank();
+    uint8_t *r = reg(b, addr);
+    uint8_t old = *r;
+
+    switch (addr) {
+    case R(ENC_EIR):
+        /* PKTIF follows EPKTCNT */
+        *r = (value & ~EIR_PKTIF) | (old & EIR_PKTIF);
+        return;
+    case R(ENC_ESTAT):
+        return;
+    case R(ENC_ECON2):
+        if ((value & ECON2_PKTDEC) != 0U) {
+            uint8_t *cnt = greg(ENC_EPKTCNT);
+
+            if (*cnt != 0U && --*cnt == 0U) {
+                *reg(0, R(ENC_EIR)) &= ~EIR_PKTIF;
+            }
+        }
+        *r = value & ~ECON2_PKTDEC;
+        return;
+    case R(ENC_ECON1):
+        *r = value;
+        if ((value & ECON1_TXRST) != 0U) {
+            sim.tx_due = 0;
+            *r &= ~ECON1_TXRTS;
+        } else if ((value & ECON1_TXRTS) != 0U && (old & ECON1_TXRTS) == 0U) {
+            tx_start();
+        } else if ((value & ECON1_TXRTS) == 0U) {
+            sim.tx_due = 0;
+        }
+        return;
+    default:
+        break;
+    }
+
+    *r = value;
+    if (b == 0U && addr == R(ENC_ERXSTH)) {
+        sreg16(ENC_ERXWRPTL, greg16(ENC_ERXSTL));
+    } else if (b == 2U && addr == R(ENC_MICMD) && (value & MICMD_MIIRD) != 0U) {
+        uint16_t data = sim.phy[*greg(ENC_MIREGADR) & 0x1fU];
+
+        *greg(ENC_MIRDL) = data & 0xffU;
+        *greg(ENC_MIRDH) = data >> 8;
+    } else if (b == 2U && addr == R(ENC_MIWRH)) {
+        sim.phy[*greg(ENC_MIREGADR) & 0x1fU] = (uint16_t)(*greg(ENC_MIWRL) | (value << 8));
+    }
+}
+
+static uint8_t rd(uint8_t addr)
+{
+    uint8_t b = bank();
+
+    if (b == 3U && addr == R(ENC_EREVID)) {
+        return SIM_REVID;
+    }
+    return *reg(b, addr);
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t rbm(void)
+{
+    uint16_t p = greg16(ENC_ERDPTL);
+    uint8_t data = sim.mem[p];
+
+    if ((*reg(0, R(ENC_ECON2)) & ECON2_AUTOINC) != 0U) {
+        /* Reads wrap at the end of the RX FIFO */
+        if (p == greg16(ENC_ERXNDL)) {
+            p = greg16(ENC_ERXSTL);
+        } else {
+            p = (p + 1U) & PKTMEM_END;
+        }
+        sreg16(ENC_ERDPTL, p);
+    }
+    return data;
+}
+
+static void wbm(uint8_t data)
+{
+    uint16_t p = greg16(ENC_EWRPTL);
+
+    sim.mem[p] = data;
+    if ((*reg(0, R(ENC_ECON2)) & ECON2_AUTOINC) != 0U) {
+        sreg16(ENC_EWRPTL, (p + 1U) & PKTMEM_END);
+    }
+}
+
+static void cs_low(void)
+{
+    if (sim.state == SIM_IDLE) {
+        sim.state = SIM_CMD;
+        enc_sim_stats.commands++;
+    }
+}
+
+static void cs_high(void)
+{
+    sim.state = SIM_IDLE;
+}
+
+static uint8_t spi_byte(uint8_t out)
+{
+    uint8_t in = 0;
+
+    enc_sim_stats.bytes++;
+    tick(8000000000ULL / ENC_SIM_SPI_HZ);
+
+    switch (sim.state) {
+    case SIM_CMD:
+        sim.addr = out & ENC_ADDR_MASK;
+        sim.index = 0;
+        switch (out & 0xe0U) {
+        case ENC_RCR:
+            sim.state = SIM_RCR;
+            break;
+        case ENC_RBM & 0xe0U:
+            sim.state = SIM_RBM;
+            break;
+        case ENC_WCR:
+            sim.state = SIM_WCR;
+            break;
+        case ENC_WBM & 0xe0U:
+            sim.state = SIM_WBM;
+            break;
+        case ENC_BFS:
+            sim.state = SIM_BFS;
+            break;
+        case ENC_BFC:
+            sim.state = SIM_BFC;
+            break;
+        default:
+            sim.state = SIM_DONE;
+            break;
+        }
+        if (out == ENC_SRC) {
+            memset(sim.banks, 0, sizeof(sim.banks));
+            memset(sim.common, 0, sizeof(sim.common));
+            *reg(0, R(ENC_ESTAT)) = ESTAT_CLKRDY;
+            sim.tx_due = 0;
+        }
+        break;
+    case SIM_RCR:
+        if (sim.index++ == 0U && is_phymac(bank(), sim.addr)) {
+            break;
+        }
+        in = rd(sim.addr);
+        sim.state = SIM_DONE;
+        break;
+    case SIM_WCR:
+        wr(sim.addr, out);
+        sim.state = SIM_DONE;
+        break;
+    case SIM_BFS:
+        wr(sim.addr, rd(sim.addr) | out);
+        sim.state = SIM_DONE;
+        break;
+    case SIM_BFC:
+        wr(sim.addr, rd(sim.addr) & ~out);
+        sim.state = SIM_DONE;
+        break;
+    case SIM_RBM:
+        in = rbm();
+        break;
+    case SIM_WBM:
+        wbm(out);
+        break;
+    default:
+        break;
+    }
+    return in;
+}
+/*-----------------------------------------------------------*/
+
+/* SPI callbacks of enc28j60.h, as encspi.c implements them on SPI0 */
+
+void ENC_SPI_Select(bool select)
+{
+    if (select) {
+        cs_low();
+    } else {
+        cs_high();
+    }
+}
+
+void ENC_SPI_SendBuf(uint8_t *master2slave, uint8_t *slave2master, uint16_t bufferSize)
+{
+    uint16_t i;
+
+    enc_sim_stats.transfers++;
+    cs_low();
+    for (i = 0; i < bufferSize; i++) {
+        uint8_t in = spi_byte(master2slave != NULL ? master2slave[i] : 0U);
+
+        if (slave2master != NULL) {
+            slave2master[i] = in;
+        }
+    }
+    cs_high();
+}
+
+void ENC_SPI_SendOps(uint8_t *buffer, const uint8_t *oplen, uint8_t nops)
+{
+    uint8_t op;
+    uint8_t i;
+
+    enc_sim_stats.transfers++;
+    for (op = 0; op < nops; op++) {
+        cs_low();
+        for (i = 0; i < oplen[op]; i++) {
+            buffer[i] = spi_byte(buffer[i]);
+        }
+        cs_high();
+        buffer += oplen[op];
+    }
+}
+
+void ENC_SPI_Send(uint8_t command)
+{
+    enc_sim_stats.transfers++;
+    cs_low();
+    spi_byte(command);
+    cs_high();
+}
+
+void ENC_SPI_SendWithoutSelection(uint8_t command)
+{
+    enc_sim_stats.transfers++;
+    spi_byte(command);
+}
+/*-----------------------------------------------------------*/
+
+/* Time services of the driver */
+
+void HAL_Delay(volatile uint32_t Delay)
+{
+    tick((uint64_t)Delay * 1000000U);
+}
+
+/* Each call costs a microsecond, so that busy-waits on the tick end */
+uint32_t HAL_GetTick(void)
+{
+    tick(1000U);
+    return (uint32_t)(sim.now / 1000000U);
+}
+
+void hrtimer_delay_us(uint32_t us)
+{
+    tick((uint64_t)us * 1000U);
+}
+/*-----------------------------------------------------------*/
+
+void enc_sim_reset(void)
+{
+    enc_sim_tx_fn hook = sim.tx_hook;
+
+    memset(&sim, 0, sizeof(sim));
+    memset(&enc_sim_stats, 0, sizeof(enc_sim_stats));
+    sim.tx_hook = hook;
+    *reg(0, R(ENC_ESTAT)) = ESTAT_CLKRDY;
+}
+
+int enc_sim_rx(const uint8_t *frame, uint16_t len)
+{
+    uint16_t start = greg16(ENC_ERXSTL);
+    uint16_t end = greg16(ENC_ERXNDL);
+    uint16_t size = (uint16_t)(end - start + 1U);
+    uint16_t wrpt = greg16(ENC_ERXWRPTL);
+    uint16_t rdpt = greg16(ENC_ERXRDPTL);
+    uint16_t space = (uint16_t)((rdpt - wrpt + size) % size);
+    uint16_t need = (uint16_t)((6U + len + 4U + 1U) & ~1U);
+    uint16_t next = (uint16_t)(wrpt + need > end ? wrpt + need - size : wrpt + need);
+    uint8_t hdr[6];
+    uint8_t *cnt = greg(ENC_EPKTCNT);
+    uint32_t i;
+
+    if ((*reg(0, R(ENC_ECON1)) & ECON1_RXEN) == 0U || need >= space || *cnt == 0xffU) {
+        enc_sim_stats.rx_dropped++;
+        return -1;
+    }
+
+    /* Next packet pointer and receive status vector, then the frame and its
+    CRC */
+    hdr[0] = next & 0xffU;
+    hdr[1] = next >> 8;
+    hdr[2] = (len + 4U) & 0xffU;
+    hdr[3] = (len + 4U) >> 8;
+    hdr[4] = RXSTAT_OK;
+    hdr[5] = 0;
+    for (i = 0; i < need; i++) {
+        uint8_t b = i < 6U ? hdr[i] : (i < 6U + len ? frame[i - 6U] : 0U);
+
+        sim.mem[wrpt] = b;
+        wrpt = wrpt == end ? start : (uint16_t)(wrpt + 1U);
+    }
+    sreg16(ENC_ERXWRPTL, next);
+    (*cnt)++;
+    *reg(0, R(ENC_EIR)) |= EIR_PKTIF;
+    enc_sim_stats.rx_frames++;
+    return 0;
+}
+
+int enc_sim_int_pending(void)
+{
+    uint8_t eie = *reg(0, R(ENC_EIE));
+    uint8_t eir = *reg(0, R(ENC_EIR));
+
+    return (eie & EIE_INTIE) != 0U && (eie & eir & 0x7bU) != 0U;
+}
+
+uint64_t enc_sim_now(void)
+{
+    return sim.now;
+}
+
+void enc_sim_advance(uint64_t ns)
+{
+    tick(ns);
+}
+
+uint64_t enc_sim_tx_due(void)
+{
+    return sim.tx_due;
+}
+
+void enc_sim_set_tx_hook(enc_sim_tx_fn fn)
+{
+    sim.tx_hook = fn;
+}
+/*-----------------------------------------------------------*/
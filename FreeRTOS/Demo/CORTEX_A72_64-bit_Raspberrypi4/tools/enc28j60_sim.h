@@ -0,0 +1,58 @@
+/* enc28j60_sim.h */
+#ifndef ENC28J60_SIM_H
+#define ENC28J60_SIM_H
+
+#include <stdint.h>
+
+/*
+ * Host model of an ENC28J60 behind the ENC_SPI_* callbacks of enc28j60.c, for
+ * the host benchmarks of the driver.  It decodes the SPI commands (RCR, WCR,
+ * BFS, BFC, RBM, WBM, SRC) against a register file, the 8 KB packet memory and
+ * the PHY registers, receives the frames given to enc_sim_rx() into the RX
+ * FIFO and transmits the frames the driver starts with ECON1.TXRTS.
+ *
+ * Time is simulated: each byte on the bus takes 8 SPI clocks, a transmission
+ * takes the wire time of the frame at 10 Mb/s, and HAL_Delay(), HAL_GetTick()
+ * and hrtimer_delay_us() use the same clock.  The MII completes at once.
+ */
+
+#ifndef ENC_SIM_SPI_HZ
+#define ENC_SIM_SPI_HZ      (10000000U)
+#endif
+
+struct enc_sim_stats {
+    uint64_t transfers;     /* ENC_SPI_* calls, each one is a spi0_* transfer */
+    uint64_t commands;      /* Commands, one per chip select */
+    uint64_t bytes;         /* Bytes on the bus */
+    uint64_t rx_frames;     /* Frames stored in the RX FIFO */
+    uint64_t rx_dropped;    /* Frames dropped, the RX FIFO was full */
+    uint64_t tx_frames;     /* Frames transmitted */
+};
+
+extern struct enc_sim_stats enc_sim_stats;
+
+/* Transmitted frame, without the control byte and the CRC */
+typedef void (*enc_sim_tx_fn)(const uint8_t *frame, uint16_t len);
+
+/* Power on reset.  Also clears the statistics and the simulated clock. */
+void enc_sim_reset(void);
+
+/* Receive a frame (without its CRC).  Returns -1 when it does not fit in the
+RX FIFO. */
+int enc_sim_rx(const uint8_t *frame, uint16_t len);
+
+/* INT pin asserted: EIE.INTIE and an enabled flag in EIR */
+int enc_sim_int_pending(void);
+
+/* Simulated time, ns */
+uint64_t enc_sim_now(void);
+
+/* Let time pass, completes the transmission in progress when it is due */
+void enc_sim_advance(uint64_t ns);
+
+/* Time at which the transmission in progress completes, 0 if none */
+uint64_t enc_sim_tx_due(void);
+
+void enc_sim_set_tx_hook(enc_sim_tx_fn fn);
+
+#endif /* ENC28J60_SIM_H */
@@ -0,0 +1,193 @@
+/* enc_rx_bench.c */
+/*
+ * Host benchmark of the ENC28J60 receive path of enc28j60.c, driven from the
+ * simulated controller of enc28j60_sim.c.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -I../driver/enc28j60_ethernet_v1_0/src -I../uart/src \
+ *       enc_rx_bench.c enc28j60_sim.c ../driver/enc28j60_ethernet_v1_0/src/enc28j60.c -o enc_rx_bench
+ *   ./enc_rx_bench
+ *
+ * Bursts of frames are stored in the RX FIFO, then serviced the way
+ * prvEMACHandlerTask() does after the interrupt: ENC_IRQHandler(), EPKTCNT
+ * and ENC_GetReceivedFrameBuf() until the FIFO is empty, and INTIE set again.
+ * For each frame size and burst length it reports the host CPU time, the SPI
+ * transfers and commands, and the time on the SPI bus at ENC_SIM_SPI_HZ.  The
+ * frames read back are compared with the ones sent.
+ *
+ * The "idle" line is one EPKTCNT check with no frame pending: the cost of
+ * every pass of a polling loop, which the interrupt driven task no longer
+ * pays.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "enc28j60.h"
+#include "enc28j60_sim.h"
+
+#define RX_BENCH_ROUNDS     (20000U)
+#define RX_BENCH_MAXBURST   (3U)
+
+static const uint16_t rx_bench_sizes[] = { 60U, 590U, 1514U };
+static const unsigned rx_bench_bursts[] = { 1U, 3U };
+
+static ENC_HandleTypeDef handle;
+static uint8_t mac[6] = { 0xc0, 0xff, 0xee, 0xc0, 0xff, 0xee };
+static uint8_t rx_buf[RX_BENCH_MAXBURST][MAX_FRAMELEN];
+static uint8_t tx_frame[MAX_FRAMELEN];
+
+struct rx_bench_result {
+    double cpu_ns;
+    double transfers;
+    double commands;
+    double bus_us;
+};
+/*-----------------------------------------------------------*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void start(void)
+{
+    enc_sim_reset();
+    memset(&handle, 0, sizeof(handle));
+    handle.Init.DuplexMode = ETH_MODE_HALFDUPLEX;
+    handle.Init.MACAddr = mac;
+    handle.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
+    handle.Init.InterruptEnableBits = EIE_LINKIE | EIE_PKTIE | EIE_TXIE | EIE_TXERIE;
+    if (!ENC_Start(&handle)) {
+        fprintf(stderr, "ENC_Start failed\n");
+        exit(1);
+    }
+    ENC_SetMacAddr(&handle);
+    ENC_EnableInterrupts(EIE_INTIE);
+}
+
+/* prvEMACHandlerTask() and xNetworkInterfaceInput(), without the IP stack */
+static unsigned service(void)
+{
+    unsigned n = 0;
+
+    ENC_IRQHandler(&handle);
+    if ((handle.interruptFlags & EIR_PKTIF) != 0) {
+        for (ENC_GetPkcnt(&handle); handle.pktCnt != 0; ENC_GetPkcnt(&handle)) {
+            while (handle.pktCnt-- != 0) {
+                if (ENC_GetReceivedFrameBuf(&handle, rx_buf[n % RX_BENCH_MAXBURST])) {
+                    n++;
+                }
+            }
+        }
+    }
+    ENC_EnableInterrupts(EIE_INTIE);
+    return n;
+}
+/*-----------------------------------------------------------*/
+
+static struct rx_bench_result run(uint16_t size, unsigned burst)
+{
+    struct rx_bench_result res;
+    struct enc_sim_stats before;
+    uint64_t cpu = 0, bus = 0, transfers = 0, commands = 0, t, sim_t;
+    unsigned r, i, frames = 0;
+
+    start();
+    for (r = 0; r < RX_BENCH_ROUNDS; r++) {
+        for (i = 0; i < burst; i++) {
+            tx_frame[0] = (uint8_t)r;
+            tx_frame[1] = (uint8_t)i;
+            if (enc_sim_rx(tx_frame, size) != 0) {
+                fprintf(stderr, "RX FIFO full\n");
+                exit(1);
+            }
+        }
+        if (!enc_sim_int_pending()) {
+            fprintf(stderr, "no interrupt\n");
+            exit(1);
+        }
+
+        before = enc_sim_stats;
+        sim_t = enc_sim_now();
+        t = now_ns();
+        i = service();
+        cpu += now_ns() - t;
+        bus += enc_sim_now() - sim_t;
+        transfers += enc_sim_stats.transfers - before.transfers;
+        commands += enc_sim_stats.commands - before.commands;
+
+        if (i != burst || handle.RxFrameInfos.length != size) {
+            fprintf(stderr, "%u of %u frames received\n", i, burst);
+            exit(1);
+        }
+        for (i = 0; i < burst; i++) {
+            tx_frame[0] = (uint8_t)r;
+            tx_frame[1] = (uint8_t)i;
+            if (memcmp(rx_buf[i], tx_frame, size) != 0) {
+                fprintf(stderr, "frame %u of round %u differs\n", i, r);
+                exit(1);
+            }
+        }
+        frames += burst;
+    }
+
+    res.cpu_ns = (double)cpu / frames;
+    res.transfers = (double)transfers / frames;
+    res.commands = (double)commands / frames;
+    res.bus_us = (double)bus / frames / 1000.0;
+    return res;
+}
+
+static struct rx_bench_result run_idle(void)
+{
+    struct rx_bench_result res;
+    struct enc_sim_stats before;
+    uint64_t cpu, sim_t;
+    unsigned r;
+
+    start();
+    before = enc_sim_stats;
+    sim_t = enc_sim_now();
+    cpu = now_ns();
+    for (r = 0; r < RX_BENCH_ROUNDS; r++) {
+        ENC_GetPkcnt(&handle);
+    }
+    cpu = now_ns() - cpu;
+
+    res.cpu_ns = (double)cpu / RX_BENCH_ROUNDS;
+    res.transfers = (double)(enc_sim_stats.transfers - before.transfers) / RX_BENCH_ROUNDS;
+    res.commands = (double)(enc_sim_stats.commands - before.commands) / RX_BENCH_ROUNDS;
+    res.bus_us = (double)(enc_sim_now() - sim_t) / RX_BENCH_ROUNDS / 1000.0;
+    return res;
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    struct rx_bench_result res;
+    unsigned i, j;
+
+    memset(tx_frame, 0x5a, sizeof(tx_frame));
+
+    printf("%6s %6s %14s %10s %10s %12s\n", "bytes", "burst", "cpu/frame", "transfers", "commands", "bus/frame");
+    for (i = 0; i < sizeof(rx_bench_sizes) / sizeof(rx_bench_sizes[0]); i++) {
+        for (j = 0; j < sizeof(rx_bench_bursts) / sizeof(rx_bench_bursts[0]); j++) {
+            res = run(rx_bench_sizes[i], rx_bench_bursts[j]);
+            printf("%6u %6u %11.1f ns %10.2f %10.2f %9.1f us\n", rx_bench_sizes[i], rx_bench_bursts[j],
+                   res.cpu_ns, res.transfers, res.commands, res.bus_us);
+        }
+    }
+    res = run_idle();
+    printf("%13s %11.1f ns %10.2f %10.2f %9.1f us\n", "idle",
+           res.cpu_ns, res.transfers, res.commands, res.bus_us);
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
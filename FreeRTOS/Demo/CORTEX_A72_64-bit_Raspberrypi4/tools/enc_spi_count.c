@@ -0,0 +1,161 @@
+/* enc_spi_count.c */
+/*
+ * Counts the SPI transfers (spi0_send_recv() and spi0_send_recv_ops() calls)
+ * and the ENC28J60 commands of each driver operation, and per received and
+ * transmitted frame, with the simulated controller of enc28j60_sim.c.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -I../driver/enc28j60_ethernet_v1_0/src -I../uart/src \
+ *       enc_spi_count.c enc28j60_sim.c ../driver/enc28j60_ethernet_v1_0/src/enc28j60.c -o enc_spi_count
+ *   ./enc_spi_count
+ *
+ * Any revision of enc28j60.c with the same API can be counted, for example
+ * the one before the commands were batched:
+ *   git show 4f99b1a:./../driver/enc28j60_ethernet_v1_0/src/enc28j60.c > /tmp/enc28j60.c
+ *   gcc -O2 -I../driver/enc28j60_ethernet_v1_0/src -I../uart/src \
+ *       enc_spi_count.c enc28j60_sim.c /tmp/enc28j60.c -o enc_spi_count_before
+ *
+ * transfers (commands)            before batching    batched
+ *   ENC_RestoreTXBuffer               4 (4)           1 (4)
+ *   ENC_Transmit, idle controller     8 (8)           1 (8)
+ *   ENC_IRQHandler, TX completion     8 (8)           4 (7)
+ *   ENC_IRQHandler, RX frame          4 (4)           2 (4)
+ *   received frame                   22 (20)         12 (18)
+ *   transmitted frame                23 (22)          9 (21)
+ * A received frame is the interrupt, one EPKTCNT check with the frame and
+ * one without, and INTIE set again.  A transmitted frame is the frame
+ * written and started, then its completion interrupt and INTIE.  The ENC28J60
+ * needs its chip select raised after every command, so a batch is one
+ * transfer but still one command per register access.  A buffer read or
+ * write is two transfers under one chip select, the opcode and the data,
+ * which is why a frame can count more transfers than commands.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "enc28j60.h"
+#include "enc28j60_sim.h"
+
+#define COUNT_FRAME         (590U)
+
+static ENC_HandleTypeDef handle;
+static uint8_t mac[6] = { 0xc0, 0xff, 0xee, 0xc0, 0xff, 0xee };
+static uint8_t frame[MAX_FRAMELEN];
+
+static struct enc_sim_stats mark;
+/*-----------------------------------------------------------*/
+
+static void count_start(void)
+{
+    mark = enc_sim_stats;
+}
+
+static void count_print(const char *what)
+{
+    printf("  %-32s %4llu (%llu)\n", what,
+           (unsigned long long)(enc_sim_stats.transfers - mark.transfers),
+           (unsigned long long)(enc_sim_stats.commands - mark.commands));
+}
+/*-----------------------------------------------------------*/
+
+static void start(void)
+{
+    enc_sim_reset();
+    memset(&handle, 0, sizeof(handle));
+    handle.Init.DuplexMode = ETH_MODE_HALFDUPLEX;
+    handle.Init.MACAddr = mac;
+    handle.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
+    handle.Init.InterruptEnableBits = EIE_LINKIE | EIE_PKTIE | EIE_TXIE | EIE_TXERIE;
+    if (!ENC_Start(&handle)) {
+        fprintf(stderr, "ENC_Start failed\n");
+        exit(1);
+    }
+    ENC_SetMacAddr(&handle);
+    ENC_EnableInterrupts(EIE_INTIE);
+}
+
+/* As prvEMACHandlerTask() and xNetworkInterfaceInput() */
+static void receive(void)
+{
+    ENC_IRQHandler(&handle);
+    for (ENC_GetPkcnt(&handle); handle.pktCnt != 0; ENC_GetPkcnt(&handle)) {
+        while (handle.pktCnt-- != 0) {
+            if (!ENC_GetReceivedFrameBuf(&handle, frame)) {
+                fprintf(stderr, "bad frame\n");
+                exit(1);
+            }
+        }
+    }
+    ENC_EnableInterrupts(EIE_INTIE);
+}
+
+static void transmit(void)
+{
+    if (ENC_RestoreTXBuffer(&handle, COUNT_FRAME) != ERR_OK) {
+        fprintf(stderr, "no TX slot\n");
+        exit(1);
+    }
+    ENC_WriteBuffer(frame, COUNT_FRAME);
+    handle.transmitLength = COUNT_FRAME;
+    ENC_Transmit(&handle);
+}
+
+static void tx_complete(void)
+{
+    enc_sim_advance(enc_sim_tx_due() - enc_sim_now());
+    if (!enc_sim_int_pending()) {
+        fprintf(stderr, "no TX interrupt\n");
+        exit(1);
+    }
+    ENC_IRQHandler(&handle);
+    ENC_EnableInterrupts(EIE_INTIE);
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    memset(frame, 0x5a, sizeof(frame));
+
+    printf("transfers (commands)\n");
+    start();
+
+    count_start();
+    if (ENC_RestoreTXBuffer(&handle, COUNT_FRAME) != ERR_OK) {
+        return 1;
+    }
+    count_print("ENC_RestoreTXBuffer");
+    ENC_WriteBuffer(frame, COUNT_FRAME);
+    handle.transmitLength = COUNT_FRAME;
+    count_start();
+    ENC_Transmit(&handle);
+    count_print("ENC_Transmit, idle controller");
+    enc_sim_advance(enc_sim_tx_due() - enc_sim_now());
+
+    count_start();
+    ENC_IRQHandler(&handle);
+    count_print("ENC_IRQHandler, TX completion");
+    ENC_EnableInterrupts(EIE_INTIE);
+
+    enc_sim_rx(frame, COUNT_FRAME);
+    count_start();
+    ENC_IRQHandler(&handle);
+    count_print("ENC_IRQHandler, RX frame");
+    ENC_GetPkcnt(&handle);
+    ENC_GetReceivedFrameBuf(&handle, frame);
+    ENC_EnableInterrupts(EIE_INTIE);
+
+    enc_sim_rx(frame, COUNT_FRAME);
+    count_start();
+    receive();
+    count_print("received frame");
+
+    count_start();
+    transmit();
+    tx_complete();
+    count_print("transmitted frame");
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,215 @@
+/* enc_tx_bench.c */
+/*
+ * Host benchmark of the ENC28J60 transmit path, with the driver of
+ * enc28j60.c and the simulated controller of enc28j60_sim.c.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -I../driver/enc28j60_ethernet_v1_0/src -I../uart/src \
+ *       enc_tx_bench.c enc28j60_sim.c ../driver/enc28j60_ethernet_v1_0/src/enc28j60.c -o enc_tx_bench
+ *   ./enc_tx_bench
+ *
+ * The IP-task side of xNetworkInterfaceOutput() is a queue of TX_BENCH_QUEUE
+ * frames.  The EMAC task side is the loop of prvEMACHandlerTask(): on the
+ * interrupt ENC_IRQHandler() and ENC_TransmitPoll(), then ENC_RestoreTXBuffer(),
+ * ENC_WriteBuffer() and ENC_Transmit() for the queued frames while a TX slot
+ * is free.  Simulated time passes with the SPI bytes and the wire time of the
+ * frames, the task is otherwise idle until the next completion.
+ *
+ * Two loads are run for each frame size:
+ *   single  one frame at a time, the next one is queued when the previous one
+ *           has left: the latency of an idle link.
+ *   stream  the queue is kept full: frames per second and the queueing
+ *           latency of a saturated link.
+ * The latency runs from the queueing of the frame to the end of its
+ * transmission, in simulated time.  "spi/frame" is the bus time the EMAC task
+ * spends writing a frame to the controller; before the frames were only
+ * queued by the IP-task, it was blocked on the SPI transfers for that long
+ * (plus the wait for the driver mutex).  The host CPU time of the EMAC task
+ * per frame is reported as well.  Every transmitted frame is checked against
+ * the one queued.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "enc28j60.h"
+#include "enc28j60_sim.h"
+
+#define TX_BENCH_FRAMES     (20000U)
+#define TX_BENCH_QUEUE      (16U)   /* ENC_TX_QUEUE_LENGTH */
+
+static const uint16_t tx_bench_sizes[] = { 60U, 590U, 1514U };
+
+static ENC_HandleTypeDef handle;
+static uint8_t mac[6] = { 0xc0, 0xff, 0xee, 0xc0, 0xff, 0xee };
+static uint8_t frame[MAX_FRAMELEN];
+
+/* Frames queued by the IP-task, by sequence number */
+static uint32_t queue_head;     /* Next to write to the controller */
+static uint32_t queue_tail;     /* Next to queue */
+static uint64_t queued_at[TX_BENCH_FRAMES];
+
+/* Transmitted frames */
+static uint32_t tx_done;
+static uint16_t tx_size;
+static uint64_t lat_sum;
+static uint64_t lat_max;
+
+struct tx_bench_result {
+    double fps;
+    double lat_us;
+    double lat_max_us;
+    double spi_us;
+    double cpu_ns;
+};
+/*-----------------------------------------------------------*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void fill(uint32_t seq)
+{
+    memcpy(frame, &seq, sizeof(seq));
+}
+
+static void transmitted(const uint8_t *data, uint16_t len)
+{
+    uint64_t lat;
+    uint32_t seq;
+
+    memcpy(&seq, data, sizeof(seq));
+    fill(seq);
+    if (seq != tx_done || len != tx_size || memcmp(data, frame, len) != 0) {
+        fprintf(stderr, "frame %u: got %u (%u bytes)\n", tx_done, seq, len);
+        exit(1);
+    }
+    lat = enc_sim_now() - queued_at[seq];
+    lat_sum += lat;
+    if (lat > lat_max) {
+        lat_max = lat;
+    }
+    tx_done++;
+}
+/*-----------------------------------------------------------*/
+
+static void start(void)
+{
+    enc_sim_set_tx_hook(transmitted);
+    enc_sim_reset();
+    memset(&handle, 0, sizeof(handle));
+    handle.Init.DuplexMode = ETH_MODE_HALFDUPLEX;
+    handle.Init.MACAddr = mac;
+    handle.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
+    handle.Init.InterruptEnableBits = EIE_LINKIE | EIE_PKTIE | EIE_TXIE | EIE_TXERIE;
+    if (!ENC_Start(&handle)) {
+        fprintf(stderr, "ENC_Start failed\n");
+        exit(1);
+    }
+    ENC_SetMacAddr(&handle);
+    ENC_EnableInterrupts(EIE_INTIE);
+}
+
+/* prvENCSendQueued(), returns the SPI bus time */
+static uint64_t send_queued(uint32_t *written)
+{
+    uint64_t t = enc_sim_now();
+
+    while (queue_head != queue_tail) {
+        if (ENC_RestoreTXBuffer(&handle, tx_size) == ERR_TIMEOUT) {
+            break;
+        }
+        fill(queue_head);
+        ENC_WriteBuffer(frame, tx_size);
+        handle.transmitLength = tx_size;
+        ENC_Transmit(&handle);
+        queue_head++;
+        (*written)++;
+    }
+    return enc_sim_now() - t;
+}
+/*-----------------------------------------------------------*/
+
+static struct tx_bench_result run(uint16_t size, int stream)
+{
+    struct tx_bench_result res;
+    uint64_t spi = 0, cpu = 0, t, t0;
+    uint32_t written = 0;
+    uint32_t depth = stream ? TX_BENCH_QUEUE : 1U;
+    int irq, tx;
+
+    start();
+    tx_size = size;
+    queue_head = queue_tail = 0;
+    tx_done = 0;
+    lat_sum = lat_max = 0;
+    t0 = enc_sim_now();
+
+    while (tx_done < TX_BENCH_FRAMES) {
+        /* The IP-task keeps queueing until the queue holds depth frames */
+        tx = 0;
+        while (queue_tail < TX_BENCH_FRAMES && queue_tail - tx_done < depth &&
+               queue_tail - queue_head < TX_BENCH_QUEUE) {
+            queued_at[queue_tail++] = enc_sim_now();
+            tx = 1;
+        }
+
+        irq = enc_sim_int_pending();
+        if (!irq && !tx) {
+            /* Nothing to do until the transmission in progress completes */
+            if (enc_sim_tx_due() == 0) {
+                fprintf(stderr, "stalled at frame %u\n", tx_done);
+                exit(1);
+            }
+            enc_sim_advance(enc_sim_tx_due() - enc_sim_now());
+            continue;
+        }
+
+        t = now_ns();
+        if (irq) {
+            ENC_IRQHandler(&handle);
+            ENC_TransmitPoll(&handle);
+        }
+        spi += send_queued(&written);
+        if (irq) {
+            ENC_EnableInterrupts(EIE_INTIE);
+        }
+        cpu += now_ns() - t;
+    }
+
+    res.fps = (double)TX_BENCH_FRAMES * 1e9 / (double)(enc_sim_now() - t0);
+    res.lat_us = (double)lat_sum / TX_BENCH_FRAMES / 1000.0;
+    res.lat_max_us = (double)lat_max / 1000.0;
+    res.spi_us = (double)spi / written / 1000.0;
+    res.cpu_ns = (double)cpu / written;
+    return res;
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    struct tx_bench_result res;
+    unsigned i;
+    int stream;
+
+    memset(frame, 0xa5, sizeof(frame));
+
+    printf("%6s %7s %10s %12s %12s %12s %14s\n", "bytes", "load", "frames/s", "latency", "max", "spi/frame", "cpu/frame");
+    for (i = 0; i < sizeof(tx_bench_sizes) / sizeof(tx_bench_sizes[0]); i++) {
+        for (stream = 0; stream < 2; stream++) {
+            res = run(tx_bench_sizes[i], stream);
+            printf("%6u %7s %10.0f %9.1f us %9.1f us %9.1f us %11.1f ns\n", tx_bench_sizes[i],
+                   stream ? "stream" : "single", res.fps, res.lat_us, res.lat_max_us, res.spi_us, res.cpu_ns);
+        }
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,527 @@
+/* latency_report.c */
+/*
+ * Linux side of the latency measurements (uart/src/latency.c): reads struct
+ * latency_shm and prints min/avg/p99/max of the interrupt entry, tick and
+ * wakeup latencies and of the critical sections, and the critical section
+ * call sites that keep interrupts masked longest.  Limits make it usable as a
+ * release gate: the exit status is 2 when one is exceeded.
+ *
+ * The demo must be built with configUSE_LATENCY_HARNESS 1 (FreeRTOSConfig.h).
+ *
+ * Build and run on the Raspberry Pi (or anywhere, for a dump):
+ *   gcc -O2 -I../uart/src latency_report.c -o latency_report
+ *   sudo ./latency_report                   since boot
+ *   sudo ./latency_report -d 60             over the next 60 s, e.g. while iperf runs
+ *   sudo ./latency_report -d 60 -L total:p99:20 -L critical:max:50
+ *   sudo ./latency_report -o lat.bin        save a dump, read it with -f lat.bin
+ *   addr2line -e uart.elf 0x...             source line of a critical section
+ *
+ * ip_event is how long events wait in the IP-task's queue.  To see what the
+ * deferred log (binlog.h) saves the IP-task, run the same load, e.g.
+ * "iperf -c <target> -p 5001 -t 60" against mainCREATE_TCP_THROUGHPUT_TASKS
+ * (main.c), on a build with ipconfigDEFERRED_LOGGING 0 and one with 1
+ * (FreeRTOSIPConfig.h), each with "-d 60", and compare the ip_event rows.
+ *
+ * The region is mapped from /dev/mem with O_SYNC, so it is read uncached; the
+ * target maps it write-through.  Percentiles come from the histogram, they are
+ * the upper bound of the bucket they fall in.  Over an interval, min and max
+ * are exact when they changed meanwhile and bucket bounds otherwise; the max
+ * of a call site is the one since boot.
+ */
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "latency.h"
+
+#define MAX_LIMITS      (16U)
+#define MAX_SITES       (LATENCY_MAX_CORES * LATENCY_MAX_SITES)
+
+enum lat_stat { STAT_MIN, STAT_AVG, STAT_P99, STAT_MAX };
+
+struct metric {
+    const char *name;
+    const char *what;
+    int per_core;       /* in struct latency_core, else in struct latency_harness */
+    size_t offset;
+};
+
+struct limit {
+    const struct metric *metric;
+    enum lat_stat stat;
+    double us;
+};
+
+struct site_row {
+    uint64_t site;
+    uint64_t count;
+    uint64_t ticks;
+    uint64_t max_ticks;
+};
+
+static const struct metric metrics[] = {
+    { "dispatch", "IRQ vector to handler", 1, offsetof(struct latency_core, dispatch) },
+    { "tick", "tick timer to vector", 1, offsetof(struct latency_core, tick) },
+    { "critical", "critical sections", 1, offsetof(struct latency_core, critical) },
+    { "timer_entry", "timer to vector", 0, offsetof(struct latency_harness, timer_entry) },
+    { "timer_handler", "timer to callback", 0, offsetof(struct latency_harness, timer_handler) },
+    { "wake", "callback to task", 0, offsetof(struct latency_harness, wake) },
+    { "total", "timer to task", 0, offsetof(struct latency_harness, total) },
+    { "ip_event", "event to IP-task", 0, offsetof(struct latency_harness, ip_event) },
+};
+#define NUM_METRICS (sizeof(metrics) / sizeof(metrics[0]))
+
+static const char *const stat_names[] = { "min", "avg", "p99", "max" };
+
+static struct latency_shm before, after;
+static struct limit limits[MAX_LIMITS];
+static uint32_t num_limits;
+static struct site_row sites[MAX_SITES];
+/*-----------------------------------------------------------*/
+
+/* Device memory takes aligned accesses only, so no memcpy() */
+static void copy64(void *dst, const volatile void *src, size_t size)
+{
+    const volatile uint64_t *s = src;
+    uint64_t *d = dst;
+    size_t i;
+
+    for (i = 0; i < size / sizeof(uint64_t); i++) {
+        d[i] = s[i];
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Reads the region into first, and after interval seconds into second */
+static int read_mem(struct latency_shm *first, struct latency_shm *second, unsigned interval)
+{
+    size_t len = (sizeof(*first) + 4095U) & ~(size_t)4095U;
+    void *map;
+    int fd;
+
+    fd = open("/dev/mem", O_RDONLY | O_SYNC);
+    if (fd < 0) {
+        perror("/dev/mem");
+        return -1;
+    }
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, (off_t)LATENCY_SHM_ADDR);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    copy64(first, map, sizeof(*first));
+    if (second != NULL) {
+        sleep(interval);
+        copy64(second, map, sizeof(*second));
+    }
+    munmap(map, len);
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int read_file(const char *path, struct latency_shm *lat)
+{
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    n = fread(lat, 1, sizeof(*lat), f);
+    fclose(f);
+    if (n != sizeof(*lat)) {
+        fprintf(stderr, "%s: %zu bytes, expected %zu\n", path, n, sizeof(*lat));
+        return -1;
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int write_file(const char *path, const struct latency_shm *lat)
+{
+    FILE *f = fopen(path, "wb");
+
+    if ((f == NULL) || (fwrite(lat, sizeof(*lat), 1, f) != 1)) {
+        perror(path);
+        return -1;
+    }
+    return fclose(f);
+}
+/*-----------------------------------------------------------*/
+
+static const struct latency_hist *hist_of(const struct latency_shm *lat, const struct metric *m, uint32_t core)
+{
+    const char *base = m->per_core ? (const char *)&lat->cores[core] : (const char *)&lat->harness;
+
+    return (const struct latency_hist *)(base + m->offset);
+}
+/*-----------------------------------------------------------*/
+
+/* What was added to a between the readings old and a, old may be NULL */
+static void hist_interval(struct latency_hist *a, const struct latency_hist *old)
+{
+    uint32_t i, lowest = LATENCY_HIST_BUCKETS, highest = 0U;
+
+    if (old == NULL) {
+        return;
+    }
+    a->count -= old->count;
+    a->sum -= old->sum;
+    for (i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        a->bucket[i] -= old->bucket[i];
+        if (a->bucket[i] != 0U) {
+            if (lowest == LATENCY_HIST_BUCKETS) {
+                lowest = i;
+            }
+            highest = i;
+        }
+    }
+    if (a->count == 0U) {
+        return;
+    }
+    if (a->min == old->min) {
+        a->min = latency_bucket_low(lowest);
+    }
+    if ((a->max == old->max) && (highest < LATENCY_HIST_BUCKETS - 1U)) {
+        a->max = latency_bucket_low(highest + 1U) - 1U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void hist_merge(struct latency_hist *dst, const struct latency_hist *src)
+{
+    uint32_t i;
+
+    if (src->count == 0U) {
+        return;
+    }
+    if ((dst->count == 0U) || (src->min < dst->min)) {
+        dst->min = src->min;
+    }
+    if (src->max > dst->max) {
+        dst->max = src->max;
+    }
+    dst->count += src->count;
+    dst->sum += src->sum;
+    for (i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        dst->bucket[i] += src->bucket[i];
+    }
+}
+/*-----------------------------------------------------------*/
+
+static double ticks_to_us(double ticks)
+{
+    return ticks * 1e6 / (double)after.cntfrq;
+}
+/*-----------------------------------------------------------*/
+
+static double stat_us(const struct latency_hist *h, enum lat_stat stat)
+{
+    uint64_t rank, seen = 0U, bound;
+    uint32_t i;
+
+    if (h->count == 0U) {
+        return 0.0;
+    }
+    switch (stat) {
+    case STAT_MIN:
+        return ticks_to_us((double)h->min);
+    case STAT_AVG:
+        return ticks_to_us((double)h->sum / (double)h->count);
+    case STAT_MAX:
+        return ticks_to_us((double)h->max);
+    default:
+        break;
+    }
+
+    rank = (uint64_t)((double)h->count * 0.99);
+    if (rank >= h->count) {
+        rank = h->count - 1U;
+    }
+    for (i = 0; i < LATENCY_HIST_BUCKETS - 1U; i++) {
+        seen += h->bucket[i];
+        if (seen > rank) {
+            break;
+        }
+    }
+    bound = (i == LATENCY_HIST_BUCKETS - 1U) ? h->max : latency_bucket_low(i + 1U) - 1U;
+    return ticks_to_us((double)((bound < h->max) ? bound : h->max));
+}
+/*-----------------------------------------------------------*/
+
+/* The metric over the interval, of one core or of all (core == num_cores) */
+static void metric_hist(const struct metric *m, uint32_t core, int interval, struct latency_hist *out)
+{
+    struct latency_hist h;
+    uint32_t c;
+
+    memset(out, 0, sizeof(*out));
+    for (c = 0; c < after.num_cores; c++) {
+        if ((core != after.num_cores) && (c != core)) {
+            continue;
+        }
+        if (!m->per_core && (c != 0U)) {
+            break;
+        }
+        h = *hist_of(&after, m, c);
+        hist_interval(&h, interval ? hist_of(&before, m, c) : NULL);
+        hist_merge(out, &h);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void print_row(const struct metric *m, const char *core, const struct latency_hist *h)
+{
+    printf("%-14s %-22s %4s %10llu %9.2f %9.2f %9.2f %9.2f\n", m->name, m->what, core,
+           (unsigned long long)h->count, stat_us(h, STAT_MIN), stat_us(h, STAT_AVG),
+           stat_us(h, STAT_P99), stat_us(h, STAT_MAX));
+}
+/*-----------------------------------------------------------*/
+
+static void print_metrics(int interval, int per_core)
+{
+    struct latency_hist h;
+    char core_name[12];
+    uint32_t i, core;
+
+    printf("\n%-14s %-22s %4s %10s %9s %9s %9s %9s\n", "metric", "", "core", "count", "min us",
+           "avg us", "p99 us", "max us");
+    for (i = 0; i < NUM_METRICS; i++) {
+        if (per_core && metrics[i].per_core) {
+            for (core = 0; core < after.num_cores; core++) {
+                snprintf(core_name, sizeof(core_name), "%u", core);
+                metric_hist(&metrics[i], core, interval, &h);
+                print_row(&metrics[i], core_name, &h);
+            }
+        } else {
+            metric_hist(&metrics[i], after.num_cores, interval, &h);
+            print_row(&metrics[i], metrics[i].per_core ? "all" : "-", &h);
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void add_site(uint32_t *num, const struct latency_site *s, int sign)
+{
+    uint32_t i;
+
+    for (i = 0; (i < *num) && (sites[i].site != s->site); i++) {
+    }
+    if (i == *num) {
+        if (*num == MAX_SITES) {
+            return;
+        }
+        memset(&sites[i], 0, sizeof(sites[i]));
+        sites[i].site = s->site;
+        (*num)++;
+    }
+    sites[i].count += (uint64_t)sign * s->count;
+    sites[i].ticks += (uint64_t)sign * s->ticks;
+    if ((sign > 0) && (s->max_ticks > sites[i].max_ticks)) {
+        sites[i].max_ticks = s->max_ticks;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int compare_sites(const void *a, const void *b)
+{
+    const struct site_row *sa = a, *sb = b;
+
+    if (sa->max_ticks != sb->max_ticks) {
+        return (sa->max_ticks > sb->max_ticks) ? -1 : 1;
+    }
+    return (sa->count > sb->count) ? -1 : (sa->count < sb->count);
+}
+/*-----------------------------------------------------------*/
+
+static void print_sites(int interval, uint32_t top)
+{
+    uint64_t full = 0U;
+    uint32_t num = 0U, core, i, shown = 0U;
+
+    for (core = 0; core < after.num_cores; core++) {
+        for (i = 0; i < LATENCY_MAX_SITES; i++) {
+            if (after.cores[core].sites[i].site != 0U) {
+                add_site(&num, &after.cores[core].sites[i], 1);
+            }
+            if (interval && (before.cores[core].sites[i].site != 0U)) {
+                add_site(&num, &before.cores[core].sites[i], -1);
+            }
+        }
+        full += after.cores[core].sites_full - (interval ? before.cores[core].sites_full : 0U);
+    }
+    qsort(sites, num, sizeof(sites[0]), compare_sites);
+
+    printf("\ncritical sections by longest, all cores:\n");
+    printf("%-18s %10s %9s %9s\n", "site", "count", "avg us", "max us");
+    for (i = 0; (i < num) && (shown < top); i++) {
+        if (sites[i].count == 0U) {
+            continue;
+        }
+        printf("0x%016llx %10llu %9.2f %9.2f\n", (unsigned long long)sites[i].site,
+               (unsigned long long)sites[i].count,
+               ticks_to_us((double)sites[i].ticks / (double)sites[i].count),
+               ticks_to_us((double)sites[i].max_ticks));
+        shown++;
+    }
+    if (full != 0U) {
+        printf("%llu sections not counted per site, the site table is full\n", (unsigned long long)full);
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* metric:stat:us */
+static int parse_limit(char *arg)
+{
+    struct limit *l;
+    char *stat, *us;
+    uint32_t i;
+
+    stat = strchr(arg, ':');
+    us = stat ? strchr(stat + 1, ':') : NULL;
+    if ((us == NULL) || (num_limits == MAX_LIMITS)) {
+        return -1;
+    }
+    *stat++ = '\0';
+    *us++ = '\0';
+    l = &limits[num_limits];
+    l->metric = NULL;
+    for (i = 0; i < NUM_METRICS; i++) {
+        if (strcmp(arg, metrics[i].name) == 0) {
+            l->metric = &metrics[i];
+        }
+    }
+    for (i = 0; i < sizeof(stat_names) / sizeof(stat_names[0]); i++) {
+        if (strcmp(stat, stat_names[i]) == 0) {
+            break;
+        }
+    }
+    if ((l->metric == NULL) || (i == sizeof(stat_names) / sizeof(stat_names[0]))) {
+        return -1;
+    }
+    l->stat = (enum lat_stat)i;
+    l->us = strtod(us, NULL);
+    num_limits++;
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int check_limits(int interval)
+{
+    struct latency_hist h;
+    const struct limit *l;
+    double value;
+    uint32_t i;
+    int failed = 0;
+
+    for (i = 0; i < num_limits; i++) {
+        l = &limits[i];
+        metric_hist(l->metric, after.num_cores, interval, &h);
+        value = stat_us(&h, l->stat);
+        if (h.count == 0U) {
+            printf("LIMIT %s %s: no samples\n", l->metric->name, stat_names[l->stat]);
+            failed = 1;
+        } else if (value > l->us) {
+            printf("LIMIT %s %s: %.2f us > %.2f us\n", l->metric->name, stat_names[l->stat], value, l->us);
+            failed = 1;
+        }
+    }
+    if ((num_limits != 0U) && !failed) {
+        printf("all %u limits met\n", num_limits);
+    }
+    return failed;
+}
+/*-----------------------------------------------------------*/
+
+static int valid(const struct latency_shm *lat)
+{
+    if ((lat->magic != LATENCY_MAGIC) || (lat->version != LATENCY_VERSION)) {
+        fprintf(stderr, "no latency measurements (magic %08x version %u), is the demo built with "
+                "configUSE_LATENCY_HARNESS 1?\n", lat->magic, lat->version);
+        return 0;
+    }
+    if ((lat->num_cores == 0U) || (lat->num_cores > LATENCY_MAX_CORES) || (lat->cntfrq == 0U)) {
+        fprintf(stderr, "corrupt latency measurements\n");
+        return 0;
+    }
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-d seconds] [-c] [-s sites] [-L metric:stat:us ...] [-f dump [-b dump]] [-o dump]\n"
+            "  -d sec   over the next sec seconds instead of since boot\n"
+            "  -c       one row per core for the per-core metrics\n"
+            "  -s n     critical section call sites to list (default 10)\n"
+            "  -L lim   fail (exit status 2) when a statistic exceeds a limit in us,\n"
+            "           stat is min, avg, p99 or max, metric is one of:\n", prog);
+    for (uint32_t i = 0; i < NUM_METRICS; i++) {
+        fprintf(stderr, "             %-14s %s\n", metrics[i].name, metrics[i].what);
+    }
+    fprintf(stderr, "  -f dump  read a dump instead of /dev/mem\n"
+            "  -b dump  with -f, a dump taken earlier to measure the interval from\n"
+            "  -o dump  write the (last) reading to a dump\n");
+    exit(1);
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *in = NULL, *base = NULL, *out = NULL;
+    unsigned seconds = 0U, top = 10U;
+    int per_core = 0, interval, opt;
+
+    while ((opt = getopt(argc, argv, "d:cs:L:f:b:o:")) != -1) {
+        switch (opt) {
+        case 'd': seconds = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'c': per_core = 1; break;
+        case 's': top = (unsigned)strtoul(optarg, NULL, 0); break;
+        case 'L':
+            if (parse_limit(optarg) != 0) {
+                usage(argv[0]);
+            }
+            break;
+        case 'f': in = optarg; break;
+        case 'b': base = optarg; break;
+        case 'o': out = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+    if ((base && !in) || (in && seconds)) {
+        usage(argv[0]);
+    }
+    interval = (base != NULL) || (seconds != 0U);
+
+    if (in) {
+        if ((read_file(in, &after) != 0) || (base && (read_file(base, &before) != 0))) {
+            return 1;
+        }
+    } else if (read_mem(seconds ? &before : &after, seconds ? &after : NULL, seconds) != 0) {
+        return 1;
+    }
+    if (!valid(&after) || (interval && !valid(&before))) {
+        return 1;
+    }
+    if (out && (write_file(out, &after) != 0)) {
+        return 1;
+    }
+
+    if (interval) {
+        printf("over an interval, %u cores, CNTFRQ %u Hz\n", after.num_cores, after.cntfrq);
+    } else {
+        printf("since boot, %u cores, CNTFRQ %u Hz\n", after.num_cores, after.cntfrq);
+    }
+    print_metrics(interval, per_core);
+    print_sites(interval, top);
+
+    return check_limits(interval) ? 2 : 0;
+}
+/*-----------------------------------------------------------*/
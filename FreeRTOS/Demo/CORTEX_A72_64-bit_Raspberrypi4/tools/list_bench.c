@@ -0,0 +1,159 @@
+/* list_bench.c */
+/*
+ * Host benchmark of vListInsert() and uxListRemove() on plain and indexed
+ * lists (configUSE_INDEXED_LISTS), with 10, 100 and 1000 items in the list.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -I../../../Source -I../../../Source/include list_bench.c -o list_bench
+ *   ./list_bench
+ *
+ * Items get wake times up to LIST_BENCH_SPAN ticks ahead, as in a delayed task
+ * list.  Each round removes half of the items at random and inserts them again
+ * with new wake times, each phase is timed as a whole so the clock is not read
+ * per call.  The list order is checked after every round.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* Just enough of FreeRTOS.h for list.c */
+#define INC_FREERTOS_H
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint64_t TickType_t;
+#define portMAX_DELAY                               ((TickType_t)0xffffffffffffffffULL)
+#define pdFALSE                                     ((BaseType_t)0)
+#define pdTRUE                                      ((BaseType_t)1)
+#define PRIVILEGED_FUNCTION
+#define mtCOVERAGE_TEST_MARKER()
+#define mtCOVERAGE_TEST_DELAY()
+#define configASSERT(x)                             do { if (!(x)) { fprintf(stderr, "assert %s:%d\n", __FILE__, __LINE__); abort(); } } while (0)
+#define configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES   0
+#define configUSE_INDEXED_LISTS                     1
+
+#include "list.c"
+
+#define LIST_BENCH_SPAN     (10000U)
+#define LIST_BENCH_OPS      (2000000U)  /* insertions per list size and kind */
+
+static const unsigned list_bench_sizes[] = { 10U, 100U, 1000U };
+
+struct list_bench_result {
+    double insert_ns;
+    double remove_ns;
+};
+/*-----------------------------------------------------------*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void check_order(List_t *list, unsigned count)
+{
+    const ListItem_t *item;
+    TickType_t last = 0;
+    unsigned n = 0;
+
+    for (item = listGET_HEAD_ENTRY(list); item != listGET_END_MARKER(list); item = listGET_NEXT(item)) {
+        configASSERT(item->xItemValue >= last);
+        last = item->xItemValue;
+        n++;
+    }
+    configASSERT((n == count) && (listCURRENT_LIST_LENGTH(list) == count));
+}
+/*-----------------------------------------------------------*/
+
+static struct list_bench_result run(unsigned count, int indexed)
+{
+    struct list_bench_result res = { 0.0, 0.0 };
+    ListItem_t *items, **moved;
+    uint64_t insert_ns = 0, remove_ns = 0, t;
+    unsigned rounds, half, r, i, j;
+    TickType_t tick = 0;
+    List_t list;
+
+    items = calloc(count, sizeof(*items));
+    moved = calloc(count, sizeof(*moved));
+    if (!items || !moved) {
+        exit(1);
+    }
+
+    if (indexed) {
+        vListInitialiseIndexed(&list);
+    } else {
+        vListInitialise(&list);
+    }
+    srand(count);
+    for (i = 0; i < count; i++) {
+        vListInitialiseItem(&items[i]);
+        listSET_LIST_ITEM_VALUE(&items[i], tick + 1U + (TickType_t)(rand() % LIST_BENCH_SPAN));
+        vListInsert(&list, &items[i]);
+    }
+
+    half = (count + 1U) / 2U;
+    rounds = LIST_BENCH_OPS / half;
+    for (r = 0; r < rounds; r++) {
+        tick++;
+
+        /* Pick half of the items, different ones each round */
+        for (i = 0; i < half; i++) {
+            do {
+                j = (unsigned)rand() % count;
+            } while (items[j].pxContainer == NULL);
+            moved[i] = &items[j];
+            items[j].pxContainer = NULL;
+        }
+        for (i = 0; i < half; i++) {
+            moved[i]->pxContainer = &list;
+        }
+
+        t = now_ns();
+        for (i = 0; i < half; i++) {
+            (void)uxListRemove(moved[i]);
+        }
+        remove_ns += now_ns() - t;
+
+        for (i = 0; i < half; i++) {
+            listSET_LIST_ITEM_VALUE(moved[i], tick + 1U + (TickType_t)(rand() % LIST_BENCH_SPAN));
+        }
+
+        t = now_ns();
+        for (i = 0; i < half; i++) {
+            vListInsert(&list, moved[i]);
+        }
+        insert_ns += now_ns() - t;
+
+        check_order(&list, count);
+    }
+
+    res.insert_ns = (double)insert_ns / ((double)rounds * half);
+    res.remove_ns = (double)remove_ns / ((double)rounds * half);
+
+    free(moved);
+    free(items);
+    return res;
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    struct list_bench_result plain, indexed;
+    unsigned i;
+
+    printf("%8s %14s %14s %14s %14s\n", "items", "insert plain", "insert index", "remove plain", "remove index");
+    for (i = 0; i < sizeof(list_bench_sizes) / sizeof(list_bench_sizes[0]); i++) {
+        plain = run(list_bench_sizes[i], 0);
+        indexed = run(list_bench_sizes[i], 1);
+        printf("%8u %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n", list_bench_sizes[i],
+               plain.insert_ns, indexed.insert_ns, plain.remove_ns, indexed.remove_ns);
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,256 @@
+/* mp_message_buffer_bench.c */
+/*
+ * Host stress test and benchmark of the multi-producer message buffer
+ * (mp_message_buffer.h) against a message buffer (stream_buffer.c) whose
+ * producers and reader share a mutex, which stands in for the critical section
+ * the producers need on the target.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -pthread -I../../../Source -I../../../Source/include mp_message_buffer_bench.c -o mp_message_buffer_bench
+ *   ./mp_message_buffer_bench [producers]
+ *
+ * Each producer thread sends MPMB_BENCH_RECORDS records of 8 to 64 bytes,
+ * holding its number, a sequence number and a pattern derived from both.  The
+ * reader (the main thread) checks that the records of each producer arrive
+ * complete and in order.  Producers and the reader retry with sched_yield()
+ * when the buffer is full or empty, nothing blocks.
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Just enough of FreeRTOS.h and task.h for stream_buffer.c and
+mp_message_buffer.c, without blocking and notifications */
+#define INC_FREERTOS_H
+#define INC_TASK_H
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint64_t TickType_t;
+typedef void *TaskHandle_t;
+typedef struct { int dummy; } TimeOut_t;
+typedef struct { void *pvDummy1[ 2 ]; size_t xDummy2[ 3 ]; void *pvDummy3; uint8_t ucDummy4; } StaticMPMessageBuffer_t;
+typedef struct { size_t dummy[ 8 ]; } StaticStreamBuffer_t;
+typedef enum { eNoAction = 0 } eNotifyAction;
+#define pdFALSE                                     ((BaseType_t)0)
+#define pdTRUE                                      ((BaseType_t)1)
+#define pdPASS                                      pdTRUE
+#define pdFAIL                                      pdFALSE
+#define PRIVILEGED_FUNCTION
+#define mtCOVERAGE_TEST_MARKER()
+#define configASSERT(x)                             do { if (!(x)) { fprintf(stderr, "assert %s:%d\n", __FILE__, __LINE__); abort(); } } while (0)
+#define configASSERT_DEFINED                        1
+#define configSUPPORT_DYNAMIC_ALLOCATION            1
+#define configSUPPORT_STATIC_ALLOCATION             0
+#define configUSE_TASK_NOTIFICATIONS                1
+#define configUSE_TRACE_FACILITY                    0
+#define configUSE_TIMERS                            0
+#define INCLUDE_xTaskGetSchedulerState              0
+#define configMESSAGE_BUFFER_LENGTH_TYPE            size_t
+#define configMIN(a, b)                             (((a) < (b)) ? (a) : (b))
+#define portPOINTER_SIZE_TYPE                       uintptr_t
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()
+#define pvPortMalloc                                malloc
+#define vPortFree                                   free
+#define portSET_INTERRUPT_MASK_FROM_ISR()           0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)        (void)(x)
+#define taskENTER_CRITICAL()
+#define taskEXIT_CRITICAL()
+#define sbSEND_COMPLETED(x)
+#define sbSEND_COMPLETE_FROM_ISR(x, w)
+#define sbRECEIVE_COMPLETED(x)
+#define sbRECEIVE_COMPLETED_FROM_ISR(x, w)
+#define traceSTREAM_BUFFER_CREATE(x, m)
+#define traceSTREAM_BUFFER_CREATE_FAILED(m)
+#define traceSTREAM_BUFFER_CREATE_STATIC_FAILED(x, m)
+#define traceSTREAM_BUFFER_DELETE(x)
+#define traceSTREAM_BUFFER_RESET(x)
+#define traceSTREAM_BUFFER_SEND(x, n)
+#define traceSTREAM_BUFFER_SEND_FAILED(x)
+#define traceSTREAM_BUFFER_SEND_FROM_ISR(x, n)
+#define traceSTREAM_BUFFER_RECEIVE(x, n)
+#define traceSTREAM_BUFFER_RECEIVE_FAILED(x)
+#define traceSTREAM_BUFFER_RECEIVE_FROM_ISR(x, n)
+#define traceBLOCKING_ON_STREAM_BUFFER_SEND(x)
+#define traceBLOCKING_ON_STREAM_BUFFER_RECEIVE(x)
+
+static void vTaskSetTimeOutState(TimeOut_t *t) { (void)t; }
+static BaseType_t xTaskCheckForTimeOut(TimeOut_t *t, TickType_t *w) { (void)t; (void)w; return pdTRUE; }
+static TaskHandle_t xTaskGetCurrentTaskHandle(void) { return NULL; }
+static BaseType_t xTaskNotifyStateClear(TaskHandle_t t) { (void)t; return pdFALSE; }
+static BaseType_t xTaskNotifyWait(uint32_t a, uint32_t b, uint32_t *c, TickType_t d) { (void)a; (void)b; (void)c; (void)d; return pdFALSE; }
+static BaseType_t xTaskNotify(TaskHandle_t t, uint32_t v, eNotifyAction a) { (void)t; (void)v; (void)a; return pdPASS; }
+static BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t v, eNotifyAction a, BaseType_t *w) { (void)t; (void)v; (void)a; (void)w; return pdPASS; }
+
+#include "stream_buffer.c"
+#include "mp_message_buffer.c"
+
+#define MPMB_BENCH_RECORDS      (200000U)   /* per producer */
+#define MPMB_BENCH_MAX_DATA     (64U)
+#define MPMB_BENCH_BUFFER_SIZE  (4096U)
+#define MPMB_BENCH_MAX_PRODUCERS (16U)
+
+struct record {
+    uint32_t producer;
+    uint32_t seq;
+    uint8_t pattern[MPMB_BENCH_MAX_DATA - 8U];
+};
+
+static MPMessageBufferHandle_t mp_buffer;
+static StreamBufferHandle_t stream_buffer;
+static pthread_mutex_t stream_lock = PTHREAD_MUTEX_INITIALIZER;
+static int use_stream;
+/*-----------------------------------------------------------*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static size_t record_length(uint32_t producer, uint32_t seq)
+{
+    return 8U + ((producer * 7U + seq) % (MPMB_BENCH_MAX_DATA - 7U));
+}
+/*-----------------------------------------------------------*/
+
+static void fill(struct record *rec, uint32_t producer, uint32_t seq, size_t len)
+{
+    size_t i;
+
+    rec->producer = producer;
+    rec->seq = seq;
+    for (i = 0; i < len - 8U; i++) {
+        rec->pattern[i] = (uint8_t)(producer + seq + i);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void *producer(void *arg)
+{
+    uint32_t id = (uint32_t)(uintptr_t)arg;
+    struct record rec;
+    size_t len, sent;
+    uint32_t seq;
+    void *slot;
+
+    for (seq = 0; seq < MPMB_BENCH_RECORDS; seq++) {
+        len = record_length(id, seq);
+        if (use_stream) {
+            fill(&rec, id, seq, len);
+            do {
+                pthread_mutex_lock(&stream_lock);
+                sent = xStreamBufferSend(stream_buffer, &rec, len, 0);
+                pthread_mutex_unlock(&stream_lock);
+                if (sent == 0) {
+                    sched_yield();
+                }
+            } while (sent == 0);
+        } else {
+            /* Written in place */
+            while ((slot = pvMPMessageBufferReserve(mp_buffer, len)) == NULL) {
+                sched_yield();
+            }
+            fill(slot, id, seq, len);
+            vMPMessageBufferCommit(mp_buffer, slot);
+        }
+    }
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void check(const struct record *rec, size_t len, uint32_t *next_seq, unsigned producers)
+{
+    size_t i;
+
+    configASSERT(rec->producer < producers);
+    configASSERT(rec->seq == next_seq[rec->producer]);
+    configASSERT(len == record_length(rec->producer, rec->seq));
+    for (i = 0; i < len - 8U; i++) {
+        configASSERT(rec->pattern[i] == (uint8_t)(rec->producer + rec->seq + i));
+    }
+    next_seq[rec->producer]++;
+}
+/*-----------------------------------------------------------*/
+
+static double run(unsigned producers, int stream)
+{
+    uint32_t next_seq[MPMB_BENCH_MAX_PRODUCERS] = { 0 };
+    pthread_t threads[MPMB_BENCH_MAX_PRODUCERS];
+    uint64_t received = 0, total, t;
+    struct record rec;
+    const void *slot;
+    size_t len;
+    unsigned i;
+
+    use_stream = stream;
+    total = (uint64_t)producers * MPMB_BENCH_RECORDS;
+
+    t = now_ns();
+    for (i = 0; i < producers; i++) {
+        pthread_create(&threads[i], NULL, producer, (void *)(uintptr_t)i);
+    }
+    while (received < total) {
+        if (stream) {
+            pthread_mutex_lock(&stream_lock);
+            len = xStreamBufferReceive(stream_buffer, &rec, sizeof(rec), 0);
+            pthread_mutex_unlock(&stream_lock);
+            if (len == 0) {
+                sched_yield();
+                continue;
+            }
+            check(&rec, len, next_seq, producers);
+        } else {
+            slot = pvMPMessageBufferAcquire(mp_buffer, &len, 0);
+            if (slot == NULL) {
+                sched_yield();
+                continue;
+            }
+            check(slot, len, next_seq, producers);
+            vMPMessageBufferRelease(mp_buffer);
+        }
+        received++;
+    }
+    for (i = 0; i < producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    t = now_ns() - t;
+
+    for (i = 0; i < producers; i++) {
+        configASSERT(next_seq[i] == MPMB_BENCH_RECORDS);
+    }
+    return (double)total * 1e9 / (double)t;
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    unsigned producers = (argc > 1) ? (unsigned)atoi(argv[1]) : 4U;
+    double mp, locked;
+
+    if ((producers == 0U) || (producers > MPMB_BENCH_MAX_PRODUCERS)) {
+        fprintf(stderr, "1 to %u producers\n", MPMB_BENCH_MAX_PRODUCERS);
+        return 1;
+    }
+
+    mp_buffer = xMPMessageBufferCreate(MPMB_BENCH_BUFFER_SIZE);
+    stream_buffer = xStreamBufferGenericCreate(MPMB_BENCH_BUFFER_SIZE, 0, pdTRUE);
+    configASSERT((mp_buffer != NULL) && (stream_buffer != NULL));
+
+    mp = run(producers, 0);
+    locked = run(producers, 1);
+    printf("%u producers, %u records each, all received in order\n", producers, MPMB_BENCH_RECORDS);
+    printf("multi-producer buffer:    %10.0f records/s\n", mp);
+    printf("message buffer + lock:    %10.0f records/s\n", locked);
+
+    vMPMessageBufferDelete(mp_buffer);
+    vStreamBufferDelete(stream_buffer);
+    return 0;
+}
+/*-----------------------------------------------------------*/
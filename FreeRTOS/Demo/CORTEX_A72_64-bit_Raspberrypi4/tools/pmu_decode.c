@@ -0,0 +1,252 @@
+/* pmu_decode.c */
+/*
+ * Linux side of the PMU probes (uart/src/pmu.c): reads struct pmu_shm and
+ * prints per probe the calls, the cycles per call with their percentiles,
+ * instructions per cycle, cache refills and branch mispredicts per call.
+ *
+ * Build and run on the Raspberry Pi (or anywhere, for a dump):
+ *   gcc -O2 -I../uart/src pmu_decode.c -o pmu_decode
+ *   sudo ./pmu_decode                   all cores together
+ *   sudo ./pmu_decode -c                one row per core
+ *   sudo ./pmu_decode -H                with the histogram of the cycles
+ *   sudo ./pmu_decode -o pmu.bin        save a dump, read it with -f pmu.bin
+ *
+ * The region is mapped from /dev/mem with O_SYNC, so it is read uncached; the
+ * target maps it write-through.  Percentiles come from the power of two
+ * histogram, they are the upper bound of the bucket they fall in.
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "pmu.h"
+
+static struct pmu_shm pmu;
+/*-----------------------------------------------------------*/
+
+/* Device memory takes aligned accesses only, so no memcpy() */
+static void copy64(void *dst, const volatile void *src, size_t size)
+{
+    const volatile uint64_t *s = src;
+    uint64_t *d = dst;
+    size_t i;
+
+    for (i = 0; i < size / sizeof(uint64_t); i++) {
+        d[i] = s[i];
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int read_mem(void)
+{
+    size_t len = (sizeof(pmu) + 4095U) & ~(size_t)4095U;
+    void *map;
+    int fd;
+
+    fd = open("/dev/mem", O_RDONLY | O_SYNC);
+    if (fd < 0) {
+        perror("/dev/mem");
+        return -1;
+    }
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, (off_t)PMU_SHM_ADDR);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    copy64(&pmu, map, sizeof(pmu));
+    munmap(map, len);
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    n = fread(&pmu, 1, sizeof(pmu), f);
+    fclose(f);
+    if (n != sizeof(pmu)) {
+        fprintf(stderr, "%s: %zu bytes, expected %zu\n", path, n, sizeof(pmu));
+        return -1;
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int write_file(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+
+    if ((f == NULL) || (fwrite(&pmu, sizeof(pmu), 1, f) != 1)) {
+        perror(path);
+        return -1;
+    }
+    return fclose(f);
+}
+/*-----------------------------------------------------------*/
+
+/* Adds the row of src to dst */
+static void merge(struct pmu_probe *dst, const struct pmu_probe *src)
+{
+    uint32_t i;
+
+    if (src->count != 0U) {
+        if ((dst->count == 0U) || (src->min_cycles < dst->min_cycles)) {
+            dst->min_cycles = src->min_cycles;
+        }
+        if (src->max_cycles > dst->max_cycles) {
+            dst->max_cycles = src->max_cycles;
+        }
+    }
+    dst->count += src->count;
+    dst->discarded += src->discarded;
+    for (i = 0; i < PMU_NUM_COUNTERS; i++) {
+        dst->sum[i] += src->sum[i];
+    }
+    for (i = 0; i < PMU_HIST_BUCKETS; i++) {
+        dst->hist[i] += src->hist[i];
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Upper bound of the bucket the pct percentile falls in */
+static uint64_t percentile(const struct pmu_probe *p, double pct)
+{
+    uint64_t seen = 0U, rank;
+    uint32_t i;
+
+    rank = (uint64_t)((double)p->count * pct / 100.0);
+    if (rank >= p->count) {
+        rank = p->count - 1U;
+    }
+    for (i = 0; i < PMU_HIST_BUCKETS - 1U; i++) {
+        seen += p->hist[i];
+        if (seen > rank) {
+            break;
+        }
+    }
+    /* The last bucket is open, its bound is the maximum */
+    return (i == PMU_HIST_BUCKETS - 1U) ? p->max_cycles : (1ULL << i);
+}
+/*-----------------------------------------------------------*/
+
+static double per_call(const struct pmu_probe *p, uint32_t counter)
+{
+    return (double)p->sum[counter] / (double)p->count;
+}
+/*-----------------------------------------------------------*/
+
+static void print_row(const char *name, const char *core, const struct pmu_probe *p, int hist)
+{
+    uint32_t i;
+
+    if (p->count == 0U) {
+        printf("%-12.16s %4s %10u %8llu\n", name, core, 0U, (unsigned long long)p->discarded);
+        return;
+    }
+    printf("%-12.16s %4s %10llu %8llu %10.0f %8llu %8llu %8llu %10llu %5.2f %8.2f %8.2f %8.2f\n",
+           name, core, (unsigned long long)p->count, (unsigned long long)p->discarded,
+           per_call(p, PMU_CYCLES), (unsigned long long)p->min_cycles,
+           (unsigned long long)percentile(p, 50.0), (unsigned long long)percentile(p, 99.0),
+           (unsigned long long)p->max_cycles,
+           p->sum[PMU_CYCLES] ? (double)p->sum[PMU_INSTRUCTIONS] / (double)p->sum[PMU_CYCLES] : 0.0,
+           per_call(p, PMU_L1D_REFILLS), per_call(p, PMU_L2D_REFILLS), per_call(p, PMU_BRANCH_MISSES));
+    if (hist) {
+        for (i = 0; i < PMU_HIST_BUCKETS; i++) {
+            if (p->hist[i] != 0U) {
+                printf("%22s < 2^%-2u %10u\n", "", i, p->hist[i]);
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void print_table(int per_core, int hist)
+{
+    struct pmu_probe all;
+    char name[PMU_NAME_LEN + 1U], core_name[12];
+    uint32_t probe, core;
+
+    for (core = 0; core < pmu.num_cores; core++) {
+        printf("core %u: empty probe counts %llu cycles, %llu instructions%s\n", core,
+               (unsigned long long)pmu.overhead[core][PMU_CYCLES],
+               (unsigned long long)pmu.overhead[core][PMU_INSTRUCTIONS],
+               (pmu.flags[core] & PMU_FLAG_NO_PMU) ? ", no PMU" : "");
+    }
+
+    printf("\n%-12s %4s %10s %8s %10s %8s %8s %8s %10s %5s %8s %8s %8s\n", "probe", "core", "calls",
+           "discard", "avg cyc", "min", "p50", "p99", "max", "ipc", "l1d/call", "l2d/call", "brm/call");
+    for (probe = 0; probe < pmu.num_probes; probe++) {
+        memcpy(name, pmu.names[probe], PMU_NAME_LEN);
+        name[PMU_NAME_LEN] = '\0';
+        if (per_core) {
+            for (core = 0; core < pmu.num_cores; core++) {
+                snprintf(core_name, sizeof(core_name), "%u", core);
+                print_row(name, core_name, &pmu.probes[core][probe], hist);
+            }
+        } else {
+            memset(&all, 0, sizeof(all));
+            for (core = 0; core < pmu.num_cores; core++) {
+                merge(&all, &pmu.probes[core][probe]);
+            }
+            print_row(name, "all", &all, hist);
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-c] [-H] [-f dump] [-o dump]\n"
+            "  -c       one row per core instead of all cores together\n"
+            "  -H       print the histogram of the cycles of each probe\n"
+            "  -f dump  read a dump instead of /dev/mem\n"
+            "  -o dump  write the data read to a dump\n", prog);
+    exit(1);
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *in = NULL, *out = NULL;
+    int per_core = 0, hist = 0, opt;
+
+    while ((opt = getopt(argc, argv, "cHf:o:")) != -1) {
+        switch (opt) {
+        case 'c': per_core = 1; break;
+        case 'H': hist = 1; break;
+        case 'f': in = optarg; break;
+        case 'o': out = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if ((in ? read_file(in) : read_mem()) != 0) {
+        return 1;
+    }
+    if ((pmu.magic != PMU_MAGIC) || (pmu.version != PMU_VERSION)) {
+        fprintf(stderr, "no PMU probes (magic %08x version %u)\n", pmu.magic, pmu.version);
+        return 1;
+    }
+    if ((pmu.num_cores > PMU_MAX_CORES) || (pmu.num_probes > PMU_MAX_PROBES)) {
+        fprintf(stderr, "corrupt PMU probes\n");
+        return 1;
+    }
+    if (out && (write_file(out) != 0)) {
+        return 1;
+    }
+
+    print_table(per_core, hist);
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,652 @@
+/* pointer_queue_test.c */
+/*
+ * Host stress test and benchmark of the pointer queue (pointer_queue.c), with
+ * just enough of the kernel simulated for it to block: each task is a thread,
+ * a mutex stands in for the critical section, and a blocked task waits on a
+ * condition variable until it is taken out of the event list, or until its
+ * time out expires, which takes it out of the list as the tick would.  A tick
+ * is 1 ms.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -pthread -I../../../Source -I../../../Source/include pointer_queue_test.c -o pointer_queue_test
+ *   ./pointer_queue_test
+ *
+ * Any revision of pointer_queue.c with the same API can be tested, for example
+ * the one that blocked on task notifications:
+ *   mkdir -p /tmp/pq_old
+ *   git show b833dd9:./../../../Source/pointer_queue.c > /tmp/pq_old/pointer_queue.c
+ *   gcc -O2 -pthread -I/tmp/pq_old -I../../../Source -I../../../Source/include pointer_queue_test.c -o pointer_queue_test_old
+ *
+ * order         PQ_TEST_SENDERS tasks and an interrupt send PQ_TEST_ROUNDS
+ *               pointers each through a queue of 4, the receiver checks the
+ *               order of each sender; the most senders blocked at once is
+ *               printed.
+ * priority      Two senders of different priorities wait on a full queue,
+ *               the higher one must be woken first.
+ * timeout       Send and receive give up after their block time and leave
+ *               the queue usable.
+ * notification  A notification pending for the receiver is still pending
+ *               after it waited on the queue.
+ * length one    A queue of one pointer is full with one pointer.
+ *
+ * Results on a one CPU host (gcc 12 -O2):
+ *   order, 4 senders blocked at most at once, all tests ok
+ *   bursts of 16 without blocking: 141.7 ns/pointer (0.00 critical sections/pointer)
+ *   length senders ns/pointer (critical sections/pointer)
+ *       64       1     311.2 (2.03)
+ *       64       2     569.0 (2.04)
+ *       64       4     881.8 (2.04)
+ *        2       1    4754.7 (2.48)
+ *        2       2    4812.5 (2.85)
+ *        2       4    5085.9 (3.36)
+ * A task that sends and receives without blocking never enters a critical
+ * section.  With the receiver in its own task it drains the queue faster than
+ * the senders fill it and blocks for nearly every pointer, a critical section
+ * to block and one to be woken; with a queue of 2 the senders block as well.
+ *
+ * The revision that blocked on notifications fails priority, notification and
+ * length one, and does not always return from order or the benchmark: a
+ * sender that registered as the waiting one could be notified and then clear
+ * the notification before it blocked, and wait for ever.
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Just enough of FreeRTOS.h and task.h for list.c and pointer_queue.c */
+#define INC_FREERTOS_H
+#define INC_TASK_H
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint64_t TickType_t;
+typedef struct sim_task *TaskHandle_t;
+typedef struct { uint64_t start_ns; } TimeOut_t;
+typedef struct { void *pvDummy[ 32 ]; } StaticPointerQueue_t;  /* Static creation is not tested */
+typedef struct { void *pvDummy[ 2 ]; } StaticPointerQueueSlot_t;
+typedef enum { eNoAction = 0 } eNotifyAction;
+#define portMAX_DELAY                               ((TickType_t)0xffffffffffffffffULL)
+#define portBYTE_ALIGNMENT_MASK                     (0x000f)
+#define pdFALSE                                     ((BaseType_t)0)
+#define pdTRUE                                      ((BaseType_t)1)
+#define pdPASS                                      pdTRUE
+#define pdFAIL                                      pdFALSE
+#define errQUEUE_EMPTY                              ((BaseType_t)0)
+#define errQUEUE_FULL                               ((BaseType_t)0)
+#define PRIVILEGED_FUNCTION
+#define mtCOVERAGE_TEST_MARKER()
+#define mtCOVERAGE_TEST_DELAY()
+#define configASSERT(x)                             do { if (!(x)) { fprintf(stderr, "assert %s:%d\n", __FILE__, __LINE__); abort(); } } while (0)
+#define configASSERT_DEFINED                        1
+#define configSUPPORT_DYNAMIC_ALLOCATION            1
+#define configUSE_TASK_NOTIFICATIONS                1
+#define configUSE_PREEMPTION                        1
+#define configUSE_TIMERS                            0
+#define configMAX_PRIORITIES                        8
+#define INCLUDE_xTaskGetSchedulerState              0
+#define configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES   0
+#define configUSE_INDEXED_LISTS                     0
+#define portASSERT_IF_INTERRUPT_PRIORITY_INVALID()
+#define pvPortMalloc                                malloc
+#define vPortFree                                   free
+#define taskENTER_CRITICAL()                        sim_enter_critical()
+#define taskEXIT_CRITICAL()                         sim_exit_critical()
+#define taskENTER_CRITICAL_FROM_ISR()               (sim_enter_critical(), (UBaseType_t)0)
+#define taskEXIT_CRITICAL_FROM_ISR(x)               do { (void)(x); sim_exit_critical(); } while (0)
+#define portYIELD_WITHIN_API()                      sim_yield()
+
+#include "list.c"
+
+#define PQ_TEST_SENDERS         (4U)
+#define PQ_TEST_ROUNDS          (20000U)    /* per sender */
+#define PQ_BENCH_POINTERS       (20000U)    /* per run */
+#define PQ_BENCH_BURST          (16U)
+#define PQ_SIM_TICK_NS          (1000000ULL)
+
+struct sim_task {
+    ListItem_t xEventListItem;
+    UBaseType_t priority;
+    int sender;
+    int blocked;
+    int notified;               /* A notification is pending */
+    int waiting_notification;
+    uint64_t deadline_ns;       /* 0: no time out */
+    pthread_cond_t wake;
+};
+
+static pthread_mutex_t kernel = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct sim_task *current;
+static __thread unsigned nesting;
+
+static uint64_t critical_sections;
+static uint64_t delays;
+static unsigned senders_blocked;
+static unsigned senders_blocked_max;
+/*-----------------------------------------------------------*/
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+    struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+
+    nanosleep(&ts, NULL);
+}
+/*-----------------------------------------------------------*/
+
+static void sim_enter_critical(void)
+{
+    if (nesting++ == 0U) {
+        pthread_mutex_lock(&kernel);
+        critical_sections++;
+    }
+}
+
+static void sim_exit_critical(void)
+{
+    if (--nesting == 0U) {
+        pthread_mutex_unlock(&kernel);
+    }
+}
+
+static void sim_task_start(struct sim_task *t, UBaseType_t priority, int sender)
+{
+    pthread_condattr_t attr;
+
+    memset(t, 0, sizeof(*t));
+    t->priority = priority;
+    t->sender = sender;
+    vListInitialiseItem(&t->xEventListItem);
+    listSET_LIST_ITEM_OWNER(&t->xEventListItem, t);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&t->wake, &attr);
+    current = t;
+}
+
+static void sim_set_deadline(struct sim_task *t, TickType_t ticks)
+{
+    t->deadline_ns = ticks == portMAX_DELAY ? 0U : now_ns() + ticks * PQ_SIM_TICK_NS;
+}
+
+/* Waits for the current task to be unblocked, the kernel is held once */
+static void sim_wait(void)
+{
+    struct sim_task *t = current;
+    struct timespec ts;
+
+    configASSERT(nesting == 1U);
+    if (t->sender && ++senders_blocked > senders_blocked_max) {
+        senders_blocked_max = senders_blocked;
+    }
+    ts.tv_sec = (time_t)(t->deadline_ns / 1000000000ULL);
+    ts.tv_nsec = (long)(t->deadline_ns % 1000000000ULL);
+    while (t->blocked) {
+        if (t->deadline_ns == 0U) {
+            pthread_cond_wait(&t->wake, &kernel);
+        } else if (pthread_cond_timedwait(&t->wake, &kernel, &ts) == ETIMEDOUT && t->blocked) {
+            /* The tick takes a task that timed out out of its event list */
+            if (listLIST_ITEM_CONTAINER(&t->xEventListItem) != NULL) {
+                uxListRemove(&t->xEventListItem);
+            }
+            t->blocked = 0;
+        }
+    }
+    if (t->sender) {
+        senders_blocked--;
+    }
+}
+
+static void sim_yield(void)
+{
+    if (current->blocked) {
+        sim_wait();
+    }
+}
+
+static void sim_unblock(struct sim_task *t)
+{
+    t->blocked = 0;
+    pthread_cond_signal(&t->wake);
+}
+/*-----------------------------------------------------------*/
+
+/* The part of task.h pointer_queue.c uses */
+
+static void vTaskSetTimeOutState(TimeOut_t * const pxTimeOut)
+{
+    pxTimeOut->start_ns = now_ns();
+}
+
+static BaseType_t xTaskCheckForTimeOut(TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait)
+{
+    uint64_t elapsed;
+
+    if (*pxTicksToWait == portMAX_DELAY) {
+        return pdFALSE;
+    }
+    elapsed = (now_ns() - pxTimeOut->start_ns) / PQ_SIM_TICK_NS;
+    if (elapsed >= *pxTicksToWait) {
+        *pxTicksToWait = 0U;
+        return pdTRUE;
+    }
+    *pxTicksToWait -= elapsed;
+    pxTimeOut->start_ns += elapsed * PQ_SIM_TICK_NS;
+    return pdFALSE;
+}
+
+static void vTaskPlaceOnEventList(List_t * const pxEventList, const TickType_t xTicksToWait)
+{
+    configASSERT(nesting != 0U);
+    listSET_LIST_ITEM_VALUE(&current->xEventListItem, configMAX_PRIORITIES - current->priority);
+    vListInsert(pxEventList, &current->xEventListItem);
+    current->blocked = 1;
+    sim_set_deadline(current, xTicksToWait);
+}
+
+static BaseType_t xTaskRemoveFromEventList(const List_t * const pxEventList)
+{
+    struct sim_task *t = listGET_OWNER_OF_HEAD_ENTRY(pxEventList);
+
+    configASSERT(nesting != 0U);
+    uxListRemove(&t->xEventListItem);
+    sim_unblock(t);
+    return pdFALSE;
+}
+
+/* Only used by the revision that blocked on notifications */
+
+static inline TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return current;
+}
+
+static inline BaseType_t xTaskNotifyStateClear(TaskHandle_t xTask)
+{
+    BaseType_t xReturn;
+
+    configASSERT(xTask == NULL);
+    sim_enter_critical();
+    xReturn = current->notified ? pdTRUE : pdFALSE;
+    current->notified = 0;
+    sim_exit_critical();
+    return xReturn;
+}
+
+static inline BaseType_t xTaskNotify(TaskHandle_t xTask, uint32_t ulValue, eNotifyAction eAction)
+{
+    (void)ulValue;
+    (void)eAction;
+    sim_enter_critical();
+    xTask->notified = 1;
+    if (xTask->waiting_notification) {
+        xTask->waiting_notification = 0;
+        sim_unblock(xTask);
+    }
+    sim_exit_critical();
+    return pdPASS;
+}
+
+static inline BaseType_t xTaskNotifyFromISR(TaskHandle_t xTask, uint32_t ulValue, eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    (void)pxHigherPriorityTaskWoken;
+    return xTaskNotify(xTask, ulValue, eAction);
+}
+
+static inline BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+    BaseType_t xReturn;
+
+    (void)ulBitsToClearOnEntry;
+    (void)ulBitsToClearOnExit;
+    (void)pulNotificationValue;
+    sim_enter_critical();
+    if (!current->notified && xTicksToWait != 0U) {
+        current->waiting_notification = 1;
+        current->blocked = 1;
+        sim_set_deadline(current, xTicksToWait);
+        sim_wait();
+        current->waiting_notification = 0;
+    }
+    xReturn = current->notified ? pdTRUE : pdFALSE;
+    current->notified = 0;
+    sim_exit_critical();
+    return xReturn;
+}
+
+static inline void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    __atomic_add_fetch(&delays, 1U, __ATOMIC_RELAXED);
+    sleep_ns(xTicksToDelay * PQ_SIM_TICK_NS);
+}
+
+#include "pointer_queue.c"
+/*-----------------------------------------------------------*/
+
+static PointerQueueHandle_t queue;
+static uint32_t pointers_per_sender;
+static int failed;
+
+static void *pointer_of(uint32_t sender, uint32_t seq)
+{
+    return (void *)(((uintptr_t)(sender + 1U) << 32) | seq);
+}
+
+static void result(const char *test, int ok)
+{
+    printf("%-13s %s\n", test, ok ? "ok" : "FAILED");
+    if (!ok) {
+        failed = 1;
+    }
+}
+
+/* Waits up to 200 ms for n senders to be blocked and the queue to hold
+messages pointers */
+static int wait_senders_blocked(unsigned n, UBaseType_t messages)
+{
+    unsigned blocked, i;
+
+    for (i = 0; i < 200U; i++) {
+        pthread_mutex_lock(&kernel);
+        blocked = senders_blocked;
+        pthread_mutex_unlock(&kernel);
+        if (blocked == n && uxPointerQueueMessagesWaiting(queue) == messages) {
+            return 1;
+        }
+        sleep_ns(PQ_SIM_TICK_NS);
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+struct sender {
+    pthread_t tid;
+    uint32_t id;
+    UBaseType_t priority;
+    struct sim_task task;
+};
+
+static void *run_sender(void *arg)
+{
+    struct sender *s = arg;
+    uint32_t seq;
+
+    sim_task_start(&s->task, s->priority, 1);
+    for (seq = 0; seq < pointers_per_sender; seq++) {
+        configASSERT(xPointerQueueSend(queue, pointer_of(s->id, seq), portMAX_DELAY) == pdPASS);
+    }
+    return NULL;
+}
+
+/* An interrupt, which retries when the queue is full */
+static void *run_isr(void *arg)
+{
+    struct sender *s = arg;
+    BaseType_t woken = pdFALSE;
+    uint32_t seq;
+
+    sim_task_start(&s->task, s->priority, 0);
+    for (seq = 0; seq < pointers_per_sender; seq++) {
+        while (xPointerQueueSendFromISR(queue, pointer_of(s->id, seq), (seq & 1U) ? &woken : NULL) != pdPASS) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void start_sender(struct sender *s, uint32_t id, UBaseType_t priority)
+{
+    s->id = id;
+    s->priority = priority;
+    if (pthread_create(&s->tid, NULL, run_sender, s) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        exit(1);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_order(void)
+{
+    struct sender senders[PQ_TEST_SENDERS], isr;
+    uint32_t next[PQ_TEST_SENDERS + 1U] = { 0 };
+    uint32_t i, id, seq;
+    void *p;
+    int ok = 1;
+
+    queue = xPointerQueueCreate(4U);
+    configASSERT(queue != NULL);
+    pointers_per_sender = PQ_TEST_ROUNDS;
+    senders_blocked_max = 0U;
+
+    for (i = 0; i < PQ_TEST_SENDERS; i++) {
+        start_sender(&senders[i], i, 1U + (i % 3U));
+    }
+    isr.id = PQ_TEST_SENDERS;
+    isr.priority = configMAX_PRIORITIES;
+    if (pthread_create(&isr.tid, NULL, run_isr, &isr) != 0) {
+        fprintf(stderr, "pthread_create failed\n");
+        exit(1);
+    }
+
+    for (i = 0; i < (PQ_TEST_SENDERS + 1U) * PQ_TEST_ROUNDS; i++) {
+        configASSERT(xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS);
+        id = (uint32_t)((uintptr_t)p >> 32) - 1U;
+        seq = (uint32_t)(uintptr_t)p;
+        if (id > PQ_TEST_SENDERS || seq != next[id]) {
+            fprintf(stderr, "sender %u: pointer %u, expected %u\n", id, seq, id > PQ_TEST_SENDERS ? 0U : next[id]);
+            ok = 0;
+            break;
+        }
+        next[id]++;
+    }
+
+    for (i = 0; i < PQ_TEST_SENDERS; i++) {
+        pthread_join(senders[i].tid, NULL);
+    }
+    pthread_join(isr.tid, NULL);
+    ok = ok && uxPointerQueueMessagesWaiting(queue) == 0U && pvPointerQueuePeek(queue) == NULL;
+    vPointerQueueDelete(queue);
+
+    printf("order, %u senders blocked at most at once\n", senders_blocked_max);
+    result("order", ok);
+}
+
+static void test_priority(void)
+{
+    struct sender low, high;
+    void *p = NULL;
+    int ok;
+
+    queue = xPointerQueueCreate(2U);
+    configASSERT(queue != NULL);
+    configASSERT(xPointerQueueSend(queue, pointer_of(9U, 0U), 0U) == pdPASS);
+    configASSERT(xPointerQueueSend(queue, pointer_of(9U, 1U), 0U) == pdPASS);
+    pointers_per_sender = 1U;
+
+    start_sender(&low, 0U, 1U);
+    wait_senders_blocked(1U, 2U);
+    start_sender(&high, 1U, 3U);
+    wait_senders_blocked(2U, 2U);
+
+    /* The pointers queued before, then the one of the higher priority sender */
+    ok = xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS && p == pointer_of(9U, 0U);
+    /* On the target the woken sender preempts the receiver, the threads are
+    not scheduled by priority so the receiver waits for it */
+    wait_senders_blocked(1U, 2U);
+    ok = ok && xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS && p == pointer_of(9U, 1U);
+    ok = ok && xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS && p == pointer_of(1U, 0U);
+    ok = ok && xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS && p == pointer_of(0U, 0U);
+
+    pthread_join(low.tid, NULL);
+    pthread_join(high.tid, NULL);
+    vPointerQueueDelete(queue);
+    result("priority", ok);
+}
+
+static void test_timeout(void)
+{
+    uint64_t t;
+    void *p;
+    int ok;
+
+    queue = xPointerQueueCreate(2U);
+    configASSERT(queue != NULL);
+
+    t = now_ns();
+    ok = xPointerQueueReceive(queue, &p, 5U) == errQUEUE_EMPTY && now_ns() - t >= 5U * PQ_SIM_TICK_NS;
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 0U), 0U) == pdPASS;
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 1U), 0U) == pdPASS;
+    current->sender = 1;
+    t = now_ns();
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 2U), 5U) == errQUEUE_FULL && now_ns() - t >= 5U * PQ_SIM_TICK_NS;
+    current->sender = 0;
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == pdPASS && p == pointer_of(0U, 0U);
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 3U), 0U) == pdPASS;
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == pdPASS && p == pointer_of(0U, 1U);
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == pdPASS && p == pointer_of(0U, 3U);
+
+    vPointerQueueDelete(queue);
+    result("timeout", ok);
+}
+
+static void test_notification(void)
+{
+    void *p;
+    int ok;
+
+    queue = xPointerQueueCreate(2U);
+    configASSERT(queue != NULL);
+
+    current->notified = 1;
+    ok = xPointerQueueReceive(queue, &p, 2U) == errQUEUE_EMPTY;
+    ok = ok && current->notified;
+    current->notified = 0;
+
+    vPointerQueueDelete(queue);
+    result("notification", ok);
+}
+
+static void test_length_one(void)
+{
+    void *p = NULL;
+    int ok;
+
+    queue = xPointerQueueCreate(1U);
+    configASSERT(queue != NULL);
+
+    ok = xPointerQueueSend(queue, pointer_of(0U, 0U), 0U) == pdPASS;
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 1U), 0U) == errQUEUE_FULL;
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == pdPASS && p == pointer_of(0U, 0U);
+    ok = ok && xPointerQueueSend(queue, pointer_of(0U, 2U), 0U) == pdPASS;
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == pdPASS && p == pointer_of(0U, 2U);
+    ok = ok && xPointerQueueReceive(queue, &p, 0U) == errQUEUE_EMPTY;
+
+    vPointerQueueDelete(queue);
+    result("length one", ok);
+}
+/*-----------------------------------------------------------*/
+
+/* Bursts sent and received by one task, nothing blocks */
+static void bench_burst(void)
+{
+    uint64_t t, sections;
+    uint32_t round, i;
+    void *p;
+
+    queue = xPointerQueueCreate(PQ_BENCH_BURST);
+    configASSERT(queue != NULL);
+
+    sections = critical_sections;
+    t = now_ns();
+    for (round = 0; round < PQ_BENCH_POINTERS; round++) {
+        for (i = 0; i < PQ_BENCH_BURST; i++) {
+            configASSERT(xPointerQueueSend(queue, pointer_of(0U, i), 0U) == pdPASS);
+        }
+        for (i = 0; i < PQ_BENCH_BURST; i++) {
+            configASSERT(xPointerQueueReceive(queue, &p, 0U) == pdPASS);
+        }
+    }
+    t = now_ns() - t;
+    sections = critical_sections - sections;
+    vPointerQueueDelete(queue);
+
+    printf("bursts of %u without blocking: %.1f ns/pointer (%.2f critical sections/pointer)\n", PQ_BENCH_BURST,
+           (double)t / ((double)PQ_BENCH_POINTERS * PQ_BENCH_BURST),
+           (double)sections / ((double)PQ_BENCH_POINTERS * PQ_BENCH_BURST));
+}
+
+/* Senders and the receiver in their own tasks, all blocking */
+static void bench(UBaseType_t length, uint32_t nsenders)
+{
+    struct sender senders[PQ_TEST_SENDERS];
+    uint64_t t, sections;
+    uint32_t i, total;
+    void *p;
+
+    queue = xPointerQueueCreate(length);
+    configASSERT(queue != NULL);
+    pointers_per_sender = PQ_BENCH_POINTERS / nsenders;
+    total = pointers_per_sender * nsenders;
+
+    pthread_mutex_lock(&kernel);
+    sections = critical_sections;
+    pthread_mutex_unlock(&kernel);
+    t = now_ns();
+    for (i = 0; i < nsenders; i++) {
+        start_sender(&senders[i], i, 2U);
+    }
+    for (i = 0; i < total; i++) {
+        configASSERT(xPointerQueueReceive(queue, &p, portMAX_DELAY) == pdPASS);
+    }
+    for (i = 0; i < nsenders; i++) {
+        pthread_join(senders[i].tid, NULL);
+    }
+    t = now_ns() - t;
+    pthread_mutex_lock(&kernel);
+    sections = critical_sections - sections;
+    pthread_mutex_unlock(&kernel);
+    vPointerQueueDelete(queue);
+
+    printf("%6lu %7u %9.1f (%.2f)\n", length, nsenders, (double)t / total, (double)sections / total);
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    struct sim_task receiver;
+    static const UBaseType_t lengths[] = { 64U, 2U };
+    uint32_t nsenders;
+    unsigned i;
+
+    sim_task_start(&receiver, 2U, 0);
+
+    test_order();
+    test_priority();
+    test_timeout();
+    test_notification();
+    test_length_one();
+
+    bench_burst();
+    printf("%6s %7s %s\n", "length", "senders", "ns/pointer (critical sections/pointer)");
+    for (i = 0; i < sizeof(lengths) / sizeof(lengths[0]); i++) {
+        for (nsenders = 1U; nsenders <= PQ_TEST_SENDERS; nsenders *= 2U) {
+            bench(lengths[i], nsenders);
+        }
+    }
+    if (delays != 0U) {
+        printf("%llu sleeps of a tick\n", (unsigned long long)delays);
+    }
+
+    return failed;
+}
+/*-----------------------------------------------------------*/
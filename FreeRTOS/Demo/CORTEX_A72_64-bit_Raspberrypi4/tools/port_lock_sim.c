@@ -0,0 +1,261 @@
+/* port_lock_sim.c */
+/*
+ * Host simulation of vPortRecursiveLockAcquire() and
+ * vPortRecursiveLockRelease() (port.c of ARM_CA72_64_BIT), one thread per
+ * core.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -pthread port_lock_sim.c -o port_lock_sim
+ *   ./port_lock_sim
+ *
+ * The instructions of the acquire loop (SEVL, WFE, LDAXR, STXR) and the STLR
+ * of the release are simulated one at a time under a mutex, with the parts of
+ * the architecture they depend on: an event register and an exclusive monitor
+ * per core.  A store to the lock word clears the monitors of the other cores,
+ * which sets their event registers, as the global monitor does.  A store
+ * exclusive always clears the monitor of its own core and can fail without
+ * another store (the architecture allows it: an eviction of the line, or a
+ * write to another word of the same reservation granule such as the other
+ * lock), that happens with a probability of 1 / LOCK_SIM_SPURIOUS.  The
+ * instruction sequence follows the one of port.c, keep both in step.
+ *
+ * Each core takes the lock LOCK_SIM_ROUNDS times, recursively up to
+ * LOCK_SIM_DEPTH deep, and increments a counter in two halves with a yield in
+ * between, so two cores inside at once lose counts.  A core that enters WFE
+ * with its monitor clear and no event pending can only be woken by an event
+ * that has nothing to do with the lock, and on the target with interrupts
+ * masked none may ever come: that is counted as a hang, and the run goes on
+ * as if the event came.
+ *
+ * The loop before the fix branched back to the WFE on a failed STXR:
+ *   variant       cores  acquires   hangs  counter
+ *   stxr to wfe       2    400000   57181  ok
+ *   stxr to ldaxr     2    400000       0  ok
+ *   stxr to wfe       4    800000  114462  ok
+ *   stxr to ldaxr     4    800000       0  ok
+ */
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define LOCK_SIM_ROUNDS         (200000U)   /* per core */
+#define LOCK_SIM_DEPTH          (3U)
+#define LOCK_SIM_SPURIOUS       (8U)
+#define LOCK_SIM_MAX_CORES      (4U)
+
+struct core {
+    uint32_t id;                /* portGET_CORE_ID() + 1 */
+    int event;                  /* The event register */
+    int monitor;                /* The exclusive monitor holds the lock word */
+    uint32_t seed;
+    pthread_cond_t wake;
+};
+
+static pthread_mutex_t cpu = PTHREAD_MUTEX_INITIALIZER;
+static struct core cores[LOCK_SIM_MAX_CORES];
+static unsigned num_cores;
+static int fixed;
+
+/* ulPortLockOwner[] and ulPortLockCount[] of one lock */
+static uint32_t lock_owner;
+static uint32_t lock_count;
+
+static uint64_t counter;
+static uint64_t hangs;
+/*-----------------------------------------------------------*/
+
+static uint32_t next_random(struct core *c)
+{
+    c->seed = c->seed * 1103515245U + 12345U;
+    return c->seed >> 16;
+}
+/*-----------------------------------------------------------*/
+
+/* A store to the lock word, seen by the monitors of every other core */
+static void store_owner(struct core *c, uint32_t value)
+{
+    unsigned i;
+
+    __atomic_store_n(&lock_owner, value, __ATOMIC_RELAXED);
+    for (i = 0; i < num_cores; i++) {
+        if (&cores[i] != c && cores[i].monitor) {
+            cores[i].monitor = 0;
+            cores[i].event = 1;
+            pthread_cond_signal(&cores[i].wake);
+        }
+    }
+}
+
+static void sevl(struct core *c)
+{
+    pthread_mutex_lock(&cpu);
+    c->event = 1;
+    pthread_mutex_unlock(&cpu);
+}
+
+static void wfe(struct core *c)
+{
+    pthread_mutex_lock(&cpu);
+    if (!c->event && !c->monitor) {
+        /* Nothing the other cores do to the lock can wake this one */
+        hangs++;
+        c->event = 1;
+    }
+    while (!c->event) {
+        pthread_cond_wait(&c->wake, &cpu);
+    }
+    c->event = 0;
+    pthread_mutex_unlock(&cpu);
+}
+
+static uint32_t ldaxr(struct core *c)
+{
+    uint32_t value;
+
+    pthread_mutex_lock(&cpu);
+    value = lock_owner;
+    c->monitor = 1;
+    pthread_mutex_unlock(&cpu);
+    return value;
+}
+
+static uint32_t stxr(struct core *c, uint32_t value)
+{
+    uint32_t failed = 1U;
+
+    pthread_mutex_lock(&cpu);
+    if (c->monitor && (next_random(c) % LOCK_SIM_SPURIOUS) != 0U) {
+        store_owner(c, value);
+        failed = 0U;
+    }
+    c->monitor = 0;
+    pthread_mutex_unlock(&cpu);
+    return failed;
+}
+
+static void stlr_zero(struct core *c)
+{
+    pthread_mutex_lock(&cpu);
+    store_owner(c, 0U);
+    pthread_mutex_unlock(&cpu);
+}
+/*-----------------------------------------------------------*/
+
+/* vPortRecursiveLockAcquire() */
+static void acquire(struct core *c)
+{
+    if (__atomic_load_n(&lock_owner, __ATOMIC_RELAXED) == c->id) {
+        lock_count++;
+        return;
+    }
+
+    sevl(c);                                /*    SEVL              */
+    wfe(c);                                 /* 1: WFE               */
+    for (;;) {
+        if (ldaxr(c) != 0U) {               /* 2: LDAXR             */
+            wfe(c);                         /*    CBNZ 1b           */
+            continue;
+        }
+        if (stxr(c, c->id) == 0U) {         /*    STXR              */
+            break;
+        }
+        if (!fixed) {                       /*    CBNZ 2b, 1b before */
+            wfe(c);
+        }
+    }
+    lock_count = 1U;
+}
+
+/* vPortRecursiveLockRelease() */
+static void release(struct core *c)
+{
+    if (lock_owner != c->id) {
+        fprintf(stderr, "core %u releases a lock owned by %u\n", c->id, lock_owner);
+        exit(1);
+    }
+    if (--lock_count == 0U) {
+        stlr_zero(c);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void *run_core(void *arg)
+{
+    struct core *c = arg;
+    uint32_t round, depth, i;
+    uint64_t value;
+
+    for (round = 0; round < LOCK_SIM_ROUNDS; round++) {
+        depth = 1U + next_random(c) % LOCK_SIM_DEPTH;
+        for (i = 0; i < depth; i++) {
+            acquire(c);
+        }
+
+        value = counter;
+        if ((next_random(c) & 7U) == 0U) {
+            sched_yield();
+        }
+        counter = value + 1U;
+
+        for (i = 0; i < depth; i++) {
+            release(c);
+        }
+        if ((next_random(c) & 3U) == 0U) {
+            sched_yield();
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void run(unsigned ncores, int variant)
+{
+    pthread_t tid[LOCK_SIM_MAX_CORES];
+    unsigned i;
+
+    num_cores = ncores;
+    fixed = variant;
+    lock_owner = lock_count = 0U;
+    counter = hangs = 0U;
+    for (i = 0; i < ncores; i++) {
+        cores[i].id = i + 1U;
+        cores[i].event = cores[i].monitor = 0;
+        cores[i].seed = 0x5eed0000U + i;
+        pthread_cond_init(&cores[i].wake, NULL);
+    }
+
+    for (i = 0; i < ncores; i++) {
+        if (pthread_create(&tid[i], NULL, run_core, &cores[i]) != 0) {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(1);
+        }
+    }
+    for (i = 0; i < ncores; i++) {
+        pthread_join(tid[i], NULL);
+    }
+
+    printf("%-13s %7u %9u %7llu  %s\n", fixed ? "stxr to ldaxr" : "stxr to wfe", ncores,
+           ncores * LOCK_SIM_ROUNDS, (unsigned long long)hangs,
+           counter == (uint64_t)ncores * LOCK_SIM_ROUNDS && lock_owner == 0U ? "ok" : "LOST");
+    if (counter != (uint64_t)ncores * LOCK_SIM_ROUNDS || lock_owner != 0U || (fixed && hangs != 0U)) {
+        exit(1);
+    }
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    unsigned ncores;
+
+    printf("%-13s %7s %9s %7s  %s\n", "variant", "cores", "acquires", "hangs", "counter");
+    for (ncores = 2U; ncores <= LOCK_SIM_MAX_CORES; ncores *= 2U) {
+        run(ncores, 0);
+        run(ncores, 1);
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,252 @@
+/* profiler_decode.c */
+/*
+ * Linux side of the profiler (uart/src/profiler.c): reads struct profiler_shm
+ * and prints the CPU share of each task, the context switches and the time
+ * spent in each interrupt handler, or writes them in the folded stack format
+ * that flamegraph.pl and speedscope take.
+ *
+ * Build and run on the Raspberry Pi (or anywhere, for a dump):
+ *   gcc -O2 -I../uart/src profiler_decode.c -o profiler_decode
+ *   sudo ./profiler_decode                  table of the last period
+ *   sudo ./profiler_decode -t               table of the totals since boot
+ *   sudo ./profiler_decode -F > prof.folded; flamegraph.pl prof.folded > prof.svg
+ *   sudo ./profiler_decode -o prof.bin      save a dump, read it with -f prof.bin
+ *
+ * The region is mapped from /dev/mem with O_SYNC, so it is read uncached; the
+ * target maps it write-through.  The task table is copied until a copy is seen
+ * with an even, unchanged sequence number.  Task times count every core,
+ * interrupt handler time is part of the time of the task it interrupted.
+ */
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "profiler.h"
+
+#define SNAPSHOT_RETRIES    (1000U)
+
+static struct profiler_shm prof;
+/*-----------------------------------------------------------*/
+
+/* Device memory takes aligned accesses only, so no memcpy() */
+static void copy64(void *dst, const volatile void *src, size_t size)
+{
+    const volatile uint64_t *s = src;
+    uint64_t *d = dst;
+    size_t i;
+
+    for (i = 0; i < size / sizeof(uint64_t); i++) {
+        d[i] = s[i];
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int snapshot(const volatile struct profiler_shm *shm)
+{
+    uint32_t seq, i;
+
+    for (i = 0; i < SNAPSHOT_RETRIES; i++) {
+        seq = shm->seq;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        copy64(&prof, shm, sizeof(prof));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (((seq & 1U) == 0U) && (seq == shm->seq)) {
+            return 0;
+        }
+        usleep(1000);
+    }
+    fprintf(stderr, "no consistent snapshot\n");
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+static int read_mem(void)
+{
+    const volatile struct profiler_shm *shm;
+    size_t len = (sizeof(prof) + 4095U) & ~(size_t)4095U;
+    void *map;
+    int fd, ret;
+
+    fd = open("/dev/mem", O_RDONLY | O_SYNC);
+    if (fd < 0) {
+        perror("/dev/mem");
+        return -1;
+    }
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, (off_t)PROFILER_SHM_ADDR);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+    shm = map;
+    ret = snapshot(shm);
+    munmap(map, len);
+    return ret;
+}
+/*-----------------------------------------------------------*/
+
+static int read_file(const char *path)
+{
+    FILE *f = fopen(path, "rb");
+    size_t n;
+
+    if (f == NULL) {
+        perror(path);
+        return -1;
+    }
+    n = fread(&prof, 1, sizeof(prof), f);
+    fclose(f);
+    if (n != sizeof(prof)) {
+        fprintf(stderr, "%s: %zu bytes, expected %zu\n", path, n, sizeof(prof));
+        return -1;
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static int write_file(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+
+    if ((f == NULL) || (fwrite(&prof, sizeof(prof), 1, f) != 1)) {
+        perror(path);
+        return -1;
+    }
+    return fclose(f);
+}
+/*-----------------------------------------------------------*/
+
+static double ticks_to_us(uint64_t ticks)
+{
+    return (double)ticks * 1e6 / (double)prof.cntfrq;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t task_time(const struct profiler_task *task, int totals)
+{
+    return totals ? task->run_total : task->run_window;
+}
+/*-----------------------------------------------------------*/
+
+static void print_table(int totals)
+{
+    const struct profiler_task *task;
+    const struct profiler_irq *irq;
+    uint64_t span = totals ? prof.timestamp : prof.window;
+    uint32_t core, i;
+
+    printf("%s: %.3f s, %u cores, CNTFRQ %u Hz, period %u ms (%llu periods)%s\n",
+           totals ? "since boot" : "last period", ticks_to_us(span) / 1e6, prof.num_cores,
+           prof.cntfrq, prof.period_ms, (unsigned long long)prof.periods,
+           (prof.flags & PROFILER_FLAG_TOO_MANY_TASKS) ? ", too many tasks for the table" : "");
+
+    /* A task runs on one core at a time, so its share is of one core */
+    printf("\n%-16s %4s %4s %8s %12s %10s\n", "task", "num", "prio", "cpu %", "time us", "switches");
+    for (i = 0; i < prof.num_tasks; i++) {
+        task = &prof.tasks[i];
+        printf("%-16.16s %4u %4u %7.2f%% %12.0f %10llu\n", task->name, task->number, task->priority,
+               span ? 100.0 * (double)task_time(task, totals) / (double)span : 0.0,
+               ticks_to_us(task_time(task, totals)), (unsigned long long)task->switches);
+    }
+
+    printf("\n%-6s %12s\n", "core", "switches");
+    for (core = 0; core < prof.num_cores; core++) {
+        printf("%-6u %12llu\n", core, (unsigned long long)prof.switches[core]);
+    }
+
+    /* The interrupt counters are totals only */
+    printf("\n%-6s %4s %12s %12s %10s %10s\n", "irq", "core", "count", "total us", "avg us", "max us");
+    for (core = 0; core < prof.num_cores; core++) {
+        for (i = 0; i < PROFILER_NUM_IRQS; i++) {
+            irq = &prof.irqs[core][i];
+            if (irq->count == 0U) {
+                continue;
+            }
+            printf("%-6u %4u %12llu %12.0f %10.2f %10.2f\n", i, core, (unsigned long long)irq->count,
+                   ticks_to_us(irq->ticks), ticks_to_us(irq->ticks) / (double)irq->count,
+                   ticks_to_us(irq->max_ticks));
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* "frame;frame;... value" lines, the value in microseconds */
+static void print_folded(int totals)
+{
+    const struct profiler_task *task;
+    const struct profiler_irq *irq;
+    uint32_t core, i;
+    uint64_t us;
+
+    for (i = 0; i < prof.num_tasks; i++) {
+        task = &prof.tasks[i];
+        us = (uint64_t)ticks_to_us(task_time(task, totals));
+        if (us > 0U) {
+            printf("FreeRTOS;tasks;%.16s %llu\n", task->name, (unsigned long long)us);
+        }
+    }
+    for (core = 0; core < prof.num_cores; core++) {
+        for (i = 0; i < PROFILER_NUM_IRQS; i++) {
+            irq = &prof.irqs[core][i];
+            us = (uint64_t)ticks_to_us(irq->ticks);
+            if (us > 0U) {
+                printf("FreeRTOS;irq;core%u;irq%u %llu\n", core, i, (unsigned long long)us);
+            }
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-t] [-F] [-f dump] [-o dump]\n"
+            "  -t       totals since boot instead of the last period\n"
+            "  -F       folded stacks for flame graphs instead of a table\n"
+            "  -f dump  read a dump instead of /dev/mem\n"
+            "  -o dump  write the data read to a dump\n", prog);
+    exit(1);
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *in = NULL, *out = NULL;
+    int totals = 0, folded = 0, opt;
+
+    while ((opt = getopt(argc, argv, "tFf:o:")) != -1) {
+        switch (opt) {
+        case 't': totals = 1; break;
+        case 'F': folded = 1; break;
+        case 'f': in = optarg; break;
+        case 'o': out = optarg; break;
+        default: usage(argv[0]);
+        }
+    }
+
+    if ((in ? read_file(in) : read_mem()) != 0) {
+        return 1;
+    }
+    if ((prof.magic != PROFILER_MAGIC) || (prof.version != PROFILER_VERSION)) {
+        fprintf(stderr, "no profile (magic %08x version %u)\n", prof.magic, prof.version);
+        return 1;
+    }
+    if ((prof.num_cores > PROFILER_MAX_CORES) || (prof.num_tasks > PROFILER_MAX_TASKS) || (prof.cntfrq == 0U)) {
+        fprintf(stderr, "corrupt profile\n");
+        return 1;
+    }
+    if (out && (write_file(out) != 0)) {
+        return 1;
+    }
+
+    if (folded) {
+        print_folded(totals);
+    } else {
+        print_table(totals);
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,344 @@
+/* spi0_dma_test.c */
+/*
+ * Host test of the SPI0 DMA transfers of spi0.c: the control blocks built by
+ * spi0_dma_build_cbs() and spi0_send_recv_async() are run by a model of the
+ * legacy DMA engine and of SPI0 in DMA mode, against a slave that answers the
+ * complement of every byte.
+ *
+ * Build and run on the host:
+ *   D=../driver
+ *   gcc -O2 -I$D/spi_v1_0/src -I$D/cpu_cortexa72_v1_0/src -I$D/bgpio_v1_0/src \
+ *       -I$D/standalone_v1_0/src -I$D/uart_v1_0/src spi0_dma_test.c -o spi0_dma_test
+ *   ./spi0_dma_test
+ *
+ * The model follows the control block chain from the channel's CONBLK_AD and
+ * checks the transfer information of each block (DREQ and peripheral, address
+ * increments, interrupt), that every address is the bus address of a buffer or
+ * of the SPI FIFO, and that the length in the header word matches the data.
+ * Each transfer is also checked for the cache maintenance of the buffers, the
+ * completion through spi0_dma_isr() or spi0_dma_busy(), and that no byte
+ * outside the receive buffer was written.
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spi0.h"
+
+/* The registers of SPI0 and of the DMA engine, in host memory */
+static struct Spi0Regs mock_spi;
+static struct DmaChannelRegs mock_dma[16];
+static reg32 mock_dma_enable;
+
+#undef REGS_SPI0
+#undef REGS_DMA
+#undef REGS_DMA_ENABLE
+#define REGS_SPI0           (&mock_spi)
+#define REGS_DMA(ch)        (&mock_dma[(ch)])
+#define REGS_DMA_ENABLE     mock_dma_enable
+
+#include "spi0.c"
+
+#undef printf
+#undef sprintf
+
+#define CHECK(x)            do { if (!(x)) { fprintf(stderr, "check failed %s:%d: %s\n", __FILE__, __LINE__, #x); exit(1); } } while (0)
+
+/* brcm,dma-channel-mask left to Linux by raspi4-rpmsg.dtso */
+#define LINUX_DMA_CHANNEL_MASK  (0x07c5U)
+
+#define TEST_MAXSIZE        (0xffffU)
+#define TEST_GUARD          (64U)
+
+static u8 test_tx[TEST_MAXSIZE];
+static u8 test_rx[TEST_MAXSIZE + TEST_GUARD];
+static u8 mosi[TEST_MAXSIZE + 8];
+static u8 miso[TEST_MAXSIZE + 8];
+
+static int callbacks;
+
+/* Cache maintenance done by spi0.c */
+#define MAX_RANGES          (16)
+static struct { unsigned long start, end; } flushed[MAX_RANGES], invalidated[MAX_RANGES];
+static int nflushed, ninvalidated;
+/*-----------------------------------------------------------*/
+
+/* What spi0.c needs from the rest of the firmware */
+
+void flush_dcache_range(unsigned long start, unsigned long end)
+{
+    CHECK(nflushed < MAX_RANGES);
+    flushed[nflushed].start = start;
+    flushed[nflushed++].end = end;
+}
+
+void invalidate_dcache_range(unsigned long start, unsigned long end)
+{
+    CHECK(ninvalidated < MAX_RANGES);
+    invalidated[ninvalidated].start = start;
+    invalidated[ninvalidated++].end = end;
+}
+
+u32 gpio_pin_set_func(u8 pinNumber, GpioFunc func) { (void)pinNumber; (void)func; return 0; }
+u32 gpio_pin_set_ev_detection(u8 pinNumber, GpioEvent event) { (void)pinNumber; (void)event; return 0; }
+u32 gpio_pin_enable(u8 pinNumber) { (void)pinNumber; return 0; }
+u32 gpio_setPinOutputBool(u8 pinNumber, u8 onOrOff) { (void)pinNumber; (void)onOrOff; return 0; }
+u32 gpio_initOutputPinWithPullNone(u8 pinNumber) { (void)pinNumber; return 0; }
+void tfp_printf(char *fmt, ...) { (void)fmt; }
+/*-----------------------------------------------------------*/
+
+/* Host address of a bus address range, which must lie in one buffer */
+static u8 *bus_to_host(u32 bus, u32 len)
+{
+    static const struct { void *base; size_t size; } regions[] = {
+        { dma_words, sizeof(dma_words) },
+        { dma_tx_cbs, sizeof(dma_tx_cbs) },
+        { &dma_rx_cb, sizeof(dma_rx_cb) },
+        { test_tx, sizeof(test_tx) },
+        { test_rx, sizeof(test_rx) },
+    };
+    u8 *host = NULL;
+    unsigned i;
+
+    for (i = 0; i < sizeof(regions) / sizeof(regions[0]); i++) {
+        u32 base = DMA_BUS_ADDR(regions[i].base);
+
+        if (bus >= base && bus - base + len <= regions[i].size) {
+            CHECK(host == NULL);
+            host = (u8 *)regions[i].base + (bus - base);
+        }
+    }
+    CHECK(host != NULL);
+    return host;
+}
+
+static int flushed_range(const void *p, size_t len)
+{
+    unsigned long start = (unsigned long)p;
+    int i;
+
+    for (i = 0; i < nflushed; i++) {
+        if (flushed[i].start <= start && start + len <= flushed[i].end) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static struct DmaControlBlock *cb_at(u32 bus)
+{
+    CHECK((bus & 31U) == 0U);
+    return (struct DmaControlBlock *)bus_to_host(bus, sizeof(struct DmaControlBlock));
+}
+/*-----------------------------------------------------------*/
+
+/* Run the TX chain: the bytes written to the SPI FIFO, header word included */
+static u32 run_tx(u32 conblk)
+{
+    u32 n = 0;
+
+    while (conblk != 0) {
+        struct DmaControlBlock *cb = cb_at(conblk);
+        u32 ti_fixed = DMA_TI_DEST_DREQ | (DMA_PERMAP_SPI0_TX << DMA_TI_PERMAP__SHIFT) | DMA_TI_WAIT_RESP;
+        u32 i;
+
+        CHECK(flushed_range(cb, sizeof(*cb)));
+        CHECK((cb->ti & ~DMA_TI_SRC_INC) == ti_fixed);
+        CHECK(cb->dest_ad == SPI0_FIFO_BUS_ADDR);
+        CHECK(cb->stride == 0);
+        CHECK(cb->txfr_len != 0);
+
+        if (cb->ti & DMA_TI_SRC_INC) {
+            u8 *src = bus_to_host(cb->source_ad, cb->txfr_len);
+
+            CHECK(flushed_range(src, cb->txfr_len));
+            memcpy(&mosi[n], src, cb->txfr_len);
+        } else {
+            /* The same word over and over */
+            u8 *src = bus_to_host(cb->source_ad, 4);
+
+            CHECK(flushed_range(src, 4));
+            for (i = 0; i < cb->txfr_len; i++) {
+                mosi[n + i] = src[i % 4U];
+            }
+        }
+        n += cb->txfr_len;
+        conblk = cb->nextconbk;
+    }
+    return n;
+}
+
+/* Run the RX block on the bytes read from the SPI FIFO */
+static void run_rx(u32 conblk, u32 size, int inten)
+{
+    struct DmaControlBlock *cb = cb_at(conblk);
+    u32 ti_fixed = DMA_TI_SRC_DREQ | (DMA_PERMAP_SPI0_RX << DMA_TI_PERMAP__SHIFT) | DMA_TI_WAIT_RESP;
+    u32 i;
+
+    CHECK(flushed_range(cb, sizeof(*cb)));
+    CHECK((cb->ti & ~(DMA_TI_DEST_INC | DMA_TI_INTEN)) == ti_fixed);
+    CHECK(!!(cb->ti & DMA_TI_INTEN) == inten);
+    CHECK(cb->source_ad == SPI0_FIFO_BUS_ADDR);
+    CHECK(cb->txfr_len == size);
+    CHECK(cb->nextconbk == 0);
+
+    if (cb->ti & DMA_TI_DEST_INC) {
+        memcpy(bus_to_host(cb->dest_ad, size), miso, size);
+    } else {
+        /* Every word goes to the same sink word */
+        u8 *dst = bus_to_host(cb->dest_ad, 4);
+
+        for (i = 0; i < size; i++) {
+            dst[i % 4U] = miso[i];
+        }
+    }
+}
+
+/* The DMA engine and SPI0 process a transfer started by spi0.c */
+static void run_transfer(u8 chip_select, u32 size)
+{
+    struct DmaChannelRegs *tx = REGS_DMA(SPI0_DMA_TX_CHANNEL);
+    struct DmaChannelRegs *rx = REGS_DMA(SPI0_DMA_RX_CHANNEL);
+    int inten;
+    u32 header, n, i;
+
+    CHECK(tx->cs & DMA_CS_ACTIVE);
+    CHECK(rx->cs & DMA_CS_ACTIVE);
+    CHECK(mock_spi.cs & CS_DMAEN);
+    CHECK(!(mock_spi.cs & CS_TA));
+
+    n = run_tx(tx->conblk_ad);
+
+    /* "the transfer length in bytes in the top sixteen bits, and the control
+    register settings [7:0] in the bottom eight bits" */
+    memcpy(&header, mosi, sizeof(header));
+    CHECK(header >> 16 == size);
+    CHECK(header & CS_TA);
+    CHECK((header & CS_CS) == chip_select);
+    CHECK(!(header & (CS_CLEAR_RX | CS_CLEAR_TX)));
+    CHECK(n == 4U + size);
+
+    /* The slave answers the complement of each byte */
+    memmove(mosi, mosi + 4, size);
+    for (i = 0; i < size; i++) {
+        miso[i] = (u8)~mosi[i];
+    }
+
+    inten = !!(cb_at(rx->conblk_ad)->ti & DMA_TI_INTEN);
+    run_rx(rx->conblk_ad, size, inten);
+
+    tx->cs = (tx->cs & ~DMA_CS_ACTIVE) | DMA_CS_END;
+    rx->cs = (rx->cs & ~DMA_CS_ACTIVE) | DMA_CS_END | (inten ? DMA_CS_INT : 0);
+}
+/*-----------------------------------------------------------*/
+
+static void done(void *arg)
+{
+    CHECK(arg == &callbacks);
+    CHECK(!dma_active);
+    callbacks++;
+}
+
+static void test_transfer(u32 size, int write, int read, int async)
+{
+    u8 *s = write ? test_tx : NULL;
+    u8 *r = read ? test_rx : NULL;
+    u32 i;
+
+    for (i = 0; i < size; i++) {
+        test_tx[i] = (u8)(i * 7U + size);
+    }
+    memset(test_rx, 0x55, sizeof(test_rx));
+    nflushed = ninvalidated = 0;
+    callbacks = 0;
+
+    CHECK(spi0_send_recv_async(0, s, r, size, async ? done : NULL, &callbacks) == 0);
+    CHECK(spi0_send_recv_async(0, s, r, size, NULL, NULL) == -1);
+    if (!async) {
+        CHECK(spi0_dma_busy());
+    }
+
+    run_transfer(0, size);
+
+    if (async) {
+        spi0_dma_isr();
+        CHECK(callbacks == 1);
+        spi0_dma_isr();
+        CHECK(callbacks == 1);
+    } else {
+        CHECK(!spi0_dma_busy());
+    }
+    CHECK(!dma_active);
+    CHECK(!(mock_spi.cs & (CS_TA | CS_DMAEN)));
+
+    /* What was sent, and what was received */
+    for (i = 0; i < size; i++) {
+        CHECK(mosi[i] == (write ? test_tx[i] : 0));
+        CHECK(test_rx[i] == (read ? (u8)~mosi[i] : 0x55));
+    }
+    for (i = size; i < size + TEST_GUARD; i++) {
+        CHECK(test_rx[i] == 0x55);
+    }
+    if (read) {
+        CHECK(ninvalidated == 1);
+        CHECK(invalidated[0].start == (unsigned long)test_rx);
+        CHECK(invalidated[0].end == (unsigned long)test_rx + size);
+    } else {
+        CHECK(ninvalidated == 0);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void test_build(void)
+{
+    struct DmaControlBlock tx[2], rx;
+
+    /* Write only: the answer goes to the sink word, no interrupt */
+    spi0_dma_build_cbs(tx, &rx, 0xc0001000U, 0xc0002000U, 0, 100, 0);
+    CHECK(tx[0].source_ad == 0xc0001000U && tx[0].txfr_len == 4);
+    CHECK(tx[0].nextconbk == DMA_BUS_ADDR(&tx[1]));
+    CHECK(tx[1].source_ad == 0xc0002000U && (tx[1].ti & DMA_TI_SRC_INC));
+    CHECK(tx[1].txfr_len == 100 && tx[1].nextconbk == 0);
+    CHECK(rx.dest_ad == 0xc0001008U && !(rx.ti & (DMA_TI_DEST_INC | DMA_TI_INTEN)));
+
+    /* Read only: the fill word is sent, the answer is stored */
+    spi0_dma_build_cbs(tx, &rx, 0xc0001000U, 0, 0xc0003000U, 100, 1);
+    CHECK(tx[1].source_ad == 0xc0001004U && !(tx[1].ti & DMA_TI_SRC_INC));
+    CHECK(rx.dest_ad == 0xc0003000U && (rx.ti & DMA_TI_DEST_INC) && (rx.ti & DMA_TI_INTEN));
+
+    /* Bus addresses of SDRAM go through the uncached alias */
+    CHECK(DMA_BUS_ADDR(0x12345678UL) == 0xd2345678U);
+}
+
+int main(void)
+{
+    static const u32 sizes[] = { SPI0_DMA_THRESHOLD, 33, 34, 35, 64, 590, 1518, TEST_MAXSIZE };
+    unsigned i;
+    int mode;
+
+    /* The channels used must not be left to Linux */
+    CHECK(!(LINUX_DMA_CHANNEL_MASK & (1U << SPI0_DMA_TX_CHANNEL)));
+    CHECK(!(LINUX_DMA_CHANNEL_MASK & (1U << SPI0_DMA_RX_CHANNEL)));
+    CHECK(SPI0_DMA_TX_CHANNEL != SPI0_DMA_RX_CHANNEL);
+
+    spi0_dma_init();
+    CHECK(mock_dma_enable == ((1U << SPI0_DMA_TX_CHANNEL) | (1U << SPI0_DMA_RX_CHANNEL)));
+
+    test_build();
+
+    CHECK(spi0_send_recv_async(0, test_tx, test_rx, 0, NULL, NULL) == -1);
+    CHECK(spi0_send_recv_async(0, test_tx, test_rx, TEST_MAXSIZE + 1, NULL, NULL) == -1);
+
+    /* Full duplex, write and read, each completed by the interrupt and by
+    polling */
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        for (mode = 0; mode < 6; mode++) {
+            test_transfer(sizes[i], mode % 3 != 2, mode % 3 != 1, mode >= 3);
+        }
+    }
+
+    printf("spi0 dma: all checks passed\n");
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,521 @@
+/* trace_collect.c */
+/*
+ * Linux side of the trace recorder (uart/src/trace_recorder.c): drains the
+ * per-core rings in the memory shared with FreeRTOS and writes the events in
+ * the JSON trace event format, which ui.perfetto.dev and chrome://tracing
+ * open.  Each core is a track with the running task as a slice and the
+ * interrupt handlers nested in it, the other kernel events are instants.
+ *
+ * Build and run on the Raspberry Pi, with the raspi4-rpmsg overlay loaded:
+ *   gcc -O2 -pthread -I../uart/src -I../../../Source/include trace_collect.c -o trace_collect
+ *   sudo ./trace_collect -t 10 -o trace.json
+ *
+ * The region is found as the UIO device named "shm", or given with -u.  For a
+ * test on any Linux host, -m maps a file instead, and -s runs the recorder
+ * itself on the host with two threads as the cores, each recording the given
+ * number of events into the file while they are collected:
+ *   ./trace_collect -m /tmp/trace.shm -s 1000000 -o trace.json
+ * The simulated cores wait while their ring is full, so every event must
+ * arrive; the counts are checked at the end.
+ */
+#include <dirent.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+/* The recorder writes to whatever the region is mapped at on the host */
+static void *sim_shm;
+#define TRACE_SHM_ADDR                  ((uintptr_t)sim_shm)
+
+/* Just enough of FreeRTOS.h and task.h for trace_recorder.c */
+#define INC_FREERTOS_H
+#define INC_TASK_H
+#define configNUM_CORES                 2
+#define portGET_CORE_ID()               (sim_core)
+#define TRACE_INVALIDATE_LINE(addr)     (void)(addr)
+static __thread unsigned sim_core;
+
+#include "trace_recorder.c"
+
+#define MAX_ISR_NESTING     (8U)
+#define SIM_TASKS           (3U)
+
+struct event {
+    uint64_t timestamp;
+    uint32_t object;
+    uint16_t event;
+    uint16_t core;
+};
+
+static const char *const event_names[TRACE_EV_COUNT] = {
+    "TASK_SWITCHED_IN", "TASK_SWITCHED_OUT", "TASK_CREATE", "TASK_DELETE",
+    "TASK_DELAY", "TASK_DELAY_UNTIL", "TASK_READY", "TASK_SUSPEND",
+    "TASK_RESUME", "TASK_PRIORITY_SET", "TASK_PRIORITY_INHERIT", "TASK_PRIORITY_DISINHERIT",
+    "TASK_NOTIFY", "TASK_NOTIFY_FROM_ISR", "TASK_NOTIFY_WAIT", "TICK",
+    "QUEUE_CREATE", "QUEUE_DELETE", "QUEUE_SEND", "QUEUE_SEND_FAILED",
+    "QUEUE_SEND_FROM_ISR", "QUEUE_RECEIVE", "QUEUE_RECEIVE_FAILED", "QUEUE_RECEIVE_FROM_ISR",
+    "QUEUE_PEEK", "QUEUE_BLOCK_SEND", "QUEUE_BLOCK_RECEIVE", "ISR_ENTER",
+    "ISR_EXIT", "TIMER_EXPIRED", "EVENT_GROUP_SET", "EVENT_GROUP_WAIT",
+    "STREAM_SEND", "STREAM_RECEIVE", "IDLE_SLEEP", "IDLE_WAKE",
+};
+
+static struct event *events;
+static size_t num_events, max_events;
+static uint64_t received[TRACE_MAX_CORES];
+static volatile sig_atomic_t stop;
+static uint64_t sim_events;
+static uint32_t cntfrq;
+static uint64_t first_timestamp;
+/*-----------------------------------------------------------*/
+
+/* trace_recorder.c on the host: CNTVCT is the monotonic clock in ns */
+uint64_t read_cntvct(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t read_cntfrq(void)
+{
+    return 1000000000U;
+}
+/*-----------------------------------------------------------*/
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    stop = 1;
+}
+/*-----------------------------------------------------------*/
+
+static void push(const struct event *ev)
+{
+    if (num_events == max_events) {
+        max_events = max_events ? max_events * 2U : 65536U;
+        events = realloc(events, max_events * sizeof(*events));
+        if (events == NULL) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    events[num_events++] = *ev;
+}
+/*-----------------------------------------------------------*/
+
+/* Takes the complete records of each ring, returns how many */
+static size_t drain(struct trace_shm *shm)
+{
+    const struct trace_record *rec;
+    struct trace_ring *ring;
+    struct event ev;
+    uint32_t core, tail, info;
+    size_t n = 0;
+
+    for (core = 0; core < shm->num_cores; core++) {
+        ring = &shm->rings[core];
+        tail = ring->tail;
+        for (;;) {
+            rec = &ring->rec[tail & (TRACE_RING_RECORDS - 1U)];
+            info = __atomic_load_n(&rec->info, __ATOMIC_ACQUIRE);
+            if (TRACE_INFO_SEQ(info) != ((tail + 1U) & 0xFFFFU)) {
+                break;  /* not written yet */
+            }
+            ev.timestamp = rec->timestamp;
+            ev.object = rec->object;
+            ev.event = (uint16_t)TRACE_INFO_EVENT(info);
+            ev.core = (uint16_t)core;
+            push(&ev);
+            tail++;
+            /* The record may be reused once tail has moved past it */
+            __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+            received[core]++;
+            n++;
+        }
+    }
+    return n;
+}
+/*-----------------------------------------------------------*/
+
+static void *map_file(const char *path, size_t *len, int create)
+{
+    void *map;
+    int fd;
+
+    fd = open(path, O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if ((fd < 0) || (create && (ftruncate(fd, TRACE_SHM_SIZE) != 0))) {
+        perror(path);
+        exit(1);
+    }
+    *len = TRACE_SHM_SIZE;
+    map = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return map;
+}
+/*-----------------------------------------------------------*/
+
+/* The generic-uio device that raspi4-rpmsg.dtso names "shm" */
+static void *map_uio(const char *dev, size_t *len)
+{
+    char path[300], buf[64], found[64];
+    struct dirent *de;
+    void *map;
+    FILE *f;
+    DIR *dir;
+    int fd;
+
+    found[0] = '\0';
+    if (dev == NULL) {
+        dir = opendir("/sys/class/uio");
+        while ((dir != NULL) && ((de = readdir(dir)) != NULL)) {
+            snprintf(path, sizeof(path), "/sys/class/uio/%s/name", de->d_name);
+            f = fopen(path, "r");
+            if ((f != NULL) && (fgets(buf, sizeof(buf), f) != NULL) && (strncmp(buf, "shm", 3) == 0) &&
+                ((buf[3] == '\n') || (buf[3] == '\0'))) {
+                snprintf(found, sizeof(found), "%.63s", de->d_name);
+            }
+            if (f != NULL) {
+                fclose(f);
+            }
+        }
+        if (dir != NULL) {
+            closedir(dir);
+        }
+        if (found[0] == '\0') {
+            fprintf(stderr, "no UIO device named shm, is the raspi4-rpmsg overlay loaded?\n");
+            exit(1);
+        }
+    } else {
+        snprintf(found, sizeof(found), "%s", strrchr(dev, '/') ? strrchr(dev, '/') + 1 : dev);
+    }
+
+    snprintf(path, sizeof(path), "/sys/class/uio/%s/maps/map0/size", found);
+    f = fopen(path, "r");
+    if ((f == NULL) || (fgets(buf, sizeof(buf), f) == NULL)) {
+        perror(path);
+        exit(1);
+    }
+    fclose(f);
+    *len = strtoul(buf, NULL, 0);
+    if (*len < TRACE_SHM_SIZE) {
+        fprintf(stderr, "%s: map0 is %zu bytes, the trace needs %lu\n", found, *len, TRACE_SHM_SIZE);
+        exit(1);
+    }
+
+    snprintf(path, sizeof(path), "/dev/%s", found);
+    fd = open(path, O_RDWR | O_SYNC);
+    if (fd < 0) {
+        perror(path);
+        exit(1);
+    }
+    map = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        exit(1);
+    }
+    return map;
+}
+/*-----------------------------------------------------------*/
+
+/* A simulated core: switches between tasks, sends and receives on a queue
+and takes an interrupt, as the kernel hooks would record it */
+static void *sim_core_thread(void *arg)
+{
+    struct trace_shm *shm = sim_shm;
+    struct trace_ring *ring;
+    uint32_t task = 0U, next;
+    uint64_t i;
+
+    sim_core = (unsigned)(uintptr_t)arg;
+    ring = &shm->rings[sim_core];
+    for (i = 0; i < sim_events; i++) {
+        /* Only the simulation waits, the target drops */
+        while (__atomic_load_n(&ring->head, __ATOMIC_RELAXED) -
+               __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= TRACE_RING_RECORDS) {
+            sched_yield();
+        }
+        switch (i % 6U) {
+        case 0:
+            trace_event(TRACE_EV_TASK_SWITCHED_OUT, 0x1000U + sim_core * 0x100U + task);
+            break;
+        case 1:
+            next = (task + 1U) % SIM_TASKS;
+            trace_event(TRACE_EV_TASK_SWITCHED_IN, 0x1000U + sim_core * 0x100U + next);
+            task = next;
+            break;
+        case 2:
+            trace_event(TRACE_EV_QUEUE_SEND, 0x2000U);
+            break;
+        case 3:
+            trace_event(TRACE_EV_ISR_ENTER, 27U + sim_core);
+            break;
+        case 4:
+            trace_event(TRACE_EV_ISR_EXIT, 27U + sim_core);
+            break;
+        default:
+            trace_event(TRACE_EV_QUEUE_RECEIVE, 0x2000U);
+            break;
+        }
+    }
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void sim_start(pthread_t *threads)
+{
+    static const char *const task_names[SIM_TASKS] = { "Sender", "Receiver", "IDLE" };
+    uint32_t core, task;
+    char name[TRACE_NAME_LEN];
+
+    trace_init();
+    for (core = 0; core < configNUM_CORES; core++) {
+        for (task = 0; task < SIM_TASKS; task++) {
+            snprintf(name, sizeof(name), "%s%u", task_names[task], core);
+            trace_name(0x1000U + core * 0x100U + task, TRACE_NAME_TASK, name);
+        }
+    }
+    trace_name(0x2000U, TRACE_NAME_QUEUE, "SimQueue");
+    for (core = 0; core < configNUM_CORES; core++) {
+        pthread_create(&threads[core], NULL, sim_core_thread, (void *)(uintptr_t)core);
+    }
+}
+/*-----------------------------------------------------------*/
+
+static int compare_events(const void *a, const void *b)
+{
+    const struct event *ea = a, *eb = b;
+
+    if (ea->timestamp != eb->timestamp) {
+        return (ea->timestamp < eb->timestamp) ? -1 : 1;
+    }
+    /* Same core, same time: keep the ring order */
+    return (ea < eb) ? -1 : (ea > eb);
+}
+/*-----------------------------------------------------------*/
+
+static const char *object_name(const struct trace_shm *shm, uint32_t object, char *buf)
+{
+    uint32_t i, n = shm->num_names;
+
+    if (n > TRACE_MAX_NAMES) {
+        n = TRACE_MAX_NAMES;
+    }
+    /* The latest entry wins, a handle may be reused after a delete */
+    for (i = n; i > 0U; i--) {
+        if (shm->names[i - 1U].object == object) {
+            snprintf(buf, TRACE_NAME_LEN + 4U, "%.*s", (int)TRACE_NAME_LEN, shm->names[i - 1U].name);
+            return buf;
+        }
+    }
+    snprintf(buf, TRACE_NAME_LEN + 4U, "0x%08" PRIx32, object);
+    return buf;
+}
+/*-----------------------------------------------------------*/
+
+static double ts_us(uint64_t timestamp)
+{
+    return (double)(timestamp - first_timestamp) * 1e6 / (double)cntfrq;
+}
+/*-----------------------------------------------------------*/
+
+static void slice(FILE *out, uint32_t core, const char *name, const char *cat, uint64_t start, uint64_t end)
+{
+    fprintf(out, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":\"%s\",\"cat\":\"%s\"}",
+            core, ts_us(start), ts_us(end) - ts_us(start), name, cat);
+}
+/*-----------------------------------------------------------*/
+
+static void write_json(FILE *out, const struct trace_shm *shm)
+{
+    uint64_t task_start[TRACE_MAX_CORES], isr_start[TRACE_MAX_CORES][MAX_ISR_NESTING];
+    uint32_t task_obj[TRACE_MAX_CORES], isr_depth[TRACE_MAX_CORES] = { 0 };
+    int task_open[TRACE_MAX_CORES] = { 0 };
+    char name[TRACE_NAME_LEN + 4U], irq[32];
+    const struct event *ev;
+    uint32_t core, i;
+    size_t n;
+
+    qsort(events, num_events, sizeof(*events), compare_events);
+    first_timestamp = num_events ? events[0].timestamp : 0U;
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(out, "{\"ph\":\"M\",\"pid\":1,\"name\":\"process_name\",\"args\":{\"name\":\"FreeRTOS\"}}");
+    for (core = 0; core < shm->num_cores; core++) {
+        fprintf(out, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"core %u\"}}",
+                core, core);
+    }
+
+    for (n = 0; n < num_events; n++) {
+        ev = &events[n];
+        core = ev->core;
+        switch (ev->event) {
+        case TRACE_EV_TASK_SWITCHED_IN:
+        case TRACE_EV_TASK_SWITCHED_OUT:
+            if (task_open[core]) {
+                slice(out, core, object_name(shm, task_obj[core], name), "task", task_start[core], ev->timestamp);
+            }
+            task_open[core] = (ev->event == TRACE_EV_TASK_SWITCHED_IN);
+            task_obj[core] = ev->object;
+            task_start[core] = ev->timestamp;
+            break;
+        case TRACE_EV_ISR_ENTER:
+            if (isr_depth[core] < MAX_ISR_NESTING) {
+                isr_start[core][isr_depth[core]] = ev->timestamp;
+            }
+            isr_depth[core]++;
+            break;
+        case TRACE_EV_ISR_EXIT:
+            if (isr_depth[core] == 0U) {
+                break;  /* entered before the trace starts */
+            }
+            isr_depth[core]--;
+            if (isr_depth[core] < MAX_ISR_NESTING) {
+                snprintf(irq, sizeof(irq), "IRQ %u", ev->object);
+                slice(out, core, irq, "irq", isr_start[core][isr_depth[core]], ev->timestamp);
+            }
+            break;
+        default:
+            fprintf(out, ",\n{\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"name\":\"%s\",\"cat\":\"kernel\","
+                    "\"args\":{\"object\":\"%s\"}}", core, ts_us(ev->timestamp),
+                    (ev->event < TRACE_EV_COUNT) ? event_names[ev->event] : "UNKNOWN",
+                    (ev->event == TRACE_EV_TICK) ? "tick" : object_name(shm, ev->object, name));
+            break;
+        }
+    }
+
+    /* Close what still runs at the end */
+    for (core = 0; core < shm->num_cores; core++) {
+        if (task_open[core] && num_events) {
+            slice(out, core, object_name(shm, task_obj[core], name), "task", task_start[core],
+                  events[num_events - 1U].timestamp);
+        }
+    }
+    for (i = 0; i < shm->num_cores; i++) {
+        fprintf(out, ",\n{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%u}}",
+                i, i);
+    }
+    fprintf(out, "\n]}\n");
+}
+/*-----------------------------------------------------------*/
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-u /dev/uioN | -m file [-s events]] [-o out.json] [-t seconds] [-n]\n"
+            "  -u dev     UIO device of the shared memory (default: the one named shm)\n"
+            "  -m file    map a file instead of the UIO device\n"
+            "  -s events  run the recorder on the host, events per simulated core, needs -m\n"
+            "  -o file    JSON output (default trace.json)\n"
+            "  -t sec     collect for sec seconds (default: until Ctrl-C)\n"
+            "  -n         drop what was recorded before the collector started\n", prog);
+    exit(1);
+}
+/*-----------------------------------------------------------*/
+
+int main(int argc, char **argv)
+{
+    const char *uio = NULL, *file = NULL, *out_path = "trace.json";
+    pthread_t threads[configNUM_CORES];
+    struct trace_shm *shm;
+    uint64_t deadline = 0U, dropped;
+    int opt, skip = 0, ok = 1;
+    uint32_t core;
+    size_t len;
+    FILE *out;
+
+    while ((opt = getopt(argc, argv, "u:m:s:o:t:n")) != -1) {
+        switch (opt) {
+        case 'u': uio = optarg; break;
+        case 'm': file = optarg; break;
+        case 's': sim_events = strtoull(optarg, NULL, 0); break;
+        case 'o': out_path = optarg; break;
+        case 't': deadline = read_cntvct() + strtoull(optarg, NULL, 0) * 1000000000ULL; break;
+        case 'n': skip = 1; break;
+        default: usage(argv[0]);
+        }
+    }
+    if ((sim_events != 0U) && (file == NULL)) {
+        usage(argv[0]);
+    }
+
+    shm = file ? map_file(file, &len, sim_events != 0U) : map_uio(uio, &len);
+    sim_shm = shm;
+    if (sim_events != 0U) {
+        sim_start(threads);
+    }
+    if ((__atomic_load_n(&shm->magic, __ATOMIC_ACQUIRE) != TRACE_MAGIC) || (shm->version != TRACE_VERSION) ||
+        (shm->num_cores > TRACE_MAX_CORES) || (shm->ring_records != TRACE_RING_RECORDS) || (shm->cntfrq == 0U)) {
+        fprintf(stderr, "no trace recorder (magic %08x version %u)\n", shm->magic, shm->version);
+        return 1;
+    }
+    cntfrq = shm->cntfrq;
+    if (skip) {
+        for (core = 0; core < shm->num_cores; core++) {
+            __atomic_store_n(&shm->rings[core].tail, __atomic_load_n(&shm->rings[core].head, __ATOMIC_ACQUIRE),
+                             __ATOMIC_RELEASE);
+        }
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    while (!stop && ((deadline == 0U) || (read_cntvct() < deadline))) {
+        if (drain(shm) == 0U) {
+            if (sim_events != 0U) {
+                /* Done once every simulated event is in */
+                for (core = 0; (core < configNUM_CORES) && (received[core] == sim_events); core++) {
+                }
+                if (core == configNUM_CORES) {
+                    break;
+                }
+                sched_yield();
+            } else {
+                usleep(1000);
+            }
+        }
+    }
+    if (sim_events != 0U) {
+        for (core = 0; core < configNUM_CORES; core++) {
+            pthread_join(threads[core], NULL);
+        }
+        drain(shm);
+    }
+
+    for (core = 0; core < shm->num_cores; core++) {
+        dropped = shm->rings[core].dropped;
+        fprintf(stderr, "core %u: %" PRIu64 " events, %" PRIu64 " dropped\n", core, received[core], dropped);
+        if ((sim_events != 0U) && ((received[core] != sim_events) || (dropped != 0U))) {
+            ok = 0;
+        }
+    }
+
+    out = fopen(out_path, "w");
+    if (out == NULL) {
+        perror(out_path);
+        return 1;
+    }
+    write_json(out, shm);
+    fclose(out);
+    fprintf(stderr, "%zu events written to %s\n", num_events, out_path);
+
+    if (!ok) {
+        fprintf(stderr, "simulated events missing\n");
+        return 1;
+    }
+    return 0;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,142 @@
+/* uart_baud_test.c */
+/*
+ * Host test of uart_baud_divisor() (uart_baud.c), the IBRD/FBRD computation
+ * of the PL011 driver.
+ *
+ * Build and run on the host:
+ *   gcc -O2 -I../../../Source/include -I../uart/src uart_baud_test.c -lm -o uart_baud_test
+ *   ./uart_baud_test
+ *
+ * The divisors of the rates in common use are checked against values worked
+ * out by hand from the PL011 TRM (BAUDDIV = clock / (16 * baud), FBRD the
+ * fraction rounded to 1/64), and the rates out of range against a result of 0.
+ * Then every baud rate from 1 to clock / 16 is checked, for several reference
+ * clocks, against a floating point reference: the divisor is the nearest
+ * 1/64 to the exact one, a carry out of the fraction goes to IBRD, and the
+ * rate returned is the one the divisor generates, rounded.  The worst error
+ * of the generated rate is printed for each clock.
+ */
+#include <stdint.h>
+
+/* Just enough of FreeRTOS.h for uart.h, whose putc() is not the one of
+stdio.h */
+#define INC_FREERTOS_H
+typedef uint64_t TickType_t;
+#define putc uart_putc
+
+#include "uart_baud.c"
+
+#undef putc
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define CHECK(x)            do { if (!(x)) { fprintf(stderr, "check failed %s:%d: %s\n", __FILE__, __LINE__, #x); exit(1); } } while (0)
+
+struct baud_case {
+    uint32_t clock;
+    uint32_t baud;
+    uint32_t ibrd;          /* 0: out of range */
+    uint32_t fbrd;
+};
+
+static const struct baud_case baud_cases[] = {
+    /* 48 MHz, init_uart_clock of the demo */
+    { 48000000U,     9600U, 312U,  32U },   /* 312.5 */
+    { 48000000U,   115200U,  26U,   3U },   /* 26.0417, 2.67/64 */
+    { 48000000U,   921600U,   3U,  16U },   /* 3.2552, 16.33/64 */
+    { 48000000U,  1000000U,   3U,   0U },
+    { 48000000U,  3000000U,   1U,   0U },   /* the highest rate */
+    { 48000000U,  3000001U,   1U,   0U },   /* rounds to the highest rate */
+    { 48000000U,  3100000U,   0U,   0U },   /* BAUDDIV below 1 */
+    { 48000000U,  4000000U,   0U,   0U },
+    { 48000000U,       45U,   0U,   0U },   /* IBRD above 0xffff */
+    { 48000000U,       46U, 65217U, 25U },  /* 65217.39 */
+    { 48000000U,        0U,   0U,   0U },
+    /* 3 MHz, the firmware default */
+    {  3000000U,   115200U,   1U,  40U },   /* 1.6276, 40.17/64 */
+    {  3000000U,    38400U,   4U,  57U },   /* 4.8828, 56.5/64 rounds up */
+    /* 64 MHz, needed for 4 Mbaud */
+    { 64000000U,  4000000U,   1U,   0U },
+    /* Fraction rounding up to the next integer: 1.9961 is 2 + 0/64 */
+    { 48000000U,  1503000U,   2U,   0U },
+};
+
+static const uint32_t baud_clocks[] = { 3000000U, 48000000U, 64000000U, 100000000U };
+/*-----------------------------------------------------------*/
+
+static void test_cases(void)
+{
+    const struct baud_case *c;
+    uint32_t ibrd, fbrd, rate;
+    unsigned i;
+
+    for (i = 0; i < sizeof(baud_cases) / sizeof(baud_cases[0]); i++) {
+        c = &baud_cases[i];
+        ibrd = fbrd = 0xdeadU;
+        rate = uart_baud_divisor(c->clock, c->baud, &ibrd, &fbrd);
+        if (c->ibrd == 0U) {
+            if (rate != 0U) {
+                fprintf(stderr, "%u at %u Hz: %u, expected out of range\n", c->baud, c->clock, rate);
+                exit(1);
+            }
+            continue;
+        }
+        if (rate == 0U || ibrd != c->ibrd || fbrd != c->fbrd) {
+            fprintf(stderr, "%u at %u Hz: IBRD %u FBRD %u, expected %u %u\n",
+                    c->baud, c->clock, ibrd, fbrd, c->ibrd, c->fbrd);
+            exit(1);
+        }
+    }
+    printf("%u fixed cases ok\n", (unsigned)(sizeof(baud_cases) / sizeof(baud_cases[0])));
+}
+/*-----------------------------------------------------------*/
+
+/* Every rate up to clock / 16 against the floating point divisor */
+static void test_sweep(uint32_t clock)
+{
+    uint32_t baud, ibrd, fbrd, rate, div, max = clock / 16U;
+    double exact, worst = 0.0, err;
+    uint32_t worst_baud = 0;
+
+    for (baud = 1U; baud <= max; baud++) {
+        exact = (double)clock * 4.0 / (double)baud;     /* BAUDDIV * 64 */
+        rate = uart_baud_divisor(clock, baud, &ibrd, &fbrd);
+        div = (uint32_t)llround(exact);
+
+        if ((div >> 6) == 0U || (div >> 6) > 0xffffU) {
+            CHECK(rate == 0U);
+            continue;
+        }
+        CHECK(rate != 0U);
+        CHECK(fbrd < 64U);
+        /* Nearest 1/64, the carry of a rounded up fraction is in IBRD */
+        CHECK(((ibrd << 6) | fbrd) == div);
+        CHECK(fabs((double)((ibrd << 6) | fbrd) - exact) <= 0.5 + 1e-9);
+        /* The rate generated by that divisor, to the nearest baud */
+        CHECK(fabs((double)rate - (double)clock * 4.0 / (double)div) <= 0.5 + 1e-9);
+
+        err = fabs((double)rate - (double)baud) / (double)baud;
+        if (err > worst) {
+            worst = err;
+            worst_baud = baud;
+        }
+    }
+    printf("%9u Hz: rates 1 to %u ok, worst error %.3f%% at %u baud\n",
+           clock, max, worst * 100.0, worst_baud);
+}
+/*-----------------------------------------------------------*/
+
+int main(void)
+{
+    unsigned i;
+
+    test_cases();
+    for (i = 0; i < sizeof(baud_clocks) / sizeof(baud_clocks[0]); i++) {
+        test_sweep(baud_clocks[i]);
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
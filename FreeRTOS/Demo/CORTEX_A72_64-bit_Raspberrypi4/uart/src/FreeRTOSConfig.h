@@ -30,7 +30,7 @@
 
 #define configCPU_CLOCK_HZ						100000000UL
 #define configUSE_PORT_OPTIMISED_TASK_SELECTION	1
-#define configUSE_TICKLESS_IDLE					0
+#define configUSE_TICKLESS_IDLE					1
 #define configTICK_RATE_HZ						( ( TickType_t ) 1000 )
 #define configPERIPHERAL_CLOCK_HZ  				( 33333000UL )
 #define configUSE_PREEMPTION					1
@@ -53,6 +53,7 @@
 #define configUSE_COUNTING_SEMAPHORES			1
 #define configUSE_QUEUE_SETS					1
 #define configNUM_THREAD_LOCAL_STORAGE_POINTERS	3 /* FreeRTOS+FAT requires 2 pointers if a CWD is supported. */
+#define configUSE_INDEXED_LISTS					0 /* The demo keeps about ten delayed tasks and timers, too few for the index to pay off (tools/list_bench.c). */
 
 #define configUSE_MUTEXES						1
 
@@ -61,6 +62,8 @@
 #define configTIMER_TASK_PRIORITY				( configMAX_PRIORITIES - 1 )
 #define configTIMER_QUEUE_LENGTH				5
 #define configTIMER_TASK_STACK_DEPTH			( configMINIMAL_STACK_SIZE * 2 )
+#define configUSE_TIMER_DIRECT_COMMANDS			1 /* Timer commands from the timer task bypass the timer queue. */
+#define configTIMER_COMMAND_BATCH_LENGTH		configTIMER_QUEUE_LENGTH
 
 /* Set the following definitions to 1 to include the API function, or zero
 to exclude the API function. */
@@ -86,11 +89,73 @@ void vConfigureTickInterrupt( void );
 #define configSETUP_TICK_INTERRUPT() vConfigureTickInterrupt()
 void vClearTickInterrupt( void );
 #define configCLEAR_TICK_INTERRUPT() vClearTickInterrupt()
+/* TickType_t is not defined yet, it is a uint64_t on this port. */
+void vApplicationSleep( uint64_t xExpectedIdleTime );
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vApplicationSleep( xExpectedIdleTime )
+
+/* FreeRTOS runs on two cores, see startup.S.  The tick interrupt is handled
+by the first one. */
+#define configNUM_CORES							2
+void vConfigureYieldInterrupt( void );
+#define configSETUP_YIELD_INTERRUPT() vConfigureYieldInterrupt()
+void start_secondary_cores( void );
+#define configSTART_SECONDARY_CORES() start_secondary_cores()
+
+/* Run time stats count CNTVCT_EL0 (see portmacro.h), profiler.c publishes them
+to Linux together with the context switches counted here.  It also keeps the
+time in the idle tasks the benchmarks derive the CPU load from. */
+#define configGENERATE_RUN_TIME_STATS			1
+#define configRUN_TIME_COUNTER_TYPE				uint64_t
+void profiler_task_switched_in( uint64_t number, uint32_t idle );
+
+/* PMU counts of the network stack and of yields, see pmu.h.  Set to 0 to
+build without the probes. */
+#define configUSE_PMU_PROBES					1
+#if( configUSE_PMU_PROBES == 1 )
+	void pmu_yield_begin( void );
+	void pmu_yield_end( void );
+	#define traceTASK_YIELD()		pmu_yield_begin()
+	#define tracePMU_SWITCHED_IN()	pmu_yield_end()
+#else
+	#define tracePMU_SWITCHED_IN()
+#endif
+
+/* Set to 1 to measure interrupt latency, scheduling latency and critical
+section lengths, see latency.h and tools/latency_report.c.  Off by default: the
+harness wakes a top priority task every LATENCY_PERIOD_US, which keeps the
+cores out of tickless idle, and times every critical section.  The IRQ vector
+stamps CNTVCT either way. */
+#define configUSE_LATENCY_HARNESS				0
+#if( configUSE_LATENCY_HARNESS == 1 )
+	void latency_critical_enter( void *site );
+	void latency_critical_exit( void );
+	#define traceCRITICAL_ENTER()	latency_critical_enter( __builtin_return_address( 0 ) )
+	#define traceCRITICAL_EXIT()	latency_critical_exit()
+#endif
+
+/* Kernel events are recorded to the memory shared with Linux, see
+trace_hooks.h.  Set to 0 to build without the trace hooks. */
+#define configUSE_TRACE_RECORDER				1
+#if( configUSE_TRACE_RECORDER == 1 )
+	#include "trace_hooks.h"
+	#define traceTASK_SWITCHED_IN()	do { tracePMU_SWITCHED_IN();											\
+									 profiler_task_switched_in( pxCurrentTCB->uxTCBNumber,					\
+																( uint32_t ) ( pxCurrentTCB == xIdleTaskHandle ) );	\
+									 trace_event( TRACE_EV_TASK_SWITCHED_IN, TRACE_OBJ( pxCurrentTCB ) ); } while( 0 )
+#else
+	#define traceTASK_SWITCHED_IN()	do { tracePMU_SWITCHED_IN();											\
+									 profiler_task_switched_in( pxCurrentTCB->uxTCBNumber,					\
+																( uint32_t ) ( pxCurrentTCB == xIdleTaskHandle ) ); } while( 0 )
+#endif
 
 #define configINTERRUPT_CONTROLLER_BASE_ADDRESS (0xFF841000U)
 #define configINTERRUPT_CONTROLLER_CPU_INTERFACE_OFFSET (0x1000U)
 #define configUNIQUE_INTERRUPT_PRIORITIES		(16)
-#define configMAX_API_CALL_INTERRUPT_PRIORITY	(14)
+/* GIC priority 0xA0: interrupts that use the FreeRTOS API must be registered
+at 0xA0 or below (numerically higher), isr_register() refuses the others.
+Handlers nest, each one can be preempted by those at a higher priority, see
+interrupt.h. */
+#define configMAX_API_CALL_INTERRUPT_PRIORITY	(10)
 
 
 /****** TCP demo settings. ****************************************************/
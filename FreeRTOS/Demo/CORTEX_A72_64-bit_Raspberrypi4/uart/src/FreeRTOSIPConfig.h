@@ -373,7 +373,13 @@ device, and pdFALSE in all other cases.  */
 
 /* Set to 1 if the driver's transmit function is using zero copy.  Otherwise set
 to 0. */
-#define ipconfigZERO_COPY_TX_DRIVER			0
+#define ipconfigZERO_COPY_TX_DRIVER			1
+
+/* Keep the free network buffer descriptors and TCP segment descriptors in
+lock-free fixed-block pools (pool.h) rather than in lists guarded by critical
+sections. */
+#define ipconfigBUFFER_ALLOC_USE_POOL		1
+#define ipconfigTCP_WIN_USE_POOL			1
 
 
 /* UDP Logging related constants follow.  The standard UDP logging facility
@@ -387,12 +393,40 @@ extern int lUDPLoggingPrintf( const char *pcFormatString, ... );
 #include "printf.h"
 #define xil_newline(...)			do { printf(__VA_ARGS__); printf("\r\n"); } while (0)
 
+/* The IP stack logs through the deferred binary log so that formatting and
+UART output happen in the binlog task, not in the IP task.  Set to 0 to print
+synchronously from the IP task instead, to compare the two with the event
+latency below. */
+#define ipconfigDEFERRED_LOGGING	1
+#if( ipconfigDEFERRED_LOGGING == 1 )
+	#include "binlog.h"
+	#define ipLOG_PRINTF				binlog_printf
+#else
+	#define ipLOG_PRINTF				tfp_printf
+#endif
+
+/* With the latency harness, how long events wait for the IP-task goes to the
+ip_event histogram, see tools/latency_report.c. */
+#if( configUSE_LATENCY_HARNESS == 1 )
+	#include "hrtimer.h"
+	#include "latency.h"
+	#define ipconfigMEASURE_EVENT_LATENCY	1
+	#define ipconfigEVENT_TIMESTAMP()		hrtimer_now()
+	#define iptraceEVENT_LATENCY( eEvent, ullWaited )	latency_ip_event( ullWaited )
+#endif
+
+/* Scoped PMU probes on the packet processing paths, see pmu.h. */
+#if( configUSE_PMU_PROBES == 1 )
+	#include "pmu.h"
+	#define iptracePROBE_SCOPE( xProbe )	PMU_SCOPE( PMU_PROBE_##xProbe )
+#endif
+
 /* Set to 1 to print out debug messages.  If ipconfigHAS_DEBUG_PRINTF is set to
 1 then FreeRTOS_debug_printf should be defined to the function used to print
 out the debugging messages. */
 #define ipconfigHAS_DEBUG_PRINTF	1
 #if( ipconfigHAS_DEBUG_PRINTF == 1 )
-	#define FreeRTOS_debug_printf(X)    tfp_printf X
+	#define FreeRTOS_debug_printf(X)    ipLOG_PRINTF X
 #endif
 
 /* Set to 1 to print out non debugging messages, for example the output of the
@@ -401,7 +435,7 @@ then FreeRTOS_printf should be set to the function used to print out the
 messages. */
 #define ipconfigHAS_PRINTF			1
 #if( ipconfigHAS_PRINTF == 1 )
-	#define FreeRTOS_printf(tfp_printf) //			xil_newline X
+	#define FreeRTOS_printf(X)			ipLOG_PRINTF X
 #endif
 
 
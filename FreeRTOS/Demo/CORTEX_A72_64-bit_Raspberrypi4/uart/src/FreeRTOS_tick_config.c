@@ -5,10 +5,19 @@
 #include "interrupt.h"
 #include "board.h"
 #include "uart.h"
+#include "profiler.h"
+#include "trace_recorder.h"
+#include "latency.h"
 
 /* Vector table */
 extern INTERRUPT_VECTOR InterruptHandlerFunctionTable[MAX_NUM_IRQS];
 
+/* Tick and yield SGI, below the hrtimer and the UART (interrupt.h) */
+#define TICK_PRIORITY       (0xC0U)
+
+/* Longest time the tick is stopped for, the core wakes up at least once a minute */
+#define TICKLESS_MAX_TICKS  ((TickType_t)configTICK_RATE_HZ * 60U)
+
 /* ARM Generic Timer */
 static uint32_t timer_cntfrq = 0;
 static uint32_t timer_tick = 0;
@@ -28,6 +37,30 @@ void write_cntv_tval(uint32_t val)
 }
 /*-----------------------------------------------------------*/
 
+void write_cntv_cval(uint64_t val)
+{
+    asm volatile ("msr cntv_cval_el0, %0" :: "r" (val));
+    asm volatile ("isb");
+    return;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t read_cntv_cval(void)
+{
+    uint64_t val;
+    asm volatile ("mrs %0, cntv_cval_el0" : "=r" (val));
+    return val;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t read_cntvct(void)
+{
+    uint64_t val;
+    asm volatile ("isb; mrs %0, cntvct_el0" : "=r" (val));
+    return val;
+}
+/*-----------------------------------------------------------*/
+
 uint32_t read_cntfrq(void)
 {
     uint32_t val;
@@ -47,7 +80,7 @@ void init_timer(void)
 void timer_set_tick_rate_hz(uint32_t rate)
 {
     timer_tick = timer_cntfrq / rate ;
-    write_cntv_tval(timer_tick);
+    write_cntv_cval(read_cntvct() + timer_tick);
 }
 /*-----------------------------------------------------------*/
 
@@ -63,40 +96,119 @@ void vConfigureTickInterrupt( void )
     enable_cntv();
 
     /* register the time isr */
-    isr_register(IRQ_VTIMER, 0xA0U, (0x1U << 0x3U), FreeRTOS_Tick_Handler);
+    isr_register(IRQ_VTIMER, TICK_PRIORITY, RTOS_IRQ_CPUMASK, FreeRTOS_Tick_Handler);
 
     return;
 }
 /*-----------------------------------------------------------*/
 
+#if( configNUM_CORES > 1 )
+/* Called on each core, the SGI enable and priority registers are banked */
+void vConfigureYieldInterrupt( void )
+{
+    isr_register(portYIELD_CORE_SGI, TICK_PRIORITY, 0x0U, FreeRTOS_Yield_Handler);
+
+    return;
+}
+/*-----------------------------------------------------------*/
+#endif
+
 void vClearTickInterrupt( void )
 {
-    write_cntv_tval(timer_tick);    // clear cntv interrupt and set next timer.
+    uint64_t cval = read_cntv_cval();
+
+#if( configUSE_LATENCY_HARNESS == 1 )
+    latency_tick(cval);
+#endif
+    /* Clear cntv interrupt and set next timer.  The compare value moves by
+       exactly one tick, so the latency of this interrupt does not add up. */
+    write_cntv_cval(cval + timer_tick);
     return;
 }
 /*-----------------------------------------------------------*/
 
-void vApplicationIRQHandler( uint32_t ulICCIAR )
+#if( configUSE_TICKLESS_IDLE != 0 )
+/*
+ * portSUPPRESS_TICKS_AND_SLEEP(), called by the idle task with the scheduler
+ * suspended.  Instead of a tick every period, the timer compare value is set
+ * to the tick the next task unblocks at.  The compare value stays on the tick
+ * grid, so the ticks after waking keep their phase.
+ */
+void vApplicationSleep( TickType_t xExpectedIdleTime )
 {
-    uint32_t ulInterruptID, val;
+    uint64_t next_tick, wakeup, now;
+    TickType_t elapsed;
 
-    /* The ID of the interrupt can be obtained by bitwise ANDing the ICCIAR value
-    with 0x3FF. */
-    ulInterruptID = ulICCIAR & (0x3FFU);
+    /* The tick timer is banked, only the core that set it up stops it */
+    configASSERT(portGET_CORE_ID() == 0U);
 
-    /* prepare EOI notification */
-    if (ulInterruptID < 0x10) { // its a Software-Generated-Interrupt (SGI)
-        val = ((0x3U << 10) | ulInterruptID);
-#if 0
-    } else if (ulInterruptID == 0x3ff) {
+    if (xExpectedIdleTime > TICKLESS_MAX_TICKS) {
+        xExpectedIdleTime = TICKLESS_MAX_TICKS;
+    }
+
+    /* Masked in the CPU, not by priority, so a pending interrupt still ends WFI */
+    portDISABLE_INTERRUPTS();
+
+    if (eTaskConfirmSleepModeStatus() == eAbortSleep) {
+        portENABLE_INTERRUPTS();
         return;
-#endif
+    }
+
+    /* next_tick is the tick that has not been counted yet, the tick interrupt
+       at wakeup counts the last one */
+    next_tick = read_cntv_cval();
+    wakeup = next_tick + (uint64_t)(xExpectedIdleTime - 1U) * timer_tick;
+    write_cntv_cval(wakeup);
+
+    asm volatile ("dsb sy");
+    asm volatile ("wfi");
+    asm volatile ("isb");
+
+    now = read_cntvct();
+    if (now >= wakeup) {
+        elapsed = xExpectedIdleTime - 1U;
     } else {
-        val = ulInterruptID;
+        /* Woken early by another interrupt (UART, ENC28J60, ...).  Count the
+           ticks that have passed and go back to the next one on the grid. */
+        elapsed = 0U;
+        if (now >= next_tick) {
+            elapsed = (TickType_t)((now - next_tick) / timer_tick) + 1U;
+        }
+        write_cntv_cval(next_tick + (uint64_t)elapsed * timer_tick);
     }
-    eoi_notify(val);
+    vTaskStepTick(elapsed);
+
+    /* The interrupt that woke the core is taken here */
+    portENABLE_INTERRUPTS();
 
-    if (val >= MAX_NUM_IRQS) {
+    return;
+}
+/*-----------------------------------------------------------*/
+#endif
+
+/*
+ * Called by FreeRTOS_IRQ_Handler (portASM.S) with IRQs masked, after it saved
+ * ELR and SPSR on the IRQ stack.  The EOI is written by portASM.S once this
+ * returns, until then the running priority of the GIC is that of this
+ * interrupt, so the handler runs with IRQs unmasked and only interrupts of a
+ * higher priority preempt it.  The FreeRTOS_IRQ_Handler of a nested interrupt
+ * leaves the context switch to the outermost one.
+ */
+void vApplicationIRQHandler( uint32_t ulICCIAR )
+{
+    uint32_t ulInterruptID;
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+    uint64_t start;
+#endif
+#if( configUSE_LATENCY_HARNESS == 1 )
+    uint64_t outer_entry;
+#endif
+
+    /* The ID of the interrupt can be obtained by bitwise ANDing the ICCIAR value
+    with 0x3FF.  1023 is a spurious interrupt, its EOI is ignored. */
+    ulInterruptID = ulICCIAR & (0x3FFU);
+
+    if (ulInterruptID >= MAX_NUM_IRQS) {
         return;
     }
 
@@ -106,7 +218,32 @@ void vApplicationIRQHandler( uint32_t ulICCIAR )
     if (!(InterruptHandlerFunctionTable[ulInterruptID].fn)) {
         return;
     }
+#if( configUSE_TRACE_RECORDER == 1 )
+    trace_event(TRACE_EV_ISR_ENTER, ulInterruptID);
+#endif
+#if( configUSE_LATENCY_HARNESS == 1 )
+    outer_entry = latency_irq_dispatch();
+#endif
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+    /* The handler time is also counted in the run time of the interrupted
+    task, the profiler reports it separately per IRQ, including the handlers
+    nested in it. */
+    start = read_cntvct();
+#endif
+
+    portENABLE_INTERRUPTS();
     InterruptHandlerFunctionTable[ulInterruptID].fn();
+    portDISABLE_INTERRUPTS();
+
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+    profiler_irq_done(ulInterruptID, start);
+#endif
+#if( configUSE_LATENCY_HARNESS == 1 )
+    latency_irq_return(outer_entry);
+#endif
+#if( configUSE_TRACE_RECORDER == 1 )
+    trace_event(TRACE_EV_ISR_EXIT, ulInterruptID);
+#endif
 
     return;
 }
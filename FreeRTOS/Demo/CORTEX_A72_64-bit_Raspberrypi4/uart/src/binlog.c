@@ -0,0 +1,305 @@
+/* binlog.c */
+#include <stddef.h>
+#include <stdint.h>
+#include <stdarg.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "printf.h"
+#include "uart.h"
+#include "binlog.h"
+
+#ifdef configNUM_CORES
+#define BINLOG_CORES     (configNUM_CORES)
+#else
+#define BINLOG_CORES     (1U)
+#endif
+
+/* Bytes of %s arguments per record, fills the record up to 128 bytes */
+#define BINLOG_STR_SIZE  (40U)
+
+/* Formatted text is passed to BINLOG_OUTPUT in chunks of this size */
+#define BINLOG_BATCH     (256U)
+
+#define BINLOG_STACK     (1024U)
+#define BINLOG_PRIORITY  (tskIDLE_PRIORITY + 1U)
+
+/*
+ * seq is written last by the producer and holds the ring index + 1 of the
+ * record, so a slot still holding a record from the previous lap is not
+ * taken for a new one.
+ */
+struct BINLOG_REC {
+    volatile uint32_t seq;
+    uint32_t nargs;
+    const char *fmt;
+    uint64_t args[BINLOG_MAX_ARGS];
+    char str[BINLOG_STR_SIZE];
+};
+
+/*
+ * Multi-producer/single-consumer ring.  Producers reserve a slot by moving
+ * head with a compare-and-swap, so a task preempted by an interrupt handler
+ * that logs too keeps its slot; only the drain task moves tail.
+ */
+struct BINLOG_RING {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t dropped;
+    struct BINLOG_REC rec[BINLOG_RECORDS];
+} __attribute__((aligned(64)));
+
+struct BINLOG_OUT {
+    uint32_t len;
+    uint8_t buf[BINLOG_BATCH];
+};
+
+static struct BINLOG_RING binlog_rings[BINLOG_CORES];
+static uint32_t binlog_max_ticks;
+
+static inline uint32_t binlog_core(void)
+{
+    return (uint32_t)portGET_CORE_ID() % BINLOG_CORES;
+}
+/*-----------------------------------------------------------*/
+
+static inline uint64_t binlog_now(void)
+{
+    uint64_t cnt;
+
+    asm volatile ("isb; mrs %0, cntvct_el0" : "=r" (cnt));
+    return cnt;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * Takes the arguments tfp_format() will consume for fmt, parsing it the same
+ * way.  Every variadic argument occupies a 64-bit slot under AAPCS64, so the
+ * slots are stored as they are and the drain task hands them back in the
+ * same positions.
+ */
+static void binlog_capture(struct BINLOG_REC *rec, const char *fmt, va_list va)
+{
+    uint32_t nargs = 0U;
+    uint32_t used = 0U;
+    const char *s;
+    char ch;
+
+    while ((ch = *fmt++) != '\0' && nargs < BINLOG_MAX_ARGS) {
+        if (ch != '%') {
+            continue;
+        }
+        ch = *fmt++;
+        if (ch == '0') {
+            ch = *fmt++;
+        }
+        while (ch >= '0' && ch <= '9') {
+            ch = *fmt++;
+        }
+#ifdef PRINTF_LONG_SUPPORT
+        if (ch == 'l') {
+            ch = *fmt++;
+        }
+#endif
+        switch (ch) {
+        case '\0':
+            fmt--;
+            break;
+        case 's':
+            /* Replaced by a pointer into the record when formatting */
+            s = va_arg(va, const char *);
+            rec->args[nargs++] = used;
+            while (used < BINLOG_STR_SIZE - 1U && s != NULL && *s != '\0') {
+                rec->str[used++] = *s++;
+            }
+            rec->str[used] = '\0';
+            if (used < BINLOG_STR_SIZE - 1U) {
+                used++;
+            }
+            break;
+        case 'u':
+        case 'd':
+        case 'x':
+        case 'X':
+        case 'c':
+            rec->args[nargs++] = va_arg(va, uint64_t);
+            break;
+        default:
+            break;
+        }
+    }
+    rec->nargs = nargs;
+}
+/*-----------------------------------------------------------*/
+
+void binlog_printf(const char *fmt, ...)
+{
+    struct BINLOG_RING *ring = &binlog_rings[binlog_core()];
+    struct BINLOG_REC *rec;
+    uint64_t start = binlog_now();
+    uint32_t head, ticks, max;
+    va_list va;
+
+    head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    do {
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= BINLOG_RECORDS) {
+            __atomic_fetch_add(&ring->dropped, 1U, __ATOMIC_RELAXED);
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + 1U, 0,
+                                          __ATOMIC_ACQUIRE, __ATOMIC_RELAXED));
+
+    rec = &ring->rec[head & (BINLOG_RECORDS - 1U)];
+    rec->fmt = fmt;
+    va_start(va, fmt);
+    binlog_capture(rec, fmt, va);
+    va_end(va);
+    __atomic_store_n(&rec->seq, head + 1U, __ATOMIC_RELEASE);
+
+    ticks = (uint32_t)(binlog_now() - start);
+    max = __atomic_load_n(&binlog_max_ticks, __ATOMIC_RELAXED);
+    while (ticks > max &&
+           !__atomic_compare_exchange_n(&binlog_max_ticks, &max, ticks, 0,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) { }
+}
+/*-----------------------------------------------------------*/
+
+void binlog_stats(uint32_t *dropped, uint32_t *max_ticks)
+{
+    uint32_t core, total = 0U;
+
+    for (core = 0U; core < BINLOG_CORES; core++) {
+        total += __atomic_load_n(&binlog_rings[core].dropped, __ATOMIC_RELAXED);
+    }
+    *dropped = total;
+    *max_ticks = __atomic_load_n(&binlog_max_ticks, __ATOMIC_RELAXED);
+}
+/*-----------------------------------------------------------*/
+
+static void binlog_flush(struct BINLOG_OUT *out)
+{
+    if (out->len != 0U) {
+        BINLOG_OUTPUT(out->buf, out->len);
+        out->len = 0U;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void binlog_putc(void *p, char c)
+{
+    struct BINLOG_OUT *out = (struct BINLOG_OUT *)p;
+
+    if (out->len > BINLOG_BATCH - 2U) {
+        binlog_flush(out);
+    }
+    if (c == '\n') {
+        out->buf[out->len++] = '\r';
+    }
+    out->buf[out->len++] = (uint8_t)c;
+}
+/*-----------------------------------------------------------*/
+
+static void binlog_format(struct BINLOG_OUT *out, const char *fmt, ...)
+{
+    va_list va;
+
+    va_start(va, fmt);
+    tfp_format(out, binlog_putc, (char *)fmt, va);
+    va_end(va);
+}
+/*-----------------------------------------------------------*/
+
+/* Formats one record, rec is a private copy. */
+static void binlog_emit(struct BINLOG_OUT *out, struct BINLOG_REC *rec)
+{
+    const char *fmt = rec->fmt;
+    uint32_t n = 0U;
+    char ch;
+
+    /* Point the %s slots at the copied strings */
+    while ((ch = *fmt++) != '\0' && n < rec->nargs) {
+        if (ch != '%') {
+            continue;
+        }
+        ch = *fmt++;
+        if (ch == '0') {
+            ch = *fmt++;
+        }
+        while (ch >= '0' && ch <= '9') {
+            ch = *fmt++;
+        }
+#ifdef PRINTF_LONG_SUPPORT
+        if (ch == 'l') {
+            ch = *fmt++;
+        }
+#endif
+        if (ch == '\0') {
+            break;
+        } else if (ch == 's') {
+            rec->args[n] = (uint64_t)(uintptr_t)&rec->str[rec->args[n]];
+            n++;
+        } else if (ch == 'u' || ch == 'd' || ch == 'x' || ch == 'X' || ch == 'c') {
+            n++;
+        }
+    }
+
+    binlog_format(out, rec->fmt, rec->args[0], rec->args[1], rec->args[2], rec->args[3],
+                  rec->args[4], rec->args[5], rec->args[6], rec->args[7]);
+}
+/*-----------------------------------------------------------*/
+
+/* Formats the committed records of ring, returns how many. */
+static uint32_t binlog_drain(struct BINLOG_RING *ring, struct BINLOG_OUT *out)
+{
+    static struct BINLOG_REC rec;
+    struct BINLOG_REC *slot;
+    uint32_t tail = ring->tail;
+    uint32_t count = 0U;
+
+    for (;;) {
+        slot = &ring->rec[tail & (BINLOG_RECORDS - 1U)];
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != tail + 1U) {
+            break;  /* Empty, or the producer has not committed yet */
+        }
+        rec = *slot;
+        tail++;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        binlog_emit(out, &rec);
+        count++;
+    }
+    return count;
+}
+/*-----------------------------------------------------------*/
+
+static void binlog_task(void *pvParameters)
+{
+    static struct BINLOG_OUT out;
+    uint32_t core, count, dropped, reported = 0U, max_ticks;
+
+    (void) pvParameters;
+
+    for (;;) {
+        count = 0U;
+        for (core = 0U; core < BINLOG_CORES; core++) {
+            count += binlog_drain(&binlog_rings[core], &out);
+        }
+
+        binlog_stats(&dropped, &max_ticks);
+        if (dropped != reported) {
+            binlog_format(&out, "binlog: %u records dropped\n", dropped - reported);
+            reported = dropped;
+        }
+        binlog_flush(&out);
+
+        if (count == 0U) {
+            vTaskDelay(pdMS_TO_TICKS(BINLOG_DRAIN_MS));
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+void binlog_init(void)
+{
+    xTaskCreate(binlog_task, "binlog", BINLOG_STACK, NULL, BINLOG_PRIORITY, NULL);
+}
@@ -0,0 +1,40 @@
+/* binlog.h */
+#ifndef BINLOG_H
+#define BINLOG_H
+
+#include <stdint.h>
+
+/* Records per core, a power of two */
+#ifndef BINLOG_RECORDS
+#define BINLOG_RECORDS (64U)
+#endif
+
+/* Arguments kept per record, further arguments are dropped */
+#define BINLOG_MAX_ARGS (8U)
+
+/* Period of the drain task while the rings are empty */
+#ifndef BINLOG_DRAIN_MS
+#define BINLOG_DRAIN_MS (20U)
+#endif
+
+/* Where the formatted text goes, e.g. a UDP logging socket */
+#ifndef BINLOG_OUTPUT
+#define BINLOG_OUTPUT(buf, len) uart_write((buf), (len))
+#endif
+
+/*
+ * Deferred printf: the format pointer and the raw arguments are stored in a
+ * lock-free ring of the calling core, the drain task formats them later.
+ * Callable from tasks and interrupt handlers.  fmt must stay valid (a string
+ * literal), %s arguments are copied.
+ */
+void binlog_printf(const char *fmt, ...);
+
+/* Records lost because a ring was full, and the longest binlog_printf()
+call in CNTVCT ticks. */
+void binlog_stats(uint32_t *dropped, uint32_t *max_ticks);
+
+/* Creates the drain task, call before vTaskStartScheduler(). */
+void binlog_init(void);
+
+#endif /* BINLOG_H */
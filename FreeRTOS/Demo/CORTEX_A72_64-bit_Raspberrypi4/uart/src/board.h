@@ -6,6 +6,10 @@
 /* The number of IRQs on BCM2711 */
 #define MAX_NUM_IRQS (224U)
 
+/* FreeRTOS runs on cores #2 and #3, SPIs are routed to the first of them */
+#define RTOS_FIRST_CORE     (2U)
+#define RTOS_IRQ_CPUMASK    (0x1U << RTOS_FIRST_CORE)
+
 /* IRQ number which will be registered as an interrupt */
 #define IRQ_VC_UART (153)
 
@@ -38,7 +42,7 @@
 #define IRQ_VTIMER              (27)    // virtual timer for FreeRTOS_Tick_Handler
 #define IRQ_CCP2TX              (28)
 #define IRQ_GPU                 (29)
-#define IRQ_RESERVED0           (30)
+#define IRQ_PTIMER              (30)    // EL1 physical timer for hrtimer.c
 #define IRQ_RESERVED1           (31)
 #define IRQ_GPIO0               (32)
 #define IRQ_GPIO1               (33)
@@ -155,3 +159,4 @@
 #define IRQ_SD_CARD2            (144)
 #define IRQ_SD_CARD3            (145)
 #define IRQ_VC_UART             (153)   // Interrupt for uart sends
+#define IRQ_VC_DMA(ch)          (112 + (ch))    // Legacy DMA channels 0-10 (VideoCore IRQ 16 + ch)
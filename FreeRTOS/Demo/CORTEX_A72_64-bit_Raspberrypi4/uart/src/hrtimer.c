@@ -0,0 +1,337 @@
+/* hrtimer.c */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+#include "interrupt.h"
+#include "board.h"
+#include "hrtimer.h"
+
+/* GICD_SGIR, the target list is in bits 23:16 */
+#define GICD_SGIR           (GICD_BASE + 0xF00UL)
+#define GICD_SGIR_TARGETS   (16U)
+
+/* hrtimer_delay_us() */
+#define DELAY_WAITING   (0U)
+#define DELAY_FIRED     (1U)    /* the callback runs */
+#define DELAY_GIVEN     (2U)    /* the callback no longer touches the waiter */
+
+struct delay_wait {
+    SemaphoreHandle_t done;
+    volatile uint32_t state;
+};
+
+extern uint32_t read_cntfrq(void);
+extern uint64_t ullPortInterruptNesting[];
+
+/* Armed timers, heap[0] has the earliest deadline */
+static struct hrtimer *heap[HRTIMER_MAX_TIMERS];
+static uint32_t heap_len;
+static uint32_t heap_lock;
+static uint32_t cnt_per_mhz;
+
+static void hrtimer_isr(void);
+/*-----------------------------------------------------------*/
+
+static inline uint64_t read_cntpct(void)
+{
+    uint64_t val;
+    asm volatile ("isb; mrs %0, cntpct_el0" : "=r" (val));
+    return val;
+}
+/*-----------------------------------------------------------*/
+
+static inline void write_cntp_cval(uint64_t val)
+{
+    asm volatile ("msr cntp_cval_el0, %0" :: "r" (val));
+}
+/*-----------------------------------------------------------*/
+
+static inline void write_cntp_ctl(uint64_t val)
+{
+    asm volatile ("msr cntp_ctl_el0, %0" :: "r" (val));
+    asm volatile ("isb");
+}
+/*-----------------------------------------------------------*/
+
+/* The heap is shared by both cores and the timer interrupt, IRQs are masked
+while it is held so the interrupt cannot spin on its own core. */
+static uint64_t hrtimer_lock(void)
+{
+    uint64_t daif;
+
+    asm volatile ("mrs %0, daif" : "=r" (daif));
+    asm volatile ("msr daifset, #2" ::: "memory");
+    while (__atomic_exchange_n(&heap_lock, 1U, __ATOMIC_ACQUIRE) != 0U) {
+        while (__atomic_load_n(&heap_lock, __ATOMIC_RELAXED) != 0U) {
+            ;
+        }
+    }
+    return daif;
+}
+/*-----------------------------------------------------------*/
+
+static void hrtimer_unlock(uint64_t daif)
+{
+    __atomic_store_n(&heap_lock, 0U, __ATOMIC_RELEASE);
+    asm volatile ("msr daif, %0" :: "r" (daif) : "memory");
+}
+/*-----------------------------------------------------------*/
+
+static void heap_set(uint32_t idx, struct hrtimer *timer)
+{
+    heap[idx] = timer;
+    timer->slot = idx + 1U;
+}
+/*-----------------------------------------------------------*/
+
+static void heap_up(uint32_t idx)
+{
+    struct hrtimer *timer = heap[idx];
+    uint32_t parent;
+
+    while (idx > 0U) {
+        parent = (idx - 1U) / 2U;
+        if (heap[parent]->deadline <= timer->deadline) {
+            break;
+        }
+        heap_set(idx, heap[parent]);
+        idx = parent;
+    }
+    heap_set(idx, timer);
+}
+/*-----------------------------------------------------------*/
+
+static void heap_down(uint32_t idx)
+{
+    struct hrtimer *timer = heap[idx];
+    uint32_t child;
+
+    for (;;) {
+        child = 2U * idx + 1U;
+        if (child >= heap_len) {
+            break;
+        }
+        if ((child + 1U < heap_len) && (heap[child + 1U]->deadline < heap[child]->deadline)) {
+            child++;
+        }
+        if (timer->deadline <= heap[child]->deadline) {
+            break;
+        }
+        heap_set(idx, heap[child]);
+        idx = child;
+    }
+    heap_set(idx, timer);
+}
+/*-----------------------------------------------------------*/
+
+static void heap_remove(struct hrtimer *timer)
+{
+    uint32_t idx = timer->slot - 1U;
+
+    timer->slot = 0U;
+    heap_len--;
+    if (idx == heap_len) {
+        return;
+    }
+    heap[idx] = heap[heap_len];
+    heap_up(idx);
+    heap_down(heap[idx]->slot - 1U);
+}
+/*-----------------------------------------------------------*/
+
+/* Called with the lock held on core 0 */
+static void hrtimer_program(void)
+{
+    if (heap_len == 0U) {
+        write_cntp_ctl(0U);
+    } else {
+        write_cntp_cval(heap[0]->deadline);
+        write_cntp_ctl(1U);     // ENABLE, IMASK clear
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Called with the lock held after heap[0] changed */
+static void hrtimer_reprogram(void)
+{
+    if (portGET_CORE_ID() == 0U) {
+        hrtimer_program();
+    } else {
+        /* The physical timer is banked, let core 0 set it */
+        asm volatile ("dsb ishst" ::: "memory");
+        *(volatile uint32_t *)GICD_SGIR = (RTOS_IRQ_CPUMASK << GICD_SGIR_TARGETS) | HRTIMER_SGI;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void hrtimer_init(void)
+{
+    configASSERT(portGET_CORE_ID() == 0U);
+
+    cnt_per_mhz = read_cntfrq() / 1000000U;
+    write_cntp_ctl(0U);
+
+    /* PPI and SGI registers are banked, this sets them up for core 0 only */
+    isr_register(IRQ_PTIMER, HRTIMER_PRIORITY, RTOS_IRQ_CPUMASK, hrtimer_isr);
+    isr_register(HRTIMER_SGI, HRTIMER_PRIORITY, RTOS_IRQ_CPUMASK, hrtimer_isr);
+
+    return;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t hrtimer_now(void)
+{
+    return read_cntpct();
+}
+/*-----------------------------------------------------------*/
+
+uint64_t hrtimer_us_to_cnt(uint64_t us)
+{
+    return us * cnt_per_mhz;
+}
+/*-----------------------------------------------------------*/
+
+int hrtimer_start(struct hrtimer *timer, uint64_t deadline)
+{
+    struct hrtimer *first;
+    uint64_t daif;
+
+    daif = hrtimer_lock();
+    first = (heap_len > 0U) ? heap[0] : NULL;
+
+    if (timer->slot != 0U) {
+        heap_remove(timer);
+    } else if (heap_len == HRTIMER_MAX_TIMERS) {
+        hrtimer_unlock(daif);
+        return -1;
+    }
+    timer->deadline = deadline;
+    heap_len++;
+    heap_set(heap_len - 1U, timer);
+    heap_up(heap_len - 1U);
+
+    if ((heap[0] != first) || (first == timer)) {
+        hrtimer_reprogram();
+    }
+    hrtimer_unlock(daif);
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+int hrtimer_start_us(struct hrtimer *timer, uint64_t us)
+{
+    return hrtimer_start(timer, read_cntpct() + hrtimer_us_to_cnt(us));
+}
+/*-----------------------------------------------------------*/
+
+int hrtimer_cancel(struct hrtimer *timer)
+{
+    uint64_t daif;
+    int was_first;
+
+    daif = hrtimer_lock();
+    if (timer->slot == 0U) {
+        hrtimer_unlock(daif);
+        return -1;
+    }
+    was_first = (timer->slot == 1U);
+    heap_remove(timer);
+
+    /* A stale compare value only costs an interrupt that finds nothing to
+    run, core 0 disarms the timer right away, other cores leave it. */
+    if (was_first && (portGET_CORE_ID() == 0U)) {
+        hrtimer_program();
+    }
+    hrtimer_unlock(daif);
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/* Timer PPI and HRTIMER_SGI on core 0 */
+static void hrtimer_isr(void)
+{
+    struct hrtimer *timer;
+    uint64_t daif;
+
+    daif = hrtimer_lock();
+    while ((heap_len > 0U) && (heap[0]->deadline <= read_cntpct())) {
+        timer = heap[0];
+        heap_remove(timer);
+
+        /* Without the lock, so the callback can start timers */
+        hrtimer_unlock(daif);
+        timer->fn(timer);
+        daif = hrtimer_lock();
+    }
+    hrtimer_program();
+    hrtimer_unlock(daif);
+
+    return;
+}
+/*-----------------------------------------------------------*/
+
+static void delay_expired(struct hrtimer *timer)
+{
+    struct delay_wait *wait = timer->arg;
+    BaseType_t woken = pdFALSE;
+
+    __atomic_store_n(&wait->state, DELAY_FIRED, __ATOMIC_RELEASE);
+    xSemaphoreGiveFromISR(wait->done, &woken);
+    /* The waiter may return once it sees this */
+    __atomic_store_n(&wait->state, DELAY_GIVEN, __ATOMIC_RELEASE);
+
+    portYIELD_FROM_ISR(woken);
+}
+/*-----------------------------------------------------------*/
+
+void hrtimer_delay_us(uint64_t us)
+{
+    struct delay_wait wait;
+    struct hrtimer timer;
+    uint64_t deadline;
+
+    deadline = read_cntpct() + hrtimer_us_to_cnt(us);
+
+    wait.done = NULL;
+    wait.state = DELAY_WAITING;
+    timer.fn = delay_expired;
+    timer.arg = &wait;
+    timer.slot = 0U;
+
+    /* Blocking costs about as much as a short delay, and is not possible
+    before the scheduler runs or in an interrupt.  The semaphore is private to
+    this call: the notification value of the calling task can hold event bits
+    (e.g. ENC_EVENT_IRQ and ENC_EVENT_TX of the EMAC task) that a give would
+    merge with. */
+    if ((us >= HRTIMER_SPIN_US) &&
+        (xTaskGetSchedulerState() == taskSCHEDULER_RUNNING) &&
+        (ullPortInterruptNesting[portGET_CORE_ID()] == 0U)) {
+        wait.done = xSemaphoreCreateBinary();
+    }
+    if ((wait.done == NULL) || (hrtimer_start(&timer, deadline) != 0)) {
+        if (wait.done != NULL) {
+            vSemaphoreDelete(wait.done);
+        }
+        while (read_cntpct() < deadline) {
+            ;
+        }
+        return;
+    }
+
+    xSemaphoreTake(wait.done, portMAX_DELAY);
+    /* The callback runs on core 0, this may be core 1, and it may still be
+    inside xSemaphoreGiveFromISR() */
+    while (__atomic_load_n(&wait.state, __ATOMIC_ACQUIRE) != DELAY_GIVEN) {
+        ;
+    }
+    vSemaphoreDelete(wait.done);
+
+    return;
+}
+/*-----------------------------------------------------------*/
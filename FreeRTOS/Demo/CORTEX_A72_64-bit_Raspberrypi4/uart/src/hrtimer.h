@@ -0,0 +1,66 @@
+/* hrtimer.h */
+#ifndef HRTIMER_H
+#define HRTIMER_H
+
+#include <stdint.h>
+
+/* Timers that can be armed at the same time */
+#ifndef HRTIMER_MAX_TIMERS
+#define HRTIMER_MAX_TIMERS (32U)
+#endif
+
+/* hrtimer_delay_us() busy-waits for delays shorter than this */
+#ifndef HRTIMER_SPIN_US
+#define HRTIMER_SPIN_US (20U)
+#endif
+
+/* The most urgent interrupt, it preempts the others (interrupt.h) */
+#define HRTIMER_PRIORITY (0xA0U)
+
+/* SGI that makes core 0 reprogram the timer for a timer armed on another core */
+#define HRTIMER_SGI (1U)
+
+struct hrtimer;
+
+/* Called from the timer interrupt on core 0, the timer is no longer armed and
+can be started again from here. */
+typedef void (*hrtimer_fn)(struct hrtimer *timer);
+
+struct hrtimer {
+    uint64_t deadline;  /* CNTPCT value */
+    hrtimer_fn fn;
+    void *arg;
+    uint32_t slot;      /* Heap index + 1, 0 while not armed */
+};
+
+/*
+ * Microsecond timers on the EL1 physical timer of core 0, independent of the
+ * RTOS tick.  Armed timers are kept in a min-heap of deadlines, the compare
+ * value is always set to the earliest one.  Callable from tasks and interrupt
+ * handlers on any core.
+ */
+
+/* Sets up the timer and its interrupts, call on core 0 before
+vTaskStartScheduler(). */
+void hrtimer_init(void);
+
+/* Current CNTPCT value (equal to CNTVCT), and microseconds in CNTPCT ticks. */
+uint64_t hrtimer_now(void);
+uint64_t hrtimer_us_to_cnt(uint64_t us);
+
+/* Arm timer for the absolute CNTPCT value deadline, or us microseconds from
+now.  A timer that is armed already is moved.  Returns -1 when
+HRTIMER_MAX_TIMERS timers are armed. */
+int hrtimer_start(struct hrtimer *timer, uint64_t deadline);
+int hrtimer_start_us(struct hrtimer *timer, uint64_t us);
+
+/* Disarm timer.  Returns -1 when it was not armed (it may have fired). */
+int hrtimer_cancel(struct hrtimer *timer);
+
+/* Block the calling task for at least us microseconds, other tasks run
+meanwhile.  Busy-waits for less than HRTIMER_SPIN_US, in interrupts, before
+the scheduler runs and when no semaphore can be allocated.  Blocks on a binary
+semaphore of its own, the notification of the calling task is not touched. */
+void hrtimer_delay_us(uint64_t us);
+
+#endif /* HRTIMER_H */
@@ -1,3 +1,5 @@
+#include "FreeRTOS.h"
+
 #include "interrupt.h"
 #include "board.h"
 
@@ -22,6 +24,9 @@ int isr_register(uint32_t intno, uint32_t pri, uint32_t cpumask, void (*fn)(void
     if (!fn) {
         return -4;
     }
+    if (pri < IRQ_PRIORITY_MAX_API) {
+        return -5;
+    }
 
     /* GICD_ISENABLERn */
     n = intno / 32U;
@@ -1,6 +1,26 @@
 #include <stdint.h>
 
+/*
+ * GIC priorities, a lower value is more urgent.  vApplicationIRQHandler()
+ * runs each handler with IRQs unmasked in the CPU, and the GIC only signals
+ * interrupts of a higher priority than the one being handled, so a handler is
+ * preempted by those above it and never by its own level or those below.
+ *
+ *   0xA0  hrtimer (HRTIMER_PRIORITY)
+ *   0xB0  UART (UART_PRIORITY)
+ *   0xC0  tick and the yield SGI (FreeRTOS_tick_config.c)
+ *   0xD0  ENC28J60 and its SPI DMA (ETH_PRIORITY)
+ *
+ * All of them use the FreeRTOS API, so none may be above
+ * configMAX_API_CALL_INTERRUPT_PRIORITY: the critical sections of the kernel
+ * mask the priority mask register up to it.  Only 16 levels are implemented,
+ * the low four bits of a priority are ignored.
+ */
+#define IRQ_PRIORITY_MAX_API    (configMAX_API_CALL_INTERRUPT_PRIORITY << portPRIORITY_SHIFT)
+
 /* Functions */
+
+/* Returns -5 for a priority above IRQ_PRIORITY_MAX_API. */
 int isr_register(uint32_t intno, uint32_t pri, uint32_t cpumask, void (*fn)(void));
 void eoi_notify(uint32_t val);
 void wait_gic_init(void);
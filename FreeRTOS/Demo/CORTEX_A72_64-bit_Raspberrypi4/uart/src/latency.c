@@ -0,0 +1,223 @@
+/* latency.c */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "hrtimer.h"
+#include "latency.h"
+
+#if( configNUM_CORES > LATENCY_MAX_CORES )
+#error Raise LATENCY_MAX_CORES
+#endif
+
+#define LATENCY_STACK       (512U)
+#define LATENCY_PRIORITY    (configMAX_PRIORITIES - 1U)     /* with the timer task */
+
+/* irq_entry_cntvct[] has a cache line per core */
+#define ENTRY_STRIDE        (64U / sizeof(uint64_t))
+
+extern uint64_t read_cntvct(void);
+extern uint32_t read_cntfrq(void);
+
+static struct latency_shm * const shm = (struct latency_shm *)LATENCY_SHM_ADDR;
+
+typedef char latency_shm_fits[(sizeof(struct latency_shm) <= LATENCY_SHM_SIZE) ? 1 : -1];
+
+static uint32_t latency_ready;
+
+static TaskHandle_t latency_task_handle;
+static struct hrtimer latency_timer;
+static uint64_t latency_fired;      /* CNTVCT in the timer callback */
+
+/* Vector entry of the interrupt each core is handling, latency_irq_return()
+puts back the one of the interrupt a nested one preempted */
+static uint64_t irq_entry_current[configNUM_CORES];
+
+/* The outermost critical section of each core, site is NULL outside one */
+static uint64_t critical_start[configNUM_CORES];
+static void *critical_site[configNUM_CORES];
+/*-----------------------------------------------------------*/
+
+static void hist_add(struct latency_hist *hist, uint64_t ticks)
+{
+    if ((hist->count == 0U) || (ticks < hist->min)) {
+        hist->min = ticks;
+    }
+    if (ticks > hist->max) {
+        hist->max = ticks;
+    }
+    hist->sum += ticks;
+    hist->bucket[latency_bucket(ticks)]++;
+    hist->count++;
+}
+/*-----------------------------------------------------------*/
+
+static inline uint64_t irq_entry(void)
+{
+    return irq_entry_current[portGET_CORE_ID()];
+}
+/*-----------------------------------------------------------*/
+
+uint64_t latency_irq_dispatch(void)
+{
+    UBaseType_t core = portGET_CORE_ID();
+    uint64_t now = read_cntvct();
+    uint64_t outer_entry = irq_entry_current[core];
+
+    irq_entry_current[core] = irq_entry_cntvct[core * ENTRY_STRIDE];
+    if (latency_ready != 0U) {
+        hist_add(&shm->cores[core].dispatch, now - irq_entry_current[core]);
+    }
+    return outer_entry;
+}
+/*-----------------------------------------------------------*/
+
+void latency_irq_return(uint64_t outer_entry)
+{
+    irq_entry_current[portGET_CORE_ID()] = outer_entry;
+}
+/*-----------------------------------------------------------*/
+
+void latency_ip_event(uint64_t ticks)
+{
+    if (latency_ready != 0U) {
+        hist_add(&shm->harness.ip_event, ticks);
+    }
+}
+/*-----------------------------------------------------------*/
+
+void latency_tick(uint64_t cval)
+{
+    uint64_t entry = irq_entry();
+
+    if ((latency_ready == 0U) || (entry < cval)) {
+        return;
+    }
+    hist_add(&shm->cores[portGET_CORE_ID()].tick, entry - cval);
+}
+/*-----------------------------------------------------------*/
+
+void latency_critical_enter(void *site)
+{
+    UBaseType_t core = portGET_CORE_ID();
+
+    critical_site[core] = site;
+    critical_start[core] = read_cntvct();
+}
+/*-----------------------------------------------------------*/
+
+void latency_critical_exit(void)
+{
+    UBaseType_t core = portGET_CORE_ID();
+    struct latency_core *stats = &shm->cores[core];
+    struct latency_site *entry;
+    uint64_t ticks, site;
+    uint32_t idx, i;
+
+    ticks = read_cntvct() - critical_start[core];
+    site = (uint64_t)(uintptr_t)critical_site[core];
+    critical_site[core] = NULL;
+    if ((latency_ready == 0U) || (site == 0U)) {
+        return;
+    }
+
+    hist_add(&stats->critical, ticks);
+
+    /* Open addressing on the call site, entries are never removed */
+    idx = (uint32_t)((site >> 2) * 0x9E3779B1U) & (LATENCY_MAX_SITES - 1U);
+    for (i = 0; i < LATENCY_MAX_SITES; i++) {
+        entry = &stats->sites[(idx + i) & (LATENCY_MAX_SITES - 1U)];
+        if (entry->site == 0U) {
+            entry->site = site;
+        }
+        if (entry->site == site) {
+            entry->count++;
+            entry->ticks += ticks;
+            if (ticks > entry->max_ticks) {
+                entry->max_ticks = ticks;
+            }
+            return;
+        }
+    }
+    stats->sites_full++;
+}
+/*-----------------------------------------------------------*/
+
+/* Timer interrupt on core 0 */
+static void latency_timer_fn(struct hrtimer *timer)
+{
+    struct latency_harness *harness = &shm->harness;
+    BaseType_t woken = pdFALSE;
+    uint64_t entry;
+
+    latency_fired = read_cntvct();
+    entry = irq_entry();
+    if (entry >= timer->deadline) {
+        hist_add(&harness->timer_entry, entry - timer->deadline);
+    }
+    hist_add(&harness->timer_handler, latency_fired - timer->deadline);
+
+    vTaskNotifyGiveFromISR(latency_task_handle, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+/*-----------------------------------------------------------*/
+
+static void latency_task(void *param)
+{
+    struct latency_harness *harness = &shm->harness;
+    uint64_t period, period_start, deadline, now;
+    uint32_t seed = 0x2545F491U;
+
+    (void)param;
+
+    period = hrtimer_us_to_cnt(LATENCY_PERIOD_US);
+    period_start = hrtimer_now();
+    for (;;) {
+        /* xorshift32 */
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+
+        now = hrtimer_now();
+        period_start += period;
+        if (period_start < now) {
+            /* Fell behind, do not catch up with a burst */
+            period_start = now;
+        }
+        deadline = period_start + (seed % period);
+        if (hrtimer_start(&latency_timer, deadline) != 0) {
+            vTaskDelay(1);
+            continue;
+        }
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        now = read_cntvct();
+        hist_add(&harness->wake, now - latency_fired);
+        hist_add(&harness->total, now - deadline);
+    }
+}
+/*-----------------------------------------------------------*/
+
+void latency_init(void)
+{
+    uint64_t *p = (uint64_t *)shm;
+    size_t i;
+
+    for (i = 0; i < sizeof(*shm) / sizeof(uint64_t); i++) {
+        p[i] = 0U;
+    }
+    shm->version = LATENCY_VERSION;
+    shm->num_cores = configNUM_CORES;
+    shm->cntfrq = read_cntfrq();
+    /* Written last, the report tool ignores the region until then */
+    __atomic_store_n(&shm->magic, LATENCY_MAGIC, __ATOMIC_RELEASE);
+
+    latency_timer.fn = latency_timer_fn;
+    xTaskCreate(latency_task, "Latency", LATENCY_STACK, NULL, LATENCY_PRIORITY, &latency_task_handle);
+    latency_ready = 1U;
+
+    return;
+}
+/*-----------------------------------------------------------*/
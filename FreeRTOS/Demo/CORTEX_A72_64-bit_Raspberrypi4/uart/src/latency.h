@@ -0,0 +1,142 @@
+/* latency.h */
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+
+/*
+ * Where the measurements are kept: the last 256KB of the region that
+ * mmu_cfg.c maps as shared with Linux, above the PMU probes (pmu.h).  Linux
+ * reads them through /dev/mem, see tools/latency_report.c.
+ */
+#ifndef LATENCY_SHM_ADDR
+#define LATENCY_SHM_ADDR (0x207C0000UL)
+#endif
+#define LATENCY_SHM_SIZE (0x40000UL)
+
+/* Period of the harness timer, each one is started at a random point of the
+next period so the deadlines are not in phase with the tick */
+#ifndef LATENCY_PERIOD_US
+#define LATENCY_PERIOD_US (997U)
+#endif
+
+#define LATENCY_MAGIC       (0x4E45544CU)   /* "LTEN" */
+#define LATENCY_VERSION     (2U)
+
+/* Fixed, the report tool includes this header */
+#define LATENCY_MAX_CORES   (4U)
+#define LATENCY_MAX_SITES   (64U)   /* critical section call sites per core, a power of two */
+#define LATENCY_HIST_BUCKETS (64U)
+
+/*
+ * Histogram of CNTVCT ticks with four buckets per power of two: 0 to 3 have
+ * their own bucket, above that the two bits below the leading one pick one of
+ * four.  Bucket 63 starts at 7 * 2^14 ticks (2.1 ms at 54 MHz) and takes
+ * everything above.
+ */
+struct latency_hist {
+    uint64_t count;
+    uint64_t sum;
+    uint64_t min;
+    uint64_t max;
+    uint32_t bucket[LATENCY_HIST_BUCKETS];
+};
+
+static inline uint32_t latency_bucket(uint64_t ticks)
+{
+    uint32_t exp, idx;
+
+    if (ticks < 4U) {
+        return (uint32_t)ticks;
+    }
+    exp = 63U - (uint32_t)__builtin_clzll(ticks);
+    idx = 4U * (exp - 1U) + (uint32_t)((ticks >> (exp - 2U)) & 3U);
+    return (idx < LATENCY_HIST_BUCKETS) ? idx : (LATENCY_HIST_BUCKETS - 1U);
+}
+
+/* Lowest number of ticks in bucket idx */
+static inline uint64_t latency_bucket_low(uint32_t idx)
+{
+    if (idx < 4U) {
+        return idx;
+    }
+    return (uint64_t)(4U + (idx & 3U)) << (idx / 4U - 1U);
+}
+
+/* Outermost critical section entered from one call site */
+struct latency_site {
+    uint64_t site;      /* return address of vTaskEnterCritical() */
+    uint64_t count;
+    uint64_t ticks;     /* total with interrupts masked */
+    uint64_t max_ticks;
+};
+
+/* Written only by the core they belong to */
+struct latency_core {
+    struct latency_hist dispatch;   /* vector entry to the call of the handler, every IRQ */
+    struct latency_hist tick;       /* tick timer compare value to vector entry */
+    struct latency_hist critical;   /* interrupts masked by critical sections */
+    uint64_t sites_full;            /* sections not counted per site, the table was full */
+    struct latency_site sites[LATENCY_MAX_SITES];
+};
+
+/*
+ * The harness: a timer with a known deadline (hrtimer.h) wakes the latency
+ * task through a notification.  timer_entry and timer_handler are written by
+ * the timer interrupt on core 0, wake and total by the task.  ip_event is
+ * written by the IP-task, it is not part of the harness but kept with it.
+ */
+struct latency_harness {
+    struct latency_hist timer_entry;    /* deadline to vector entry */
+    struct latency_hist timer_handler;  /* deadline to the callback */
+    struct latency_hist wake;           /* callback to the task running */
+    struct latency_hist total;          /* deadline to the task running */
+    struct latency_hist ip_event;       /* event sent to the IP-task taking it */
+};
+
+struct latency_shm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_cores;
+    uint32_t cntfrq;        /* CNTVCT ticks per second */
+    struct latency_harness harness;
+    struct latency_core cores[LATENCY_MAX_CORES];
+};
+
+/*
+ * Interrupt and scheduling latency: the vector (FreeRTOS_asm_vector.S) stamps
+ * CNTVCT as the first thing on IRQ entry, vApplicationIRQHandler() measures
+ * from there to the dispatch, the tick handler from the compare value to the
+ * vector.  The kernel's outermost critical sections are timed per call site.
+ * Every field is updated on its own, the report tool takes the difference of
+ * two readings to measure an interval.
+ */
+
+/* CNTVCT at the vector entry of the latest IRQ of each core, 64 bytes apart,
+written by FreeRTOS_asm_vector.S.  A nested IRQ overwrites it, the entry of
+the interrupt being handled is kept by latency_irq_dispatch(). */
+extern uint64_t irq_entry_cntvct[];
+
+/* Clears the shared memory and creates the latency task, call after
+hrtimer_init() and before vTaskStartScheduler(). */
+void latency_init(void);
+
+/* vApplicationIRQHandler(), right before the handler is called.  Returns the
+entry of the interrupt this one is nested in, for latency_irq_return(). */
+uint64_t latency_irq_dispatch(void);
+
+/* vApplicationIRQHandler(), after the handler returned, IRQs masked. */
+void latency_irq_return(uint64_t outer_entry);
+
+/* The tick interrupt, with the compare value that made it fire. */
+void latency_tick(uint64_t cval);
+
+/* traceCRITICAL_ENTER() and traceCRITICAL_EXIT(), interrupts are masked. */
+void latency_critical_enter(void *site);
+void latency_critical_exit(void);
+
+/* iptraceEVENT_LATENCY(), how long an event waited for the IP-task, in CNTVCT
+ticks (ipconfigMEASURE_EVENT_LATENCY, FreeRTOSIPConfig.h). */
+void latency_ip_event(uint64_t ticks);
+
+#endif /* LATENCY_H */
@@ -6,6 +6,9 @@
 #include "queue.h"
 #include "timers.h"
 #include "semphr.h"
+#include "pool.h"
+#include "pointer_queue.h"
+#include "rwlock.h"
 
 /* FreeRTOS+TCP includes. */
 #include "FreeRTOS_IP.h"
@@ -15,6 +18,12 @@
 
 // driver includes
 #include "uart.h"
+#include "binlog.h"
+#include "hrtimer.h"
+#include "profiler.h"
+#include "trace_recorder.h"
+#include "pmu.h"
+#include "latency.h"
 #include "spi0.h"
 #include "printf.h"
 #include "enc28j60.h"
@@ -71,6 +80,46 @@ typedef enum EN_RESULT
 
 #define STACK_SIZE			( configMINIMAL_STACK_SIZE * 3 )
 
+/* Set to 1 to measure the UART throughput and the CPU load it causes. */
+#ifndef mainCREATE_UART_BENCHMARK_TASK
+	#define mainCREATE_UART_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to compare a copying queue with a pointer queue (pointer_queue.h). */
+#ifndef mainCREATE_QUEUE_BENCHMARK_TASK
+	#define mainCREATE_QUEUE_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to compare xQueueSend()/xQueueReceive() with xQueueSendMultiple()/
+xQueueReceiveMultiple() under a flood of events. */
+#ifndef mainCREATE_EVENT_FLOOD_BENCHMARK_TASK
+	#define mainCREATE_EVENT_FLOOD_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to measure the software timer reset rate and the CPU load of timer
+resets issued through the timer queue and from the timer task itself. */
+#ifndef mainCREATE_TIMER_BENCHMARK_TASK
+	#define mainCREATE_TIMER_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to compare a reader/writer lock (rwlock.h) with a mutex on a table
+that is read far more often than written. */
+#ifndef mainCREATE_RWLOCK_BENCHMARK_TASK
+	#define mainCREATE_RWLOCK_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to measure the cost of a context switch between tasks that do and
+do not use the FPU, whose registers the port switches lazily. */
+#ifndef mainCREATE_CONTEXT_SWITCH_BENCHMARK_TASK
+	#define mainCREATE_CONTEXT_SWITCH_BENCHMARK_TASK	0
+#endif
+
+/* Set to 1 to measure the TCP throughput in both directions with a host on
+the link, iperf style, see prvTCPThroughputTask(). */
+#ifndef mainCREATE_TCP_THROUGHPUT_TASKS
+	#define mainCREATE_TCP_THROUGHPUT_TASKS	0
+#endif
+
 /* Define names that will be used for SDN, LLMNR and NBNS searches. */
 // defined in makefile DmainHOST
 #ifndef mainHOST_NAME
@@ -199,6 +248,882 @@ void TaskB(void *pvParameters)
 }
 /*-----------------------------------------------------------*/
 
+#if( mainCREATE_UART_BENCHMARK_TASK == 1 ) || ( mainCREATE_TIMER_BENCHMARK_TASK == 1 ) || ( mainCREATE_TCP_THROUGHPUT_TASKS == 1 )
+
+/* CPU load of the RTOS cores in percent, from the run time counter and
+profiler_idle_ticks() sampled at the start of an interval. */
+static uint32_t prvCPULoad( uint64_t ullTimeStart, uint64_t ullIdleStart )
+{
+uint64_t ullTime, ullIdle;
+
+	ullTime = ( portGET_RUN_TIME_COUNTER_VALUE() - ullTimeStart ) * configNUM_CORES;
+	ullIdle = profiler_idle_ticks() - ullIdleStart;
+	if( ( ullTime == 0 ) || ( ullIdle >= ullTime ) )
+	{
+		return 0;
+	}
+	return ( uint32_t ) ( ( ( ullTime - ullIdle ) * 100 ) / ullTime );
+}
+/*-----------------------------------------------------------*/
+
+#endif
+
+#if( mainCREATE_UART_BENCHMARK_TASK == 1 )
+
+#define mainUART_BENCHMARK_BYTES	( 16 * 1024 )
+
+/* Rates the benchmark runs at.  The terminal only follows UART_BAUD, the
+output at the other rates shows up as garbage. */
+static const uint32_t ulBenchmarkBauds[] = { UART_BAUD, 921600, 3000000 };
+
+static void prvUARTBenchmarkTask( void *pvParameters )
+{
+static uint8_t ucLine[ 64 ];
+uint32_t ulSent, ulLoad;
+uint64_t ullTimeStart, ullIdleStart;
+TickType_t xStart, xElapsed;
+size_t x, xBaud;
+
+	( void ) pvParameters;
+
+	for( x = 0; x < sizeof( ucLine ) - 2; x++ )
+	{
+		ucLine[ x ] = ( uint8_t ) ( 'A' + ( x % 26 ) );
+	}
+	ucLine[ x++ ] = '\r';
+	ucLine[ x ] = '\n';
+
+	for( ;; )
+	{
+		for( xBaud = 0; xBaud < sizeof( ulBenchmarkBauds ) / sizeof( ulBenchmarkBauds[ 0 ] ); xBaud++ )
+		{
+			if( uart_set_baud( ulBenchmarkBauds[ xBaud ] ) != 0 )
+			{
+				printf( "UART benchmark: %u baud not possible\n", ( unsigned ) ulBenchmarkBauds[ xBaud ] );
+				continue;
+			}
+
+			ullTimeStart = portGET_RUN_TIME_COUNTER_VALUE();
+			ullIdleStart = profiler_idle_ticks();
+			xStart = xTaskGetTickCount();
+			for( ulSent = 0; ulSent < mainUART_BENCHMARK_BYTES; ulSent += sizeof( ucLine ) )
+			{
+				uart_write( ucLine, sizeof( ucLine ) );
+			}
+			/* Switching back waits for the Tx ring to drain before the
+			clock is stopped. */
+			uart_set_baud( UART_BAUD );
+			xElapsed = xTaskGetTickCount() - xStart;
+			ulLoad = prvCPULoad( ullTimeStart, ullIdleStart );
+
+			if( xElapsed == 0 )
+			{
+				xElapsed = 1;
+			}
+			printf( "UART benchmark @%u: %u bytes/s, CPU load %u%%, %u bytes dropped\n",
+					( unsigned ) ulBenchmarkBauds[ xBaud ],
+					( unsigned ) ( ( ulSent * 1000 ) / ( xElapsed * portTICK_PERIOD_MS ) ),
+					( unsigned ) ulLoad, ( unsigned ) uart_dropped() );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_UART_BENCHMARK_TASK */
+
+#if( mainCREATE_QUEUE_BENCHMARK_TASK == 1 )
+
+#define mainQUEUE_BENCHMARK_MESSAGES	10000
+#define mainQUEUE_BENCHMARK_LENGTH		8
+#define mainQUEUE_BENCHMARK_MAX_PAYLOAD	1500
+
+static const size_t xBenchmarkPayloads[] = { 8, 64, mainQUEUE_BENCHMARK_MAX_PAYLOAD };
+
+typedef struct QueueBenchmark
+{
+	QueueHandle_t xQueue;					/* Copying queue, or NULL. */
+	PointerQueueHandle_t xPointerQueue;		/* Pointer queue, or NULL. */
+	PoolHandle_t xPool;						/* Payloads sent through xPointerQueue. */
+	size_t xPayload;
+	TaskHandle_t xProducer;
+} QueueBenchmark_t;
+
+static void prvQueueBenchmarkConsumer( void *pvParameters )
+{
+static uint8_t ucBuffer[ mainQUEUE_BENCHMARK_MAX_PAYLOAD ];
+QueueBenchmark_t * const pxBenchmark = ( QueueBenchmark_t * ) pvParameters;
+uint8_t *pucPayload;
+uint32_t ulReceived;
+
+	for( ulReceived = 0; ulReceived < mainQUEUE_BENCHMARK_MESSAGES; ulReceived++ )
+	{
+		if( pxBenchmark->xQueue != NULL )
+		{
+			( void ) xQueueReceive( pxBenchmark->xQueue, ucBuffer, portMAX_DELAY );
+		}
+		else
+		{
+			/* The block now belongs to this task, which returns it to the
+			pool when done with it. */
+			( void ) xPointerQueueReceive( pxBenchmark->xPointerQueue, ( void ** ) &pucPayload, portMAX_DELAY );
+			ucBuffer[ 0 ] = pucPayload[ 0 ];
+			vPoolFree( pxBenchmark->xPool, pucPayload );
+		}
+	}
+
+	xTaskNotifyGive( pxBenchmark->xProducer );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/* Sends mainQUEUE_BENCHMARK_MESSAGES payloads to a consumer task, returns the
+CNTPCT ticks until the consumer received the last one. */
+static uint64_t prvQueueBenchmarkRun( QueueBenchmark_t *pxBenchmark )
+{
+static uint8_t ucBuffer[ mainQUEUE_BENCHMARK_MAX_PAYLOAD ];
+uint8_t *pucPayload;
+uint64_t ullStart;
+uint32_t ulSent;
+
+	pxBenchmark->xProducer = xTaskGetCurrentTaskHandle();
+	xTaskCreate( prvQueueBenchmarkConsumer, "QueueCons", 512, pxBenchmark, uxTaskPriorityGet( NULL ), NULL );
+
+	ullStart = hrtimer_now();
+	for( ulSent = 0; ulSent < mainQUEUE_BENCHMARK_MESSAGES; ulSent++ )
+	{
+		if( pxBenchmark->xQueue != NULL )
+		{
+			ucBuffer[ 0 ] = ( uint8_t ) ulSent;
+			( void ) xQueueSend( pxBenchmark->xQueue, ucBuffer, portMAX_DELAY );
+		}
+		else
+		{
+			/* The pool holds a block for each slot of the queue, plus the
+			blocks the producer and the consumer work on. */
+			pucPayload = ( uint8_t * ) pvPoolAlloc( pxBenchmark->xPool );
+			configASSERT( pucPayload != NULL );
+			pucPayload[ 0 ] = ( uint8_t ) ulSent;
+			( void ) xPointerQueueSend( pxBenchmark->xPointerQueue, pucPayload, portMAX_DELAY );
+		}
+	}
+
+	( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+	return hrtimer_now() - ullStart;
+}
+/*-----------------------------------------------------------*/
+
+static void prvQueueBenchmarkTask( void *pvParameters )
+{
+QueueBenchmark_t xBenchmark;
+uint64_t ullCopy, ullPointer, ullPerSecond;
+size_t x;
+
+	( void ) pvParameters;
+
+	ullPerSecond = hrtimer_us_to_cnt( 1000000 );
+
+	for( ;; )
+	{
+		for( x = 0; x < sizeof( xBenchmarkPayloads ) / sizeof( xBenchmarkPayloads[ 0 ] ); x++ )
+		{
+			xBenchmark.xPayload = xBenchmarkPayloads[ x ];
+
+			xBenchmark.xQueue = xQueueCreate( mainQUEUE_BENCHMARK_LENGTH, xBenchmark.xPayload );
+			xBenchmark.xPointerQueue = NULL;
+			xBenchmark.xPool = NULL;
+			configASSERT( xBenchmark.xQueue != NULL );
+			ullCopy = prvQueueBenchmarkRun( &xBenchmark );
+			vQueueDelete( xBenchmark.xQueue );
+
+			xBenchmark.xQueue = NULL;
+			xBenchmark.xPointerQueue = xPointerQueueCreate( mainQUEUE_BENCHMARK_LENGTH );
+			xBenchmark.xPool = xPoolCreate( xBenchmark.xPayload, mainQUEUE_BENCHMARK_LENGTH + 2 );
+			configASSERT( ( xBenchmark.xPointerQueue != NULL ) && ( xBenchmark.xPool != NULL ) );
+			ullPointer = prvQueueBenchmarkRun( &xBenchmark );
+			vPointerQueueDelete( xBenchmark.xPointerQueue );
+			vPoolDelete( xBenchmark.xPool );
+
+			printf( "Queue benchmark %u bytes: copy %u msg/s, pointer %u msg/s\n",
+					( unsigned ) xBenchmark.xPayload,
+					( unsigned ) ( ( mainQUEUE_BENCHMARK_MESSAGES * ullPerSecond ) / ( ullCopy + 1 ) ),
+					( unsigned ) ( ( mainQUEUE_BENCHMARK_MESSAGES * ullPerSecond ) / ( ullPointer + 1 ) ) );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_QUEUE_BENCHMARK_TASK */
+
+#if( mainCREATE_EVENT_FLOOD_BENCHMARK_TASK == 1 )
+
+/* The flood is sent in bursts of mainEVENT_FLOOD_PPS / configTICK_RATE_HZ
+events, one burst per tick, as a network driver would pass a burst of frames to
+the IP-task. */
+#define mainEVENT_FLOOD_PPS			10000
+#define mainEVENT_FLOOD_SECONDS		2
+#define mainEVENT_FLOOD_BURST		( ( BaseType_t ) ( mainEVENT_FLOOD_PPS / configTICK_RATE_HZ ) )
+#define mainEVENT_FLOOD_BATCH		8		/* As ipconfigEVENT_BATCH_LENGTH. */
+#define mainEVENT_FLOOD_QUEUE_LENGTH	50	/* As ipconfigEVENT_QUEUE_LENGTH. */
+
+/* The layout of IPStackEvent_t. */
+typedef struct FloodEvent
+{
+	uint32_t ulType;	/* 1 ends the run. */
+	void *pvData;
+} FloodEvent_t;
+
+typedef struct EventFlood
+{
+	QueueHandle_t xQueue;
+	BaseType_t xBatched;
+	TaskHandle_t xProducer;
+	uint32_t ulReceived;
+	uint64_t ullReceiveTicks;	/* CNTPCT ticks spent in the receive calls. */
+} EventFlood_t;
+
+static void prvEventFloodConsumer( void *pvParameters )
+{
+EventFlood_t * const pxFlood = ( EventFlood_t * ) pvParameters;
+FloodEvent_t xEvents[ mainEVENT_FLOOD_BATCH ];
+BaseType_t xCount, x, xDone = pdFALSE;
+uint64_t ullStart;
+
+	while( xDone == pdFALSE )
+	{
+		ullStart = hrtimer_now();
+		if( pxFlood->xBatched != pdFALSE )
+		{
+			xCount = xQueueReceiveMultiple( pxFlood->xQueue, xEvents, mainEVENT_FLOOD_BATCH, portMAX_DELAY );
+		}
+		else
+		{
+			xCount = ( xQueueReceive( pxFlood->xQueue, xEvents, portMAX_DELAY ) == pdPASS ) ? 1 : 0;
+		}
+		pxFlood->ullReceiveTicks += hrtimer_now() - ullStart;
+
+		for( x = 0; x < xCount; x++ )
+		{
+			if( xEvents[ x ].ulType == 1 )
+			{
+				xDone = pdTRUE;
+			}
+			else
+			{
+				pxFlood->ulReceived++;
+			}
+		}
+	}
+
+	xTaskNotifyGive( pxFlood->xProducer );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvEventFloodBenchmarkTask( void *pvParameters )
+{
+static EventFlood_t xFlood;
+FloodEvent_t xEvents[ mainEVENT_FLOOD_BURST ], xStop = { 1, NULL };
+uint64_t ullSendTicks, ullStart, ullPerSecond;
+uint32_t ulSent, ulDropped, ulTick;
+TickType_t xLastWake;
+BaseType_t xBatched, x;
+
+	( void ) pvParameters;
+
+	ullPerSecond = hrtimer_us_to_cnt( 1000000 );
+
+	for( x = 0; x < mainEVENT_FLOOD_BURST; x++ )
+	{
+		xEvents[ x ].ulType = 0;
+		xEvents[ x ].pvData = NULL;
+	}
+
+	xFlood.xQueue = xQueueCreate( mainEVENT_FLOOD_QUEUE_LENGTH, sizeof( FloodEvent_t ) );
+	configASSERT( xFlood.xQueue != NULL );
+	xFlood.xProducer = xTaskGetCurrentTaskHandle();
+
+	for( ;; )
+	{
+		for( xBatched = pdFALSE; xBatched <= pdTRUE; xBatched++ )
+		{
+			xFlood.xBatched = xBatched;
+			xFlood.ulReceived = 0;
+			xFlood.ullReceiveTicks = 0;
+			ullSendTicks = 0;
+			ulSent = 0;
+
+			/* The consumer runs below this task, as the IP-task runs below the
+			driver task, so the bursts pile up in the queue. */
+			xTaskCreate( prvEventFloodConsumer, "FloodCons", 512, &xFlood, uxTaskPriorityGet( NULL ) - 1, NULL );
+
+			xLastWake = xTaskGetTickCount();
+			for( ulTick = 0; ulTick < ( mainEVENT_FLOOD_SECONDS * configTICK_RATE_HZ ); ulTick++ )
+			{
+				ullStart = hrtimer_now();
+				if( xBatched != pdFALSE )
+				{
+					ulSent += ( uint32_t ) xQueueSendMultiple( xFlood.xQueue, xEvents, mainEVENT_FLOOD_BURST, 0 );
+				}
+				else
+				{
+					for( x = 0; x < mainEVENT_FLOOD_BURST; x++ )
+					{
+						if( xQueueSend( xFlood.xQueue, &( xEvents[ x ] ), 0 ) == pdPASS )
+						{
+							ulSent++;
+						}
+					}
+				}
+				ullSendTicks += hrtimer_now() - ullStart;
+
+				vTaskDelayUntil( &xLastWake, 1 );
+			}
+
+			( void ) xQueueSend( xFlood.xQueue, &xStop, portMAX_DELAY );
+			( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+
+			ulDropped = ( mainEVENT_FLOOD_SECONDS * mainEVENT_FLOOD_PPS ) - ulSent;
+			printf( "Event flood %s: %u events/s, %u dropped, send %u ns/event, receive %u ns/event\n",
+					( xBatched != pdFALSE ) ? "batched" : "single",
+					( unsigned ) ( xFlood.ulReceived / mainEVENT_FLOOD_SECONDS ),
+					( unsigned ) ulDropped,
+					( unsigned ) ( ( ullSendTicks * 1000000000ULL ) / ( ullPerSecond * ( ulSent + 1 ) ) ),
+					( unsigned ) ( ( xFlood.ullReceiveTicks * 1000000000ULL ) / ( ullPerSecond * ( xFlood.ulReceived + 1 ) ) ) );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_EVENT_FLOOD_BENCHMARK_TASK */
+
+#if( mainCREATE_TIMER_BENCHMARK_TASK == 1 )
+
+/* The rate is measured over mainTIMER_BENCH_RESETS resets back to back, the CPU
+load over one second of mainTIMER_BENCH_PER_TICK resets per tick, as a driver
+that restarts a timeout timer for every frame would issue them. */
+#define mainTIMER_BENCH_RESETS		10000
+#define mainTIMER_BENCH_PER_TICK	10
+#define mainTIMER_BENCH_TICKS		configTICK_RATE_HZ
+
+static TimerHandle_t xTimerBenchTarget;
+static TaskHandle_t xTimerBenchTask;
+static uint32_t ulTimerBenchTicksLeft;
+
+/* The target is reset before it ever expires. */
+static void prvTimerBenchTargetExpired( TimerHandle_t xTimer )
+{
+	( void ) xTimer;
+}
+/*-----------------------------------------------------------*/
+
+/* Pended to the timer task, so the resets do not go through the timer queue
+when configUSE_TIMER_DIRECT_COMMANDS is 1. */
+static void prvTimerBenchResetLoop( void *pvParameter1, uint32_t ulParameter2 )
+{
+uint32_t ul;
+
+	( void ) pvParameter1;
+
+	for( ul = 0; ul < ulParameter2; ul++ )
+	{
+		( void ) xTimerReset( xTimerBenchTarget, 0 );
+	}
+	xTaskNotifyGive( xTimerBenchTask );
+}
+/*-----------------------------------------------------------*/
+
+/* Auto-reload timer with a period of one tick, issues the resets of the CPU
+load run from the timer task. */
+static void prvTimerBenchDriver( TimerHandle_t xTimer )
+{
+uint32_t ul;
+
+	for( ul = 0; ul < mainTIMER_BENCH_PER_TICK; ul++ )
+	{
+		( void ) xTimerReset( xTimerBenchTarget, 0 );
+	}
+
+	ulTimerBenchTicksLeft--;
+	if( ulTimerBenchTicksLeft == 0 )
+	{
+		( void ) xTimerStop( xTimer, 0 );
+		xTaskNotifyGive( xTimerBenchTask );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvTimerBenchmarkTask( void *pvParameters )
+{
+TimerHandle_t xDriver;
+uint32_t ulLoad, ulTick, ul;
+uint64_t ullStart, ullElapsed, ullPerSecond, ullTimeStart, ullIdleStart;
+TickType_t xLastWake;
+BaseType_t xFromTimerTask;
+
+	( void ) pvParameters;
+
+	ullPerSecond = hrtimer_us_to_cnt( 1000000 );
+	xTimerBenchTask = xTaskGetCurrentTaskHandle();
+	xTimerBenchTarget = xTimerCreate( "BenchTarget", pdMS_TO_TICKS( 1000 ), pdFALSE, NULL, prvTimerBenchTargetExpired );
+	xDriver = xTimerCreate( "BenchDriver", 1, pdTRUE, NULL, prvTimerBenchDriver );
+	configASSERT( ( xTimerBenchTarget != NULL ) && ( xDriver != NULL ) );
+
+	for( ;; )
+	{
+		for( xFromTimerTask = pdFALSE; xFromTimerTask <= pdTRUE; xFromTimerTask++ )
+		{
+			ullStart = hrtimer_now();
+			if( xFromTimerTask != pdFALSE )
+			{
+				( void ) xTimerPendFunctionCall( prvTimerBenchResetLoop, NULL, mainTIMER_BENCH_RESETS, portMAX_DELAY );
+				( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+			}
+			else
+			{
+				for( ul = 0; ul < mainTIMER_BENCH_RESETS; ul++ )
+				{
+					( void ) xTimerReset( xTimerBenchTarget, portMAX_DELAY );
+				}
+			}
+			ullElapsed = hrtimer_now() - ullStart;
+
+			ullTimeStart = portGET_RUN_TIME_COUNTER_VALUE();
+			ullIdleStart = profiler_idle_ticks();
+			if( xFromTimerTask != pdFALSE )
+			{
+				ulTimerBenchTicksLeft = mainTIMER_BENCH_TICKS;
+				( void ) xTimerStart( xDriver, portMAX_DELAY );
+				( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+			}
+			else
+			{
+				xLastWake = xTaskGetTickCount();
+				for( ulTick = 0; ulTick < mainTIMER_BENCH_TICKS; ulTick++ )
+				{
+					for( ul = 0; ul < mainTIMER_BENCH_PER_TICK; ul++ )
+					{
+						( void ) xTimerReset( xTimerBenchTarget, portMAX_DELAY );
+					}
+					vTaskDelayUntil( &xLastWake, 1 );
+				}
+			}
+			ulLoad = prvCPULoad( ullTimeStart, ullIdleStart );
+			printf( "Timer resets from %s: %u resets/s, CPU load %u%% at %u resets/s\n",
+					( xFromTimerTask != pdFALSE ) ? "timer task" : "other task",
+					( unsigned ) ( ( ( uint64_t ) mainTIMER_BENCH_RESETS * ullPerSecond ) / ( ullElapsed + 1 ) ),
+					( unsigned ) ulLoad,
+					( unsigned ) ( mainTIMER_BENCH_PER_TICK * configTICK_RATE_HZ ) );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_TIMER_BENCHMARK_TASK */
+
+#if( mainCREATE_RWLOCK_BENCHMARK_TASK == 1 )
+
+/* Readers copy a table of mainRWLOCK_BENCH_WORDS words in a loop, the writer
+rewrites it once per tick.  Every write stores one value in all words, so a
+reader that finds two different values saw a write half done. */
+#define mainRWLOCK_BENCH_READERS	4
+#define mainRWLOCK_BENCH_WORDS		16
+#define mainRWLOCK_BENCH_TICKS		configTICK_RATE_HZ
+
+typedef struct RWLockBench
+{
+	RWLockHandle_t xRWLock;
+	SemaphoreHandle_t xMutex;
+	BaseType_t xUseRWLock;
+	volatile BaseType_t xStop;
+	TaskHandle_t xController;
+	volatile uint32_t ulTable[ mainRWLOCK_BENCH_WORDS ];
+	uint32_t ulReads[ mainRWLOCK_BENCH_READERS ];
+	uint32_t ulTorn[ mainRWLOCK_BENCH_READERS ];
+} RWLockBench_t;
+
+static RWLockBench_t xRWLockBench;
+
+static void prvRWLockBenchReader( void *pvParameters )
+{
+const uint32_t ulReader = ( uint32_t ) ( uintptr_t ) pvParameters;
+uint32_t ulCopy[ mainRWLOCK_BENCH_WORDS ], ulReads = 0, ulTorn = 0, x;
+
+	while( xRWLockBench.xStop == pdFALSE )
+	{
+		if( xRWLockBench.xUseRWLock != pdFALSE )
+		{
+			( void ) xRWLockTakeRead( xRWLockBench.xRWLock, portMAX_DELAY );
+		}
+		else
+		{
+			( void ) xSemaphoreTake( xRWLockBench.xMutex, portMAX_DELAY );
+		}
+
+		for( x = 0; x < mainRWLOCK_BENCH_WORDS; x++ )
+		{
+			ulCopy[ x ] = xRWLockBench.ulTable[ x ];
+		}
+
+		if( xRWLockBench.xUseRWLock != pdFALSE )
+		{
+			( void ) xRWLockGiveRead( xRWLockBench.xRWLock );
+		}
+		else
+		{
+			( void ) xSemaphoreGive( xRWLockBench.xMutex );
+		}
+
+		for( x = 1; x < mainRWLOCK_BENCH_WORDS; x++ )
+		{
+			if( ulCopy[ x ] != ulCopy[ 0 ] )
+			{
+				ulTorn++;
+				break;
+			}
+		}
+		ulReads++;
+	}
+
+	xRWLockBench.ulReads[ ulReader ] = ulReads;
+	xRWLockBench.ulTorn[ ulReader ] = ulTorn;
+	xTaskNotifyGive( xRWLockBench.xController );
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvRWLockBenchmarkTask( void *pvParameters )
+{
+uint32_t ulGeneration = 0, ulReads, ulTorn, ulTick, x;
+uint64_t ullStart, ullWriteTicks, ullWorstTicks, ullPerSecond;
+TickType_t xLastWake;
+BaseType_t xUseRWLock;
+
+	( void ) pvParameters;
+
+	ullPerSecond = hrtimer_us_to_cnt( 1000000 );
+	xRWLockBench.xRWLock = xRWLockCreate();
+	xRWLockBench.xMutex = xSemaphoreCreateMutex();
+	xRWLockBench.xController = xTaskGetCurrentTaskHandle();
+	configASSERT( ( xRWLockBench.xRWLock != NULL ) && ( xRWLockBench.xMutex != NULL ) );
+
+	for( ;; )
+	{
+		for( xUseRWLock = pdFALSE; xUseRWLock <= pdTRUE; xUseRWLock++ )
+		{
+			xRWLockBench.xUseRWLock = xUseRWLock;
+			xRWLockBench.xStop = pdFALSE;
+			ullWriteTicks = 0;
+			ullWorstTicks = 0;
+
+			/* The readers run below this task, so the writes are on time
+			unless the lock keeps the writer out. */
+			for( x = 0; x < mainRWLOCK_BENCH_READERS; x++ )
+			{
+				xTaskCreate( prvRWLockBenchReader, "RWReader", 512, ( void * ) ( uintptr_t ) x, uxTaskPriorityGet( NULL ) - 1, NULL );
+			}
+
+			xLastWake = xTaskGetTickCount();
+			for( ulTick = 0; ulTick < mainRWLOCK_BENCH_TICKS; ulTick++ )
+			{
+				vTaskDelayUntil( &xLastWake, 1 );
+
+				ullStart = hrtimer_now();
+				if( xUseRWLock != pdFALSE )
+				{
+					( void ) xRWLockTakeWrite( xRWLockBench.xRWLock, portMAX_DELAY );
+				}
+				else
+				{
+					( void ) xSemaphoreTake( xRWLockBench.xMutex, portMAX_DELAY );
+				}
+
+				ulGeneration++;
+				for( x = 0; x < mainRWLOCK_BENCH_WORDS; x++ )
+				{
+					xRWLockBench.ulTable[ x ] = ulGeneration;
+				}
+
+				if( xUseRWLock != pdFALSE )
+				{
+					( void ) xRWLockGiveWrite( xRWLockBench.xRWLock );
+				}
+				else
+				{
+					( void ) xSemaphoreGive( xRWLockBench.xMutex );
+				}
+
+				ullStart = hrtimer_now() - ullStart;
+				ullWriteTicks += ullStart;
+				if( ullStart > ullWorstTicks )
+				{
+					ullWorstTicks = ullStart;
+				}
+			}
+
+			xRWLockBench.xStop = pdTRUE;
+			ulReads = 0;
+			ulTorn = 0;
+			for( x = 0; x < mainRWLOCK_BENCH_READERS; x++ )
+			{
+				( void ) ulTaskNotifyTake( pdFALSE, portMAX_DELAY );
+			}
+			for( x = 0; x < mainRWLOCK_BENCH_READERS; x++ )
+			{
+				ulReads += xRWLockBench.ulReads[ x ];
+				ulTorn += xRWLockBench.ulTorn[ x ];
+			}
+
+			printf( "RW lock benchmark %s: %u reads/s by %u readers, %u torn, write %u ns average %u ns worst\n",
+					( xUseRWLock != pdFALSE ) ? "rwlock" : "mutex",
+					( unsigned ) ( ulReads / ( mainRWLOCK_BENCH_TICKS / configTICK_RATE_HZ ) ),
+					( unsigned ) mainRWLOCK_BENCH_READERS,
+					( unsigned ) ulTorn,
+					( unsigned ) ( ( ullWriteTicks * 1000000000ULL ) / ( ullPerSecond * mainRWLOCK_BENCH_TICKS ) ),
+					( unsigned ) ( ( ullWorstTicks * 1000000000ULL ) / ullPerSecond ) );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_RWLOCK_BENCHMARK_TASK */
+
+#if( mainCREATE_CONTEXT_SWITCH_BENCHMARK_TASK == 1 )
+
+/* Two tasks on one core hand a notification back and forth, each hand-over is
+a context switch.  Neither, one or both of them touch the FPU in every round,
+so the switches carry no floating point registers, the FPU trap and the save
+of the registers of one task (which the core still holds when it comes back),
+or the trap, the save and the restore of both. */
+#define mainCTX_BENCH_ROUNDS		10000
+
+typedef struct ContextSwitchBench
+{
+	TaskHandle_t xController;
+	TaskHandle_t xPartner;
+	uint32_t ulFPUTasks;
+} ContextSwitchBench_t;
+
+static ContextSwitchBench_t xCtxBench;
+
+/* Reads FPCR, which traps while the FPU is disabled as any floating point
+instruction does.  The register is named by its encoding, as this file is
+built with -mgeneral-regs-only. */
+static inline void prvTouchFPU( void )
+{
+uint64_t ullFPCR;
+
+	__asm volatile ( "MRS %0, S3_3_C4_C4_0" : "=r" ( ullFPCR ) :: "memory" );
+	( void ) ullFPCR;
+}
+/*-----------------------------------------------------------*/
+
+/* The cycle counter of the PMU, started on this core by pmu_init(). */
+static inline uint64_t prvCycles( void )
+{
+uint64_t ullCycles = 0;
+
+	#if( configUSE_PMU_PROBES == 1 )
+	{
+		__asm volatile ( "MRS %0, PMCCNTR_EL0" : "=r" ( ullCycles ) :: "memory" );
+	}
+	#endif
+	return ullCycles;
+}
+/*-----------------------------------------------------------*/
+
+static void prvContextSwitchPartner( void *pvParameters )
+{
+uint32_t ulRound;
+
+	( void ) pvParameters;
+
+	for( ulRound = 0; ulRound < mainCTX_BENCH_ROUNDS; ulRound++ )
+	{
+		( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+		if( xCtxBench.ulFPUTasks == 2 )
+		{
+			prvTouchFPU();
+		}
+		xTaskNotifyGive( xCtxBench.xController );
+	}
+
+	vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvContextSwitchBenchmarkTask( void *pvParameters )
+{
+uint64_t ullTicks, ullCycles, ullPerSecond;
+uint32_t ulRound;
+
+	( void ) pvParameters;
+
+	ullPerSecond = hrtimer_us_to_cnt( 1000000 );
+	xCtxBench.xController = xTaskGetCurrentTaskHandle();
+
+	#if( configNUM_CORES > 1 )
+	{
+		/* The core pmu_init() started the cycle counter of. */
+		vTaskCoreAffinitySet( NULL, ( 1U << 0 ) );
+	}
+	#endif
+
+	for( ;; )
+	{
+		for( xCtxBench.ulFPUTasks = 0; xCtxBench.ulFPUTasks <= 2; xCtxBench.ulFPUTasks++ )
+		{
+			/* Same priority, so every notification given only readies the
+			other task, and the switch happens when the giver blocks. */
+			xTaskCreate( prvContextSwitchPartner, "CtxPartner", 512, NULL, uxTaskPriorityGet( NULL ), &xCtxBench.xPartner );
+			configASSERT( xCtxBench.xPartner != NULL );
+			#if( configNUM_CORES > 1 )
+			{
+				vTaskCoreAffinitySet( xCtxBench.xPartner, ( 1U << 0 ) );
+			}
+			#endif
+
+			ullTicks = hrtimer_now();
+			ullCycles = prvCycles();
+			for( ulRound = 0; ulRound < mainCTX_BENCH_ROUNDS; ulRound++ )
+			{
+				if( xCtxBench.ulFPUTasks != 0 )
+				{
+					prvTouchFPU();
+				}
+				xTaskNotifyGive( xCtxBench.xPartner );
+				( void ) ulTaskNotifyTake( pdTRUE, portMAX_DELAY );
+			}
+			ullCycles = prvCycles() - ullCycles;
+			ullTicks = hrtimer_now() - ullTicks;
+
+			printf( "Context switch benchmark, %u FPU tasks: %u ns, %u cycles per switch\n",
+					( unsigned ) xCtxBench.ulFPUTasks,
+					( unsigned ) ( ( ullTicks * 1000000000ULL ) / ( ullPerSecond * 2 * mainCTX_BENCH_ROUNDS ) ),
+					( unsigned ) ( ullCycles / ( 2 * mainCTX_BENCH_ROUNDS ) ) );
+		}
+
+		vTaskDelay( pdMS_TO_TICKS( 5000 ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_CONTEXT_SWITCH_BENCHMARK_TASK */
+
+#if( mainCREATE_TCP_THROUGHPUT_TASKS == 1 )
+
+/* One task per direction, a host on the link connects to its port.  On
+mainTCP_RX_PORT everything received is discarded, the iperf 2 client drives it:
+	iperf -c <target> -p 5001 -t 10
+On mainTCP_TX_PORT the target sends for mainTCP_THROUGHPUT_SECONDS and closes:
+	nc <target> 5002 > /dev/null
+When the connection ends the target prints the rate and its CPU load.  RX
+stops counting at the last data received, TX counts what was queued to the
+socket, which is at most one TX buffer (ipconfigTCP_TX_BUFFER_LENGTH) ahead
+of what the host received. */
+#define mainTCP_RX_PORT				5001
+#define mainTCP_TX_PORT				5002
+#define mainTCP_THROUGHPUT_SECONDS	10
+#define mainTCP_THROUGHPUT_CHUNK	( 4 * 1460 )
+#define mainTCP_SHUTDOWN_MS			5000
+
+static void prvTCPThroughputTask( void *pvParameters )
+{
+static uint8_t ucChunks[ 2 ][ mainTCP_THROUGHPUT_CHUNK ];
+const BaseType_t xTransmit = ( ( uintptr_t ) pvParameters == mainTCP_TX_PORT );
+uint8_t * const pucChunk = ucChunks[ xTransmit ];
+const TickType_t xTimeOut = pdMS_TO_TICKS( mainTCP_SHUTDOWN_MS );
+const TickType_t xDuration = pdMS_TO_TICKS( mainTCP_THROUGHPUT_SECONDS * 1000 );
+struct freertos_sockaddr xAddress, xPeer;
+socklen_t xSize;
+Socket_t xListener, xSocket;
+uint64_t ullBytes, ullTimeStart, ullIdleStart;
+TickType_t xStart, xEnd;
+BaseType_t xResult;
+uint32_t ulLoad, ulMs;
+
+	xListener = FreeRTOS_socket( FREERTOS_AF_INET, FREERTOS_SOCK_STREAM, FREERTOS_IPPROTO_TCP );
+	configASSERT( xListener != FREERTOS_INVALID_SOCKET );
+	xAddress.sin_addr = 0;
+	xAddress.sin_port = FreeRTOS_htons( ( uint16_t ) ( uintptr_t ) pvParameters );
+	FreeRTOS_bind( xListener, &xAddress, sizeof( xAddress ) );
+	FreeRTOS_listen( xListener, 1 );
+
+	for( ;; )
+	{
+		xSize = sizeof( xPeer );
+		xSocket = FreeRTOS_accept( xListener, &xPeer, &xSize );
+		if( ( xSocket == NULL ) || ( xSocket == FREERTOS_INVALID_SOCKET ) )
+		{
+			continue;
+		}
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+		FreeRTOS_setsockopt( xSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeOut, sizeof( xTimeOut ) );
+
+		ullBytes = 0;
+		ullTimeStart = portGET_RUN_TIME_COUNTER_VALUE();
+		ullIdleStart = profiler_idle_ticks();
+		xStart = xTaskGetTickCount();
+		xEnd = xStart;
+		for( ;; )
+		{
+			if( xTransmit != pdFALSE )
+			{
+				if( ( xTaskGetTickCount() - xStart ) >= xDuration )
+				{
+					break;
+				}
+				xResult = FreeRTOS_send( xSocket, pucChunk, sizeof( ucChunks[ 0 ] ), 0 );
+			}
+			else
+			{
+				xResult = FreeRTOS_recv( xSocket, pucChunk, sizeof( ucChunks[ 0 ] ), 0 );
+			}
+
+			/* An error once the host closes, 0 after mainTCP_SHUTDOWN_MS
+			without progress */
+			if( xResult <= 0 )
+			{
+				break;
+			}
+			ullBytes += ( uint64_t ) xResult;
+			xEnd = xTaskGetTickCount();
+		}
+		ulLoad = prvCPULoad( ullTimeStart, ullIdleStart );
+
+		/* Wait for the shutdown to take effect, indicated by FreeRTOS_recv()
+		returning an error. */
+		FreeRTOS_shutdown( xSocket, FREERTOS_SHUT_RDWR );
+		while( FreeRTOS_recv( xSocket, pucChunk, sizeof( ucChunks[ 0 ] ), 0 ) > 0 )
+		{
+		}
+		FreeRTOS_closesocket( xSocket );
+
+		ulMs = ( uint32_t ) ( ( xEnd - xStart ) * portTICK_PERIOD_MS );
+		if( ulMs == 0 )
+		{
+			ulMs = 1;
+		}
+		printf( "TCP %s: %u kbit/s, %u bytes in %u ms, CPU load %u%%\n",
+				( xTransmit != pdFALSE ) ? "TX" : "RX",
+				( unsigned ) ( ( ullBytes * 8 ) / ulMs ),
+				( unsigned ) ullBytes, ( unsigned ) ulMs, ( unsigned ) ulLoad );
+	}
+}
+/*-----------------------------------------------------------*/
+
+#endif /* mainCREATE_TCP_THROUGHPUT_TASKS */
+
 TimerHandle_t timer;
 uint32_t count=0;
 void interval_func(TimerHandle_t pxTimer)
@@ -207,7 +1132,8 @@ void interval_func(TimerHandle_t pxTimer)
     uint8_t buf[2] = {0};
     uint32_t len = 0;
 
-    len = uart_read_bytes(buf, sizeof(buf) - 1);
+    /* Never block the timer service task. */
+    len = uart_read(buf, sizeof(buf) - 1, 0);
     if (len)
         uart_puts((char *)buf);
 
@@ -287,8 +1213,21 @@ void main(void)
 {
     TaskHandle_t initTask, task_a, task_b;
 
+#if( configUSE_TRACE_RECORDER == 1 )
+    /* Before anything creates tasks or queues, so their names are recorded */
+    trace_init();
+#endif
     uart_init();
     init_printf(0, putc);
+    binlog_init();
+    hrtimer_init();
+    profiler_init();
+#if( configUSE_PMU_PROBES == 1 )
+    pmu_init();
+#endif
+#if( configUSE_LATENCY_HARNESS == 1 )
+    latency_init();
+#endif
     uart_puts("\r\n****************************\r\n");
     uart_puts("\r\n    FreeRTOS UART Sample\r\n");
     uart_puts("\r\n  (This sample uses UART2)\r\n");
@@ -300,6 +1239,24 @@ void main(void)
     xTaskCreate(initTask, "initTask", STACK_SIZE, NULL, tskIDLE_PRIORITY, &initTask);
 
     xTaskCreate(TaskA, "Task A", 512, NULL, 0x10, &task_a);
+#if( mainCREATE_UART_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvUARTBenchmarkTask, "UARTBench", 512, NULL, tskIDLE_PRIORITY + 1, NULL);
+#endif
+#if( mainCREATE_QUEUE_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvQueueBenchmarkTask, "QueueBench", 512, NULL, tskIDLE_PRIORITY + 1, NULL);
+#endif
+#if( mainCREATE_EVENT_FLOOD_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvEventFloodBenchmarkTask, "FloodBench", 512, NULL, tskIDLE_PRIORITY + 2, NULL);
+#endif
+#if( mainCREATE_TIMER_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvTimerBenchmarkTask, "TimerBench", 512, NULL, tskIDLE_PRIORITY + 1, NULL);
+#endif
+#if( mainCREATE_RWLOCK_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvRWLockBenchmarkTask, "RWLockBench", 512, NULL, tskIDLE_PRIORITY + 2, NULL);
+#endif
+#if( mainCREATE_CONTEXT_SWITCH_BENCHMARK_TASK == 1 )
+    xTaskCreate(prvContextSwitchBenchmarkTask, "CtxBench", 512, NULL, configMAX_PRIORITIES - 2, NULL);
+#endif
     //xTaskCreate(TaskB, "Task B", 512, NULL, 0x10, &task_b);
     
 
@@ -608,6 +1565,13 @@ char cBuffer[ 16 ];
 			}
 			#endif
 
+			#if( mainCREATE_TCP_THROUGHPUT_TASKS == 1 )
+			{
+				xTaskCreate( prvTCPThroughputTask, "TCPRxBench", STACK_SIZE, ( void * ) mainTCP_RX_PORT, tskIDLE_PRIORITY + 1, NULL );
+				xTaskCreate( prvTCPThroughputTask, "TCPTxBench", STACK_SIZE, ( void * ) mainTCP_TX_PORT, tskIDLE_PRIORITY + 1, NULL );
+			}
+			#endif
+
 			// Start a new task to fetch logging lines and send them out. 
 			#if( mainCREATE_UDP_LOGGING_TASK == 1 )
 			{
@@ -0,0 +1,259 @@
+/* pmu.c */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "pmu.h"
+
+#if( configNUM_CORES > PMU_MAX_CORES )
+#error Raise PMU_MAX_CORES
+#endif
+
+typedef char pmu_probes_fit[(PMU_NUM_PROBES <= PMU_MAX_PROBES) ? 1 : -1];
+
+/* PMCR_EL0 */
+#define PMCR_E              (1U << 0)   /* enable */
+#define PMCR_P              (1U << 1)   /* reset the event counters */
+#define PMCR_C              (1U << 2)   /* reset the cycle counter */
+#define PMCR_LC             (1U << 6)   /* 64-bit cycle counter */
+#define PMCR_N(pmcr)        (((pmcr) >> 11) & 0x1FU)
+
+/* PMCNTENSET_EL0: the cycle counter and event counters 0 to 3 */
+#define PMCNTEN_MASK        ((1U << 31) | 0xFU)
+
+/* Event counters in use, counter 0 is PMU_INSTRUCTIONS */
+#define PMU_NUM_EVENTS      (PMU_NUM_COUNTERS - 1U)
+
+#define PMU_CALIBRATION_RUNS (16U)
+
+static const char pmu_names[PMU_NUM_PROBES][PMU_NAME_LEN] = {
+    "ip_packet", "checksum", "tcp_state", "yield",
+};
+
+static struct pmu_shm * const shm = (struct pmu_shm *)PMU_SHM_ADDR;
+
+typedef char pmu_shm_fits[(sizeof(struct pmu_shm) <= PMU_SHM_SIZE) ? 1 : -1];
+
+static uint32_t pmu_ready;
+static uint32_t pmu_configured[configNUM_CORES];
+
+/* The open yield probe of each core, probe is PMU_NUM_PROBES when none is */
+static struct pmu_scope yield_scope[configNUM_CORES];
+/*-----------------------------------------------------------*/
+
+static inline uint64_t pmu_mask_irqs(void)
+{
+    uint64_t daif;
+
+    asm volatile ("mrs %0, daif; msr daifset, #2" : "=r" (daif) :: "memory");
+    return daif;
+}
+/*-----------------------------------------------------------*/
+
+static inline void pmu_restore_irqs(uint64_t daif)
+{
+    asm volatile ("msr daif, %0" :: "r" (daif) : "memory");
+}
+/*-----------------------------------------------------------*/
+
+static inline void pmu_sample(uint64_t *count)
+{
+    uint64_t c0, c1, c2, c3;
+
+    /* Everything before has been counted */
+    asm volatile ("isb" ::: "memory");
+    asm volatile ("mrs %0, pmccntr_el0" : "=r" (count[PMU_CYCLES]));
+    asm volatile ("mrs %0, pmevcntr0_el0" : "=r" (c0));
+    asm volatile ("mrs %0, pmevcntr1_el0" : "=r" (c1));
+    asm volatile ("mrs %0, pmevcntr2_el0" : "=r" (c2));
+    asm volatile ("mrs %0, pmevcntr3_el0" : "=r" (c3));
+    count[PMU_INSTRUCTIONS] = c0;
+    count[PMU_L1D_REFILLS] = c1;
+    count[PMU_L2D_REFILLS] = c2;
+    count[PMU_BRANCH_MISSES] = c3;
+}
+/*-----------------------------------------------------------*/
+
+/* The event counters are 32 bits wide, the cycle counter 64 */
+static inline uint64_t pmu_delta(uint32_t counter, uint64_t start, uint64_t end)
+{
+    return (counter == PMU_CYCLES) ? (end - start) : (uint64_t)(uint32_t)(end - start);
+}
+/*-----------------------------------------------------------*/
+
+/* Interrupts are masked */
+static void pmu_configure(uint32_t core)
+{
+    uint64_t pmcr, a[PMU_NUM_COUNTERS], b[PMU_NUM_COUNTERS], delta;
+    uint32_t i, run;
+
+    asm volatile ("mrs %0, pmcr_el0" : "=r" (pmcr));
+    if (PMCR_N(pmcr) < PMU_NUM_EVENTS) {
+        shm->flags[core] |= PMU_FLAG_NO_PMU;
+    }
+
+    /* Count at EL0 and EL1, not at EL2 */
+    asm volatile ("msr pmevtyper0_el0, %0" :: "r" (0x08UL));
+    asm volatile ("msr pmevtyper1_el0, %0" :: "r" (0x03UL));
+    asm volatile ("msr pmevtyper2_el0, %0" :: "r" (0x17UL));
+    asm volatile ("msr pmevtyper3_el0, %0" :: "r" (0x10UL));
+    asm volatile ("msr pmccfiltr_el0, %0" :: "r" (0UL));
+    asm volatile ("msr pmcntenset_el0, %0" :: "r" ((uint64_t)PMCNTEN_MASK));
+    asm volatile ("msr pmcr_el0, %0; isb" :: "r" (pmcr | PMCR_E | PMCR_P | PMCR_C | PMCR_LC) : "memory");
+
+    /* What the reads of an empty probe count */
+    for (i = 0; i < PMU_NUM_COUNTERS; i++) {
+        shm->overhead[core][i] = UINT64_MAX;
+    }
+    for (run = 0; run < PMU_CALIBRATION_RUNS; run++) {
+        pmu_sample(a);
+        pmu_sample(b);
+        for (i = 0; i < PMU_NUM_COUNTERS; i++) {
+            delta = pmu_delta(i, a[i], b[i]);
+            if (delta < shm->overhead[core][i]) {
+                shm->overhead[core][i] = delta;
+            }
+        }
+    }
+
+    pmu_configured[core] = 1U;
+}
+/*-----------------------------------------------------------*/
+
+static void pmu_add(uint32_t core, uint32_t probe, const uint64_t *start, const uint64_t *end)
+{
+    struct pmu_probe *p = &shm->probes[core][probe];
+    uint64_t cycles;
+    uint32_t i, bucket;
+
+    for (i = 0; i < PMU_NUM_COUNTERS; i++) {
+        p->sum[i] += pmu_delta(i, start[i], end[i]);
+    }
+    cycles = end[PMU_CYCLES] - start[PMU_CYCLES];
+    if ((p->count == 0U) || (cycles < p->min_cycles)) {
+        p->min_cycles = cycles;
+    }
+    if (cycles > p->max_cycles) {
+        p->max_cycles = cycles;
+    }
+    bucket = (cycles == 0U) ? 0U : (64U - (uint32_t)__builtin_clzll(cycles));
+    if (bucket >= PMU_HIST_BUCKETS) {
+        bucket = PMU_HIST_BUCKETS - 1U;
+    }
+    p->hist[bucket]++;
+    p->count++;
+}
+/*-----------------------------------------------------------*/
+
+struct pmu_scope pmu_begin(uint32_t probe)
+{
+    struct pmu_scope scope;
+    uint64_t daif;
+
+    scope.probe = PMU_NUM_PROBES;
+    scope.core = 0U;
+    if ((__atomic_load_n(&pmu_ready, __ATOMIC_ACQUIRE) == 0U) || (probe >= PMU_NUM_PROBES)) {
+        return scope;
+    }
+
+    /* The core and its counters are read without migrating in between */
+    daif = pmu_mask_irqs();
+    scope.core = (uint32_t)portGET_CORE_ID();
+    if (pmu_configured[scope.core] == 0U) {
+        pmu_configure(scope.core);
+    }
+    scope.probe = probe;
+    pmu_sample(scope.start);
+    pmu_restore_irqs(daif);
+
+    return scope;
+}
+/*-----------------------------------------------------------*/
+
+void pmu_end(struct pmu_scope *scope)
+{
+    uint64_t end[PMU_NUM_COUNTERS];
+    uint64_t daif;
+    uint32_t core;
+
+    if (scope->probe >= PMU_NUM_PROBES) {
+        return;
+    }
+
+    daif = pmu_mask_irqs();
+    pmu_sample(end);
+    core = (uint32_t)portGET_CORE_ID();
+    if (core == scope->core) {
+        pmu_add(core, scope->probe, scope->start, end);
+    } else {
+        /* The counters of two cores cannot be compared */
+        shm->probes[core][scope->probe].discarded++;
+    }
+    pmu_restore_irqs(daif);
+}
+/*-----------------------------------------------------------*/
+
+void pmu_yield_begin(void)
+{
+    struct pmu_scope scope;
+    uint64_t daif;
+
+    /* Masked until the scope is stored on the core it was opened on.  The
+    trap follows right away, an interrupt in between that switches the task
+    ends the probe itself. */
+    daif = pmu_mask_irqs();
+    scope = pmu_begin(PMU_PROBE_YIELD);
+    if (scope.probe != PMU_NUM_PROBES) {
+        yield_scope[scope.core] = scope;
+    }
+    pmu_restore_irqs(daif);
+}
+/*-----------------------------------------------------------*/
+
+void pmu_yield_end(void)
+{
+    struct pmu_scope *scope;
+
+    /* Called by vTaskSwitchContext() with interrupts masked */
+    if (__atomic_load_n(&pmu_ready, __ATOMIC_ACQUIRE) == 0U) {
+        return;
+    }
+    scope = &yield_scope[portGET_CORE_ID()];
+    pmu_end(scope);
+    scope->probe = PMU_NUM_PROBES;
+}
+/*-----------------------------------------------------------*/
+
+void pmu_init(void)
+{
+    uint64_t *p = (uint64_t *)shm;
+    uint64_t daif;
+    size_t i, j;
+
+    for (i = 0; i < sizeof(*shm) / sizeof(uint64_t); i++) {
+        p[i] = 0U;
+    }
+    for (i = 0; i < PMU_NUM_PROBES; i++) {
+        for (j = 0; j < PMU_NAME_LEN; j++) {
+            shm->names[i][j] = pmu_names[i][j];
+        }
+    }
+    for (i = 0; i < configNUM_CORES; i++) {
+        yield_scope[i].probe = PMU_NUM_PROBES;
+    }
+    shm->version = PMU_VERSION;
+    shm->num_cores = configNUM_CORES;
+    shm->num_probes = PMU_NUM_PROBES;
+
+    daif = pmu_mask_irqs();
+    pmu_configure((uint32_t)portGET_CORE_ID());
+    pmu_restore_irqs(daif);
+
+    shm->magic = PMU_MAGIC;
+    __atomic_store_n(&pmu_ready, 1U, __ATOMIC_RELEASE);
+
+    return;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,106 @@
+/* pmu.h */
+#ifndef PMU_H
+#define PMU_H
+
+#include <stdint.h>
+
+/*
+ * Where the probe statistics are kept: 256KB of the region that mmu_cfg.c
+ * maps as shared with Linux, between the profiler (profiler.h) and the
+ * latency measurements (latency.h).
+ * Linux reads them through /dev/mem, see tools/pmu_decode.c.
+ */
+#ifndef PMU_SHM_ADDR
+#define PMU_SHM_ADDR (0x20780000UL)
+#endif
+#define PMU_SHM_SIZE (0x40000UL)
+
+#define PMU_MAGIC       (0x50554D50U)   /* "PMUP" */
+#define PMU_VERSION     (1U)
+
+/* Fixed, the decoder includes this header */
+#define PMU_MAX_CORES       (4U)
+#define PMU_MAX_PROBES      (16U)
+#define PMU_NAME_LEN        (16U)
+#define PMU_HIST_BUCKETS    (32U)   /* bucket n: cycles below 2^n, the last one everything above */
+
+/* What is counted over each probe, the cycle counter and four of the six
+event counters of the Cortex-A72 */
+#define PMU_CYCLES          (0U)    /* PMCCNTR_EL0 */
+#define PMU_INSTRUCTIONS    (1U)    /* 0x08 INST_RETIRED */
+#define PMU_L1D_REFILLS     (2U)    /* 0x03 L1D_CACHE_REFILL */
+#define PMU_L2D_REFILLS     (3U)    /* 0x17 L2D_CACHE_REFILL */
+#define PMU_BRANCH_MISSES   (4U)    /* 0x10 BR_MIS_PRED */
+#define PMU_NUM_COUNTERS    (5U)
+
+/* Probes, their names are in pmu.c */
+#define PMU_PROBE_IP_PACKET (0U)    /* prvIPTask(): one eNetworkRxEvent */
+#define PMU_PROBE_CHECKSUM  (1U)    /* usGenerateChecksum() */
+#define PMU_PROBE_TCP_STATE (2U)    /* prvTCPHandleState() */
+#define PMU_PROBE_YIELD     (3U)    /* portYIELD() up to the end of vTaskSwitchContext() */
+#define PMU_NUM_PROBES      (4U)
+
+/* The core has fewer than four event counters, or they are not accessible
+(a hypervisor that does not give the PMU to the guest makes them read 0) */
+#define PMU_FLAG_NO_PMU     (1U << 0)
+
+struct pmu_probe {
+    uint64_t count;
+    uint64_t discarded;     /* ended on another core than they began, not counted */
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+    uint64_t sum[PMU_NUM_COUNTERS];
+    uint32_t hist[PMU_HIST_BUCKETS];    /* of the cycles */
+};
+
+/*
+ * Each core updates its own rows as probes end, with interrupts masked.  A
+ * reader sees each field consistently, the fields of one probe may be a
+ * sample apart.
+ */
+struct pmu_shm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_cores;
+    uint32_t num_probes;
+    uint32_t flags[PMU_MAX_CORES];
+    uint64_t overhead[PMU_MAX_CORES][PMU_NUM_COUNTERS];    /* counted by an empty probe */
+    char names[PMU_MAX_PROBES][PMU_NAME_LEN];
+    struct pmu_probe probes[PMU_MAX_CORES][PMU_MAX_PROBES];
+};
+
+/* State of a probe between pmu_begin() and pmu_end() */
+struct pmu_scope {
+    uint64_t start[PMU_NUM_COUNTERS];
+    uint32_t probe;
+    uint32_t core;
+};
+
+/*
+ * Per-function cycle, instruction, cache refill and branch mispredict counts
+ * from the PMU of each core, accumulated per probe with a histogram of the
+ * cycles.  The counts include whatever preempts the probed code on the same
+ * core, a probe that ends on another core is discarded.
+ */
+
+/* Clears the shared memory and starts the counters of this core, the other
+cores start theirs at their first probe.  Call before vTaskStartScheduler(). */
+void pmu_init(void);
+
+/* Opens a probe, the returned scope is closed by pmu_end(). */
+struct pmu_scope pmu_begin(uint32_t probe);
+
+/* Closes a probe and adds what was counted since pmu_begin(). */
+void pmu_end(struct pmu_scope *scope);
+
+/* The probe around the rest of the enclosing block, it ends wherever the
+block is left. */
+#define PMU_SCOPE(probe) \
+    struct pmu_scope pmu_scope_##probe __attribute__((cleanup(pmu_end))) = pmu_begin(probe)
+
+/* traceTASK_YIELD() and traceTASK_SWITCHED_IN(): the yield probe of the core
+runs from the trap to the next task being selected. */
+void pmu_yield_begin(void);
+void pmu_yield_end(void);
+
+#endif /* PMU_H */
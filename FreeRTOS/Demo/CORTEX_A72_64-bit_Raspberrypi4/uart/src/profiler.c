@@ -0,0 +1,219 @@
+/* profiler.c */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "board.h"
+#include "profiler.h"
+
+#if( configGENERATE_RUN_TIME_STATS != 1 )
+#error profiler.c needs configGENERATE_RUN_TIME_STATS
+#endif
+
+#if( configNUM_CORES > PROFILER_MAX_CORES ) || ( MAX_NUM_IRQS > PROFILER_NUM_IRQS )
+#error Raise PROFILER_MAX_CORES or PROFILER_NUM_IRQS
+#endif
+
+#define PROFILER_STACK      (512U)
+#define PROFILER_PRIORITY   (configMAX_PRIORITIES - 2U)     /* below the timer task */
+
+/* Run time of each task at the end of the previous period */
+struct profiler_prev {
+    UBaseType_t number;
+    uint64_t total;
+};
+
+extern uint64_t read_cntvct(void);
+extern uint32_t read_cntfrq(void);
+
+static struct profiler_shm * const shm = (struct profiler_shm *)PROFILER_SHM_ADDR;
+
+typedef char profiler_shm_fits[(sizeof(struct profiler_shm) <= PROFILER_SHM_SIZE) ? 1 : -1];
+
+static uint32_t profiler_ready;
+
+/* Switches per task number, written by traceTASK_SWITCHED_IN() on the core
+the task is switched in on - a task is only switched in on one core at a time */
+static uint64_t task_switches[PROFILER_MAX_TASK_NUMBER];
+
+/* Time in the idle tasks, per core and only written by that core.  idle_since
+is CNTVCT when the idle task was switched in, 0 while another task runs; seq
+is odd while the two are updated. */
+static volatile uint32_t idle_seq[PROFILER_MAX_CORES];
+static uint64_t idle_since[PROFILER_MAX_CORES];
+static uint64_t idle_ticks[PROFILER_MAX_CORES];
+
+static TaskStatus_t status[PROFILER_MAX_TASKS];
+static struct profiler_prev prev[PROFILER_MAX_TASKS];
+static uint32_t num_prev;
+/*-----------------------------------------------------------*/
+
+void profiler_task_switched_in(uint64_t number, uint32_t idle)
+{
+    uint32_t core = portGET_CORE_ID();
+    uint64_t now = read_cntvct();
+
+    __atomic_store_n(&idle_seq[core], idle_seq[core] + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (idle_since[core] != 0U) {
+        idle_ticks[core] += now - idle_since[core];
+    }
+    idle_since[core] = (idle != 0U) ? now : 0U;
+    __atomic_store_n(&idle_seq[core], idle_seq[core] + 1U, __ATOMIC_RELEASE);
+
+    if (profiler_ready == 0U) {
+        return;
+    }
+
+    shm->switches[core]++;
+    if (number < PROFILER_MAX_TASK_NUMBER) {
+        task_switches[number]++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint64_t profiler_idle_ticks(void)
+{
+    uint64_t total = 0U, ticks, since, now;
+    uint32_t core, seq;
+
+    for (core = 0; core < configNUM_CORES; core++) {
+        do {
+            seq = __atomic_load_n(&idle_seq[core], __ATOMIC_ACQUIRE);
+            ticks = idle_ticks[core];
+            since = idle_since[core];
+            now = read_cntvct();
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        } while ((seq & 1U) != 0U || seq != __atomic_load_n(&idle_seq[core], __ATOMIC_RELAXED));
+
+        /* The idle task running now, possibly asleep in WFI */
+        if (since != 0U && now > since) {
+            ticks += now - since;
+        }
+        total += ticks;
+    }
+    return total;
+}
+/*-----------------------------------------------------------*/
+
+void profiler_irq_done(uint32_t id, uint64_t start)
+{
+    struct profiler_irq *irq;
+    uint64_t ticks;
+
+    ticks = read_cntvct() - start;
+    if ((profiler_ready == 0U) || (id >= PROFILER_NUM_IRQS)) {
+        return;
+    }
+
+    /* Only this core writes its row */
+    irq = &shm->irqs[portGET_CORE_ID()][id];
+    irq->count++;
+    irq->ticks += ticks;
+    if (ticks > irq->max_ticks) {
+        irq->max_ticks = ticks;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prev_total(UBaseType_t number)
+{
+    uint32_t i;
+
+    for (i = 0; i < num_prev; i++) {
+        if (prev[i].number == number) {
+            return prev[i].total;
+        }
+    }
+    /* Created during the last period */
+    return 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void profiler_publish(UBaseType_t num_tasks, uint64_t total)
+{
+    struct profiler_task *task;
+    uint32_t i, j;
+
+    /* Odd while the table is rewritten */
+    __atomic_store_n(&shm->seq, shm->seq + 1U, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    for (i = 0; i < num_tasks; i++) {
+        task = &shm->tasks[i];
+        for (j = 0; (j < PROFILER_NAME_LEN - 1U) && (status[i].pcTaskName[j] != '\0'); j++) {
+            task->name[j] = status[i].pcTaskName[j];
+        }
+        task->name[j] = '\0';
+        task->number = (uint32_t)status[i].xTaskNumber;
+        task->priority = (uint32_t)status[i].uxBasePriority;
+        task->run_total = status[i].ulRunTimeCounter;
+        task->run_window = task->run_total - prev_total(status[i].xTaskNumber);
+        task->switches = (status[i].xTaskNumber < PROFILER_MAX_TASK_NUMBER) ?
+                         task_switches[status[i].xTaskNumber] : 0U;
+    }
+    for (i = 0; i < num_tasks; i++) {
+        prev[i].number = status[i].xTaskNumber;
+        prev[i].total = status[i].ulRunTimeCounter;
+    }
+    num_prev = num_tasks;
+
+    shm->num_tasks = num_tasks;
+    shm->window = total - shm->timestamp;
+    shm->timestamp = total;
+    shm->periods++;
+    shm->flags &= ~PROFILER_FLAG_TOO_MANY_TASKS;
+
+    __atomic_store_n(&shm->seq, shm->seq + 1U, __ATOMIC_RELEASE);
+}
+/*-----------------------------------------------------------*/
+
+static void profiler_task(void *param)
+{
+    TickType_t wake;
+    UBaseType_t num_tasks;
+    uint64_t total;
+
+    (void)param;
+
+    wake = xTaskGetTickCount();
+    for (;;) {
+        vTaskDelayUntil(&wake, pdMS_TO_TICKS(PROFILER_PERIOD_MS));
+
+        /* The tasks that run on the other core while this samples do not
+        have their current time slice counted yet, it is counted in the
+        period they are switched out in. */
+        num_tasks = uxTaskGetSystemState(status, PROFILER_MAX_TASKS, &total);
+        if (num_tasks == 0U) {
+            /* The next period covers this one too */
+            shm->flags |= PROFILER_FLAG_TOO_MANY_TASKS;
+            continue;
+        }
+        profiler_publish(num_tasks, total);
+    }
+}
+/*-----------------------------------------------------------*/
+
+void profiler_init(void)
+{
+    uint8_t *p = (uint8_t *)shm;
+    size_t i;
+
+    for (i = 0; i < sizeof(*shm); i++) {
+        p[i] = 0U;
+    }
+    shm->version = PROFILER_VERSION;
+    shm->num_cores = configNUM_CORES;
+    shm->cntfrq = read_cntfrq();
+    shm->period_ms = PROFILER_PERIOD_MS;
+    /* Written last, the decoder ignores the region until then */
+    __atomic_store_n(&shm->magic, PROFILER_MAGIC, __ATOMIC_RELEASE);
+    profiler_ready = 1U;
+
+    xTaskCreate(profiler_task, "Profiler", PROFILER_STACK, NULL, PROFILER_PRIORITY, NULL);
+
+    return;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,107 @@
+/* profiler.h */
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+/*
+ * Where the profile is kept: 512KB of the 2MB write-through region that
+ * mmu_cfg.c maps as shared with Linux, between the trace recorder
+ * (trace_recorder.h) and the PMU probes (pmu.h).  Linux reads it through
+ * /dev/mem, see tools/profiler_decode.c.
+ */
+#ifndef PROFILER_SHM_ADDR
+#define PROFILER_SHM_ADDR (0x20700000UL)
+#endif
+#define PROFILER_SHM_SIZE (0x80000UL)
+
+/* Period of the profiler task, the CPU share of each task is measured over
+one period */
+#ifndef PROFILER_PERIOD_MS
+#define PROFILER_PERIOD_MS (1000U)
+#endif
+
+#define PROFILER_MAGIC      (0x464F5250U)   /* "PROF" */
+#define PROFILER_VERSION    (1U)
+
+/* Sizes of the tables in the shared memory, the decoder includes this header
+so they are fixed rather than taken from FreeRTOSConfig.h and board.h. */
+#define PROFILER_MAX_CORES  (4U)
+#define PROFILER_MAX_TASKS  (32U)
+#define PROFILER_NUM_IRQS   (224U)  /* MAX_NUM_IRQS */
+#define PROFILER_NAME_LEN   (16U)   /* configMAX_TASK_NAME_LEN */
+
+/* Only tasks numbered below this have their context switches counted */
+#define PROFILER_MAX_TASK_NUMBER (64U)
+
+/* More tasks than PROFILER_MAX_TASKS, the task table was not updated */
+#define PROFILER_FLAG_TOO_MANY_TASKS (1U << 0)
+
+struct profiler_task {
+    char name[PROFILER_NAME_LEN];
+    uint32_t number;        /* uxTCBNumber, unique per task */
+    uint32_t priority;      /* base priority */
+    uint64_t run_window;    /* CNTVCT ticks in the Running state during the last period */
+    uint64_t run_total;     /* ... since the scheduler was started */
+    uint64_t switches;      /* times switched in since the scheduler was started */
+};
+
+struct profiler_irq {
+    uint64_t count;
+    uint64_t ticks;         /* CNTVCT ticks spent in the handler */
+    uint64_t max_ticks;     /* longest single run of the handler */
+};
+
+/*
+ * The task table and the header fields up to tasks are rewritten at the end
+ * of each period, seq is odd while that happens: a reader copies them and
+ * retries when seq was odd or changed meanwhile.  The per-core counters are
+ * updated as things happen by the core they belong to, each 64-bit field on
+ * its own is read consistently.
+ */
+struct profiler_shm {
+    uint32_t magic;
+    uint32_t version;
+    volatile uint32_t seq;
+    uint32_t flags;
+    uint32_t num_cores;
+    uint32_t num_tasks;
+    uint32_t cntfrq;        /* CNTVCT ticks per second */
+    uint32_t period_ms;
+    uint64_t periods;       /* completed periods */
+    uint64_t window;        /* CNTVCT ticks in the last period */
+    uint64_t timestamp;     /* run time counter at the end of the last period */
+    struct profiler_task tasks[PROFILER_MAX_TASKS];
+    uint64_t switches[PROFILER_MAX_CORES];  /* context switches per core */
+    struct profiler_irq irqs[PROFILER_MAX_CORES][PROFILER_NUM_IRQS];
+};
+
+/*
+ * Per-task CPU share from the kernel's run time stats (configGENERATE_RUN_TIME_STATS,
+ * counted in CNTVCT ticks), context switches per core and task from
+ * traceTASK_SWITCHED_IN(), and the time spent in each interrupt handler from
+ * vApplicationIRQHandler().  The profiler task samples the run time stats
+ * every PROFILER_PERIOD_MS and publishes everything in struct profiler_shm at
+ * PROFILER_SHM_ADDR.
+ */
+
+/* Clears the shared memory and creates the profiler task, call before
+vTaskStartScheduler(). */
+void profiler_init(void);
+
+/* traceTASK_SWITCHED_IN(), with the number of the task switched in and
+whether it is the idle task of the core. */
+void profiler_task_switched_in(uint64_t number, uint32_t idle);
+
+/* CNTVCT ticks spent in the idle tasks since the scheduler was started,
+summed over the cores.  Includes the time of the idle tasks running now and
+the tickless sleep, so unlike an idle hook counter it is exact across WFI;
+the CPU load over an interval of run time counter values is
+1 - idle / (interval * configNUM_CORES). */
+uint64_t profiler_idle_ticks(void);
+
+/* Called by vApplicationIRQHandler() after the handler of IRQ id returned,
+start is CNTVCT before it was called. */
+void profiler_irq_done(uint32_t id, uint64_t start);
+
+#endif /* PROFILER_H */
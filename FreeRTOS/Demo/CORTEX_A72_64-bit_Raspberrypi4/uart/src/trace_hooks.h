@@ -0,0 +1,71 @@
+/* trace_hooks.h */
+#ifndef TRACE_HOOKS_H
+#define TRACE_HOOKS_H
+
+/*
+ * Kernel trace hooks that feed the trace recorder (trace_recorder.h),
+ * included by FreeRTOSConfig.h.  The macros expand inside tasks.c, queue.c,
+ * timers.c and the other kernel sources, so they may use the TCB and queue
+ * fields and pxCurrentTCB.  traceTASK_SWITCHED_IN() is defined in
+ * FreeRTOSConfig.h, it also feeds the profiler.
+ */
+
+#include <stdint.h>
+
+#include "trace_recorder.h"
+
+#define TRACE_OBJ(x)    ((uint32_t)(uintptr_t)(x))
+
+#define traceTASK_SWITCHED_OUT()            trace_event(TRACE_EV_TASK_SWITCHED_OUT, TRACE_OBJ(pxCurrentTCB))
+#define traceTASK_CREATE(pxNewTCB)          do { trace_name(TRACE_OBJ(pxNewTCB), TRACE_NAME_TASK, (pxNewTCB)->pcTaskName); \
+                                                 trace_event(TRACE_EV_TASK_CREATE, TRACE_OBJ(pxNewTCB)); } while (0)
+#define traceTASK_DELETE(pxTaskToDelete)    trace_event(TRACE_EV_TASK_DELETE, TRACE_OBJ(pxTaskToDelete))
+#define traceTASK_DELAY()                   trace_event(TRACE_EV_TASK_DELAY, TRACE_OBJ(pxCurrentTCB))
+#define traceTASK_DELAY_UNTIL(x)            trace_event(TRACE_EV_TASK_DELAY_UNTIL, TRACE_OBJ(pxCurrentTCB))
+#define traceMOVED_TASK_TO_READY_STATE(pxTCB) trace_event(TRACE_EV_TASK_READY, TRACE_OBJ(pxTCB))
+#define traceTASK_SUSPEND(pxTaskToSuspend)  trace_event(TRACE_EV_TASK_SUSPEND, TRACE_OBJ(pxTaskToSuspend))
+#define traceTASK_RESUME(pxTaskToResume)    trace_event(TRACE_EV_TASK_RESUME, TRACE_OBJ(pxTaskToResume))
+#define traceTASK_RESUME_FROM_ISR(pxTaskToResume) trace_event(TRACE_EV_TASK_RESUME, TRACE_OBJ(pxTaskToResume))
+#define traceTASK_PRIORITY_SET(pxTask, uxNewPriority) trace_event(TRACE_EV_TASK_PRIORITY_SET, TRACE_OBJ(pxTask))
+#define traceTASK_PRIORITY_INHERIT(pxTCBOfMutexHolder, uxInheritedPriority) \
+                                            trace_event(TRACE_EV_TASK_PRIORITY_INHERIT, TRACE_OBJ(pxTCBOfMutexHolder))
+#define traceTASK_PRIORITY_DISINHERIT(pxTCBOfMutexHolder, uxOriginalPriority) \
+                                            trace_event(TRACE_EV_TASK_PRIORITY_DISINHERIT, TRACE_OBJ(pxTCBOfMutexHolder))
+#define traceTASK_NOTIFY()                  trace_event(TRACE_EV_TASK_NOTIFY, TRACE_OBJ(pxTCB))
+#define traceTASK_NOTIFY_FROM_ISR()         trace_event(TRACE_EV_TASK_NOTIFY_FROM_ISR, TRACE_OBJ(pxTCB))
+#define traceTASK_NOTIFY_GIVE_FROM_ISR()    trace_event(TRACE_EV_TASK_NOTIFY_FROM_ISR, TRACE_OBJ(pxTCB))
+#define traceTASK_NOTIFY_TAKE_BLOCK()       trace_event(TRACE_EV_TASK_NOTIFY_WAIT, TRACE_OBJ(pxCurrentTCB))
+#define traceTASK_NOTIFY_WAIT_BLOCK()       trace_event(TRACE_EV_TASK_NOTIFY_WAIT, TRACE_OBJ(pxCurrentTCB))
+#define traceTASK_INCREMENT_TICK(xTickCount) trace_event(TRACE_EV_TICK, (uint32_t)(xTickCount))
+#define traceLOW_POWER_IDLE_BEGIN()         trace_event(TRACE_EV_IDLE_SLEEP, 0U)
+#define traceLOW_POWER_IDLE_END()           trace_event(TRACE_EV_IDLE_WAKE, 0U)
+
+#define traceQUEUE_CREATE(pxNewQueue)       trace_event(TRACE_EV_QUEUE_CREATE, TRACE_OBJ(pxNewQueue))
+#define traceCREATE_MUTEX(pxNewQueue)       trace_event(TRACE_EV_QUEUE_CREATE, TRACE_OBJ(pxNewQueue))
+#define traceQUEUE_REGISTRY_ADD(xQueue, pcQueueName) trace_name(TRACE_OBJ(xQueue), TRACE_NAME_QUEUE, (pcQueueName))
+#define traceQUEUE_DELETE(pxQueue)          trace_event(TRACE_EV_QUEUE_DELETE, TRACE_OBJ(pxQueue))
+#define traceQUEUE_SEND(pxQueue)            trace_event(TRACE_EV_QUEUE_SEND, TRACE_OBJ(pxQueue))
+#define traceQUEUE_SEND_FAILED(pxQueue)     trace_event(TRACE_EV_QUEUE_SEND_FAILED, TRACE_OBJ(pxQueue))
+#define traceQUEUE_SEND_FROM_ISR(pxQueue)   trace_event(TRACE_EV_QUEUE_SEND_FROM_ISR, TRACE_OBJ(pxQueue))
+#define traceQUEUE_RECEIVE(pxQueue)         trace_event(TRACE_EV_QUEUE_RECEIVE, TRACE_OBJ(pxQueue))
+#define traceQUEUE_RECEIVE_FAILED(pxQueue)  trace_event(TRACE_EV_QUEUE_RECEIVE_FAILED, TRACE_OBJ(pxQueue))
+#define traceQUEUE_RECEIVE_FROM_ISR(pxQueue) trace_event(TRACE_EV_QUEUE_RECEIVE_FROM_ISR, TRACE_OBJ(pxQueue))
+#define traceQUEUE_PEEK(pxQueue)            trace_event(TRACE_EV_QUEUE_PEEK, TRACE_OBJ(pxQueue))
+#define traceBLOCKING_ON_QUEUE_SEND(pxQueue) trace_event(TRACE_EV_QUEUE_BLOCK_SEND, TRACE_OBJ(pxQueue))
+#define traceBLOCKING_ON_QUEUE_RECEIVE(pxQueue) trace_event(TRACE_EV_QUEUE_BLOCK_RECEIVE, TRACE_OBJ(pxQueue))
+#define traceBLOCKING_ON_QUEUE_PEEK(pxQueue) trace_event(TRACE_EV_QUEUE_BLOCK_RECEIVE, TRACE_OBJ(pxQueue))
+
+#define traceTIMER_CREATE(pxNewTimer)       trace_name(TRACE_OBJ(pxNewTimer), TRACE_NAME_TIMER, (pxNewTimer)->pcTimerName)
+#define traceTIMER_EXPIRED(pxTimer)         trace_event(TRACE_EV_TIMER_EXPIRED, TRACE_OBJ(pxTimer))
+
+#define traceEVENT_GROUP_SET_BITS(xEventGroup, uxBitsToSet) trace_event(TRACE_EV_EVENT_GROUP_SET, TRACE_OBJ(xEventGroup))
+#define traceEVENT_GROUP_SET_BITS_FROM_ISR(xEventGroup, uxBitsToSet) trace_event(TRACE_EV_EVENT_GROUP_SET, TRACE_OBJ(xEventGroup))
+#define traceEVENT_GROUP_WAIT_BITS_BLOCK(xEventGroup, uxBitsToWaitFor) trace_event(TRACE_EV_EVENT_GROUP_WAIT, TRACE_OBJ(xEventGroup))
+#define traceEVENT_GROUP_SYNC_BLOCK(xEventGroup, uxBitsToSet, uxBitsToWaitFor) trace_event(TRACE_EV_EVENT_GROUP_WAIT, TRACE_OBJ(xEventGroup))
+
+#define traceSTREAM_BUFFER_SEND(xStreamBuffer, xBytesSent) trace_event(TRACE_EV_STREAM_SEND, TRACE_OBJ(xStreamBuffer))
+#define traceSTREAM_BUFFER_SEND_FROM_ISR(xStreamBuffer, xBytesSent) trace_event(TRACE_EV_STREAM_SEND, TRACE_OBJ(xStreamBuffer))
+#define traceSTREAM_BUFFER_RECEIVE(xStreamBuffer, xReceivedLength) trace_event(TRACE_EV_STREAM_RECEIVE, TRACE_OBJ(xStreamBuffer))
+#define traceSTREAM_BUFFER_RECEIVE_FROM_ISR(xStreamBuffer, xReceivedLength) trace_event(TRACE_EV_STREAM_RECEIVE, TRACE_OBJ(xStreamBuffer))
+
+#endif /* TRACE_HOOKS_H */
@@ -0,0 +1,122 @@
+/* trace_recorder.c */
+#include <stddef.h>
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "trace_recorder.h"
+
+#if( configNUM_CORES > TRACE_MAX_CORES )
+#error Raise TRACE_MAX_CORES
+#endif
+
+/* The collector writes tail through an uncached mapping, so the line may be
+stale in the cache of this core.  The region is write-through, the line is
+never dirty and can be dropped. */
+#ifndef TRACE_INVALIDATE_LINE
+#define TRACE_INVALIDATE_LINE(addr) asm volatile ("dc civac, %0; dsb sy" :: "r" (addr) : "memory")
+#endif
+
+#define trace_shm() ((struct trace_shm *)TRACE_SHM_ADDR)
+
+typedef char trace_shm_fits[(sizeof(struct trace_shm) <= TRACE_SHM_SIZE) ? 1 : -1];
+
+extern uint64_t read_cntvct(void);
+extern uint32_t read_cntfrq(void);
+
+static uint64_t trace_mask;
+/*-----------------------------------------------------------*/
+
+void trace_event(uint32_t event, uint32_t object)
+{
+    struct trace_ring *ring;
+    struct trace_record *rec;
+    uint64_t timestamp;
+    uint32_t head;
+
+    if ((__atomic_load_n(&trace_mask, __ATOMIC_RELAXED) & (1ULL << event)) == 0U) {
+        return;
+    }
+
+    ring = &trace_shm()->rings[portGET_CORE_ID()];
+    timestamp = read_cntvct();
+
+    /* An interrupt handler that records events while this is preempted takes
+    the next record, the CAS fails here and is retried */
+    head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    do {
+        if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= TRACE_RING_RECORDS) {
+            /* Fetch tail again on the first drop and every 64th, not on each
+            while no collector runs */
+            if ((__atomic_fetch_add(&ring->dropped, 1U, __ATOMIC_RELAXED) & 63U) == 0U) {
+                TRACE_INVALIDATE_LINE(&ring->tail);
+            }
+            return;
+        }
+    } while (!__atomic_compare_exchange_n(&ring->head, &head, head + 1U, 1,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    rec = &ring->rec[head & (TRACE_RING_RECORDS - 1U)];
+    rec->timestamp = timestamp;
+    rec->object = object;
+    __atomic_store_n(&rec->info, ((head + 1U) << 16) | event, __ATOMIC_RELEASE);
+}
+/*-----------------------------------------------------------*/
+
+void trace_name(uint32_t object, uint32_t kind, const char *name)
+{
+    struct trace_shm *shm = trace_shm();
+    struct trace_name *entry;
+    uint32_t idx, i;
+
+    if ((object == 0U) || (__atomic_load_n(&trace_mask, __ATOMIC_RELAXED) == 0U)) {
+        return;
+    }
+
+    idx = __atomic_fetch_add(&shm->num_names, 1U, __ATOMIC_RELAXED);
+    if (idx >= TRACE_MAX_NAMES) {
+        /* Full, keep num_names from growing further */
+        __atomic_store_n(&shm->num_names, TRACE_MAX_NAMES, __ATOMIC_RELAXED);
+        return;
+    }
+
+    entry = &shm->names[idx];
+    for (i = 0; (i < TRACE_NAME_LEN - 1U) && (name != NULL) && (name[i] != '\0'); i++) {
+        entry->name[i] = name[i];
+    }
+    entry->name[i] = '\0';
+    entry->kind = kind;
+    __atomic_store_n(&entry->object, object, __ATOMIC_RELEASE);
+}
+/*-----------------------------------------------------------*/
+
+void trace_set_mask(uint64_t mask)
+{
+    __atomic_store_n(&trace_mask, mask, __ATOMIC_RELAXED);
+    trace_shm()->mask = mask;
+}
+/*-----------------------------------------------------------*/
+
+void trace_init(void)
+{
+    struct trace_shm *shm = trace_shm();
+    uint64_t *p = (uint64_t *)shm;
+    size_t i;
+
+    trace_mask = 0U;
+    for (i = 0; i < sizeof(*shm) / sizeof(uint64_t); i++) {
+        p[i] = 0U;
+    }
+    shm->version = TRACE_VERSION;
+    shm->num_cores = configNUM_CORES;
+    shm->cntfrq = read_cntfrq();
+    shm->ring_records = TRACE_RING_RECORDS;
+    /* Written last, the collector ignores the region until then */
+    __atomic_store_n(&shm->magic, TRACE_MAGIC, __ATOMIC_RELEASE);
+
+    trace_set_mask(TRACE_DEFAULT_MASK);
+
+    return;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,147 @@
+/* trace_recorder.h */
+#ifndef TRACE_RECORDER_H
+#define TRACE_RECORDER_H
+
+#include <stdint.h>
+
+/*
+ * Where the trace is kept: the lower half of the 2MB write-through region
+ * that mmu_cfg.c maps as shared with Linux and raspi4-rpmsg.dtso exposes as
+ * the generic-uio device "shm".  The profiler (profiler.h) has the upper
+ * half.  Linux reads it with tools/trace_collect.c.
+ */
+#ifndef TRACE_SHM_ADDR
+#define TRACE_SHM_ADDR (0x20600000UL)
+#endif
+#define TRACE_SHM_SIZE (0x100000UL)
+
+#define TRACE_MAGIC     (0x45435254U)   /* "TRCE" */
+#define TRACE_VERSION   (1U)
+
+/* Fixed, the collector includes this header */
+#define TRACE_MAX_CORES     (4U)
+#define TRACE_RING_RECORDS  (8192U)     /* per core, a power of two below 65536 */
+#define TRACE_MAX_NAMES     (128U)
+#define TRACE_NAME_LEN      (16U)
+
+/* Event IDs, below 64 so they fit the event mask */
+#define TRACE_EV_TASK_SWITCHED_IN   (0U)    /* object: task */
+#define TRACE_EV_TASK_SWITCHED_OUT  (1U)
+#define TRACE_EV_TASK_CREATE        (2U)
+#define TRACE_EV_TASK_DELETE        (3U)
+#define TRACE_EV_TASK_DELAY         (4U)
+#define TRACE_EV_TASK_DELAY_UNTIL   (5U)
+#define TRACE_EV_TASK_READY         (6U)
+#define TRACE_EV_TASK_SUSPEND       (7U)
+#define TRACE_EV_TASK_RESUME        (8U)
+#define TRACE_EV_TASK_PRIORITY_SET  (9U)
+#define TRACE_EV_TASK_PRIORITY_INHERIT (10U)
+#define TRACE_EV_TASK_PRIORITY_DISINHERIT (11U)
+#define TRACE_EV_TASK_NOTIFY        (12U)   /* object: the task notified */
+#define TRACE_EV_TASK_NOTIFY_FROM_ISR (13U)
+#define TRACE_EV_TASK_NOTIFY_WAIT   (14U)   /* object: the task that blocks */
+#define TRACE_EV_TICK               (15U)   /* object: tick count */
+#define TRACE_EV_QUEUE_CREATE       (16U)   /* object: queue, semaphore or mutex */
+#define TRACE_EV_QUEUE_DELETE       (17U)
+#define TRACE_EV_QUEUE_SEND         (18U)
+#define TRACE_EV_QUEUE_SEND_FAILED  (19U)
+#define TRACE_EV_QUEUE_SEND_FROM_ISR (20U)
+#define TRACE_EV_QUEUE_RECEIVE      (21U)
+#define TRACE_EV_QUEUE_RECEIVE_FAILED (22U)
+#define TRACE_EV_QUEUE_RECEIVE_FROM_ISR (23U)
+#define TRACE_EV_QUEUE_PEEK         (24U)
+#define TRACE_EV_QUEUE_BLOCK_SEND   (25U)
+#define TRACE_EV_QUEUE_BLOCK_RECEIVE (26U)
+#define TRACE_EV_ISR_ENTER          (27U)   /* object: IRQ number */
+#define TRACE_EV_ISR_EXIT           (28U)
+#define TRACE_EV_TIMER_EXPIRED      (29U)   /* object: timer */
+#define TRACE_EV_EVENT_GROUP_SET    (30U)   /* object: event group */
+#define TRACE_EV_EVENT_GROUP_WAIT   (31U)
+#define TRACE_EV_STREAM_SEND        (32U)   /* object: stream or message buffer */
+#define TRACE_EV_STREAM_RECEIVE     (33U)
+#define TRACE_EV_IDLE_SLEEP         (34U)   /* object: none */
+#define TRACE_EV_IDLE_WAKE          (35U)
+#define TRACE_EV_COUNT              (36U)
+
+/* The tick is left out by default, it would fill the rings with one event per
+millisecond */
+#ifndef TRACE_DEFAULT_MASK
+#define TRACE_DEFAULT_MASK (((1ULL << TRACE_EV_COUNT) - 1ULL) & ~(1ULL << TRACE_EV_TICK))
+#endif
+
+/* Kinds of names */
+#define TRACE_NAME_TASK     (1U)
+#define TRACE_NAME_QUEUE    (2U)
+#define TRACE_NAME_TIMER    (3U)
+
+/*
+ * Objects are identified by the low 32 bits of their handle, all of the RAM
+ * of the RTOS is below 4GB.  info is written last: the event in bits 15:0 and
+ * the low 16 bits of the record's index + 1 in bits 31:16, so a reader can
+ * tell a record that is complete from one of the previous lap.
+ */
+struct trace_record {
+    uint64_t timestamp;     /* CNTVCT */
+    uint32_t object;
+    uint32_t info;
+};
+
+#define TRACE_INFO_EVENT(info)  ((info) & 0xFFFFU)
+#define TRACE_INFO_SEQ(info)    ((info) >> 16)
+
+/* object is written last, 0 while the entry is not complete */
+struct trace_name {
+    uint32_t object;
+    uint32_t kind;
+    char name[TRACE_NAME_LEN];
+};
+
+/*
+ * One ring per core, written only by that core (tasks and interrupt handlers,
+ * which reserve records with a compare-and-swap on head).  tail is written
+ * only by the collector, in a cache line of its own.  Records are dropped and
+ * counted while the ring is full.
+ */
+struct trace_ring {
+    uint32_t head;
+    uint32_t dropped;
+    uint32_t pad0[14];
+    uint32_t tail;
+    uint32_t pad1[15];
+    struct trace_record rec[TRACE_RING_RECORDS];
+} __attribute__((aligned(64)));
+
+struct trace_shm {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t num_cores;
+    uint32_t cntfrq;        /* CNTVCT ticks per second */
+    uint32_t ring_records;
+    uint32_t num_names;     /* entries claimed in names */
+    uint64_t mask;          /* events being recorded */
+    struct trace_name names[TRACE_MAX_NAMES];
+    struct trace_ring rings[TRACE_MAX_CORES];
+};
+
+/*
+ * Binary recorder for the kernel trace hooks (trace_hooks.h).  Each event is
+ * a 16-byte record with the CNTVCT timestamp, the event ID and the object it
+ * concerns; names of tasks, registered queues and timers are kept in a table
+ * beside the rings.  Callable from tasks and interrupt handlers on any core,
+ * never blocks.
+ */
+
+/* Clears the shared memory and starts recording, call first thing in main()
+so the names of all tasks and queues are seen. */
+void trace_init(void);
+
+/* Records event for object on the calling core. */
+void trace_event(uint32_t event, uint32_t object);
+
+/* Adds a name for object, names longer than TRACE_NAME_LEN - 1 are cut. */
+void trace_name(uint32_t object, uint32_t kind, const char *name);
+
+/* Sets the events that are recorded, one bit per event ID. */
+void trace_set_mask(uint64_t mask);
+
+#endif /* TRACE_RECORDER_H */
@@ -1,8 +1,10 @@
 /* uart.c */
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "FreeRTOS.h"
+#include "task.h"
 #include "board.h"
 #include "interrupt.h"
 #include "semphr.h"
@@ -18,18 +20,202 @@
 #define UART_CR   (*(volatile unsigned int *)(UART_BASE+0x30U))
 #define UART_IFLS (*(volatile unsigned int *)(UART_BASE+0x34U))
 #define UART_IMSC (*(volatile unsigned int *)(UART_BASE+0x38U))
+#define UART_MIS  (*(volatile unsigned int *)(UART_BASE+0x40U))
 #define UART_ICR  (*(volatile unsigned int *)(UART_BASE+0x44U))
 
+/* UART_FR bits */
+#define UART_FR_TXFE    (0x1U << 7)     /* Tx FIFO empty */
+#define UART_FR_TXFF    (0x1U << 5)     /* Tx FIFO full */
+#define UART_FR_RXFE    (0x1U << 4)     /* Rx FIFO empty */
+#define UART_FR_BUSY    (0x1U << 3)     /* Transmitting */
+
+/* UART_LCRH: 8/n/1, FIFO enabled */
+#define UART_LCRH_VALUE ((0x3U << 5) | (0x1U << 4))
+
+/* UART_CR: Tx, Rx and UART enabled */
+#define UART_CR_VALUE   (0x301U)
+
+/* UART_IMSC, UART_MIS and UART_ICR bits */
+#define UART_INT_RX     (0x1U << 4)     /* Rx FIFO level */
+#define UART_INT_TX     (0x1U << 5)     /* Tx FIFO level */
+#define UART_INT_RT     (0x1U << 6)     /* Rx timeout */
+
+/* UART_IFLS: Rx interrupt at 1/2 full, Tx interrupt at 1/4 full */
+#define UART_IFLS_VALUE ((0x2U << 3) | 0x1U)
+
 /* GPIO */
 #define GPIO_BASE (0xFE200000U)
 #define GPFSEL0   (*(volatile unsigned int *)(GPIO_BASE))
 #define GPIO_PUP_PDN_CNTRL_REG0 (*(volatile unsigned int *)(GPIO_BASE+0xE4U))
 
+/* Ring buffer sizes, powers of two */
+#ifndef UART_TX_BUFSIZE
+#define UART_TX_BUFSIZE  (2048U)
+#endif
+#ifndef UART_RX_BUFSIZE
+#define UART_RX_BUFSIZE  (256U)
+#endif
+#define UART_ISR_BUFSIZE (64U)
+
+/* A writer waiting for room in the Tx ring checks again after this time. */
+#define UART_TX_WAIT_MS  (100U)
+
+/* uart_putchar() primes the Tx FIFO at the end of a line, or after this
+many bytes of a longer one. */
+#define UART_TX_LINE     (128U)
+
+/*
+ * Single-producer/single-consumer ring buffer.  head is only written by the
+ * producer and tail only by the consumer, so the two sides need no lock
+ * between them.  Each side still has to be one writer at a time, on any core:
+ * tx_mux and rx_mux make the tasks one producer of tx_ring and one consumer of
+ * rx_ring, tx_lock the interrupt handlers and the tasks one consumer of the
+ * Tx rings and one producer of isr_ring.  rx_ring is only written by
+ * uart_isr, whose SPI goes to a single core (RTOS_IRQ_CPUMASK).
+ */
+struct RING {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t mask;
+    uint8_t *buf;
+};
+
 struct UARTCTL {
-    SemaphoreHandle_t tx_mux;
-    QueueHandle_t     rx_queue;
+    SemaphoreHandle_t tx_mux;   /* Makes the writing tasks a single producer */
+    SemaphoreHandle_t tx_space; /* Given by uart_isr to a writer waiting for room */
+    SemaphoreHandle_t rx_avail; /* Given by uart_isr when bytes were received */
+    SemaphoreHandle_t rx_mux;   /* Makes the reading tasks a single consumer */
+    TaskHandle_t line_owner;    /* Holds tx_mux until the end of its line */
+    uint32_t line_len;          /* Bytes of that line not yet primed */
+    struct RING tx_ring;        /* uart_write -> uart_isr */
+    struct RING isr_ring;       /* uart_putchar_isr -> uart_isr */
+    struct RING rx_ring;        /* uart_isr -> uart_read */
+    uint32_t tx_lock;           /* See uart_tx_lock() */
+    volatile uint32_t tx_waiting;
+    volatile uint32_t tx_dropped;   /* Bytes uart_putchar_isr had no room for */
+    volatile uint32_t rx_dropped;   /* Bytes received while rx_ring was full */
 };
-struct UARTCTL *uartctl;
+
+static uint8_t tx_buf[UART_TX_BUFSIZE];
+static uint8_t isr_buf[UART_ISR_BUFSIZE];
+static uint8_t rx_buf[UART_RX_BUFSIZE];
+
+static struct UARTCTL uartctl = {
+    .tx_ring  = { 0U, 0U, UART_TX_BUFSIZE - 1U, tx_buf },
+    .isr_ring = { 0U, 0U, UART_ISR_BUFSIZE - 1U, isr_buf },
+    .rx_ring  = { 0U, 0U, UART_RX_BUFSIZE - 1U, rx_buf },
+};
+
+static inline uint32_t ring_count(struct RING *ring)
+{
+    return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+/*-----------------------------------------------------------*/
+
+/* Producer side: copy as much of src as fits, in at most two spans. */
+static uint32_t ring_write(struct RING *ring, const uint8_t *src, uint32_t length)
+{
+    uint32_t head = ring->head;
+    uint32_t space = ring->mask + 1U - (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE));
+    uint32_t offset = head & ring->mask;
+    uint32_t first;
+
+    if (length > space) {
+        length = space;
+    }
+    first = ring->mask + 1U - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(&ring->buf[offset], src, first);
+    memcpy(ring->buf, src + first, length - first);
+
+    __atomic_store_n(&ring->head, head + length, __ATOMIC_RELEASE);
+    return length;
+}
+/*-----------------------------------------------------------*/
+
+/* Consumer side: copy up to length bytes to dst, in at most two spans. */
+static uint32_t ring_read(struct RING *ring, uint8_t *dst, uint32_t length)
+{
+    uint32_t tail = ring->tail;
+    uint32_t count = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) - tail;
+    uint32_t offset = tail & ring->mask;
+    uint32_t first;
+
+    if (length > count) {
+        length = count;
+    }
+    first = ring->mask + 1U - offset;
+    if (first > length) {
+        first = length;
+    }
+    memcpy(dst, &ring->buf[offset], first);
+    memcpy(dst + first, ring->buf, length - first);
+
+    __atomic_store_n(&ring->tail, tail + length, __ATOMIC_RELEASE);
+    return length;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * The consumer side of the Tx rings runs in uart_isr, in the writing tasks
+ * through uart_tx_start() and, through uart_putchar_isr(), in the handlers of
+ * other interrupts, which nest with the UART interrupt (interrupt.h) and run
+ * on both cores.  IRQs are masked while tx_lock is held so an interrupt
+ * cannot spin on its own core.
+ */
+static inline uint64_t uart_tx_lock(void)
+{
+    uint64_t daif;
+
+    asm volatile ("mrs %0, daif" : "=r" (daif));
+    asm volatile ("msr daifset, #2" ::: "memory");
+    while (__atomic_exchange_n(&uartctl.tx_lock, 1U, __ATOMIC_ACQUIRE) != 0U) {
+        while (__atomic_load_n(&uartctl.tx_lock, __ATOMIC_RELAXED) != 0U) {
+            ;
+        }
+    }
+    return daif;
+}
+/*-----------------------------------------------------------*/
+
+static inline void uart_tx_unlock(uint64_t daif)
+{
+    __atomic_store_n(&uartctl.tx_lock, 0U, __ATOMIC_RELEASE);
+    asm volatile ("msr daif, %0" :: "r" (daif) : "memory");
+}
+/*-----------------------------------------------------------*/
+
+/* Move queued bytes to the Tx FIFO until it is full, tx_lock held. */
+static void uart_tx_fill(void)
+{
+    uint8_t c;
+
+    while ( !(UART_FR & UART_FR_TXFF) ) {
+        /* Bytes queued from interrupt context go first */
+        if (ring_read(&uartctl.isr_ring, &c, 1U) == 0U &&
+            ring_read(&uartctl.tx_ring, &c, 1U) == 0U) {
+            break;
+        }
+        UART_DR = c;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/* Prime the Tx FIFO from the rings; tx_waiting asks uart_isr for tx_space
+once it made room. */
+static void uart_tx_start(uint32_t waiting)
+{
+    uint64_t daif;
+
+    daif = uart_tx_lock();
+    uart_tx_fill();
+    uartctl.tx_waiting = waiting;
+    uart_tx_unlock(daif);
+}
+/*-----------------------------------------------------------*/
 
 void putc(void *p, char c) {
     /* Avoid compiler warning about unreferenced parameter. */
@@ -41,67 +227,259 @@ void putc(void *p, char c) {
     uart_putchar(c);
 }
 
+uint32_t uart_write(const uint8_t *buf, uint32_t length)
+{
+    uint32_t done = 0;
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        /* Interrupts are not running yet (or the caller must not block):
+        polled output. */
+        for (; done < length; done++) {
+            while ( UART_FR & UART_FR_TXFF ) { }
+            UART_DR = buf[done];
+        }
+        return length;
+    }
+
+    if (uartctl.line_owner == xTaskGetCurrentTaskHandle()) {
+        /* Ends the line the caller started with uart_putchar(), tx_mux is
+        already held */
+        uartctl.line_owner = NULL;
+    } else {
+        xSemaphoreTake(uartctl.tx_mux, (portTickType) portMAX_DELAY);
+    }
+    for (;;) {
+        done += ring_write(&uartctl.tx_ring, buf + done, length - done);
+
+        /* Prime the Tx FIFO, the Tx interrupt refills it from now on */
+        uart_tx_start(done < length);
+
+        if (done == length) {
+            break;
+        }
+        xSemaphoreTake(uartctl.tx_space, pdMS_TO_TICKS(UART_TX_WAIT_MS));
+    }
+    xSemaphoreGive(uartctl.tx_mux);
+
+    return length;
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * tfp_printf() comes here a byte at a time through putc().  The writer keeps
+ * tx_mux from its first byte to the end of the line, so its lines are not
+ * mixed with those of other writers, and the bytes go straight to the Tx
+ * ring.  The FIFO is primed, and tx_mux given, at the end of the line, after
+ * UART_TX_LINE bytes, and by uart_flush().
+ */
 void uart_putchar(uint8_t c)
 {
-    xSemaphoreTake(uartctl->tx_mux, (portTickType) portMAX_DELAY);
-    /* wait until tx becomes idle. */
-    while ( UART_FR & (0x20) ) { }
-    UART_DR = c;
-    asm volatile ("isb");
-    xSemaphoreGive(uartctl->tx_mux);
+    TaskHandle_t self;
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        uart_write(&c, 1U);
+        return;
+    }
+
+    self = xTaskGetCurrentTaskHandle();
+    if (uartctl.line_owner != self) {
+        xSemaphoreTake(uartctl.tx_mux, (portTickType) portMAX_DELAY);
+        uartctl.line_owner = self;
+        uartctl.line_len = 0U;
+    }
+
+    while (ring_write(&uartctl.tx_ring, &c, 1U) == 0U) {
+        /* The ring is full */
+        uart_tx_start(1U);
+        xSemaphoreTake(uartctl.tx_space, pdMS_TO_TICKS(UART_TX_WAIT_MS));
+    }
+
+    if (c == '\n' || ++uartctl.line_len >= UART_TX_LINE) {
+        uart_tx_start(0U);
+        uartctl.line_owner = NULL;
+        xSemaphoreGive(uartctl.tx_mux);
+    }
+}
+/*-----------------------------------------------------------*/
+
+void uart_flush(void)
+{
+    if (uartctl.line_owner == xTaskGetCurrentTaskHandle()) {
+        uart_tx_start(0U);
+        uartctl.line_owner = NULL;
+        xSemaphoreGive(uartctl.tx_mux);
+    }
 }
 /*-----------------------------------------------------------*/
 
 void uart_putchar_isr(uint8_t c)
 {
-    xSemaphoreTakeFromISR(uartctl->tx_mux, NULL);
-    /* wait mini uart for tx idle. */
-    while ( (UART_FR & 0x20) ) { }
-    UART_DR = c;
-    asm volatile ("isb");
-    xSemaphoreGiveFromISR(uartctl->tx_mux, NULL);
+    uint64_t daif;
+
+    /* Never spins: straight into the FIFO when nothing is queued, otherwise
+    queued for uart_isr.  The byte is dropped when the ISR ring is full.
+    tx_lock is held as the caller may be preempted by another interrupt that
+    writes here too, or race one on the other core. */
+    daif = uart_tx_lock();
+    if (ring_count(&uartctl.isr_ring) == 0U && ring_count(&uartctl.tx_ring) == 0U &&
+        !(UART_FR & UART_FR_TXFF)) {
+        UART_DR = c;
+    } else if (ring_write(&uartctl.isr_ring, &c, 1U) == 0U) {
+        uartctl.tx_dropped++;
+    } else {
+        uart_tx_fill();
+    }
+    uart_tx_unlock(daif);
 }
 /*-----------------------------------------------------------*/
 
 void uart_puts(const char* str)
 {
-    for (size_t i = 0; str[i] != '\0'; i ++)
-        uart_putchar((uint8_t)str[i]);
+    uart_write((const uint8_t *)str, strlen(str));
 }
 /*-----------------------------------------------------------*/
 
 void uart_puthex(uint64_t v)
 {
     const char *hexdigits = "0123456789ABCDEF";
-    for (int i = 60; i >= 0; i -= 4)
-        uart_putchar(hexdigits[(v >> i) & 0xf]);
+    uint8_t buf[16];
+
+    for (int i = 0; i < 16; i++)
+        buf[i] = hexdigits[(v >> (60 - 4 * i)) & 0xf];
+    uart_write(buf, sizeof(buf));
+}
+/*-----------------------------------------------------------*/
+
+uint32_t uart_read(uint8_t *buf, uint32_t length, TickType_t xTicksToWait)
+{
+    uint32_t num;
+
+    /* A prompt without a newline goes out before waiting for the answer */
+    uart_flush();
+
+    if (xSemaphoreTake(uartctl.rx_mux, xTicksToWait) != pdTRUE) {
+        return 0U;
+    }
+
+    num = ring_read(&uartctl.rx_ring, buf, length);
+
+    /* rx_avail may still be given for bytes which were already read */
+    while (num == 0U && length != 0U &&
+           xSemaphoreTake(uartctl.rx_avail, xTicksToWait) == pdTRUE) {
+        num = ring_read(&uartctl.rx_ring, buf, length);
+    }
+    xSemaphoreGive(uartctl.rx_mux);
+
+    return num;
 }
 /*-----------------------------------------------------------*/
 
 uint32_t uart_read_bytes(uint8_t *buf, uint32_t length)
 {
-    uint32_t num = uxQueueMessagesWaiting(uartctl->rx_queue);
-    uint32_t i;
+    uint32_t i = 0;
 
-    for (i = 0; i < num || i < length; i++) {
-        xQueueReceive(uartctl->rx_queue, &buf[i], (portTickType) portMAX_DELAY);
+    while (i < length) {
+        i += uart_read(&buf[i], length - i, (portTickType) portMAX_DELAY);
     }
 
     return i;
 }
 /*-----------------------------------------------------------*/
 
+/* Reprogram the divisors, the UART must be idle. */
+static void uart_program_baud(uint32_t ibrd, uint32_t fbrd)
+{
+    UART_CR   = 0x0U;
+    UART_IBRD = ibrd;
+    UART_FBRD = fbrd;
+    UART_LCRH = UART_LCRH_VALUE;    /* Latches IBRD and FBRD */
+    UART_CR   = UART_CR_VALUE;
+    asm volatile ("isb");
+}
+/*-----------------------------------------------------------*/
+
+int uart_set_baud(uint32_t baud)
+{
+    uint32_t ibrd, fbrd;
+
+    if (uart_baud_divisor(UART_CLOCK_HZ, baud, &ibrd, &fbrd) == 0U) {
+        return -1;
+    }
+
+    if (xTaskGetSchedulerState() != taskSCHEDULER_RUNNING) {
+        while ( !(UART_FR & UART_FR_TXFE) || (UART_FR & UART_FR_BUSY) ) { }
+        uart_program_baud(ibrd, fbrd);
+        return 0;
+    }
+
+    /* Hold off the writers and let the bytes already queued go out at the
+    old rate; the rings keep their content across the switch. */
+    uart_flush();
+    xSemaphoreTake(uartctl.tx_mux, (portTickType) portMAX_DELAY);
+    while (ring_count(&uartctl.tx_ring) != 0U || ring_count(&uartctl.isr_ring) != 0U ||
+           !(UART_FR & UART_FR_TXFE) || (UART_FR & UART_FR_BUSY)) {
+        vTaskDelay(1);
+    }
+    uart_program_baud(ibrd, fbrd);
+    xSemaphoreGive(uartctl.tx_mux);
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t uart_dropped(void)
+{
+    return uartctl.tx_dropped + uartctl.rx_dropped;
+}
+/*-----------------------------------------------------------*/
+
 void uart_isr(void)
 {
-    /* RX data */
-    if( !(UART_FR & (0x1U << 4)) ) {
-        uint8_t c = (uint8_t) 0xFF & UART_DR;
-        xQueueSendToBackFromISR(uartctl->rx_queue, &c, NULL);
+    BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+    uint32_t mis = UART_MIS;
+    uint32_t received = 0;
+    uint64_t daif;
+    uint8_t c;
+
+    /* RX data: drain the FIFO, the timeout interrupt covers the bytes below
+    the FIFO level */
+    if (mis & (UART_INT_RX | UART_INT_RT)) {
+        while ( !(UART_FR & UART_FR_RXFE) ) {
+            c = (uint8_t) 0xFF & UART_DR;
+            if (ring_write(&uartctl.rx_ring, &c, 1U) == 0U) {
+                uartctl.rx_dropped++;
+            }
+            received++;
+        }
+        UART_ICR = UART_INT_RX | UART_INT_RT;
+
+        if (received != 0U) {
+            xSemaphoreGiveFromISR(uartctl.rx_avail, &xHigherPriorityTaskWoken);
+        }
     }
+
+    /* TX FIFO below its level: refill it */
+    if (mis & UART_INT_TX) {
+        daif = uart_tx_lock();
+        uart_tx_fill();
+        if (ring_count(&uartctl.isr_ring) == 0U && ring_count(&uartctl.tx_ring) == 0U) {
+            /* Nothing left, the interrupt is raised again once a writer has
+            primed the FIFO and it drained below the level */
+            UART_ICR = UART_INT_TX;
+        }
+        uart_tx_unlock(daif);
+
+        if (uartctl.tx_waiting) {
+            uartctl.tx_waiting = 0;
+            xSemaphoreGiveFromISR(uartctl.tx_space, &xHigherPriorityTaskWoken);
+        }
+    }
+
+    portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
 }
 /*-----------------------------------------------------------*/
 
-/* 
+/*
  * wait_linux()
  * This is a busy loop function to wait until Linux completes GIC initialization
  */
@@ -126,25 +504,26 @@ void uart_init(void)
     r &= ~((0x3U << 2) | 0x3U);
     GPIO_PUP_PDN_CNTRL_REG0 = r;
 
-    /* PL011 settings with assumption of 48MHz clock */
-    UART_ICR  = 0x7FFU;         /* Clears an interrupt */
-    UART_IBRD = 0x1AU;          /* 115200 baud */
-    UART_FBRD = 0x3U;
-    UART_LCRH = ((0x3U << 5) | (0x0U << 4));    /* 8/n/1, FIFO disabled */
-    UART_IMSC = (0x1U << 4);    /* RX interrupt enabled */
-    UART_CR   = 0x301;          /* Enables Tx, Rx and UART */
-    asm volatile ("isb");
+    uartctl.tx_mux = xSemaphoreCreateMutex();
+    uartctl.tx_space = xSemaphoreCreateBinary();
+    uartctl.rx_avail = xSemaphoreCreateBinary();
+    uartctl.rx_mux = xSemaphoreCreateMutex();
 
-    uartctl = pvPortMalloc(sizeof (struct UARTCTL));
-    uartctl->tx_mux = xSemaphoreCreateMutex();
-    uartctl->rx_queue = xQueueCreate(16, sizeof (uint8_t));
+    /* PL011 settings for a UART_CLOCK_HZ reference clock */
+    UART_CR   = 0x0U;           /* Disable while configuring */
+    UART_ICR  = 0x7FFU;         /* Clears an interrupt */
+    UART_IFLS = UART_IFLS_VALUE;
+    UART_IMSC = UART_INT_RX | UART_INT_RT | UART_INT_TX;
+    if (uart_set_baud(UART_BAUD) != 0) {
+        uart_program_baud(0x1AU, 0x3U);     /* 115200 baud at 48MHz */
+    }
 
 #if defined(__LINUX__)
     uart_puts("\r\nWaiting until Linux starts booting up ...\r\n");
     wait_linux();
 #endif
 
-    isr_register(IRQ_VC_UART, UART_PRIORITY, (0x1U << 0x3U), uart_isr);
+    isr_register(IRQ_VC_UART, UART_PRIORITY, RTOS_IRQ_CPUMASK, uart_isr);
     return;
 }
 /*-----------------------------------------------------------*/
@@ -1,9 +1,44 @@
-#define UART_PRIORITY (0xA0)
+/* Above the tick and the Ethernet controller so the Rx FIFO does not overrun
+while they run (interrupt.h) */
+#define UART_PRIORITY (0xB0)
+
+/* Reference clock of the PL011 (init_uart_clock in config.txt).  The highest
+possible baud rate is UART_CLOCK_HZ / 16. */
+#ifndef UART_CLOCK_HZ
+#define UART_CLOCK_HZ (48000000U)
+#endif
+
+/* Baud rate set by uart_init() */
+#ifndef UART_BAUD
+#define UART_BAUD (115200U)
+#endif
 
 void putc(void *p, char c);
 void uart_putchar(uint8_t c);
+void uart_putchar_isr(uint8_t c);
 void uart_puts(const char* str);
 void uart_puthex(uint64_t v);
+
+/* Queue length bytes for transmission, blocks while the Tx ring is full. */
+uint32_t uart_write(const uint8_t *buf, uint32_t length);
+
+/* Send the line the calling task started with uart_putchar() without
+waiting for its newline. */
+void uart_flush(void);
+
+/* Copy up to length received bytes to buf, waiting at most xTicksToWait for
+the first one.  Returns the number of bytes copied. */
+uint32_t uart_read(uint8_t *buf, uint32_t length, TickType_t xTicksToWait);
 uint32_t uart_read_bytes(uint8_t *buf, uint32_t length);
-void uart_init(void);
 
+/* Compute IBRD/FBRD for baud from the reference clock.  Returns the baud
+rate actually generated, or 0 when baud can not be reached. */
+uint32_t uart_baud_divisor(uint32_t clock, uint32_t baud, uint32_t *ibrd, uint32_t *fbrd);
+
+/* Switch to a new baud rate once the queued bytes are sent, the ring
+buffers are kept.  Returns -1 when the rate is out of range. */
+int uart_set_baud(uint32_t baud);
+
+/* Bytes lost because a ring buffer was full. */
+uint32_t uart_dropped(void);
+void uart_init(void);
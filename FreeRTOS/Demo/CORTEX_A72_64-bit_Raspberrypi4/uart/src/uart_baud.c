@@ -0,0 +1,33 @@
+/* uart_baud.c */
+/*
+ * PL011 divisor math, kept apart from uart.c so that it builds on the host
+ * for tools/uart_baud_test.c.
+ */
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+#include "uart.h"
+
+uint32_t uart_baud_divisor(uint32_t clock, uint32_t baud, uint32_t *ibrd, uint32_t *fbrd)
+{
+    uint64_t div;
+
+    if (baud == 0U) {
+        return 0U;
+    }
+
+    /* BAUDDIV = clock / (16 * baud), as a 16.6 fixed point value rounded to
+    the nearest 1/64: clock * 64 / (16 * baud) = clock * 4 / baud */
+    div = (((uint64_t)clock * 4U) + (baud / 2U)) / baud;
+    *ibrd = (uint32_t)(div >> 6);
+    *fbrd = (uint32_t)(div & 0x3FU);
+
+    /* IBRD is 16 bits wide, a BAUDDIV below 1 is not allowed */
+    if (*ibrd == 0U || *ibrd > 0xFFFFU) {
+        return 0U;
+    }
+
+    /* The rate actually generated, to the nearest baud */
+    return (uint32_t)((((uint64_t)clock * 4U) + (div / 2U)) / div);
+}
+/*-----------------------------------------------------------*/
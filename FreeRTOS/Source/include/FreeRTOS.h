@@ -58,6 +58,12 @@ extern "C" {
 /* Basic FreeRTOS definitions. */
 #include "projdefs.h"
 
+/* The number of cores the scheduler runs tasks on.  Must be defaulted before
+portable.h is included, as the port's macros depend on it. */
+#ifndef configNUM_CORES
+	#define configNUM_CORES 1
+#endif
+
 /* Definitions specific to the port being used. */
 #include "portable.h"
 
@@ -331,6 +337,25 @@ hold explicit before calling the code. */
 	#define traceTASK_SWITCHED_IN()
 #endif
 
+#ifndef traceTASK_YIELD
+	/* Called by ports that support it when the running task yields, before it
+	traps into the scheduler. */
+	#define traceTASK_YIELD()
+#endif
+
+#ifndef traceCRITICAL_ENTER
+	/* Called with interrupts masked when the outermost critical section of
+	the core is entered.  Expands inside the function called by
+	taskENTER_CRITICAL(), so its return address is the call site. */
+	#define traceCRITICAL_ENTER()
+#endif
+
+#ifndef traceCRITICAL_EXIT
+	/* Called when the outermost critical section of the core is left, before
+	interrupts are unmasked. */
+	#define traceCRITICAL_EXIT()
+#endif
+
 #ifndef traceINCREASE_TICK_COUNT
 	/* Called before stepping the tick count after waking from tickless idle
 	sleep. */
@@ -716,6 +741,13 @@ hold explicit before calling the code. */
 	#define configGENERATE_RUN_TIME_STATS 0
 #endif
 
+/* The type of the run time counters.  A 32-bit counter driven by a fast clock
+wraps after a few minutes, ports with a 64-bit free running counter can set it
+to uint64_t. */
+#ifndef configRUN_TIME_COUNTER_TYPE
+	#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
 #if ( configGENERATE_RUN_TIME_STATS == 1 )
 
 	#ifndef portCONFIGURE_TIMER_FOR_RUN_TIME_STATS
@@ -743,7 +775,20 @@ hold explicit before calling the code. */
 #endif
 
 #ifndef portYIELD_WITHIN_API
-	#define portYIELD_WITHIN_API portYIELD
+	#if( configNUM_CORES > 1 )
+		/* A yield requested inside a critical section is held until the
+		critical section is exited, as the core must not switch tasks while it
+		holds the scheduler locks. */
+		#define portYIELD_WITHIN_API vTaskYieldWithinAPI
+	#else
+		#define portYIELD_WITHIN_API portYIELD
+	#endif
+#endif
+
+#if( configNUM_CORES > 1 )
+	#if !defined( portGET_TASK_LOCK ) || !defined( portYIELD_CORE )
+		#error configNUM_CORES is greater than 1 but the port does not provide the multi-core macros.
+	#endif
 #endif
 
 #ifndef portSUPPRESS_TICKS_AND_SLEEP
@@ -834,6 +879,22 @@ hold explicit before calling the code. */
 	#define configUSE_TASK_NOTIFICATIONS 1
 #endif
 
+#ifndef configUSE_POOL_POISONING
+	#define configUSE_POOL_POISONING 0
+#endif
+
+#ifndef configUSE_INDEXED_LISTS
+	#define configUSE_INDEXED_LISTS 0
+#endif
+
+#ifndef configUSE_TIMER_DIRECT_COMMANDS
+	#define configUSE_TIMER_DIRECT_COMMANDS 0
+#endif
+
+#ifndef configTIMER_COMMAND_BATCH_LENGTH
+	#define configTIMER_COMMAND_BATCH_LENGTH 1
+#endif
+
 #ifndef configUSE_POSIX_ERRNO
 	#define configUSE_POSIX_ERRNO 0
 #endif
@@ -1065,6 +1126,10 @@ struct xSTATIC_LIST_ITEM
 	#endif
 	TickType_t xDummy2;
 	void *pvDummy3[ 4 ];
+	#if( configUSE_INDEXED_LISTS == 1 )
+		void *pvDummy5[ 3 ];
+		UBaseType_t uxDummy6;
+	#endif
 	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
 		TickType_t xDummy4;
 	#endif
@@ -1091,6 +1156,10 @@ typedef struct xSTATIC_LIST
 	UBaseType_t uxDummy2;
 	void *pvDummy3;
 	StaticMiniListItem_t xDummy4;
+	#if( configUSE_INDEXED_LISTS == 1 )
+		void *pvDummy6;
+		BaseType_t xDummy7;
+	#endif
 	#if( configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES == 1 )
 		TickType_t xDummy5;
 	#endif
@@ -1138,7 +1207,7 @@ typedef struct xSTATIC_TCB
 		void			*pvDummy15[ configNUM_THREAD_LOCAL_STORAGE_POINTERS ];
 	#endif
 	#if ( configGENERATE_RUN_TIME_STATS == 1 )
-		uint32_t		ulDummy16;
+		configRUN_TIME_COUNTER_TYPE		ulDummy16;
 	#endif
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		struct	_reent	xDummy17;
@@ -1157,6 +1226,10 @@ typedef struct xSTATIC_TCB
 	#if ( configUSE_POSIX_ERRNO == 1 )
 		int				iDummy22;
 	#endif
+	#if ( configNUM_CORES > 1 )
+		BaseType_t		xDummy23;
+		UBaseType_t		uxDummy24;
+	#endif
 } StaticTask_t;
 
 /*
@@ -1287,6 +1360,64 @@ typedef struct xSTATIC_STREAM_BUFFER
 /* Message buffers are built on stream buffers. */
 typedef StaticStreamBuffer_t StaticMessageBuffer_t;
 
+/*
+ * In line with software engineering best practice, FreeRTOS implements a strict
+ * data hiding policy, so the real pool structure used by FreeRTOS to maintain
+ * fixed-block pools is not accessible to application code.  However, if the
+ * application writer wants to statically allocate the memory required to
+ * create a pool then the size of the pool object needs to be know.  The
+ * StaticPool_t structure below is provided for this purpose.  Its size and
+ * alignment requirements are guaranteed to match those of the genuine
+ * structure, no matter which architecture is being used, and no matter how the
+ * values in FreeRTOSConfig.h are set.  Its contents are somewhat obfuscated in
+ * the hope users will recognise that it would be unwise to make direct use of
+ * the structure members.
+ */
+typedef struct xSTATIC_POOL
+{
+	void *pvDummy1;
+	size_t xDummy2;
+	UBaseType_t uxDummy3[ 3 ];
+	uint64_t ullDummy4;
+	uint8_t ucDummy5;
+} StaticPool_t;
+
+/* See the comments above the struct xSTATIC_POOL definition.  A pointer queue
+created with xPointerQueueCreateStatic() also needs an array of
+StaticPointerQueueSlot_t, one for each pointer it can hold. */
+typedef struct xSTATIC_POINTER_QUEUE
+{
+	void *pvDummy1;
+	UBaseType_t uxDummy2[ 5 ];
+	StaticList_t xDummy3[ 2 ];
+	uint8_t ucDummy4;
+} StaticPointerQueue_t;
+
+typedef struct xSTATIC_POINTER_QUEUE_SLOT
+{
+	UBaseType_t uxDummy1;
+	void *pvDummy2;
+} StaticPointerQueueSlot_t;
+
+/* See the comments above the struct xSTATIC_POOL definition. */
+typedef struct xSTATIC_MP_MESSAGE_BUFFER
+{
+	void *pvDummy1[ 2 ];
+	size_t xDummy2[ 3 ];
+	void *pvDummy3;
+	uint8_t ucDummy4;
+} StaticMPMessageBuffer_t;
+
+/* See the comments above the struct xSTATIC_POOL definition.  The semaphores a
+reader/writer lock is built from are part of StaticRWLock_t. */
+typedef struct xSTATIC_RWLOCK
+{
+	UBaseType_t uxDummy1;
+	void *pvDummy2[ 3 ];
+	uint8_t ucDummy3;
+	StaticSemaphore_t xDummy4[ 2 ];
+} StaticRWLock_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -145,6 +145,12 @@ struct xLIST_ITEM
 	struct xLIST_ITEM * configLIST_VOLATILE pxPrevious;	/*< Pointer to the previous ListItem_t in the list. */
 	void * pvOwner;										/*< Pointer to the object (normally a TCB) that contains the list item.  There is therefore a two way link between the object containing the list item and the list item itself. */
 	struct xLIST * configLIST_VOLATILE pxContainer;		/*< Pointer to the list in which this list item is placed (if any). */
+	#if( configUSE_INDEXED_LISTS == 1 )
+		struct xLIST_ITEM * pxTreeParent;				/*< The tree members are only used while the item is in a list initialised by vListInitialiseIndexed(). */
+		struct xLIST_ITEM * pxTreeLeft;
+		struct xLIST_ITEM * pxTreeRight;
+		UBaseType_t uxTreeHeight;
+	#endif
 	listSECOND_LIST_ITEM_INTEGRITY_CHECK_VALUE			/*< Set to a known value if configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES is set to 1. */
 };
 typedef struct xLIST_ITEM ListItem_t;					/* For some reason lint wants this as two separate definitions. */
@@ -167,6 +173,10 @@ typedef struct xLIST
 	volatile UBaseType_t uxNumberOfItems;
 	ListItem_t * configLIST_VOLATILE pxIndex;			/*< Used to walk through the list.  Points to the last item returned by a call to listGET_OWNER_OF_NEXT_ENTRY (). */
 	MiniListItem_t xListEnd;							/*< List item that contains the maximum possible item value meaning it is always at the end of the list and is therefore used as a marker. */
+	#if( configUSE_INDEXED_LISTS == 1 )
+		ListItem_t * pxTreeRoot;						/*< Root of the AVL tree that holds the same items as the list, in the same order.  NULL if the list is empty. */
+		BaseType_t xIsIndexed;							/*< pdTRUE if the list was initialised by vListInitialiseIndexed(). */
+	#endif
 	listSECOND_LIST_INTEGRITY_CHECK_VALUE				/*< Set to a known value if configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES is set to 1. */
 } List_t;
 
@@ -344,6 +354,29 @@ List_t * const pxConstList = ( pxList );													\
  */
 void vListInitialise( List_t * const pxList ) PRIVILEGED_FUNCTION;
 
+/*
+ * As vListInitialise(), but vListInsert() finds the insertion point of the
+ * list through a balanced binary tree of its items instead of walking the
+ * list, so it takes O(log n) rather than O(n) time.  uxListRemove() also
+ * takes O(log n) time on such a list.  Everything that reads the list is
+ * unchanged - the items are still linked in item value order, so the head
+ * entry is found in constant time.
+ *
+ * Only vListInsert() can be used to add items to an indexed list.  The
+ * scheduler uses indexed lists for the delayed task lists and the timer
+ * service for the active timer lists when configUSE_INDEXED_LISTS is 1, where
+ * many blocked tasks or running timers would otherwise make each insertion
+ * walk a long list inside a critical section.
+ *
+ * @param pxList Pointer to the list being initialised.
+ *
+ * \page vListInitialiseIndexed vListInitialiseIndexed
+ * \ingroup LinkedList
+ */
+#if( configUSE_INDEXED_LISTS == 1 )
+	void vListInitialiseIndexed( List_t * const pxList ) PRIVILEGED_FUNCTION;
+#endif
+
 /*
  * Must be called before a list item is used.  This sets the list container to
  * null so the item does not think that it is already contained in a list.
@@ -0,0 +1,262 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Multi-producer message buffers.
+ *
+ * A multi-producer message buffer passes variable length records from any
+ * number of producers, tasks and interrupts on any core, to one reader.
+ * Unlike a message buffer (message_buffer.h) it needs no critical section or
+ * mutex around the producers: space is reserved with a compare-and-swap on the
+ * write position, and the producer then writes its record in place and commits
+ * it.  Records can be committed in any order, but are read in the order their
+ * space was reserved, and the reader only ever sees complete records.  A
+ * producer that is preempted between reserving and committing a record holds
+ * back the records reserved after it until it runs again.
+ *
+ * The reader can also work in place: xMPMessageBufferAcquire() returns the
+ * oldest record without copying it, and vMPMessageBufferRelease() gives its
+ * space back to the producers.  Calls made on the reader side must not run at
+ * the same time.
+ *
+ * Each record takes mpmessagebufferGRANULE_SIZE bytes for its header plus its
+ * length rounded up to mpmessagebufferGRANULE_SIZE, so the data of a record is
+ * always aligned to mpmessagebufferGRANULE_SIZE.  A record that does not fit
+ * before the end of the buffer starts at the beginning again, the space up to
+ * the end is skipped.  So that a record always fits into an empty buffer, a
+ * record including its header can take at most half of the buffer.
+ *
+ * Producers never block.  The reader can block, using its direct to task
+ * notification as stream buffers do.
+ */
+
+#ifndef MP_MESSAGE_BUFFER_H
+#define MP_MESSAGE_BUFFER_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include mp_message_buffer.h"
+#endif
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/* The unit in which space is reserved, see the comment at the top. */
+#define mpmessagebufferGRANULE_SIZE		( ( size_t ) 8 )
+
+/* The number of bytes xMPMessageBufferCreateStatic() needs for a buffer of
+xBufferSizeBytes bytes: the buffer itself, and a commit flag for every
+mpmessagebufferGRANULE_SIZE bytes of it. */
+#define mpmessagebufferSTORAGE_SIZE( xBufferSizeBytes ) ( ( xBufferSizeBytes ) + ( ( xBufferSizeBytes ) / mpmessagebufferGRANULE_SIZE ) )
+
+/**
+ * Type by which multi-producer message buffers are referenced.
+ */
+struct MPMessageBufferDefinition;
+typedef struct MPMessageBufferDefinition * MPMessageBufferHandle_t;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+MPMessageBufferHandle_t xMPMessageBufferCreateStatic( size_t xBufferSizeBytes,
+                                                      uint8_t *pucStorage,
+                                                      StaticMPMessageBuffer_t *pxStaticMPMessageBuffer );
+</pre>
+ *
+ * Creates a multi-producer message buffer using statically allocated memory.
+ *
+ * @param xBufferSizeBytes The size of the buffer, a power of two of at least
+ * 2 * mpmessagebufferGRANULE_SIZE.
+ *
+ * @param pucStorage Must point to at least
+ * mpmessagebufferSTORAGE_SIZE( xBufferSizeBytes ) bytes, aligned to
+ * mpmessagebufferGRANULE_SIZE.
+ *
+ * @param pxStaticMPMessageBuffer Must point to a variable of type
+ * StaticMPMessageBuffer_t, which will be used to hold the buffer's data
+ * structure.
+ *
+ * @return A handle to the buffer, or NULL if a parameter was invalid.
+ */
+MPMessageBufferHandle_t xMPMessageBufferCreateStatic( size_t xBufferSizeBytes, uint8_t *pucStorage, StaticMPMessageBuffer_t *pxStaticMPMessageBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+MPMessageBufferHandle_t xMPMessageBufferCreate( size_t xBufferSizeBytes );
+</pre>
+ *
+ * As xMPMessageBufferCreateStatic(), but the buffer's data structure and
+ * storage are obtained with pvPortMalloc().
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	MPMessageBufferHandle_t xMPMessageBufferCreate( size_t xBufferSizeBytes ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void vMPMessageBufferDelete( MPMessageBufferHandle_t xBuffer );
+</pre>
+ *
+ * Deletes a multi-producer message buffer.  No task may be blocked on it, and
+ * no producer may hold a reservation.
+ */
+void vMPMessageBufferDelete( MPMessageBufferHandle_t xBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void *pvMPMessageBufferReserve( MPMessageBufferHandle_t xBuffer,
+                               size_t xDataLength );
+</pre>
+ *
+ * Reserves space for a record of xDataLength bytes.  Never blocks, and can be
+ * called from tasks and interrupts.  The caller writes the record to the
+ * returned address and then passes the address to vMPMessageBufferCommit() or
+ * vMPMessageBufferCommitFromISR(), which must follow soon: the reader cannot
+ * get past a reserved record until it is committed.
+ *
+ * @return The address to write the record to, or NULL if there is not enough
+ * free space, or if xDataLength is 0 or too long (see the comment at the top).
+ */
+void *pvMPMessageBufferReserve( MPMessageBufferHandle_t xBuffer, size_t xDataLength ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void vMPMessageBufferCommit( MPMessageBufferHandle_t xBuffer,
+                             void *pvRecord );
+</pre>
+ *
+ * Makes a record obtained from pvMPMessageBufferReserve() visible to the
+ * reader, and unblocks the reader if it waits.  The record must not be touched
+ * afterwards.
+ */
+void vMPMessageBufferCommit( MPMessageBufferHandle_t xBuffer, void *pvRecord ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void vMPMessageBufferCommitFromISR( MPMessageBufferHandle_t xBuffer,
+                                    void *pvRecord,
+                                    BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of vMPMessageBufferCommit() that can be called from an interrupt.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if committing unblocked a task
+ * with a priority above that of the running task, in which case a context
+ * switch should be requested before the interrupt is exited.
+ */
+void vMPMessageBufferCommitFromISR( MPMessageBufferHandle_t xBuffer, void *pvRecord, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+size_t xMPMessageBufferSend( MPMessageBufferHandle_t xBuffer,
+                             const void *pvTxData,
+                             size_t xDataLengthBytes );
+size_t xMPMessageBufferSendFromISR( MPMessageBufferHandle_t xBuffer,
+                                    const void *pvTxData,
+                                    size_t xDataLengthBytes,
+                                    BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * Copies xDataLengthBytes bytes from pvTxData into a new record, that is
+ * reserves, fills and commits it.  Never blocks.
+ *
+ * @return xDataLengthBytes if the record was written, 0 if
+ * pvMPMessageBufferReserve() returned NULL.
+ */
+size_t xMPMessageBufferSend( MPMessageBufferHandle_t xBuffer, const void *pvTxData, size_t xDataLengthBytes ) PRIVILEGED_FUNCTION;
+size_t xMPMessageBufferSendFromISR( MPMessageBufferHandle_t xBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void *pvMPMessageBufferAcquire( MPMessageBufferHandle_t xBuffer,
+                                size_t *pxDataLength,
+                                TickType_t xTicksToWait );
+</pre>
+ *
+ * Returns the oldest record without copying it.  The record stays in the
+ * buffer, and the same record is returned again, until it is released with
+ * vMPMessageBufferRelease().
+ *
+ * @param pxDataLength Set to the length of the record.
+ *
+ * @param xTicksToWait The maximum time to wait for a committed record.
+ *
+ * @return The address of the record, or NULL if no record could be read
+ * within xTicksToWait ticks.
+ */
+void *pvMPMessageBufferAcquire( MPMessageBufferHandle_t xBuffer, size_t *pxDataLength, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+void vMPMessageBufferRelease( MPMessageBufferHandle_t xBuffer );
+</pre>
+ *
+ * Removes the record returned by pvMPMessageBufferAcquire() and makes its
+ * space available to the producers.
+ */
+void vMPMessageBufferRelease( MPMessageBufferHandle_t xBuffer ) PRIVILEGED_FUNCTION;
+
+/**
+ * mp_message_buffer.h
+ *
+<pre>
+size_t xMPMessageBufferReceive( MPMessageBufferHandle_t xBuffer,
+                                void *pvRxData,
+                                size_t xBufferLengthBytes,
+                                TickType_t xTicksToWait );
+</pre>
+ *
+ * Copies the oldest record to pvRxData and removes it.  As with a message
+ * buffer, a record longer than xBufferLengthBytes is left in the buffer.
+ *
+ * @return The length of the record, or 0 if no record could be read within
+ * xTicksToWait ticks or the record did not fit into pvRxData.
+ */
+size_t xMPMessageBufferReceive( MPMessageBufferHandle_t xBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( MP_MESSAGE_BUFFER_H ) */
@@ -0,0 +1,214 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+
+/*
+ * Pointer queues.
+ *
+ * A pointer queue passes pointers from any number of senders to one receiver.
+ * Only the pointer is stored, so the object it references changes owner
+ * without being copied: the sender must not touch the object once
+ * xPointerQueueSend() has returned pdPASS, and the receiver owns it from
+ * xPointerQueueReceive() on.  This makes the queue suitable for large
+ * payloads, for example network buffers taken from a pool (pool.h).
+ *
+ * The queue is a ring of slots that each carry a sequence number.  Senders
+ * reserve a slot with a compare-and-swap and publish the pointer by advancing
+ * the slot's sequence number, so sending takes neither a critical section nor
+ * a scheduler lock and can be done from tasks and interrupts on any core.  A
+ * sender that is preempted between reserving and publishing a slot holds back
+ * the pointers sent after it until it runs again, their order is kept.
+ *
+ * There is a single receiver: calls to xPointerQueueReceive() and
+ * pvPointerQueuePeek() must not run at the same time, which is the case when
+ * they are made by one task, or by several tasks that hold a common mutex.
+ *
+ * Tasks block in lists of waiting tasks held by the queue, as they do on a
+ * queue (queue.h): any number of senders can wait for room and the highest
+ * priority one is woken first, and task notifications are left to the
+ * application.  Sending and receiving only enter a critical section when a
+ * task on the other side is blocked, or about to block.
+ */
+
+#ifndef POINTER_QUEUE_H
+#define POINTER_QUEUE_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include pointer_queue.h"
+#endif
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/**
+ * Type by which pointer queues are referenced.
+ */
+struct PointerQueueDefinition;
+typedef struct PointerQueueDefinition * PointerQueueHandle_t;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+PointerQueueHandle_t xPointerQueueCreateStatic( UBaseType_t uxLength,
+                                                StaticPointerQueueSlot_t *pxSlotStorage,
+                                                StaticPointerQueue_t *pxStaticPointerQueue );
+</pre>
+ *
+ * Creates a pointer queue that holds up to uxLength pointers, using statically
+ * allocated memory.
+ *
+ * @param uxLength The number of pointers the queue can hold.
+ *
+ * @param pxSlotStorage Must point to an array of uxLength variables of type
+ * StaticPointerQueueSlot_t.
+ *
+ * @param pxStaticPointerQueue Must point to a variable of type
+ * StaticPointerQueue_t, which will be used to hold the queue's data structure.
+ *
+ * @return A handle to the queue, or NULL if a parameter was invalid.
+ */
+PointerQueueHandle_t xPointerQueueCreateStatic( UBaseType_t uxLength, StaticPointerQueueSlot_t *pxSlotStorage, StaticPointerQueue_t *pxStaticPointerQueue ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+PointerQueueHandle_t xPointerQueueCreate( UBaseType_t uxLength );
+</pre>
+ *
+ * As xPointerQueueCreateStatic(), but the queue's data structure and slots are
+ * obtained with pvPortMalloc().
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	PointerQueueHandle_t xPointerQueueCreate( UBaseType_t uxLength ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+void vPointerQueueDelete( PointerQueueHandle_t xQueue );
+</pre>
+ *
+ * Deletes a pointer queue.  No task may be blocked on the queue.  The objects
+ * referenced by pointers still in the queue are not touched.
+ */
+void vPointerQueueDelete( PointerQueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+BaseType_t xPointerQueueSend( PointerQueueHandle_t xQueue,
+                              void *pvItem,
+                              TickType_t xTicksToWait );
+</pre>
+ *
+ * Appends pvItem to the queue, and with it the ownership of the object it
+ * references.
+ *
+ * @param xTicksToWait The maximum time to wait for room in the queue.
+ *
+ * @return pdPASS if pvItem was sent, errQUEUE_FULL if the queue stayed full
+ * for xTicksToWait ticks.  The caller still owns the object in that case.
+ */
+BaseType_t xPointerQueueSend( PointerQueueHandle_t xQueue, void *pvItem, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+BaseType_t xPointerQueueSendFromISR( PointerQueueHandle_t xQueue,
+                                     void *pvItem,
+                                     BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xPointerQueueSend() that never blocks and can be called from an
+ * interrupt.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if sending unblocked a task
+ * with a priority above that of the running task, in which case a context
+ * switch should be requested before the interrupt is exited.
+ *
+ * @return pdPASS if pvItem was sent, errQUEUE_FULL otherwise.
+ */
+BaseType_t xPointerQueueSendFromISR( PointerQueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+BaseType_t xPointerQueueReceive( PointerQueueHandle_t xQueue,
+                                 void **ppvItem,
+                                 TickType_t xTicksToWait );
+</pre>
+ *
+ * Takes the oldest pointer from the queue, the caller owns the object it
+ * references from here on.
+ *
+ * @param ppvItem Set to the pointer taken from the queue.
+ *
+ * @param xTicksToWait The maximum time to wait for the queue to hold a
+ * pointer.
+ *
+ * @return pdPASS if a pointer was taken, errQUEUE_EMPTY if the queue stayed
+ * empty for xTicksToWait ticks.
+ */
+BaseType_t xPointerQueueReceive( PointerQueueHandle_t xQueue, void **ppvItem, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+void *pvPointerQueuePeek( PointerQueueHandle_t xQueue );
+</pre>
+ *
+ * Returns the oldest pointer in the queue without taking it, or NULL if the
+ * queue is empty.  Never blocks.  The object stays owned by the queue until
+ * the pointer is taken with xPointerQueueReceive().
+ */
+void *pvPointerQueuePeek( PointerQueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+/**
+ * pointer_queue.h
+ *
+<pre>
+UBaseType_t uxPointerQueueMessagesWaiting( PointerQueueHandle_t xQueue );
+</pre>
+ *
+ * @return The number of pointers in the queue, including those which senders
+ * are about to publish.
+ */
+UBaseType_t uxPointerQueueMessagesWaiting( PointerQueueHandle_t xQueue ) PRIVILEGED_FUNCTION;
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( POINTER_QUEUE_H ) */
@@ -0,0 +1,179 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * Fixed-block memory pools.
+ *
+ * A pool hands out blocks of one size from a fixed array.  Allocating and
+ * freeing a block takes constant time and uses neither a critical section nor
+ * a scheduler lock - the free blocks form a lock-free stack - so both can be
+ * called from tasks and from interrupts of any priority, and by any number of
+ * writers at once.
+ *
+ * A free block holds the index of the next free block in its first four
+ * bytes, the content of the rest of a block is not touched by the pool unless
+ * configUSE_POOL_POISONING is set to 1.  In that case freed blocks are filled
+ * with poolPOISON_BYTE and checked when they are handed out again, so writes
+ * through a stale pointer trigger configASSERT().
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include pool.h"
+#endif
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/**
+ * Type by which pools are referenced.
+ */
+struct PoolDefinition;
+typedef struct PoolDefinition * PoolHandle_t;
+
+/**
+ * pool.h
+ *
+<pre>
+PoolHandle_t xPoolCreateStatic( size_t xBlockSize,
+                                UBaseType_t uxBlockCount,
+                                uint8_t *pucPoolStorage,
+                                StaticPool_t *pxStaticPool );
+</pre>
+ *
+ * Creates a pool of uxBlockCount blocks of xBlockSize bytes each, using
+ * statically allocated memory.
+ *
+ * @param xBlockSize The size of each block.  Must be a multiple of four and
+ * at least four bytes.  Blocks are xBlockSize bytes apart, so pucPoolStorage
+ * can be an array of the objects the pool holds.
+ *
+ * @param uxBlockCount The number of blocks in the pool.
+ *
+ * @param pucPoolStorage Must point to at least xBlockSize * uxBlockCount bytes,
+ * aligned at least to four bytes.
+ *
+ * @param pxStaticPool Must point to a variable of type StaticPool_t, which will
+ * be used to hold the pool's data structure.
+ *
+ * @return A handle to the pool, or NULL if a parameter was invalid.
+ */
+PoolHandle_t xPoolCreateStatic( size_t xBlockSize, UBaseType_t uxBlockCount, uint8_t *pucPoolStorage, StaticPool_t *pxStaticPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount );
+</pre>
+ *
+ * As xPoolCreateStatic(), but the pool's data structure and storage are
+ * obtained with pvPortMalloc().
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * pool.h
+ *
+<pre>
+void vPoolDelete( PoolHandle_t xPool );
+</pre>
+ *
+ * Deletes a pool.  Memory obtained by xPoolCreate() is freed, the memory of a
+ * pool created by xPoolCreateStatic() is left to the application.
+ */
+void vPoolDelete( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+void *pvPoolAlloc( PoolHandle_t xPool );
+</pre>
+ *
+ * Takes a block from the pool.  Never blocks, can be called from an interrupt.
+ *
+ * @return The block, or NULL if all blocks are in use.
+ */
+void *pvPoolAlloc( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+void vPoolFree( PoolHandle_t xPool, void *pvBlock );
+</pre>
+ *
+ * Returns a block obtained from pvPoolAlloc() to the pool.  Can be called from
+ * an interrupt.
+ */
+void vPoolFree( PoolHandle_t xPool, void *pvBlock ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool );
+</pre>
+ *
+ * @return The number of blocks currently free.
+ */
+UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+UBaseType_t uxPoolGetHighWaterMark( PoolHandle_t xPool );
+</pre>
+ *
+ * @return The largest number of blocks that have been in use at the same time
+ * since the pool was created.
+ */
+UBaseType_t uxPoolGetHighWaterMark( PoolHandle_t xPool ) PRIVILEGED_FUNCTION;
+
+/**
+ * pool.h
+ *
+<pre>
+BaseType_t xPoolContains( PoolHandle_t xPool, const void *pvBlock );
+</pre>
+ *
+ * @return pdTRUE if pvBlock is the start of one of the pool's blocks.
+ */
+BaseType_t xPoolContains( PoolHandle_t xPool, const void *pvBlock ) PRIVILEGED_FUNCTION;
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( POOL_H ) */
@@ -157,6 +157,12 @@ void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions ) PRIVILEG
  */
 void vPortGetHeapStats( HeapStats_t *pxHeapStats );
 
+/*
+ * Returns the percentage of the free heap space that is not part of the
+ * largest free block.  Only implemented by heap_6.c.
+ */
+size_t xPortGetHeapFragmentation( void ) PRIVILEGED_FUNCTION;
+
 /*
  * Map to the memory management routines required for the port.
  */
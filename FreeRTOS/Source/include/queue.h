@@ -867,6 +867,81 @@ BaseType_t xQueuePeekFromISR( QueueHandle_t xQueue, void * const pvBuffer ) PRIV
  */
 BaseType_t xQueueReceive( QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
 
+/**
+ * queue. h
+ * <pre>
+ BaseType_t xQueueSendMultiple(
+								 QueueHandle_t xQueue,
+								 const void *pvItemsToQueue,
+								 UBaseType_t uxItemCount,
+								 TickType_t xTicksToWait
+							);</pre>
+ *
+ * Posts uxItemCount items to the back of a queue.  The items are copied from
+ * the array pvItemsToQueue.  As many items as fit are copied under one
+ * critical section, and the tasks that were waiting for the items are
+ * unblocked at once, so sending a burst costs less than calling
+ * xQueueSendToBack() for each item.  If the queue fills up, the calling task
+ * blocks until there is room for the rest or xTicksToWait expires.
+ *
+ * The queue must not be a semaphore or a mutex.  This function must not be
+ * called from an interrupt service routine.
+ *
+ * @param xQueue The handle to the queue on which the items are to be posted.
+ *
+ * @param pvItemsToQueue An array of uxItemCount items of the size defined when
+ * the queue was created.
+ *
+ * @param uxItemCount The number of items to post.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for space to become available on the queue.
+ *
+ * @return The number of items posted, from the start of the array.  Less than
+ * uxItemCount if the queue stayed full for xTicksToWait ticks.
+ *
+ * \defgroup xQueueSendMultiple xQueueSendMultiple
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItemsToQueue, UBaseType_t uxItemCount, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * queue. h
+ * <pre>
+ BaseType_t xQueueReceiveMultiple(
+								 QueueHandle_t xQueue,
+								 void *pvBuffer,
+								 UBaseType_t uxMaxItems,
+								 TickType_t xTicksToWait
+							);</pre>
+ *
+ * Receives up to uxMaxItems items from a queue under one critical section.
+ * The calling task blocks, as with xQueueReceive(), until the queue holds at
+ * least one item or xTicksToWait expires, and then takes all items that are
+ * in the queue, up to uxMaxItems, without waiting for more.  The tasks that
+ * were waiting for the space freed are unblocked at once.
+ *
+ * This function must not be used in an interrupt service routine.
+ *
+ * @param xQueue The handle to the queue from which the items are to be
+ * received.
+ *
+ * @param pvBuffer An array of uxMaxItems items of the size defined when the
+ * queue was created, into which the items are copied in queue order.
+ *
+ * @param uxMaxItems The maximum number of items to receive.
+ *
+ * @param xTicksToWait The maximum amount of time the task should block waiting
+ * for an item to receive should the queue be empty at the time of the call.
+ *
+ * @return The number of items received, 0 if the queue stayed empty for
+ * xTicksToWait ticks.
+ *
+ * \defgroup xQueueReceiveMultiple xQueueReceiveMultiple
+ * \ingroup QueueManagement
+ */
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, UBaseType_t uxMaxItems, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
 /**
  * queue. h
  * <pre>UBaseType_t uxQueueMessagesWaiting( const QueueHandle_t xQueue );</pre>
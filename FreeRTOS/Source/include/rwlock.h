@@ -0,0 +1,221 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+
+/*
+ * Reader/writer locks.
+ *
+ * A reader/writer lock can be held by any number of readers at the same time,
+ * or by one writer.  It suits data that is read far more often than it is
+ * changed, such as configuration tables, where a mutex would make the readers
+ * wait for each other.
+ *
+ * Writers have preference: once a writer waits for the lock no new reader is
+ * let in, so a steady stream of readers cannot keep a writer out.  The writer
+ * waits for the readers that hold the lock already to give it back.
+ *
+ * Writers serialise on a mutex (semphr.h), which is held for as long as a
+ * writer holds or waits for the lock.  Readers that find the lock taken by a
+ * writer wait on the same mutex, so the writer inherits the priority of the
+ * readers and writers it keeps waiting, as the holder of a mutex does.  The
+ * readers that hold the lock while a writer waits for them do not inherit its
+ * priority, the time the writer waits is bounded by the longest time a reader
+ * holds the lock.
+ *
+ * A lock the readers take without a writer around costs one compare-and-swap
+ * and no critical section, from tasks and interrupts on any core.  Interrupts
+ * can only try to take the lock for reading, they cannot wait for it.
+ *
+ * The lock is not recursive: a task that holds the lock must not take it
+ * again, in either mode, and a reader cannot upgrade to a writer.
+ */
+
+#ifndef RWLOCK_H
+#define RWLOCK_H
+
+#ifndef INC_FREERTOS_H
+	#error "include FreeRTOS.h must appear in source files before include rwlock.h"
+#endif
+
+#if defined( __cplusplus )
+extern "C" {
+#endif
+
+/**
+ * Type by which reader/writer locks are referenced.
+ */
+struct RWLockDefinition;
+typedef struct RWLockDefinition * RWLockHandle_t;
+
+/**
+ * rwlock.h
+ *
+<pre>
+RWLockHandle_t xRWLockCreateStatic( StaticRWLock_t *pxStaticRWLock );
+</pre>
+ *
+ * Creates a reader/writer lock using statically allocated memory.
+ *
+ * @param pxStaticRWLock Must point to a variable of type StaticRWLock_t, which
+ * will be used to hold the lock's data structure and its semaphores.
+ *
+ * @return A handle to the lock, or NULL if pxStaticRWLock was NULL.
+ */
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+	RWLockHandle_t xRWLockCreateStatic( StaticRWLock_t *pxStaticRWLock ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * rwlock.h
+ *
+<pre>
+RWLockHandle_t xRWLockCreate( void );
+</pre>
+ *
+ * As xRWLockCreateStatic(), but the lock's data structure and semaphores are
+ * obtained with pvPortMalloc().
+ *
+ * @return A handle to the lock, or NULL if there was not enough heap.
+ */
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	RWLockHandle_t xRWLockCreate( void ) PRIVILEGED_FUNCTION;
+#endif
+
+/**
+ * rwlock.h
+ *
+<pre>
+void vRWLockDelete( RWLockHandle_t xRWLock );
+</pre>
+ *
+ * Deletes a reader/writer lock.  The lock must not be held, and no task may be
+ * waiting for it.
+ */
+void vRWLockDelete( RWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockTakeRead( RWLockHandle_t xRWLock, TickType_t xTicksToWait );
+</pre>
+ *
+ * Takes the lock for reading.  Other readers may hold it at the same time.
+ *
+ * @param xTicksToWait The maximum time to wait while a writer holds the lock or
+ * waits for it.
+ *
+ * @return pdPASS if the lock was taken, pdFAIL if xTicksToWait expired first.
+ */
+BaseType_t xRWLockTakeRead( RWLockHandle_t xRWLock, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockTakeReadFromISR( RWLockHandle_t xRWLock );
+</pre>
+ *
+ * A version of xRWLockTakeRead() that can be called from an interrupt service
+ * routine.  It never waits.
+ *
+ * @return pdPASS if the lock was taken, pdFAIL if a writer holds the lock or
+ * waits for it.
+ */
+BaseType_t xRWLockTakeReadFromISR( RWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockGiveRead( RWLockHandle_t xRWLock );
+</pre>
+ *
+ * Gives back a lock taken with xRWLockTakeRead() or xRWLockTakeReadFromISR().
+ * The last reader out lets a waiting writer in.
+ *
+ * @return pdPASS, or pdFAIL if no reader held the lock.
+ */
+BaseType_t xRWLockGiveRead( RWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockGiveReadFromISR( RWLockHandle_t xRWLock,
+                                   BaseType_t *pxHigherPriorityTaskWoken );
+</pre>
+ *
+ * A version of xRWLockGiveRead() that can be called from an interrupt service
+ * routine.
+ *
+ * @param pxHigherPriorityTaskWoken Set to pdTRUE if giving the lock unblocked
+ * a writer with a priority above that of the interrupted task, in which case a
+ * context switch should be requested before the interrupt is exited.
+ *
+ * @return pdPASS, or pdFAIL if no reader held the lock.
+ */
+BaseType_t xRWLockGiveReadFromISR( RWLockHandle_t xRWLock, BaseType_t *pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockTakeWrite( RWLockHandle_t xRWLock, TickType_t xTicksToWait );
+</pre>
+ *
+ * Takes the lock for writing.  New readers are kept out from the call on, and
+ * the calling task then waits for the readers that hold the lock to give it
+ * back.  Must not be called from an interrupt service routine.
+ *
+ * @param xTicksToWait The maximum time to wait for other writers and for the
+ * readers, together.
+ *
+ * @return pdPASS if the lock was taken, pdFAIL if xTicksToWait expired first.
+ */
+BaseType_t xRWLockTakeWrite( RWLockHandle_t xRWLock, TickType_t xTicksToWait ) PRIVILEGED_FUNCTION;
+
+/**
+ * rwlock.h
+ *
+<pre>
+BaseType_t xRWLockGiveWrite( RWLockHandle_t xRWLock );
+</pre>
+ *
+ * Gives back a lock taken with xRWLockTakeWrite().  Must be called by the task
+ * that took it.
+ *
+ * @return pdPASS, or pdFAIL if the calling task did not hold the lock for
+ * writing.
+ */
+BaseType_t xRWLockGiveWrite( RWLockHandle_t xRWLock ) PRIVILEGED_FUNCTION;
+
+#if defined( __cplusplus )
+}
+#endif
+
+#endif /* !defined( RWLOCK_H ) */
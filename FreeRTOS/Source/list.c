@@ -30,6 +30,37 @@
 #include "FreeRTOS.h"
 #include "list.h"
 
+#if( configUSE_INDEXED_LISTS == 1 )
+
+	/* The height of an empty subtree is 0, that of a leaf 1. */
+	#define listTREE_HEIGHT( pxItem )	( ( ( pxItem ) == NULL ) ? ( UBaseType_t ) 0U : ( pxItem )->uxTreeHeight )
+
+	/*
+	 * The items of an indexed list are also nodes of an AVL tree, kept in the
+	 * same order as the list - an in-order walk of the tree visits the items
+	 * in the order they are linked.  Items with equal values are ordered by
+	 * the time they were inserted, as in a list without an index.
+	 */
+	static void prvTreeReplaceChild( List_t * const pxList, ListItem_t * const pxParent, const ListItem_t * const pxOldChild, ListItem_t * const pxNewChild ) PRIVILEGED_FUNCTION;
+	static ListItem_t * prvTreeRotateLeft( List_t * const pxList, ListItem_t * const pxItem ) PRIVILEGED_FUNCTION;
+	static ListItem_t * prvTreeRotateRight( List_t * const pxList, ListItem_t * const pxItem ) PRIVILEGED_FUNCTION;
+	static void prvTreeRebalance( List_t * const pxList, ListItem_t *pxItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Adds pxNewListItem to the tree and returns the item it must be linked
+	 * after in the list - the last item with a value not greater than its
+	 * own, or the end marker if there is none.
+	 */
+	static ListItem_t * prvTreeInsert( List_t * const pxList, ListItem_t * const pxNewListItem ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Removes pxItemToRemove from the tree.  Must be called while the item is
+	 * still linked in the list.
+	 */
+	static void prvTreeRemove( List_t * const pxList, ListItem_t * const pxItemToRemove ) PRIVILEGED_FUNCTION;
+
+#endif /* configUSE_INDEXED_LISTS */
+
 /*-----------------------------------------------------------
  * PUBLIC LIST API documented in list.h
  *----------------------------------------------------------*/
@@ -52,6 +83,13 @@ void vListInitialise( List_t * const pxList )
 
 	pxList->uxNumberOfItems = ( UBaseType_t ) 0U;
 
+	#if( configUSE_INDEXED_LISTS == 1 )
+	{
+		pxList->pxTreeRoot = NULL;
+		pxList->xIsIndexed = pdFALSE;
+	}
+	#endif /* configUSE_INDEXED_LISTS */
+
 	/* Write known values into the list if
 	configUSE_LIST_DATA_INTEGRITY_CHECK_BYTES is set to 1. */
 	listSET_LIST_INTEGRITY_CHECK_1_VALUE( pxList );
@@ -59,6 +97,17 @@ void vListInitialise( List_t * const pxList )
 }
 /*-----------------------------------------------------------*/
 
+#if( configUSE_INDEXED_LISTS == 1 )
+
+	void vListInitialiseIndexed( List_t * const pxList )
+	{
+		vListInitialise( pxList );
+		pxList->xIsIndexed = pdTRUE;
+	}
+
+#endif /* configUSE_INDEXED_LISTS */
+/*-----------------------------------------------------------*/
+
 void vListInitialiseItem( ListItem_t * const pxItem )
 {
 	/* Make sure the list item is not recorded as being on a list. */
@@ -81,6 +130,13 @@ ListItem_t * const pxIndex = pxList->pxIndex;
 	listTEST_LIST_INTEGRITY( pxList );
 	listTEST_LIST_ITEM_INTEGRITY( pxNewListItem );
 
+	#if( configUSE_INDEXED_LISTS == 1 )
+	{
+		/* The items of an indexed list must stay in item value order. */
+		configASSERT( pxList->xIsIndexed == pdFALSE );
+	}
+	#endif /* configUSE_INDEXED_LISTS */
+
 	/* Insert a new list item into pxList, but rather than sort the list,
 	makes the new list item the last item to be removed by a call to
 	listGET_OWNER_OF_NEXT_ENTRY(). */
@@ -118,7 +174,16 @@ const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
 	stored in ready lists (all of which have the same xItemValue value) get a
 	share of the CPU.  However, if the xItemValue is the same as the back marker
 	the iteration loop below will not end.  Therefore the value is checked
-	first, and the algorithm slightly modified if necessary. */
+	first, and the algorithm slightly modified if necessary.
+
+	An indexed list finds the same position through its tree. */
+	#if( configUSE_INDEXED_LISTS == 1 )
+	if( pxList->xIsIndexed != pdFALSE )
+	{
+		pxIterator = prvTreeInsert( pxList, pxNewListItem );
+	}
+	else
+	#endif /* configUSE_INDEXED_LISTS */
 	if( xValueOfInsertion == portMAX_DELAY )
 	{
 		pxIterator = pxList->xListEnd.pxPrevious;
@@ -173,6 +238,19 @@ UBaseType_t uxListRemove( ListItem_t * const pxItemToRemove )
 item. */
 List_t * const pxList = pxItemToRemove->pxContainer;
 
+	#if( configUSE_INDEXED_LISTS == 1 )
+	{
+		if( pxList->xIsIndexed != pdFALSE )
+		{
+			prvTreeRemove( pxList, pxItemToRemove );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif /* configUSE_INDEXED_LISTS */
+
 	pxItemToRemove->pxNext->pxPrevious = pxItemToRemove->pxPrevious;
 	pxItemToRemove->pxPrevious->pxNext = pxItemToRemove->pxNext;
 
@@ -196,3 +274,208 @@ List_t * const pxList = pxItemToRemove->pxContainer;
 }
 /*-----------------------------------------------------------*/
 
+
+#if( configUSE_INDEXED_LISTS == 1 )
+
+	static void prvTreeReplaceChild( List_t * const pxList, ListItem_t * const pxParent, const ListItem_t * const pxOldChild, ListItem_t * const pxNewChild )
+	{
+		if( pxParent == NULL )
+		{
+			pxList->pxTreeRoot = pxNewChild;
+		}
+		else if( pxParent->pxTreeLeft == pxOldChild )
+		{
+			pxParent->pxTreeLeft = pxNewChild;
+		}
+		else
+		{
+			pxParent->pxTreeRight = pxNewChild;
+		}
+
+		if( pxNewChild != NULL )
+		{
+			pxNewChild->pxTreeParent = pxParent;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static ListItem_t * prvTreeRotateLeft( List_t * const pxList, ListItem_t * const pxItem )
+	{
+	ListItem_t * const pxPivot = pxItem->pxTreeRight;
+	UBaseType_t uxLeft, uxRight;
+
+		pxItem->pxTreeRight = pxPivot->pxTreeLeft;
+		if( pxPivot->pxTreeLeft != NULL )
+		{
+			pxPivot->pxTreeLeft->pxTreeParent = pxItem;
+		}
+
+		prvTreeReplaceChild( pxList, pxItem->pxTreeParent, pxItem, pxPivot );
+		pxPivot->pxTreeLeft = pxItem;
+		pxItem->pxTreeParent = pxPivot;
+
+		uxLeft = listTREE_HEIGHT( pxItem->pxTreeLeft );
+		uxRight = listTREE_HEIGHT( pxItem->pxTreeRight );
+		pxItem->uxTreeHeight = ( ( uxLeft > uxRight ) ? uxLeft : uxRight ) + 1U;
+
+		uxLeft = pxItem->uxTreeHeight;
+		uxRight = listTREE_HEIGHT( pxPivot->pxTreeRight );
+		pxPivot->uxTreeHeight = ( ( uxLeft > uxRight ) ? uxLeft : uxRight ) + 1U;
+
+		return pxPivot;
+	}
+	/*-----------------------------------------------------------*/
+
+	static ListItem_t * prvTreeRotateRight( List_t * const pxList, ListItem_t * const pxItem )
+	{
+	ListItem_t * const pxPivot = pxItem->pxTreeLeft;
+	UBaseType_t uxLeft, uxRight;
+
+		pxItem->pxTreeLeft = pxPivot->pxTreeRight;
+		if( pxPivot->pxTreeRight != NULL )
+		{
+			pxPivot->pxTreeRight->pxTreeParent = pxItem;
+		}
+
+		prvTreeReplaceChild( pxList, pxItem->pxTreeParent, pxItem, pxPivot );
+		pxPivot->pxTreeRight = pxItem;
+		pxItem->pxTreeParent = pxPivot;
+
+		uxLeft = listTREE_HEIGHT( pxItem->pxTreeLeft );
+		uxRight = listTREE_HEIGHT( pxItem->pxTreeRight );
+		pxItem->uxTreeHeight = ( ( uxLeft > uxRight ) ? uxLeft : uxRight ) + 1U;
+
+		uxLeft = listTREE_HEIGHT( pxPivot->pxTreeLeft );
+		uxRight = pxItem->uxTreeHeight;
+		pxPivot->uxTreeHeight = ( ( uxLeft > uxRight ) ? uxLeft : uxRight ) + 1U;
+
+		return pxPivot;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTreeRebalance( List_t * const pxList, ListItem_t *pxItem )
+	{
+	UBaseType_t uxLeft, uxRight;
+
+		/* Walk from the item that changed up to the root, restoring the
+		heights and rotating where the subtrees differ by more than one.  The
+		height of the tree is below 1.45 log2( n + 2 ), so this is bounded. */
+		while( pxItem != NULL )
+		{
+			uxLeft = listTREE_HEIGHT( pxItem->pxTreeLeft );
+			uxRight = listTREE_HEIGHT( pxItem->pxTreeRight );
+
+			if( uxLeft > ( uxRight + 1U ) )
+			{
+				if( listTREE_HEIGHT( pxItem->pxTreeLeft->pxTreeLeft ) < listTREE_HEIGHT( pxItem->pxTreeLeft->pxTreeRight ) )
+				{
+					( void ) prvTreeRotateLeft( pxList, pxItem->pxTreeLeft );
+				}
+				pxItem = prvTreeRotateRight( pxList, pxItem );
+			}
+			else if( uxRight > ( uxLeft + 1U ) )
+			{
+				if( listTREE_HEIGHT( pxItem->pxTreeRight->pxTreeRight ) < listTREE_HEIGHT( pxItem->pxTreeRight->pxTreeLeft ) )
+				{
+					( void ) prvTreeRotateRight( pxList, pxItem->pxTreeRight );
+				}
+				pxItem = prvTreeRotateLeft( pxList, pxItem );
+			}
+			else
+			{
+				pxItem->uxTreeHeight = ( ( uxLeft > uxRight ) ? uxLeft : uxRight ) + 1U;
+			}
+
+			pxItem = pxItem->pxTreeParent;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	static ListItem_t * prvTreeInsert( List_t * const pxList, ListItem_t * const pxNewListItem )
+	{
+	const TickType_t xValueOfInsertion = pxNewListItem->xItemValue;
+	ListItem_t *pxPrevious = ( ListItem_t * ) &( pxList->xListEnd );	/*lint !e826 !e740 !e9087 The mini list structure is used as the list end to save RAM.  This is checked and valid. */
+	ListItem_t *pxParent = NULL;
+	ListItem_t *pxItem = pxList->pxTreeRoot;
+
+		/* Items with the same value go to the right, so the new item is
+		placed after them. */
+		while( pxItem != NULL )
+		{
+			pxParent = pxItem;
+
+			if( xValueOfInsertion < pxItem->xItemValue )
+			{
+				pxItem = pxItem->pxTreeLeft;
+			}
+			else
+			{
+				pxPrevious = pxItem;
+				pxItem = pxItem->pxTreeRight;
+			}
+		}
+
+		pxNewListItem->pxTreeLeft = NULL;
+		pxNewListItem->pxTreeRight = NULL;
+		pxNewListItem->uxTreeHeight = 1U;
+		pxNewListItem->pxTreeParent = pxParent;
+
+		if( pxParent == NULL )
+		{
+			pxList->pxTreeRoot = pxNewListItem;
+		}
+		else if( pxPrevious == pxParent )
+		{
+			pxParent->pxTreeRight = pxNewListItem;
+		}
+		else
+		{
+			pxParent->pxTreeLeft = pxNewListItem;
+		}
+
+		prvTreeRebalance( pxList, pxParent );
+
+		return pxPrevious;
+	}
+	/*-----------------------------------------------------------*/
+
+	static void prvTreeRemove( List_t * const pxList, ListItem_t * const pxItemToRemove )
+	{
+	ListItem_t *pxSuccessor, *pxChanged;
+
+		if( ( pxItemToRemove->pxTreeLeft == NULL ) || ( pxItemToRemove->pxTreeRight == NULL ) )
+		{
+			/* At most one child, which takes the place of the item. */
+			pxChanged = pxItemToRemove->pxTreeParent;
+			prvTreeReplaceChild( pxList, pxChanged, pxItemToRemove, ( pxItemToRemove->pxTreeLeft != NULL ) ? pxItemToRemove->pxTreeLeft : pxItemToRemove->pxTreeRight );
+		}
+		else
+		{
+			/* Two children.  The next item in the list is the leftmost item of
+			the right subtree - it has no left child and takes the place of the
+			removed item. */
+			pxSuccessor = pxItemToRemove->pxNext;
+
+			if( pxSuccessor->pxTreeParent == pxItemToRemove )
+			{
+				pxChanged = pxSuccessor;
+			}
+			else
+			{
+				pxChanged = pxSuccessor->pxTreeParent;
+				prvTreeReplaceChild( pxList, pxChanged, pxSuccessor, pxSuccessor->pxTreeRight );
+				pxSuccessor->pxTreeRight = pxItemToRemove->pxTreeRight;
+				pxSuccessor->pxTreeRight->pxTreeParent = pxSuccessor;
+			}
+
+			pxSuccessor->pxTreeLeft = pxItemToRemove->pxTreeLeft;
+			pxSuccessor->pxTreeLeft->pxTreeParent = pxSuccessor;
+			pxSuccessor->uxTreeHeight = pxItemToRemove->uxTreeHeight;
+			prvTreeReplaceChild( pxList, pxItemToRemove->pxTreeParent, pxItemToRemove, pxSuccessor );
+		}
+
+		prvTreeRebalance( pxList, pxChanged );
+	}
+
+#endif /* configUSE_INDEXED_LISTS */
+/*-----------------------------------------------------------*/
@@ -0,0 +1,549 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "mp_message_buffer.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_TASK_NOTIFICATIONS != 1 )
+	#error configUSE_TASK_NOTIFICATIONS must be set to 1 to build mp_message_buffer.c
+#endif
+
+/* Bits that can be set in xMP_MESSAGE_BUFFER->ucFlags. */
+#define mpmessagebufferFLAGS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 1 )
+
+/* Values of the commit flag of the granule a record header is in.  The flags
+of all other granules stay 0. */
+#define mpmessagebufferRECORD_COMMITTED		( ( uint8_t ) 1 )
+#define mpmessagebufferRECORD_PADDING		( ( uint8_t ) 2 )	/* The rest of the buffer is skipped. */
+
+/* The header of a record, which holds the length of the record's data, takes
+one granule. */
+#define mpmessagebufferHEADER_SIZE			mpmessagebufferGRANULE_SIZE
+
+/*
+ * The buffer is written at xHead and read at xTail.  Both count bytes from the
+ * creation of the buffer on and are only taken modulo xLength to access it,
+ * which is a power of two so that they can wrap around.
+ *
+ * Whether a record is committed is not kept in its header but in a separate
+ * array with one flag for each granule of the buffer.  Headers move from lap
+ * to lap, so a header read before the record is committed could hold data of
+ * the previous lap.  A flag is only set by the commit of the record whose
+ * header is in its granule, and cleared by the reader when it removes the
+ * record.
+ */
+/*lint -save -e9058 Style convention uses tag. */
+typedef struct MPMessageBufferDefinition
+{
+	uint8_t *pucBuffer;
+	uint8_t *pucCommitted;							/* One flag for each granule of pucBuffer. */
+	size_t xLength;
+	volatile size_t xHead;							/* Reserved by producers. */
+	volatile size_t xTail;							/* Released by the reader. */
+	volatile TaskHandle_t xTaskWaitingToReceive;	/* The reader if it waits for a record, else NULL. */
+	uint8_t ucFlags;
+} MPMessageBuffer_t;
+/*lint -restore */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called by both create functions to initialise the structure and the commit
+ * flags.
+ */
+static void prvInitialiseNewMPMessageBuffer( MPMessageBuffer_t * const pxBuffer, size_t xBufferSizeBytes, uint8_t * const pucStorage, uint8_t ucFlags ) PRIVILEGED_FUNCTION;
+
+/*
+ * The number of bytes a record of xDataLength bytes takes in the buffer,
+ * including its header.
+ */
+static size_t prvRecordLength( size_t xDataLength ) PRIVILEGED_FUNCTION;
+
+/*
+ * Sets the commit flag of the record pvRecord.
+ */
+static void prvCommit( MPMessageBuffer_t * const pxBuffer, void * const pvRecord ) PRIVILEGED_FUNCTION;
+
+/*
+ * Returns the oldest committed record and its length, skipping padding, or
+ * NULL if the oldest record is not committed yet or the buffer is empty.
+ */
+static void *prvNextRecord( MPMessageBuffer_t * const pxBuffer, size_t * const pxDataLength ) PRIVILEGED_FUNCTION;
+
+/*
+ * Notifies the reader if it waits for a record.  Called from an interrupt if
+ * pxHigherPriorityTaskWoken is not NULL.
+ */
+static void prvWakeReader( MPMessageBuffer_t * const pxBuffer, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	MPMessageBufferHandle_t xMPMessageBufferCreate( size_t xBufferSizeBytes )
+	{
+	uint8_t *pucAllocatedMemory;
+	size_t xStructSize;
+
+		/* The storage follows the structure, keep it aligned. */
+		xStructSize = ( sizeof( MPMessageBuffer_t ) + ( mpmessagebufferGRANULE_SIZE - 1 ) ) & ~( mpmessagebufferGRANULE_SIZE - 1 );
+
+		configASSERT( ( xBufferSizeBytes >= ( 2 * mpmessagebufferGRANULE_SIZE ) ) && ( ( xBufferSizeBytes & ( xBufferSizeBytes - 1 ) ) == 0 ) );
+
+		if( ( xBufferSizeBytes < ( 2 * mpmessagebufferGRANULE_SIZE ) ) ||
+			( ( xBufferSizeBytes & ( xBufferSizeBytes - 1 ) ) != 0 ) ||
+			( xBufferSizeBytes > ( ( ( ~( size_t ) 0 ) - xStructSize ) / 2 ) ) )
+		{
+			return NULL;
+		}
+
+		pucAllocatedMemory = ( uint8_t * ) pvPortMalloc( xStructSize + mpmessagebufferSTORAGE_SIZE( xBufferSizeBytes ) ); /*lint !e9079 malloc() only returns void*. */
+
+		if( pucAllocatedMemory != NULL )
+		{
+			prvInitialiseNewMPMessageBuffer( ( MPMessageBuffer_t * ) pucAllocatedMemory, /* Structure at the start of the allocated memory. */ /*lint !e9087 Safe cast as allocated memory is aligned. */ /*lint !e826 Area is not too small and alignment is guaranteed provided malloc() behaves as expected and returns aligned buffer. */
+											 xBufferSizeBytes,
+											 pucAllocatedMemory + xStructSize, /* Storage follows. */
+											 0 );
+		}
+
+		return ( MPMessageBufferHandle_t ) pucAllocatedMemory; /*lint !e9087 !e826 Safe cast as allocated memory is aligned. */
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+MPMessageBufferHandle_t xMPMessageBufferCreateStatic( size_t xBufferSizeBytes, uint8_t *pucStorage, StaticMPMessageBuffer_t *pxStaticMPMessageBuffer )
+{
+MPMessageBuffer_t * const pxBuffer = ( MPMessageBuffer_t * ) pxStaticMPMessageBuffer; /*lint !e740 !e9087 MPMessageBuffer_t and StaticMPMessageBuffer_t are guaranteed to have the same size and alignment requirement - checked by configASSERT(). */
+MPMessageBufferHandle_t xReturn;
+
+	configASSERT( pucStorage );
+	configASSERT( pxStaticMPMessageBuffer );
+	configASSERT( ( xBufferSizeBytes >= ( 2 * mpmessagebufferGRANULE_SIZE ) ) && ( ( xBufferSizeBytes & ( xBufferSizeBytes - 1 ) ) == 0 ) );
+	configASSERT( ( ( ( portPOINTER_SIZE_TYPE ) pucStorage ) % mpmessagebufferGRANULE_SIZE ) == 0 );
+
+	#if( configASSERT_DEFINED == 1 )
+	{
+		/* Sanity check that the size of the structure used to declare a
+		variable of type StaticMPMessageBuffer_t equals the size of the real
+		structure. */
+		volatile size_t xSize = sizeof( StaticMPMessageBuffer_t );
+		configASSERT( xSize == sizeof( MPMessageBuffer_t ) );
+	} /*lint !e529 xSize is referenced is configASSERT() is defined. */
+	#endif /* configASSERT_DEFINED */
+
+	if( ( pucStorage != NULL ) && ( pxStaticMPMessageBuffer != NULL ) &&
+		( xBufferSizeBytes >= ( 2 * mpmessagebufferGRANULE_SIZE ) ) && ( ( xBufferSizeBytes & ( xBufferSizeBytes - 1 ) ) == 0 ) )
+	{
+		prvInitialiseNewMPMessageBuffer( pxBuffer, xBufferSizeBytes, pucStorage, mpmessagebufferFLAGS_IS_STATICALLY_ALLOCATED );
+		xReturn = ( MPMessageBufferHandle_t ) pxStaticMPMessageBuffer; /*lint !e9087 Data hiding requires cast to opaque type. */
+	}
+	else
+	{
+		xReturn = NULL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vMPMessageBufferDelete( MPMessageBufferHandle_t xBuffer )
+{
+MPMessageBuffer_t * pxBuffer = xBuffer;
+
+	configASSERT( pxBuffer );
+	configASSERT( pxBuffer->xTaskWaitingToReceive == NULL );
+
+	if( ( pxBuffer->ucFlags & mpmessagebufferFLAGS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) pdFALSE )
+	{
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			/* Both the structure and the storage were allocated using a single
+			call to pvPortMalloc(), hence only one call to vPortFree() is
+			required. */
+			vPortFree( ( void * ) pxBuffer ); /*lint !e9087 Standard free() semantics require void *, plus pxBuffer was allocated by pvPortMalloc(). */
+		}
+		#else
+		{
+			/* Should not be possible to get here, ucFlags must be corrupt.
+			Force an assert. */
+			configASSERT( xBuffer == ( MPMessageBufferHandle_t ) ~0 );
+		}
+		#endif
+	}
+	else
+	{
+		/* The structure and the storage were statically allocated, so just
+		clear the structure. */
+		( void ) memset( pxBuffer, 0x00, sizeof( MPMessageBuffer_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvMPMessageBufferReserve( MPMessageBufferHandle_t xBuffer, size_t xDataLength )
+{
+MPMessageBuffer_t * const pxBuffer = xBuffer;
+size_t xHead, xUsed, xOffset, xContiguous, xRecordLength, xNeeded;
+
+	configASSERT( pxBuffer );
+
+	/* A longer record would not always fit into the empty buffer, see
+	mp_message_buffer.h, and the producer could retry for ever. */
+	if( ( xDataLength == 0 ) || ( xDataLength > ( pxBuffer->xLength / 2 ) ) )
+	{
+		return NULL;
+	}
+
+	xRecordLength = prvRecordLength( xDataLength );
+
+	if( xRecordLength > ( pxBuffer->xLength / 2 ) )
+	{
+		return NULL;
+	}
+	xHead = __atomic_load_n( &( pxBuffer->xHead ), __ATOMIC_RELAXED );
+
+	for( ;; )
+	{
+		xOffset = xHead & ( pxBuffer->xLength - 1 );
+		xContiguous = pxBuffer->xLength - xOffset;
+
+		/* A record that does not fit before the end also reserves the rest of
+		the buffer, so that it starts at the beginning. */
+		xNeeded = xRecordLength;
+		if( xNeeded > xContiguous )
+		{
+			xNeeded += xContiguous;
+		}
+
+		/* The acquire orders the writes to the reserved space after the
+		reader is done with it, see vMPMessageBufferRelease(). */
+		xUsed = xHead - __atomic_load_n( &( pxBuffer->xTail ), __ATOMIC_ACQUIRE );
+
+		if( xUsed > pxBuffer->xLength )
+		{
+			/* The reader released space reserved after xHead was read. */
+			xHead = __atomic_load_n( &( pxBuffer->xHead ), __ATOMIC_RELAXED );
+			continue;
+		}
+
+		if( xNeeded > ( pxBuffer->xLength - xUsed ) )
+		{
+			return NULL;
+		}
+
+		if( __atomic_compare_exchange_n( &( pxBuffer->xHead ), &xHead, xHead + xNeeded, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) != pdFALSE )
+		{
+			break;
+		}
+
+		/* Another producer reserved space, xHead was updated by the failed
+		compare. */
+	}
+
+	if( xNeeded != xRecordLength )
+	{
+		*( ( size_t * ) &( pxBuffer->pucBuffer[ xOffset ] ) ) = xContiguous - mpmessagebufferHEADER_SIZE; /*lint !e9087 !e826 Headers are aligned to the granule. */
+		__atomic_store_n( &( pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] ), mpmessagebufferRECORD_PADDING, __ATOMIC_RELEASE );
+		xOffset = 0;
+	}
+
+	/* The reader does not look at the header before the record is
+	committed. */
+	*( ( size_t * ) &( pxBuffer->pucBuffer[ xOffset ] ) ) = xDataLength; /*lint !e9087 !e826 Headers are aligned to the granule. */
+
+	return &( pxBuffer->pucBuffer[ xOffset + mpmessagebufferHEADER_SIZE ] );
+}
+/*-----------------------------------------------------------*/
+
+void vMPMessageBufferCommit( MPMessageBufferHandle_t xBuffer, void *pvRecord )
+{
+MPMessageBuffer_t * const pxBuffer = xBuffer;
+
+	configASSERT( pxBuffer );
+
+	prvCommit( pxBuffer, pvRecord );
+	prvWakeReader( pxBuffer, NULL );
+}
+/*-----------------------------------------------------------*/
+
+void vMPMessageBufferCommitFromISR( MPMessageBufferHandle_t xBuffer, void *pvRecord, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+MPMessageBuffer_t * const pxBuffer = xBuffer;
+
+	configASSERT( pxBuffer );
+	configASSERT( pxHigherPriorityTaskWoken );
+	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+	prvCommit( pxBuffer, pvRecord );
+	prvWakeReader( pxBuffer, pxHigherPriorityTaskWoken );
+}
+/*-----------------------------------------------------------*/
+
+size_t xMPMessageBufferSend( MPMessageBufferHandle_t xBuffer, const void *pvTxData, size_t xDataLengthBytes )
+{
+void *pvRecord;
+
+	configASSERT( pvTxData );
+
+	pvRecord = pvMPMessageBufferReserve( xBuffer, xDataLengthBytes );
+
+	if( pvRecord == NULL )
+	{
+		return 0;
+	}
+
+	( void ) memcpy( pvRecord, pvTxData, xDataLengthBytes ); /*lint !e9087 memcpy() requires void *. */
+	vMPMessageBufferCommit( xBuffer, pvRecord );
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+size_t xMPMessageBufferSendFromISR( MPMessageBufferHandle_t xBuffer, const void *pvTxData, size_t xDataLengthBytes, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+void *pvRecord;
+
+	configASSERT( pvTxData );
+
+	pvRecord = pvMPMessageBufferReserve( xBuffer, xDataLengthBytes );
+
+	if( pvRecord == NULL )
+	{
+		return 0;
+	}
+
+	( void ) memcpy( pvRecord, pvTxData, xDataLengthBytes ); /*lint !e9087 memcpy() requires void *. */
+	vMPMessageBufferCommitFromISR( xBuffer, pvRecord, pxHigherPriorityTaskWoken );
+
+	return xDataLengthBytes;
+}
+/*-----------------------------------------------------------*/
+
+void *pvMPMessageBufferAcquire( MPMessageBufferHandle_t xBuffer, size_t *pxDataLength, TickType_t xTicksToWait )
+{
+MPMessageBuffer_t * const pxBuffer = xBuffer;
+TimeOut_t xTimeOut;
+void *pvRecord;
+
+	configASSERT( pxBuffer );
+	configASSERT( pxDataLength );
+
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		pvRecord = prvNextRecord( pxBuffer, pxDataLength );
+
+		if( pvRecord != NULL )
+		{
+			break;
+		}
+
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+		{
+			break;
+		}
+
+		/* A producer commits, then looks for a waiting reader.  The reader
+		registers, then looks for a committed record again, so one of the two
+		sees the other. */
+		( void ) xTaskNotifyStateClear( NULL );
+		__atomic_store_n( &( pxBuffer->xTaskWaitingToReceive ), xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST );
+		__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+		pvRecord = prvNextRecord( pxBuffer, pxDataLength );
+
+		if( pvRecord == NULL )
+		{
+			( void ) xTaskNotifyWait( ( uint32_t ) 0, ( uint32_t ) 0, NULL, xTicksToWait );
+		}
+
+		__atomic_store_n( &( pxBuffer->xTaskWaitingToReceive ), NULL, __ATOMIC_RELAXED );
+
+		if( pvRecord != NULL )
+		{
+			break;
+		}
+	}
+
+	return pvRecord;
+}
+/*-----------------------------------------------------------*/
+
+void vMPMessageBufferRelease( MPMessageBufferHandle_t xBuffer )
+{
+MPMessageBuffer_t * const pxBuffer = xBuffer;
+const size_t xTail = pxBuffer->xTail;
+const size_t xOffset = xTail & ( pxBuffer->xLength - 1 );
+size_t xDataLength;
+
+	configASSERT( pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] == mpmessagebufferRECORD_COMMITTED );
+
+	xDataLength = *( ( size_t * ) &( pxBuffer->pucBuffer[ xOffset ] ) ); /*lint !e9087 !e826 Headers are aligned to the granule. */
+	pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] = 0;
+
+	/* Hands the space to the producers.  The release orders the reads of the
+	record and the cleared flag before their writes. */
+	__atomic_store_n( &( pxBuffer->xTail ), xTail + prvRecordLength( xDataLength ), __ATOMIC_RELEASE );
+}
+/*-----------------------------------------------------------*/
+
+size_t xMPMessageBufferReceive( MPMessageBufferHandle_t xBuffer, void *pvRxData, size_t xBufferLengthBytes, TickType_t xTicksToWait )
+{
+void *pvRecord;
+size_t xDataLength = 0;
+
+	configASSERT( pvRxData );
+
+	pvRecord = pvMPMessageBufferAcquire( xBuffer, &xDataLength, xTicksToWait );
+
+	if( pvRecord == NULL )
+	{
+		return 0;
+	}
+
+	if( xDataLength > xBufferLengthBytes )
+	{
+		return 0;
+	}
+
+	( void ) memcpy( pvRxData, pvRecord, xDataLength ); /*lint !e9087 memcpy() requires void *. */
+	vMPMessageBufferRelease( xBuffer );
+
+	return xDataLength;
+}
+/*-----------------------------------------------------------*/
+
+static size_t prvRecordLength( size_t xDataLength )
+{
+	return mpmessagebufferHEADER_SIZE + ( ( xDataLength + ( mpmessagebufferGRANULE_SIZE - 1 ) ) & ~( mpmessagebufferGRANULE_SIZE - 1 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvCommit( MPMessageBuffer_t * const pxBuffer, void * const pvRecord )
+{
+size_t xOffset;
+
+	configASSERT( pvRecord );
+
+	xOffset = ( size_t ) ( ( uint8_t * ) pvRecord - pxBuffer->pucBuffer ) - mpmessagebufferHEADER_SIZE;
+
+	configASSERT( ( xOffset < pxBuffer->xLength ) && ( ( xOffset % mpmessagebufferGRANULE_SIZE ) == 0 ) );
+	configASSERT( pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] == 0 );
+
+	/* Publishes the header and the data with the flag. */
+	__atomic_store_n( &( pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] ), mpmessagebufferRECORD_COMMITTED, __ATOMIC_RELEASE );
+}
+/*-----------------------------------------------------------*/
+
+static void *prvNextRecord( MPMessageBuffer_t * const pxBuffer, size_t * const pxDataLength )
+{
+size_t xTail, xOffset;
+uint8_t ucFlag;
+
+	for( ;; )
+	{
+		xTail = pxBuffer->xTail;
+		xOffset = xTail & ( pxBuffer->xLength - 1 );
+		ucFlag = __atomic_load_n( &( pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] ), __ATOMIC_ACQUIRE );
+
+		if( ucFlag == mpmessagebufferRECORD_COMMITTED )
+		{
+			*pxDataLength = *( ( size_t * ) &( pxBuffer->pucBuffer[ xOffset ] ) ); /*lint !e9087 !e826 Headers are aligned to the granule. */
+			return &( pxBuffer->pucBuffer[ xOffset + mpmessagebufferHEADER_SIZE ] );
+		}
+		else if( ucFlag == mpmessagebufferRECORD_PADDING )
+		{
+			/* The next record starts at the beginning of the buffer. */
+			pxBuffer->pucCommitted[ xOffset / mpmessagebufferGRANULE_SIZE ] = 0;
+			__atomic_store_n( &( pxBuffer->xTail ), xTail + ( pxBuffer->xLength - xOffset ), __ATOMIC_RELEASE );
+		}
+		else
+		{
+			return NULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvWakeReader( MPMessageBuffer_t * const pxBuffer, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+TaskHandle_t xTask;
+
+	/* Orders the commit before reading the waiting task, see
+	pvMPMessageBufferAcquire(). */
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+	xTask = __atomic_load_n( &( pxBuffer->xTaskWaitingToReceive ), __ATOMIC_RELAXED );
+
+	/* The compare-and-swap makes sure only one producer notifies the reader. */
+	if( ( xTask != NULL ) &&
+		( __atomic_compare_exchange_n( &( pxBuffer->xTaskWaitingToReceive ), &xTask, NULL, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) != pdFALSE ) )
+	{
+		if( pxHigherPriorityTaskWoken == NULL )
+		{
+			( void ) xTaskNotify( xTask, ( uint32_t ) 0, eNoAction );
+		}
+		else
+		{
+			( void ) xTaskNotifyFromISR( xTask, ( uint32_t ) 0, eNoAction, pxHigherPriorityTaskWoken );
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseNewMPMessageBuffer( MPMessageBuffer_t * const pxBuffer, size_t xBufferSizeBytes, uint8_t * const pucStorage, uint8_t ucFlags )
+{
+	( void ) memset( ( void * ) pxBuffer, 0x00, sizeof( MPMessageBuffer_t ) ); /*lint !e9087 memset() requires void *. */
+
+	pxBuffer->pucBuffer = pucStorage;
+	pxBuffer->pucCommitted = pucStorage + xBufferSizeBytes;
+	pxBuffer->xLength = xBufferSizeBytes;
+	pxBuffer->ucFlags = ucFlags;
+
+	/* A record is only read once its flag is set. */
+	( void ) memset( pxBuffer->pucCommitted, 0x00, xBufferSizeBytes / mpmessagebufferGRANULE_SIZE );
+}
@@ -0,0 +1,563 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pointer_queue.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_PREEMPTION == 0 )
+	/* If the cooperative scheduler is being used then a yield should not be
+	performed just because a higher priority task has been woken. */
+	#define pointerqueueYIELD_IF_USING_PREEMPTION()
+#else
+	#define pointerqueueYIELD_IF_USING_PREEMPTION() portYIELD_WITHIN_API()
+#endif
+
+/* Bits that can be set in xPOINTER_QUEUE->ucFlags. */
+#define pointerqueueFLAGS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 1 )
+
+/*
+ * Slot n of the ring is used for the positions n, n + uxLength, n + 2 *
+ * uxLength, ...  Its sequence number is twice the position a sender may fill it
+ * at, and that + 1 once the sender has stored the pointer.  The receiver sets
+ * it to twice the position of the next lap when it takes the pointer.  Without
+ * the factor of two a full queue of length 1 would look free for the next lap,
+ * whose position is the filled one + 1.
+ */
+typedef struct PointerQueueSlot
+{
+	volatile UBaseType_t uxSequence;
+	void * volatile pvItem;
+} PointerQueueSlot_t;
+
+/*lint -save -e9058 Style convention uses tag. */
+typedef struct PointerQueueDefinition
+{
+	PointerQueueSlot_t *pxSlots;					/* The ring of uxLength slots. */
+	UBaseType_t uxLength;
+	volatile UBaseType_t uxHead;					/* The next position a sender reserves. */
+	volatile UBaseType_t uxTail;					/* The next position the receiver takes. */
+	volatile UBaseType_t uxSendersWaiting;			/* Senders in xTasksWaitingToSend, or about to be. */
+	volatile UBaseType_t uxReceiverWaiting;			/* 1 while the receiver is in xTasksWaitingToReceive, or about to be. */
+	List_t xTasksWaitingToSend;						/* Tasks blocked waiting for room, in priority order. */
+	List_t xTasksWaitingToReceive;					/* The receiver if it is blocked waiting for a pointer. */
+	uint8_t ucFlags;
+} PointerQueue_t;
+/*lint -restore */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called by both create functions to initialise the structure and the slots.
+ */
+static void prvInitialiseNewPointerQueue( PointerQueue_t * const pxQueue, UBaseType_t uxLength, PointerQueueSlot_t * const pxSlots, uint8_t ucFlags ) PRIVILEGED_FUNCTION;
+
+/*
+ * Reserves a slot and stores pvItem in it.  Returns pdFALSE if the queue is
+ * full.
+ */
+static BaseType_t prvPush( PointerQueue_t * const pxQueue, void * const pvItem ) PRIVILEGED_FUNCTION;
+
+/*
+ * Reads the oldest pointer into *ppvItem, and takes it out of the queue if
+ * xRemove is pdTRUE.  Returns pdFALSE if the queue is empty.
+ */
+static BaseType_t prvPop( PointerQueue_t * const pxQueue, void ** const ppvItem, BaseType_t xRemove ) PRIVILEGED_FUNCTION;
+
+/*
+ * Unblocks the highest priority task in pxWaitingList, if *puxWaiting says a
+ * task may be in it.  Called from an interrupt if pxHigherPriorityTaskWoken is
+ * not NULL.
+ */
+static void prvWakeWaitingTask( volatile UBaseType_t * const puxWaiting, List_t * const pxWaitingList, BaseType_t * const pxHigherPriorityTaskWoken ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	PointerQueueHandle_t xPointerQueueCreate( UBaseType_t uxLength )
+	{
+	uint8_t *pucAllocatedMemory;
+	size_t xStructSize;
+
+		/* The slots follow the queue structure, keep them aligned. */
+		xStructSize = ( sizeof( PointerQueue_t ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+		configASSERT( uxLength > 0 );
+
+		if( ( uxLength == 0 ) || ( uxLength > ( ( ~( size_t ) 0 ) - xStructSize ) / sizeof( PointerQueueSlot_t ) ) )
+		{
+			return NULL;
+		}
+
+		pucAllocatedMemory = ( uint8_t * ) pvPortMalloc( xStructSize + ( sizeof( PointerQueueSlot_t ) * uxLength ) ); /*lint !e9079 malloc() only returns void*. */
+
+		if( pucAllocatedMemory != NULL )
+		{
+			prvInitialiseNewPointerQueue( ( PointerQueue_t * ) pucAllocatedMemory, /* Structure at the start of the allocated memory. */ /*lint !e9087 Safe cast as allocated memory is aligned. */ /*lint !e826 Area is not too small and alignment is guaranteed provided malloc() behaves as expected and returns aligned buffer. */
+										  uxLength,
+										  ( PointerQueueSlot_t * ) ( pucAllocatedMemory + xStructSize ), /* Slots follow. */ /*lint !e9087 !e826 Safe cast as allocated memory is aligned. */
+										  0 );
+		}
+
+		return ( PointerQueueHandle_t ) pucAllocatedMemory; /*lint !e9087 !e826 Safe cast as allocated memory is aligned. */
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+PointerQueueHandle_t xPointerQueueCreateStatic( UBaseType_t uxLength, StaticPointerQueueSlot_t *pxSlotStorage, StaticPointerQueue_t *pxStaticPointerQueue )
+{
+PointerQueue_t * const pxQueue = ( PointerQueue_t * ) pxStaticPointerQueue; /*lint !e740 !e9087 PointerQueue_t and StaticPointerQueue_t are guaranteed to have the same size and alignment requirement - checked by configASSERT(). */
+PointerQueueHandle_t xReturn;
+
+	configASSERT( pxSlotStorage );
+	configASSERT( pxStaticPointerQueue );
+	configASSERT( uxLength > 0 );
+
+	#if( configASSERT_DEFINED == 1 )
+	{
+		/* Sanity check that the sizes of the structures used to declare the
+		variables of type StaticPointerQueue_t and StaticPointerQueueSlot_t
+		equal the sizes of the real structures. */
+		volatile size_t xSize = sizeof( StaticPointerQueue_t );
+		configASSERT( xSize == sizeof( PointerQueue_t ) );
+		xSize = sizeof( StaticPointerQueueSlot_t );
+		configASSERT( xSize == sizeof( PointerQueueSlot_t ) );
+	} /*lint !e529 xSize is referenced is configASSERT() is defined. */
+	#endif /* configASSERT_DEFINED */
+
+	if( ( pxSlotStorage != NULL ) && ( pxStaticPointerQueue != NULL ) && ( uxLength > 0 ) )
+	{
+		prvInitialiseNewPointerQueue( pxQueue, uxLength, ( PointerQueueSlot_t * ) pxSlotStorage, pointerqueueFLAGS_IS_STATICALLY_ALLOCATED ); /*lint !e740 !e9087 Same size and alignment - checked by configASSERT(). */
+		xReturn = ( PointerQueueHandle_t ) pxStaticPointerQueue; /*lint !e9087 Data hiding requires cast to opaque type. */
+	}
+	else
+	{
+		xReturn = NULL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPointerQueueDelete( PointerQueueHandle_t xQueue )
+{
+PointerQueue_t * pxQueue = xQueue;
+
+	configASSERT( pxQueue );
+	configASSERT( ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToSend ) ) != pdFALSE ) && ( listLIST_IS_EMPTY( &( pxQueue->xTasksWaitingToReceive ) ) != pdFALSE ) );
+
+	if( ( pxQueue->ucFlags & pointerqueueFLAGS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) pdFALSE )
+	{
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			/* Both the structure and the slots were allocated using a single
+			call to pvPortMalloc(), hence only one call to vPortFree() is
+			required. */
+			vPortFree( ( void * ) pxQueue ); /*lint !e9087 Standard free() semantics require void *, plus pxQueue was allocated by pvPortMalloc(). */
+		}
+		#else
+		{
+			/* Should not be possible to get here, ucFlags must be corrupt.
+			Force an assert. */
+			configASSERT( xQueue == ( PointerQueueHandle_t ) ~0 );
+		}
+		#endif
+	}
+	else
+	{
+		/* The structure and the slots were statically allocated, so just
+		clear the structure. */
+		( void ) memset( pxQueue, 0x00, sizeof( PointerQueue_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPointerQueueSend( PointerQueueHandle_t xQueue, void *pvItem, TickType_t xTicksToWait )
+{
+PointerQueue_t * const pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xReturn, xBlocked;
+
+	configASSERT( pxQueue );
+
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		if( prvPush( pxQueue, pvItem ) != pdFALSE )
+		{
+			prvWakeWaitingTask( &( pxQueue->uxReceiverWaiting ), &( pxQueue->xTasksWaitingToReceive ), NULL );
+			return pdPASS;
+		}
+
+		taskENTER_CRITICAL();
+		{
+			/* The receiver takes a pointer, then looks at the count of waiting
+			senders.  This sender counts itself, then looks at the queue again,
+			so one of the two sees the other.  A receiver that sees the count
+			wakes a sender from within a critical section, which cannot run
+			until this one has put the task in the list. */
+			( void ) __atomic_add_fetch( &( pxQueue->uxSendersWaiting ), 1U, __ATOMIC_RELAXED );
+			__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+			xBlocked = pdFALSE;
+
+			if( prvPush( pxQueue, pvItem ) != pdFALSE )
+			{
+				xReturn = pdPASS;
+			}
+			else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+			{
+				xReturn = errQUEUE_FULL;
+			}
+			else
+			{
+				/* See ulTaskNotifyTake() for the yield within a critical
+				section. */
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+				portYIELD_WITHIN_API();
+				xBlocked = pdTRUE;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		/* Woken by the receiver or timed out, either way the task is out of
+		the list now. */
+		( void ) __atomic_sub_fetch( &( pxQueue->uxSendersWaiting ), 1U, __ATOMIC_RELAXED );
+
+		if( xBlocked != pdFALSE )
+		{
+			/* Try again. */
+			mtCOVERAGE_TEST_MARKER();
+		}
+		else if( xReturn == pdPASS )
+		{
+			prvWakeWaitingTask( &( pxQueue->uxReceiverWaiting ), &( pxQueue->xTasksWaitingToReceive ), NULL );
+			return pdPASS;
+		}
+		else
+		{
+			return errQUEUE_FULL;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPointerQueueSendFromISR( PointerQueueHandle_t xQueue, void *pvItem, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+PointerQueue_t * const pxQueue = xQueue;
+BaseType_t xReturn = errQUEUE_FULL;
+BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+
+	configASSERT( pxQueue );
+	portASSERT_IF_INTERRUPT_PRIORITY_INVALID();
+
+	if( prvPush( pxQueue, pvItem ) != pdFALSE )
+	{
+		/* pxHigherPriorityTaskWoken is optional, a NULL would tell
+		prvWakeWaitingTask() it runs in a task. */
+		prvWakeWaitingTask( &( pxQueue->uxReceiverWaiting ), &( pxQueue->xTasksWaitingToReceive ), &xHigherPriorityTaskWoken );
+
+		if( ( pxHigherPriorityTaskWoken != NULL ) && ( xHigherPriorityTaskWoken != pdFALSE ) )
+		{
+			*pxHigherPriorityTaskWoken = pdTRUE;
+		}
+
+		xReturn = pdPASS;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPointerQueueReceive( PointerQueueHandle_t xQueue, void **ppvItem, TickType_t xTicksToWait )
+{
+PointerQueue_t * const pxQueue = xQueue;
+TimeOut_t xTimeOut;
+BaseType_t xReturn, xBlocked;
+
+	configASSERT( pxQueue );
+	configASSERT( ppvItem );
+
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	for( ;; )
+	{
+		if( prvPop( pxQueue, ppvItem, pdTRUE ) != pdFALSE )
+		{
+			prvWakeWaitingTask( &( pxQueue->uxSendersWaiting ), &( pxQueue->xTasksWaitingToSend ), NULL );
+			return pdPASS;
+		}
+
+		taskENTER_CRITICAL();
+		{
+			/* As in xPointerQueueSend(), count first and look at the queue
+			again.  There is one receiver, so the count is 0 or 1. */
+			__atomic_store_n( &( pxQueue->uxReceiverWaiting ), ( UBaseType_t ) 1U, __ATOMIC_RELAXED );
+			__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+			xBlocked = pdFALSE;
+
+			if( prvPop( pxQueue, ppvItem, pdTRUE ) != pdFALSE )
+			{
+				xReturn = pdPASS;
+			}
+			else if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+			{
+				xReturn = errQUEUE_EMPTY;
+			}
+			else
+			{
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				portYIELD_WITHIN_API();
+				xBlocked = pdTRUE;
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		__atomic_store_n( &( pxQueue->uxReceiverWaiting ), ( UBaseType_t ) 0U, __ATOMIC_RELAXED );
+
+		if( xBlocked != pdFALSE )
+		{
+			/* Try again. */
+			mtCOVERAGE_TEST_MARKER();
+		}
+		else if( xReturn == pdPASS )
+		{
+			prvWakeWaitingTask( &( pxQueue->uxSendersWaiting ), &( pxQueue->xTasksWaitingToSend ), NULL );
+			return pdPASS;
+		}
+		else
+		{
+			return errQUEUE_EMPTY;
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPointerQueuePeek( PointerQueueHandle_t xQueue )
+{
+PointerQueue_t * const pxQueue = xQueue;
+void *pvItem = NULL;
+
+	configASSERT( pxQueue );
+
+	( void ) prvPop( pxQueue, &pvItem, pdFALSE );
+
+	return pvItem;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPointerQueueMessagesWaiting( PointerQueueHandle_t xQueue )
+{
+const PointerQueue_t * const pxQueue = xQueue;
+UBaseType_t uxTail;
+
+	configASSERT( pxQueue );
+
+	/* Read the tail first, the head cannot be behind it. */
+	uxTail = __atomic_load_n( &( pxQueue->uxTail ), __ATOMIC_ACQUIRE );
+
+	return __atomic_load_n( &( pxQueue->uxHead ), __ATOMIC_ACQUIRE ) - uxTail;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPush( PointerQueue_t * const pxQueue, void * const pvItem )
+{
+PointerQueueSlot_t *pxSlot;
+UBaseType_t uxPosition;
+BaseType_t xDifference;
+
+	uxPosition = __atomic_load_n( &( pxQueue->uxHead ), __ATOMIC_RELAXED );
+
+	for( ;; )
+	{
+		pxSlot = &( pxQueue->pxSlots[ uxPosition % pxQueue->uxLength ] );
+		xDifference = ( BaseType_t ) ( __atomic_load_n( &( pxSlot->uxSequence ), __ATOMIC_ACQUIRE ) - ( uxPosition * 2U ) );
+
+		if( xDifference == 0 )
+		{
+			/* The slot is free for this lap, reserve it. */
+			if( __atomic_compare_exchange_n( &( pxQueue->uxHead ), &uxPosition, uxPosition + 1U, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) != pdFALSE )
+			{
+				break;
+			}
+
+			/* Another sender reserved it, uxPosition was updated by the failed
+			compare. */
+		}
+		else if( xDifference < 0 )
+		{
+			/* The slot still holds the pointer of the previous lap. */
+			return pdFALSE;
+		}
+		else
+		{
+			/* Another sender reserved and filled the slot since uxHead was
+			read. */
+			uxPosition = __atomic_load_n( &( pxQueue->uxHead ), __ATOMIC_RELAXED );
+		}
+	}
+
+	pxSlot->pvItem = pvItem;
+
+	/* Publishes the pointer, and with the release the object it references. */
+	__atomic_store_n( &( pxSlot->uxSequence ), ( uxPosition * 2U ) + 1U, __ATOMIC_RELEASE );
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvPop( PointerQueue_t * const pxQueue, void ** const ppvItem, BaseType_t xRemove )
+{
+const UBaseType_t uxPosition = pxQueue->uxTail;
+PointerQueueSlot_t * const pxSlot = &( pxQueue->pxSlots[ uxPosition % pxQueue->uxLength ] );
+
+	if( __atomic_load_n( &( pxSlot->uxSequence ), __ATOMIC_ACQUIRE ) != ( ( uxPosition * 2U ) + 1U ) )
+	{
+		/* Empty, or the sender of the oldest pointer has not published it
+		yet. */
+		return pdFALSE;
+	}
+
+	*ppvItem = pxSlot->pvItem;
+
+	if( xRemove != pdFALSE )
+	{
+		__atomic_store_n( &( pxQueue->uxTail ), uxPosition + 1U, __ATOMIC_RELAXED );
+
+		/* Hands the slot to the senders of the next lap. */
+		__atomic_store_n( &( pxSlot->uxSequence ), ( uxPosition + pxQueue->uxLength ) * 2U, __ATOMIC_RELEASE );
+	}
+
+	return pdTRUE;
+}
+/*-----------------------------------------------------------*/
+
+static void prvWakeWaitingTask( volatile UBaseType_t * const puxWaiting, List_t * const pxWaitingList, BaseType_t * const pxHigherPriorityTaskWoken )
+{
+UBaseType_t uxSavedInterruptStatus;
+
+	/* Orders the push or pop before reading the count, see
+	xPointerQueueSend().  While no task waits the critical section is not
+	entered. */
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+	if( __atomic_load_n( puxWaiting, __ATOMIC_RELAXED ) == ( UBaseType_t ) 0U )
+	{
+		return;
+	}
+
+	if( pxHigherPriorityTaskWoken == NULL )
+	{
+		taskENTER_CRITICAL();
+		{
+			if( listLIST_IS_EMPTY( pxWaitingList ) == pdFALSE )
+			{
+				if( xTaskRemoveFromEventList( pxWaitingList ) != pdFALSE )
+				{
+					/* Yes it is ok to do this from within the critical section
+					- the kernel takes care of that. */
+					pointerqueueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				/* The waiting task found room or a pointer before it
+				blocked, or timed out. */
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+	else
+	{
+		uxSavedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+		{
+			if( ( listLIST_IS_EMPTY( pxWaitingList ) == pdFALSE ) &&
+				( xTaskRemoveFromEventList( pxWaitingList ) != pdFALSE ) )
+			{
+				*pxHigherPriorityTaskWoken = pdTRUE;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL_FROM_ISR( uxSavedInterruptStatus );
+	}
+}
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseNewPointerQueue( PointerQueue_t * const pxQueue, UBaseType_t uxLength, PointerQueueSlot_t * const pxSlots, uint8_t ucFlags )
+{
+UBaseType_t ux;
+
+	( void ) memset( ( void * ) pxQueue, 0x00, sizeof( PointerQueue_t ) ); /*lint !e9087 memset() requires void *. */
+
+	pxQueue->pxSlots = pxSlots;
+	pxQueue->uxLength = uxLength;
+	pxQueue->ucFlags = ucFlags;
+	vListInitialise( &( pxQueue->xTasksWaitingToSend ) );
+	vListInitialise( &( pxQueue->xTasksWaitingToReceive ) );
+
+	for( ux = 0; ux < uxLength; ux++ )
+	{
+		pxSlots[ ux ].uxSequence = ux * 2U;
+		pxSlots[ ux ].pvItem = NULL;
+	}
+}
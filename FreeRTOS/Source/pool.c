@@ -0,0 +1,393 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <stdlib.h>
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "pool.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* The value freed blocks are filled with when configUSE_POOL_POISONING is 1. */
+#ifndef poolPOISON_BYTE
+	#define poolPOISON_BYTE				( ( uint8_t ) 0xA5 )
+#endif
+
+/* The head of the free stack: the index + 1 of the first free block in the low
+32 bits (0 when the pool is empty) and a count of the changes made to the head
+in the high 32 bits.  The count changes on every push and pop, so a pop that
+read the next link of a block that was taken and given back in the meantime
+fails its compare-and-swap instead of corrupting the stack. */
+#define poolHEAD_INDEX( ullHead )		( ( uint32_t ) ( ullHead ) )
+#define poolHEAD_NEXT( ullHead, ulIndex )	( ( ( ( ( ullHead ) >> 32 ) + 1ULL ) << 32 ) | ( uint64_t ) ( ulIndex ) )
+
+/* The pool needs a 64-bit compare-and-swap.  The GCC builtins map to the
+exclusive load/store instructions on ARMv7-A and ARMv8-A. */
+#ifndef poolCOMPARE_AND_SWAP
+	#define poolCOMPARE_AND_SWAP( pullDestination, pullExpected, ullDesired ) \
+		__atomic_compare_exchange_n( ( pullDestination ), ( pullExpected ), ( ullDesired ), pdFALSE, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE )
+#endif
+
+/* Bits that can be set in xPOOL->ucFlags. */
+#define poolFLAGS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 1 )
+
+/*lint -save -e9058 Style convention uses tag. */
+typedef struct PoolDefinition
+{
+	uint8_t *pucStorage;				/* The first block. */
+	size_t xBlockSize;					/* The distance between blocks. */
+	UBaseType_t uxBlockCount;			/* The number of blocks. */
+	volatile UBaseType_t uxFreeCount;	/* The number of free blocks. */
+	UBaseType_t uxMinimumFreeCount;		/* The lowest value uxFreeCount had. */
+	volatile uint64_t ullHead;			/* The free stack, see poolHEAD_NEXT(). */
+	uint8_t ucFlags;
+} Pool_t;
+/*lint -restore */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called by both pool create functions to initialise the structure and put all
+ * blocks on the free stack.
+ */
+static void prvInitialiseNewPool( Pool_t * const pxPool, size_t xBlockSize, UBaseType_t uxBlockCount, uint8_t * const pucPoolStorage, uint8_t ucFlags ) PRIVILEGED_FUNCTION;
+
+/*
+ * The address of the block with index ulIndex, and the link to the next free
+ * block kept at its start.
+ */
+static uint8_t *prvBlock( const Pool_t * const pxPool, uint32_t ulIndex );
+static volatile uint32_t *prvLink( uint8_t *pucBlock );
+
+#if( configUSE_POOL_POISONING == 1 )
+	/*
+	 * pdTRUE if every byte of the block after the link holds poolPOISON_BYTE.
+	 */
+	static BaseType_t prvIsPoisoned( const Pool_t * const pxPool, const uint8_t *pucBlock ) PRIVILEGED_FUNCTION;
+#endif
+
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	PoolHandle_t xPoolCreate( size_t xBlockSize, UBaseType_t uxBlockCount )
+	{
+	uint8_t *pucAllocatedMemory;
+	size_t xStructSize;
+
+		/* The blocks follow the pool structure, keep them aligned. */
+		xStructSize = ( sizeof( Pool_t ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+		configASSERT( xBlockSize >= sizeof( uint32_t ) );
+		configASSERT( ( xBlockSize % sizeof( uint32_t ) ) == 0 );
+		configASSERT( uxBlockCount > 0 );
+
+		if( ( xBlockSize < sizeof( uint32_t ) ) || ( uxBlockCount == 0 ) ||
+			( xBlockSize > ( ( ~( size_t ) 0 ) - xStructSize ) / uxBlockCount ) )
+		{
+			return NULL;
+		}
+
+		pucAllocatedMemory = ( uint8_t * ) pvPortMalloc( xStructSize + ( xBlockSize * uxBlockCount ) ); /*lint !e9079 malloc() only returns void*. */
+
+		if( pucAllocatedMemory != NULL )
+		{
+			prvInitialiseNewPool( ( Pool_t * ) pucAllocatedMemory, /* Structure at the start of the allocated memory. */ /*lint !e9087 Safe cast as allocated memory is aligned. */ /*lint !e826 Area is not too small and alignment is guaranteed provided malloc() behaves as expected and returns aligned buffer. */
+								  xBlockSize,
+								  uxBlockCount,
+								  pucAllocatedMemory + xStructSize, /* Storage follows. */ /*lint !e9016 Indexing past structure valid for uint8_t pointer into uint8_t array. */
+								  0 );
+		}
+
+		return ( PoolHandle_t ) pucAllocatedMemory; /*lint !e9087 !e826 Safe cast as allocated memory is aligned. */
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+PoolHandle_t xPoolCreateStatic( size_t xBlockSize, UBaseType_t uxBlockCount, uint8_t *pucPoolStorage, StaticPool_t *pxStaticPool )
+{
+Pool_t * const pxPool = ( Pool_t * ) pxStaticPool; /*lint !e740 !e9087 Pool_t and StaticPool_t are guaranteed to have the same size and alignment requirement - checked by configASSERT(). */
+PoolHandle_t xReturn;
+
+	configASSERT( pucPoolStorage );
+	configASSERT( pxStaticPool );
+	configASSERT( xBlockSize >= sizeof( uint32_t ) );
+	configASSERT( ( xBlockSize % sizeof( uint32_t ) ) == 0 );
+	configASSERT( ( ( ( size_t ) pucPoolStorage ) % sizeof( uint32_t ) ) == 0 );
+	configASSERT( uxBlockCount > 0 );
+
+	#if( configASSERT_DEFINED == 1 )
+	{
+		/* Sanity check that the size of the structure used to declare a
+		variable of type StaticPool_t equals the size of the real pool
+		structure. */
+		volatile size_t xSize = sizeof( StaticPool_t );
+		configASSERT( xSize == sizeof( Pool_t ) );
+	} /*lint !e529 xSize is referenced is configASSERT() is defined. */
+	#endif /* configASSERT_DEFINED */
+
+	if( ( pucPoolStorage != NULL ) && ( pxStaticPool != NULL ) && ( xBlockSize >= sizeof( uint32_t ) ) && ( uxBlockCount > 0 ) )
+	{
+		prvInitialiseNewPool( pxPool, xBlockSize, uxBlockCount, pucPoolStorage, poolFLAGS_IS_STATICALLY_ALLOCATED );
+		xReturn = ( PoolHandle_t ) pxStaticPool; /*lint !e9087 Data hiding requires cast to opaque type. */
+	}
+	else
+	{
+		xReturn = NULL;
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPoolDelete( PoolHandle_t xPool )
+{
+Pool_t * pxPool = xPool;
+
+	configASSERT( pxPool );
+
+	if( ( pxPool->ucFlags & poolFLAGS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) pdFALSE )
+	{
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			/* Both the structure and the blocks were allocated using a
+			single call to pvPortMalloc(), hence only one call to vPortFree()
+			is required. */
+			vPortFree( ( void * ) pxPool ); /*lint !e9087 Standard free() semantics require void *, plus pxPool was allocated by pvPortMalloc(). */
+		}
+		#else
+		{
+			/* Should not be possible to get here, ucFlags must be corrupt.
+			Force an assert. */
+			configASSERT( xPool == ( PoolHandle_t ) ~0 );
+		}
+		#endif
+	}
+	else
+	{
+		/* The structure and the blocks were statically allocated, so just
+		clear the structure. */
+		( void ) memset( pxPool, 0x00, sizeof( Pool_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPoolAlloc( PoolHandle_t xPool )
+{
+Pool_t * const pxPool = xPool;
+uint64_t ullHead;
+uint32_t ulIndex;
+uint8_t *pucBlock = NULL;
+UBaseType_t uxFree, uxMinimum;
+
+	configASSERT( pxPool );
+
+	ullHead = __atomic_load_n( &( pxPool->ullHead ), __ATOMIC_ACQUIRE );
+
+	do
+	{
+		ulIndex = poolHEAD_INDEX( ullHead );
+
+		if( ulIndex == 0 )
+		{
+			/* All blocks are in use. */
+			return NULL;
+		}
+
+		/* The link read here is stale if another writer pops this block
+		first, the compare-and-swap then fails because the count in the head
+		has changed. */
+		pucBlock = prvBlock( pxPool, ulIndex );
+	} while( poolCOMPARE_AND_SWAP( &( pxPool->ullHead ), &ullHead, poolHEAD_NEXT( ullHead, *prvLink( pucBlock ) ) ) == pdFALSE );
+
+	#if( configUSE_POOL_POISONING == 1 )
+	{
+		/* A write to the block while it was free. */
+		configASSERT( prvIsPoisoned( pxPool, pucBlock ) != pdFALSE );
+	}
+	#endif
+
+	/* Latch the lowest number of free blocks for the high water mark. */
+	uxFree = __atomic_sub_fetch( &( pxPool->uxFreeCount ), 1, __ATOMIC_RELAXED );
+	uxMinimum = __atomic_load_n( &( pxPool->uxMinimumFreeCount ), __ATOMIC_RELAXED );
+
+	while( ( uxFree < uxMinimum ) &&
+		   ( __atomic_compare_exchange_n( &( pxPool->uxMinimumFreeCount ), &uxMinimum, uxFree, pdFALSE, __ATOMIC_RELAXED, __ATOMIC_RELAXED ) == pdFALSE ) )
+	{
+		/* uxMinimum was updated by the failed compare, try again. */
+	}
+
+	return pucBlock;
+}
+/*-----------------------------------------------------------*/
+
+void vPoolFree( PoolHandle_t xPool, void *pvBlock )
+{
+Pool_t * const pxPool = xPool;
+uint8_t *pucBlock = ( uint8_t * ) pvBlock;
+uint64_t ullHead;
+uint32_t ulIndex;
+
+	configASSERT( pxPool );
+	configASSERT( xPoolContains( xPool, pvBlock ) != pdFALSE );
+
+	ulIndex = ( uint32_t ) ( ( size_t ) ( pucBlock - pxPool->pucStorage ) / pxPool->xBlockSize ) + 1UL;
+
+	#if( configUSE_POOL_POISONING == 1 )
+	{
+		/* A block that is still poisoned is most likely being freed twice. */
+		configASSERT( ( pxPool->xBlockSize == sizeof( uint32_t ) ) || ( prvIsPoisoned( pxPool, pucBlock ) == pdFALSE ) );
+		( void ) memset( pucBlock + sizeof( uint32_t ), ( int ) poolPOISON_BYTE, pxPool->xBlockSize - sizeof( uint32_t ) );
+	}
+	#endif
+
+	( void ) __atomic_add_fetch( &( pxPool->uxFreeCount ), 1, __ATOMIC_RELAXED );
+
+	ullHead = __atomic_load_n( &( pxPool->ullHead ), __ATOMIC_RELAXED );
+
+	do
+	{
+		*prvLink( pucBlock ) = poolHEAD_INDEX( ullHead );
+	} while( poolCOMPARE_AND_SWAP( &( pxPool->ullHead ), &ullHead, poolHEAD_NEXT( ullHead, ulIndex ) ) == pdFALSE );
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPoolGetFreeCount( PoolHandle_t xPool )
+{
+const Pool_t * const pxPool = xPool;
+
+	configASSERT( pxPool );
+
+	return pxPool->uxFreeCount;
+}
+/*-----------------------------------------------------------*/
+
+UBaseType_t uxPoolGetHighWaterMark( PoolHandle_t xPool )
+{
+const Pool_t * const pxPool = xPool;
+
+	configASSERT( pxPool );
+
+	return pxPool->uxBlockCount - pxPool->uxMinimumFreeCount;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xPoolContains( PoolHandle_t xPool, const void *pvBlock )
+{
+const Pool_t * const pxPool = xPool;
+size_t xOffset;
+BaseType_t xReturn = pdFALSE;
+
+	configASSERT( pxPool );
+
+	if( ( const uint8_t * ) pvBlock >= pxPool->pucStorage )
+	{
+		xOffset = ( size_t ) ( ( const uint8_t * ) pvBlock - pxPool->pucStorage );
+
+		if( ( xOffset < ( pxPool->xBlockSize * pxPool->uxBlockCount ) ) && ( ( xOffset % pxPool->xBlockSize ) == 0 ) )
+		{
+			xReturn = pdTRUE;
+		}
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static uint8_t *prvBlock( const Pool_t * const pxPool, uint32_t ulIndex )
+{
+	/* Indexes on the free stack start at 1. */
+	return pxPool->pucStorage + ( ( size_t ) ( ulIndex - 1UL ) * pxPool->xBlockSize );
+}
+/*-----------------------------------------------------------*/
+
+static volatile uint32_t *prvLink( uint8_t *pucBlock )
+{
+	return ( volatile uint32_t * ) pucBlock; /*lint !e9087 !e826 Blocks are aligned to four bytes - checked when the pool is created. */
+}
+/*-----------------------------------------------------------*/
+
+#if( configUSE_POOL_POISONING == 1 )
+
+	static BaseType_t prvIsPoisoned( const Pool_t * const pxPool, const uint8_t *pucBlock )
+	{
+	size_t x;
+
+		for( x = sizeof( uint32_t ); x < pxPool->xBlockSize; x++ )
+		{
+			if( pucBlock[ x ] != poolPOISON_BYTE )
+			{
+				return pdFALSE;
+			}
+		}
+
+		return pdTRUE;
+	}
+
+#endif /* configUSE_POOL_POISONING */
+/*-----------------------------------------------------------*/
+
+static void prvInitialiseNewPool( Pool_t * const pxPool, size_t xBlockSize, UBaseType_t uxBlockCount, uint8_t * const pucPoolStorage, uint8_t ucFlags )
+{
+uint32_t ulIndex;
+uint8_t *pucBlock;
+
+	( void ) memset( ( void * ) pxPool, 0x00, sizeof( Pool_t ) ); /*lint !e9087 memset() requires void *. */
+
+	pxPool->pucStorage = pucPoolStorage;
+	pxPool->xBlockSize = xBlockSize;
+	pxPool->uxBlockCount = uxBlockCount;
+	pxPool->uxFreeCount = uxBlockCount;
+	pxPool->uxMinimumFreeCount = uxBlockCount;
+	pxPool->ucFlags = ucFlags;
+
+	/* Chain the blocks in address order, the last one ends the stack. */
+	for( ulIndex = 1; ulIndex <= ( uint32_t ) uxBlockCount; ulIndex++ )
+	{
+		pucBlock = prvBlock( pxPool, ulIndex );
+
+		#if( configUSE_POOL_POISONING == 1 )
+		{
+			( void ) memset( pucBlock + sizeof( uint32_t ), ( int ) poolPOISON_BYTE, xBlockSize - sizeof( uint32_t ) );
+		}
+		#endif
+
+		*prvLink( pucBlock ) = ( ulIndex < ( uint32_t ) uxBlockCount ) ? ( ulIndex + 1UL ) : 0UL;
+	}
+
+	pxPool->ullHead = 1ULL;
+}
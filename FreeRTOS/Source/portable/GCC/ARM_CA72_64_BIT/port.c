@@ -31,6 +31,7 @@
 /* Scheduler includes. */
 #include "FreeRTOS.h"
 #include "task.h"
+#include "pool.h"
 
 #ifndef configINTERRUPT_CONTROLLER_BASE_ADDRESS
 	#error configINTERRUPT_CONTROLLER_BASE_ADDRESS must be defined.  See http://www.freertos.org/Using-FreeRTOS-on-Cortex-A-Embedded-Processors.html
@@ -48,6 +49,31 @@
 	#error configSETUP_TICK_INTERRUPT() must be defined.  See http://www.freertos.org/Using-FreeRTOS-on-Cortex-A-Embedded-Processors.html
 #endif /* configSETUP_TICK_INTERRUPT */
 
+#if( configNUM_CORES > 1 )
+	#ifndef configSETUP_YIELD_INTERRUPT
+		#error configSETUP_YIELD_INTERRUPT() must be defined to install FreeRTOS_Yield_Handler() for portYIELD_CORE_SGI on the calling core.
+	#endif
+
+	#ifndef configSTART_SECONDARY_CORES
+		#error configSTART_SECONDARY_CORES() must be defined to release cores 1 to configNUM_CORES - 1 into vPortStartSecondaryCore().
+	#endif
+#endif /* configNUM_CORES */
+
+/* The number of floating point contexts the FPU trap can hand out to tasks
+that did not call xPortTaskUsesFPU(), see portmacro.h.  Those that did get
+theirs from the heap. */
+#ifndef configNUM_FPU_CONTEXTS
+	#define configNUM_FPU_CONTEXTS 8
+#endif
+
+/* Set to 1 to have vApplicationFPUContextFailedHook() called when the FPU
+trap finds no floating point context left for a task, every time the task
+retries.  It runs in the trap with interrupts masked, so must not call the
+API. */
+#ifndef configUSE_FPU_CONTEXT_FAILED_HOOK
+	#define configUSE_FPU_CONTEXT_FAILED_HOOK 0
+#endif
+
 #ifndef configMAX_API_CALL_INTERRUPT_PRIORITY
 	#error configMAX_API_CALL_INTERRUPT_PRIORITY must be defined.  See http://www.freertos.org/Using-FreeRTOS-on-Cortex-A-Embedded-Processors.html
 #endif
@@ -86,11 +112,10 @@ this value. */
 (but the lowest) interrupt priority. */
 #define portUNMASK_VALUE				( 0xFFUL )
 
-/* Tasks are not created with a floating point context, but can be given a
-floating point context after they have been created.  A variable is stored as
+/* Tasks are not created with a floating point context, they are given one the
+first time they execute a floating point instruction.  A variable is stored as
 part of the tasks context that holds portNO_FLOATING_POINT_CONTEXT if the task
-does not have an FPU context, or any other value if the task does have an FPU
-context. */
+does not have an FPU context, or the address of its FPUContext_t if it does. */
 #define portNO_FLOATING_POINT_CONTEXT	( ( StackType_t ) 0 )
 
 /* Constants required to setup the initial task context. */
@@ -132,6 +157,26 @@ point is zero. */
 #define portMAX_8_BIT_VALUE							( ( uint8_t ) 0xff )
 #define portBIT_0_SET								( ( uint8_t ) 0x01 )
 
+/* Distributor registers used to interrupt the other cores. */
+#define portINTERRUPT_TARGET_REGISTER_OFFSET		0x800UL
+#define portSGI_REGISTER_OFFSET						0xF00UL
+#define portSGI_TARGET_LIST_SHIFT					16UL
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Where the floating point registers of a task are kept while another task
+ * uses the FPU.  The ASM code uses the offsets, keep them in line.
+ */
+typedef struct FPUContext
+{
+	uint64_t ullQ[ 64 ];		/* 0x000: Q0 to Q31. */
+	uint64_t ullFPSR;			/* 0x200 */
+	uint64_t ullFPCR;			/* 0x208 */
+	uint64_t ullSavedOnCore;	/* 0x210: Core number + 1 of the last save, 0 if never saved. */
+	uint64_t ullPadding;
+} __attribute__(( aligned( 16 ) )) FPUContext_t;
+
 /*-----------------------------------------------------------*/
 
 /*
@@ -140,25 +185,89 @@ point is zero. */
  */
 extern void vPortRestoreTaskContext( void );
 
+/*
+ * Gives the task running on the calling core a floating point context from the
+ * pool, or returns 0 when none is left.  Called by the FPU trap handler in
+ * portASM.S.
+ */
+uint64_t ullPortAllocateFPUContext( void );
+
+#if( configUSE_FPU_CONTEXT_FAILED_HOOK == 1 )
+	extern void vApplicationFPUContextFailedHook( void );
+#endif
+
+#if( configNUM_CORES > 1 )
+	/*
+	 * Reads the GIC CPU interface of the calling core, for vPortYieldCore().
+	 */
+	static void prvRecordCoreTarget( void );
+#endif
+
 /*-----------------------------------------------------------*/
 
+/* The variables below are per core, indexed by TPIDR_EL1 in the ASM code. */
+
 /* A variable is used to keep track of the critical section nesting.  This
 variable has to be stored as part of the task context and must be initialised to
 a non zero value to ensure interrupts don't inadvertently become unmasked before
 the scheduler starts.  As it is stored as part of the task context it will
 automatically be set to 0 when the first task is started. */
-volatile uint64_t ullCriticalNesting = 9999ULL;
+volatile uint64_t ullCriticalNesting[ configNUM_CORES ] = { [ 0 ... configNUM_CORES - 1 ] = 9999ULL };
 
 /* Saved as part of the task context.  If ullPortTaskHasFPUContext is non-zero
-then floating point context must be saved and restored for the task. */
-uint64_t ullPortTaskHasFPUContext = pdFALSE;
+it is the FPUContext_t of the task.  The floating point registers are saved
+into it when the task is switched out having used the FPU, and restored from it
+when the task first uses the FPU after being switched in again. */
+uint64_t ullPortTaskHasFPUContext[ configNUM_CORES ] = { pdFALSE };
+
+/* The FPUContext_t the floating point registers of each core hold, so a task
+that is switched back in before another task used the FPU on the same core
+does not restore its registers again. */
+uint64_t ullPortFPUContextLoaded[ configNUM_CORES ] = { 0 };
+
+/* The FPUContext_t of tasks that start using the FPU unannounced come from a
+pool, as they are allocated by the FPU trap handler. */
+static FPUContext_t xPortFPUContexts[ configNUM_FPU_CONTEXTS ];
+static StaticPool_t xPortFPUContextPoolBuffer;
+static PoolHandle_t xPortFPUContextPool = NULL;
+
+/* Loaded into the FPU when a task uses it for the first time, so the rounding
+mode and the register contents do not depend on the task that ran before. */
+__attribute__(( used )) const FPUContext_t xPortInitialFPUContext = { { 0 }, 0, 0, 0, 0 };
 
 /* Set to 1 to pend a context switch from an ISR. */
-uint64_t ullPortYieldRequired = pdFALSE;
+uint64_t ullPortYieldRequired[ configNUM_CORES ] = { pdFALSE };
 
 /* Counts the interrupt nesting depth.  A context switch is only performed if
 if the nesting depth is 0. */
-uint64_t ullPortInterruptNesting = 0;
+uint64_t ullPortInterruptNesting[ configNUM_CORES ] = { 0 };
+
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+	/* CNTVCT_EL0 when the scheduler was started, the run time stats count from
+	there. */
+	uint64_t ullPortRunTimeCounterBase = 0;
+#endif
+
+/* The TCB of the task running on each core, as an array so the ASM code can
+index it the same way with one core or many. */
+#if( configNUM_CORES > 1 )
+	extern void * volatile pxCurrentTCBs[ configNUM_CORES ];
+	__attribute__(( used )) void * volatile * const pxPortCurrentTCBs = pxCurrentTCBs;
+#else
+	extern void * volatile pxCurrentTCB;
+	__attribute__(( used )) void * volatile * const pxPortCurrentTCBs = &pxCurrentTCB;
+#endif
+
+#if( configNUM_CORES > 1 )
+	/* The owner of each spinlock, 0 when free or the number of the owning core
+	plus one, and how many times the owner has taken it. */
+	static volatile uint32_t ulPortLockOwner[ portNUM_LOCKS ] = { 0 };
+	static uint32_t ulPortLockCount[ portNUM_LOCKS ] = { 0 };
+
+	/* The GIC CPU interface of each core, as the target list bit used when
+	sending it an SGI. */
+	static uint8_t ucPortCoreTargets[ configNUM_CORES ] = { 0 };
+#endif
 
 /* Used in the ASM code. */
 __attribute__(( used )) const uint64_t ullICCEOIR = portICCEOIR_END_OF_INTERRUPT_REGISTER_ADDRESS;
@@ -254,9 +363,8 @@ StackType_t *pxPortInitialiseStack( StackType_t *pxTopOfStack, TaskFunction_t px
 	*pxTopOfStack = portNO_CRITICAL_NESTING;
 	pxTopOfStack--;
 
-	/* The task will start without a floating point context.  A task that uses
-	the floating point hardware must call vPortTaskUsesFPU() before executing
-	any floating point instructions. */
+	/* The task will start without a floating point context, it gets one when
+	it executes its first floating point instruction. */
 	*pxTopOfStack = portNO_FLOATING_POINT_CONTEXT;
 
 	return pxTopOfStack;
@@ -330,6 +438,29 @@ uint32_t ulAPSR;
 			executing. */
 			portDISABLE_INTERRUPTS();
 
+			/* Floating point contexts are handed out from here on, the FPU
+			trap is enabled as each core starts its first task. */
+			xPortFPUContextPool = xPoolCreateStatic( sizeof( FPUContext_t ), configNUM_FPU_CONTEXTS, ( uint8_t * ) xPortFPUContexts, &xPortFPUContextPoolBuffer );
+			configASSERT( xPortFPUContextPool );
+
+			#if( configNUM_CORES > 1 )
+			{
+				/* This is core 0 (TPIDR_EL1 is set by the start-up code).
+				Let the other cores reach it with portYIELD_CORE(), then
+				release them.  They pick their first task in
+				vPortStartSecondaryCore() and spin on the scheduler locks until
+				this core has started its own. */
+				prvRecordCoreTarget();
+				configSETUP_YIELD_INTERRUPT();
+				configSTART_SECONDARY_CORES();
+			}
+			#else
+			{
+				/* The ASM code indexes the per-core variables with TPIDR_EL1. */
+				__asm volatile ( "MSR TPIDR_EL1, XZR" ::: "memory" );
+			}
+			#endif
+
 			/* Start the timer that generates the tick ISR. */
 			configSETUP_TICK_INTERRUPT();
 
@@ -346,10 +477,119 @@ void vPortEndScheduler( void )
 {
 	/* Not implemented in ports where there is nothing to return to.
 	Artificially force an assert. */
-	configASSERT( ullCriticalNesting == 1000ULL );
+	configASSERT( ullCriticalNesting[ 0 ] == 1000ULL );
 }
 /*-----------------------------------------------------------*/
 
+#if( configNUM_CORES > 1 )
+
+	static void prvRecordCoreTarget( void )
+	{
+	volatile uint32_t * const pulFirstTargetRegister = ( volatile uint32_t * ) ( configINTERRUPT_CONTROLLER_BASE_ADDRESS + portINTERRUPT_TARGET_REGISTER_OFFSET );
+
+		/* The first target registers are banked, each core reads back its own
+		CPU interface bit in the target field of the SGIs. */
+		ucPortCoreTargets[ portGET_CORE_ID() ] = ( uint8_t ) ( *pulFirstTargetRegister & 0xFFUL );
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortStartSecondaryCore( void )
+	{
+		/* Interrupts stay masked until the first task on this core starts. */
+		portDISABLE_INTERRUPTS();
+
+		prvRecordCoreTarget();
+		configSETUP_YIELD_INTERRUPT();
+
+		/* Pick the highest priority task not already running on another core,
+		the locks taken by vTaskSwitchContext() order this against core 0
+		starting the scheduler. */
+		vTaskSwitchContext();
+
+		/* Start the first task executing. */
+		vPortRestoreTaskContext();
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortYieldCore( UBaseType_t uxCore )
+	{
+	volatile uint32_t * const pulSGIRegister = ( volatile uint32_t * ) ( configINTERRUPT_CONTROLLER_BASE_ADDRESS + portSGI_REGISTER_OFFSET );
+
+		if( uxCore == portGET_CORE_ID() )
+		{
+			portYIELD();
+		}
+		else
+		{
+			/* Make the writes that made the other core's yield necessary
+			visible before the interrupt arrives. */
+			__asm volatile ( "DSB ISHST" ::: "memory" );
+			*pulSGIRegister = ( ( uint32_t ) ucPortCoreTargets[ uxCore ] << portSGI_TARGET_LIST_SHIFT ) | portYIELD_CORE_SGI;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	void FreeRTOS_Yield_Handler( void )
+	{
+		/* Another core wants this one to reschedule, the switch happens on
+		the way out of the IRQ handler. */
+		ullPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortRecursiveLockAcquire( UBaseType_t uxLock )
+	{
+	volatile uint32_t * const pulOwner = &( ulPortLockOwner[ uxLock ] );
+	const uint32_t ulCore = ( uint32_t ) portGET_CORE_ID() + 1UL;
+	uint32_t ulValue, ulFailed;
+
+		/* Interrupts are masked, so only this core can have set the owner to
+		its own number. */
+		if( *pulOwner == ulCore )
+		{
+			ulPortLockCount[ uxLock ]++;
+		}
+		else
+		{
+			/* Wait for the lock to become free, sleeping until the owner's
+			release clears the exclusive monitor, then claim it.  The load
+			acquire keeps the accesses the lock guards after the claim.  Only a
+			lock seen held waits for an event: a failed store exclusive has
+			cleared the monitor, so nothing would signal a WFE after it, and
+			the claim is retried from the load straight away. */
+			__asm volatile (
+				"	SEVL					\n"
+				"1:	WFE						\n"
+				"2:	LDAXR	%w0, [%2]		\n"
+				"	CBNZ	%w0, 1b			\n"
+				"	STXR	%w1, %w3, [%2]	\n"
+				"	CBNZ	%w1, 2b			\n"
+				: "=&r" ( ulValue ), "=&r" ( ulFailed )
+				: "r" ( pulOwner ), "r" ( ulCore )
+				: "memory" );
+
+			ulPortLockCount[ uxLock ] = 1UL;
+		}
+	}
+	/*-----------------------------------------------------------*/
+
+	void vPortRecursiveLockRelease( UBaseType_t uxLock )
+	{
+		configASSERT( ulPortLockOwner[ uxLock ] == ( uint32_t ) portGET_CORE_ID() + 1UL );
+
+		ulPortLockCount[ uxLock ]--;
+
+		if( ulPortLockCount[ uxLock ] == 0UL )
+		{
+			/* The store release orders the guarded accesses before the lock is
+			seen free, and wakes cores waiting in WFE. */
+			__asm volatile ( "STLR	WZR, [%0]" :: "r" ( &( ulPortLockOwner[ uxLock ] ) ) : "memory" );
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
 void vPortEnterCritical( void )
 {
 	/* Mask interrupts up to the max syscall interrupt priority. */
@@ -358,34 +598,36 @@ void vPortEnterCritical( void )
 	/* Now interrupts are disabled ullCriticalNesting can be accessed
 	directly.  Increment ullCriticalNesting to keep a count of how many times
 	portENTER_CRITICAL() has been called. */
-	ullCriticalNesting++;
+	ullCriticalNesting[ 0 ]++;
 
 	/* This is not the interrupt safe version of the enter critical function so
 	assert() if it is being called from an interrupt context.  Only API
 	functions that end in "FromISR" can be used in an interrupt.  Only assert if
 	the critical nesting count is 1 to protect against recursive calls if the
 	assert function also uses a critical section. */
-	if( ullCriticalNesting == 1ULL )
+	if( ullCriticalNesting[ 0 ] == 1ULL )
 	{
-		configASSERT( ullPortInterruptNesting == 0 );
+		configASSERT( ullPortInterruptNesting[ 0 ] == 0 );
+		traceCRITICAL_ENTER();
 	}
 }
 /*-----------------------------------------------------------*/
 
 void vPortExitCritical( void )
 {
-	if( ullCriticalNesting > portNO_CRITICAL_NESTING )
+	if( ullCriticalNesting[ 0 ] > portNO_CRITICAL_NESTING )
 	{
 		/* Decrement the nesting count as the critical section is being
 		exited. */
-		ullCriticalNesting--;
+		ullCriticalNesting[ 0 ]--;
 
 		/* If the nesting level has reached zero then all interrupt
 		priorities must be re-enabled. */
-		if( ullCriticalNesting == portNO_CRITICAL_NESTING )
+		if( ullCriticalNesting[ 0 ] == portNO_CRITICAL_NESTING )
 		{
 			/* Critical nesting has reached zero so all interrupt priorities
 			should be unmasked. */
+			traceCRITICAL_EXIT();
 			portCLEAR_INTERRUPT_MASK();
 		}
 	}
@@ -394,28 +636,20 @@ void vPortExitCritical( void )
 
 void FreeRTOS_Tick_Handler( void )
 {
-	/* Must be the lowest possible priority. */
+	/* Must be at or below the maximum API call priority. */
 	#if !defined( QEMU )
 	{
-		configASSERT( portICCRPR_RUNNING_PRIORITY_REGISTER == ( uint32_t ) ( portLOWEST_USABLE_INTERRUPT_PRIORITY << portPRIORITY_SHIFT ) );
+		configASSERT( portICCRPR_RUNNING_PRIORITY_REGISTER >= ( uint32_t ) ( configMAX_API_CALL_INTERRUPT_PRIORITY << portPRIORITY_SHIFT ) );
 	}
 	#endif
 
-	/* Interrupts should not be enabled before this point. */
-	#if( configASSERT_DEFINED == 1 )
-	{
-		uint32_t ulMaskBits;
-
-		__asm volatile( "mrs %0, daif" : "=r"( ulMaskBits ) :: "memory" );
-		configASSERT( ( ulMaskBits & portDAIF_I ) != 0 );
-	}
-	#endif /* configASSERT_DEFINED */
-
-	/* Set interrupt mask before altering scheduler structures.   The tick
-	handler runs at the lowest priority, so interrupts cannot already be masked,
-	so there is no need to save and restore the current mask value.  It is
-	necessary to turn off interrupts in the CPU itself while the ICCPMR is being
-	updated. */
+	/* Set interrupt mask before altering scheduler structures.  The tick
+	handler runs at or below the maximum API call priority, so the mask cannot
+	already be set when it is taken, so there is no need to save and restore the
+	current mask value.  It is necessary to turn off interrupts in the CPU
+	itself while the ICCPMR is being updated, the IRQ handler may have left
+	them enabled so higher priority interrupts can nest. */
+	portDISABLE_INTERRUPTS();
 	portICCPMR_PRIORITY_MASK_REGISTER = ( uint32_t ) ( configMAX_API_CALL_INTERRUPT_PRIORITY << portPRIORITY_SHIFT );
 	__asm volatile (	"dsb sy		\n"
 						"isb sy		\n" ::: "memory" );
@@ -427,7 +661,7 @@ void FreeRTOS_Tick_Handler( void )
 	/* Increment the RTOS tick. */
 	if( xTaskIncrementTick() != pdFALSE )
 	{
-		ullPortYieldRequired = pdTRUE;
+		ullPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;
 	}
 
 	/* Ensure all interrupt priorities are active again. */
@@ -435,14 +669,119 @@ void FreeRTOS_Tick_Handler( void )
 }
 /*-----------------------------------------------------------*/
 
-void vPortTaskUsesFPU( void )
+BaseType_t xPortTaskUsesFPU( void )
+{
+FPUContext_t *pxContext = NULL;
+BaseType_t xReturn = pdPASS;
+
+	/* Optional, a task that uses the FPU gets its floating point context on
+	its first floating point instruction anyway, from the pool.  A task that
+	calls this first gets a context of its own from the heap instead, so it
+	can not find the pool empty, and learns here if there is no memory for
+	it. */
+	#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	{
+		pxContext = ( FPUContext_t * ) pvPortMalloc( sizeof( FPUContext_t ) );
+	}
+	#endif
+
+	portENTER_CRITICAL();
+	{
+		if( ullPortTaskHasFPUContext[ portGET_CORE_ID() ] == portNO_FLOATING_POINT_CONTEXT )
+		{
+			if( pxContext == NULL )
+			{
+				pxContext = ( FPUContext_t * ) pvPoolAlloc( xPortFPUContextPool );
+			}
+
+			if( pxContext != NULL )
+			{
+				/* Nothing to restore yet, the trap handler loads
+				xPortInitialFPUContext instead. */
+				pxContext->ullSavedOnCore = 0ULL;
+				ullPortTaskHasFPUContext[ portGET_CORE_ID() ] = ( uint64_t ) pxContext;
+				pxContext = NULL;
+			}
+			else
+			{
+				xReturn = pdFAIL;
+			}
+		}
+	}
+	portEXIT_CRITICAL();
+
+	#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+	{
+		/* The task already had a context. */
+		vPortFree( pxContext );
+	}
+	#endif
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t ullPortAllocateFPUContext( void )
 {
-	/* A task is registering the fact that it needs an FPU context.  Set the
-	FPU flag (which is saved as part of the task context). */
-	ullPortTaskHasFPUContext = pdTRUE;
+FPUContext_t *pxContext;
+
+	/* Called by the FPU trap handler with interrupts masked, on behalf of the
+	task running on this core. */
+	pxContext = ( FPUContext_t * ) pvPoolAlloc( xPortFPUContextPool );
 
-	/* Consider initialising the FPSR here - but probably not necessary in
-	AArch64. */
+	if( pxContext == NULL )
+	{
+		/* configNUM_FPU_CONTEXTS is too low for the tasks that did not call
+		xPortTaskUsesFPU().  The trap handler leaves the FPU disabled, so the
+		instruction traps again when the task resumes: the task waits, and
+		can be preempted, until a deleted task gives a context back. */
+		#if( configUSE_FPU_CONTEXT_FAILED_HOOK == 1 )
+		{
+			vApplicationFPUContextFailedHook();
+		}
+		#endif
+
+		return 0ULL;
+	}
+
+	/* Nothing to restore yet, the trap handler loads xPortInitialFPUContext
+	instead. */
+	pxContext->ullSavedOnCore = 0ULL;
+	ullPortTaskHasFPUContext[ portGET_CORE_ID() ] = ( uint64_t ) pxContext;
+
+	return ( uint64_t ) pxContext;
+}
+/*-----------------------------------------------------------*/
+
+void vPortCleanUpTCB( void *pxTCB )
+{
+const StackType_t *pxTopOfStack;
+FPUContext_t *pxContext;
+
+	/* The task is not running, so its context is saved on its stack with the
+	FPU context pointer at the top.  pxTopOfStack is the first member of the
+	TCB. */
+	pxTopOfStack = *( StackType_t ** ) pxTCB;
+	pxContext = ( FPUContext_t * ) pxTopOfStack[ 0 ];
+
+	if( pxContext != NULL )
+	{
+		/* A core may still have it loaded, ullSavedOnCore is cleared when it
+		is handed out again so that core does not take its registers as up
+		to date. */
+		if( xPoolContains( xPortFPUContextPool, pxContext ) != pdFALSE )
+		{
+			vPoolFree( xPortFPUContextPool, pxContext );
+		}
+		else
+		{
+			#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+			{
+				vPortFree( pxContext );
+			}
+			#endif
+		}
+	}
 }
 /*-----------------------------------------------------------*/
 
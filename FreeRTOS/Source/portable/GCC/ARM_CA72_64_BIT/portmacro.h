@@ -72,24 +72,44 @@ not need to be guarded with a critical section. */
 
 /*-----------------------------------------------------------*/
 
+/* Multi-core support. */
+
+/* TPIDR_EL1 holds the number of the core, 0 to configNUM_CORES - 1.  The
+start-up code sets it on each core before main() or vPortStartSecondaryCore()
+is called, the port's per-core variables are indexed by it. */
+#if( configNUM_CORES > 1 )
+	static inline UBaseType_t uxPortGetCoreID( void )
+	{
+	UBaseType_t uxCoreID;
+
+		__asm volatile ( "MRS %0, TPIDR_EL1" : "=r" ( uxCoreID ) );
+		return uxCoreID;
+	}
+	#define portGET_CORE_ID()		uxPortGetCoreID()
+#else
+	#define portGET_CORE_ID()		( ( UBaseType_t ) 0 )
+#endif
+
+/*-----------------------------------------------------------*/
+
 /* Task utilities. */
 
 /* Called at the end of an ISR that can cause a context switch. */
 #define portEND_SWITCHING_ISR( xSwitchRequired )\
 {												\
-extern uint64_t ullPortYieldRequired;			\
+extern uint64_t ullPortYieldRequired[];			\
 												\
 	if( xSwitchRequired != pdFALSE )			\
 	{											\
-		ullPortYieldRequired = pdTRUE;			\
+		ullPortYieldRequired[ portGET_CORE_ID() ] = pdTRUE;	\
 	}											\
 }
 
 #define portYIELD_FROM_ISR( x ) portEND_SWITCHING_ISR( x )
 #if defined( GUEST )
-	#define portYIELD() __asm volatile ( "SVC 0" ::: "memory" )
+	#define portYIELD() do { traceTASK_YIELD(); __asm volatile ( "SVC 0" ::: "memory" ); } while( 0 )
 #else
-	#define portYIELD() __asm volatile ( "SMC 0" ::: "memory" )
+	#define portYIELD() do { traceTASK_YIELD(); __asm volatile ( "SMC 0" ::: "memory" ); } while( 0 )
 #endif
 /*-----------------------------------------------------------
  * Critical section control
@@ -112,12 +132,84 @@ extern void vPortInstallFreeRTOSVectorTable( void );
 	__asm volatile ( "ISB SY" );
 
 
-/* These macros do not globally disable/enable interrupts.  They do mask off
-interrupts that have a priority below configMAX_API_CALL_INTERRUPT_PRIORITY. */
-#define portENTER_CRITICAL()		vPortEnterCritical();
-#define portEXIT_CRITICAL()			vPortExitCritical();
-#define portSET_INTERRUPT_MASK_FROM_ISR()		uxPortSetInterruptMask()
-#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	vPortClearInterruptMask(x)
+#if( configNUM_CORES == 1 )
+
+	/* These macros do not globally disable/enable interrupts.  They do mask off
+	interrupts that have a priority below configMAX_API_CALL_INTERRUPT_PRIORITY. */
+	#define portENTER_CRITICAL()		vPortEnterCritical();
+	#define portEXIT_CRITICAL()			vPortExitCritical();
+	#define portSET_INTERRUPT_MASK_FROM_ISR()		uxPortSetInterruptMask()
+	#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	vPortClearInterruptMask(x)
+
+#else
+
+	/* With more than one core a critical section has to keep the other cores
+	out as well as the interrupts of this core.  Interrupts are masked in the
+	CPU, so the tick and other handlers above the API priority cannot run on
+	this core, and tasks.c takes the spinlocks below to keep the other cores
+	out. */
+	extern void vTaskEnterCritical( void );
+	extern void vTaskExitCritical( void );
+	extern UBaseType_t uxTaskEnterCriticalFromISR( void );
+	extern void vTaskExitCriticalFromISR( UBaseType_t uxSavedInterruptStatus );
+
+	#define portENTER_CRITICAL()		vTaskEnterCritical();
+	#define portEXIT_CRITICAL()			vTaskExitCritical();
+	#define portSET_INTERRUPT_MASK_FROM_ISR()		uxTaskEnterCriticalFromISR()
+	#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)	vTaskExitCriticalFromISR(x)
+
+	/* Mask IRQs in the CPU, returning the previous DAIF value. */
+	static inline UBaseType_t uxPortDisableInterrupts( void )
+	{
+	UBaseType_t uxDAIF;
+
+		__asm volatile ( "MRS %0, DAIF		\n"
+						 "MSR DAIFSET, #2	\n" : "=r" ( uxDAIF ) :: "memory" );
+		return uxDAIF;
+	}
+
+	static inline void vPortRestoreInterrupts( UBaseType_t uxDAIF )
+	{
+		__asm volatile ( "MSR DAIF, %0" :: "r" ( uxDAIF ) : "memory" );
+	}
+
+	/* Recursive spinlocks, owned by a core rather than by a task.  The task
+	lock serialises the task level code of the kernel (critical sections and
+	scheduler suspension), the ISR lock additionally guards the data the
+	interrupt safe API uses.  Interrupts must be masked on the calling core
+	while a lock is acquired or released. */
+	#define portTASK_LOCK				( 0U )
+	#define portISR_LOCK				( 1U )
+	#define portNUM_LOCKS				( 2U )
+
+	void vPortRecursiveLockAcquire( UBaseType_t uxLock );
+	void vPortRecursiveLockRelease( UBaseType_t uxLock );
+
+	#define portGET_TASK_LOCK()			vPortRecursiveLockAcquire( portTASK_LOCK )
+	#define portRELEASE_TASK_LOCK()		vPortRecursiveLockRelease( portTASK_LOCK )
+	#define portGET_ISR_LOCK()			vPortRecursiveLockAcquire( portISR_LOCK )
+	#define portRELEASE_ISR_LOCK()		vPortRecursiveLockRelease( portISR_LOCK )
+
+	/* The critical nesting depth of the core, kept in the port so it is saved
+	with the task context. */
+	extern volatile uint64_t ullCriticalNesting[];
+	#define portGET_CRITICAL_NESTING_COUNT()		( ullCriticalNesting[ portGET_CORE_ID() ] )
+	#define portINCREMENT_CRITICAL_NESTING_COUNT()	( ullCriticalNesting[ portGET_CORE_ID() ]++ )
+	#define portDECREMENT_CRITICAL_NESTING_COUNT()	( ullCriticalNesting[ portGET_CORE_ID() ]-- )
+
+	/* Software generated interrupt used to make another core yield.  Its
+	handler, FreeRTOS_Yield_Handler(), must be installed on every core by
+	configSETUP_YIELD_INTERRUPT(). */
+	#define portYIELD_CORE_SGI			( 0U )
+	void vPortYieldCore( UBaseType_t uxCore );
+	void FreeRTOS_Yield_Handler( void );
+	#define portYIELD_CORE( x )			vPortYieldCore( x )
+
+	/* Called by the start-up code of cores 1 to configNUM_CORES - 1 once
+	configSTART_SECONDARY_CORES() has released them.  Does not return. */
+	void vPortStartSecondaryCore( void );
+
+#endif /* configNUM_CORES */
 
 /*-----------------------------------------------------------*/
 
@@ -131,10 +223,42 @@ macros is used. */
 handler for whichever peripheral is used to generate the RTOS tick. */
 void FreeRTOS_Tick_Handler( void );
 
-/* Any task that uses the floating point unit MUST call vPortTaskUsesFPU()
-before any floating point instructions are executed. */
-void vPortTaskUsesFPU( void );
-#define portTASK_USES_FLOATING_POINT() vPortTaskUsesFPU()
+/* The run time stats clock is CNTVCT_EL0, the virtual count of the generic
+timer, counted from the start of the scheduler.  It runs at CNTFRQ_EL0 on all
+cores and is 64 bits wide, so configRUN_TIME_COUNTER_TYPE should be uint64_t -
+at 54MHz a 32-bit count wraps after 80 seconds. */
+#if( configGENERATE_RUN_TIME_STATS == 1 )
+	extern uint64_t ullPortRunTimeCounterBase;
+
+	static inline uint64_t ullPortReadVirtualCount( void )
+	{
+	uint64_t ullCount;
+
+		__asm volatile ( "ISB SY					\n"
+						 "MRS %0, CNTVCT_EL0	\n" : "=r" ( ullCount ) :: "memory" );
+		return ullCount;
+	}
+
+	#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()	( ullPortRunTimeCounterBase = ullPortReadVirtualCount() )
+	#define portGET_RUN_TIME_COUNTER_VALUE()			( ullPortReadVirtualCount() - ullPortRunTimeCounterBase )
+#endif
+
+/* Floating point and NEON registers are switched lazily.  The FPU is disabled
+when a task is switched in, and the first floating point instruction of the
+task traps so its registers can be restored - tasks that do not use the FPU
+never have them saved or restored.  A task gets its floating point context on
+its first floating point instruction, from a pool of configNUM_FPU_CONTEXTS.
+A task that finds the pool empty waits in the trap until a context is freed.
+Calling xPortTaskUsesFPU() before is optional: it gives the task a context
+from the heap instead, and returns pdFAIL if there is no memory for one.
+Interrupt handlers and the kernel must not use the floating point registers,
+build them with -mgeneral-regs-only. */
+BaseType_t xPortTaskUsesFPU( void );
+#define portTASK_USES_FLOATING_POINT() xPortTaskUsesFPU()
+
+/* Frees the floating point context of a deleted task. */
+void vPortCleanUpTCB( void *pxTCB );
+#define portCLEAN_UP_TCB( pxTCB ) vPortCleanUpTCB( pxTCB )
 
 #define portLOWEST_INTERRUPT_PRIORITY ( ( ( uint32_t ) configUNIQUE_INTERRUPT_PRIORITIES ) - 1UL )
 #define portLOWEST_USABLE_INTERRUPT_PRIORITY ( portLOWEST_INTERRUPT_PRIORITY - 1UL )
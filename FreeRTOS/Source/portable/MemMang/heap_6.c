@@ -0,0 +1,752 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/*
+ * A sample implementation of pvPortMalloc() and vPortFree() in which both
+ * functions execute in constant time, freed blocks are combined (coalesced)
+ * with their neighbours, and the heap can span multiple non-contiguous
+ * regions.
+ *
+ * See heap_1.c, heap_2.c, heap_3.c, heap_4.c and heap_5.c for alternative
+ * implementations, and the memory management pages of http://www.FreeRTOS.org
+ * for more information.
+ *
+ * Free blocks are kept in segregated free lists indexed by a two level map
+ * of their size (the first level is the power of two, the second level splits
+ * each power of two into heapSL_COUNT ranges), with a bitmap per level so the
+ * smallest non-empty list that is guaranteed to satisfy a request is found
+ * without searching.  Only when there is no such list is the list of the
+ * requested size searched, so a request fails only when no free block is
+ * large enough.  Every block carries a pointer to the block before it in
+ * memory, so a block being freed is merged with both neighbours without
+ * walking any list.
+ *
+ * Blocks up to configHEAP_QUICK_LIST_MAX_SIZE bytes (the socket, TCB and queue
+ * structures that are created and deleted over and over) are not merged when
+ * they are freed but kept on an exact size quick list, so the next request of
+ * the same size is a single pop.  Quick list blocks are handed back to the
+ * coalescing lists when a request can not be met otherwise.
+ *
+ * Usage notes:
+ *
+ * The heap starts out with the configTOTAL_HEAP_SIZE byte ucHeap array, as in
+ * heap_4.  vPortDefineHeapRegions() can be called at any time to add further
+ * blocks of memory to the heap.  The array of HeapRegion_t structures passed
+ * to it is terminated by a NULL zero sized region definition, the regions do
+ * not have to appear in address order.
+ *
+ * xPortGetMinimumEverFreeHeapSize() gives the high water mark of the heap and
+ * xPortGetHeapFragmentation() the part of the free space not in the largest
+ * free block.
+ */
+#include <stdlib.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+	#error This file must not be used if configSUPPORT_DYNAMIC_ALLOCATION is 0
+#endif
+
+/* Blocks up to this size, including the block header, are kept on the quick
+lists when they are freed. */
+#ifndef configHEAP_QUICK_LIST_MAX_SIZE
+	#define configHEAP_QUICK_LIST_MAX_SIZE	1024
+#endif
+
+/* Block sizes must not get too small - a free block has to hold the free list
+links as well as the header. */
+#define heapMINIMUM_BLOCK_SIZE	( ( size_t ) ( ( sizeof( BlockLink_t ) + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK ) ) )
+
+/* The size member of a block is a multiple of portBYTE_ALIGNMENT, the low bits
+hold the state of the block.  A block with neither bit set belongs to the
+application. */
+#define heapBLOCK_FREE			( ( size_t ) 0x01 )
+#define heapBLOCK_QUICK			( ( size_t ) 0x02 )
+#define heapBLOCK_STATE_MASK	( heapBLOCK_FREE | heapBLOCK_QUICK )
+#define heapBLOCK_SIZE( pxBlock )	( ( pxBlock )->xBlockSize & ~heapBLOCK_STATE_MASK )
+
+/* Second level: each power of two is split into 2^heapSL_LOG2 lists. */
+#define heapSL_LOG2				( 4 )
+#define heapSL_COUNT			( 1U << heapSL_LOG2 )
+
+/* Blocks below heapSMALL_BLOCK bytes all go to the first level 0 lists, one
+list per portBYTE_ALIGNMENT step. */
+#define heapSMALL_BLOCK			( ( size_t ) heapSL_COUNT * portBYTE_ALIGNMENT )
+
+/* First level lists, enough for blocks below 2GB. */
+#define heapFL_COUNT			( 25 )
+#define heapMAXIMUM_BLOCK_SIZE	( ( size_t ) 0x7FFFFFF0UL )
+
+#define heapQUICK_LIST_COUNT	( ( configHEAP_QUICK_LIST_MAX_SIZE / portBYTE_ALIGNMENT ) + 1 )
+
+/* Index of the most/least significant set bit, x must not be 0. */
+#ifndef heapFLS
+	#define heapFLS( x )		( ( UBaseType_t ) ( 63 - __builtin_clzll( ( unsigned long long ) ( x ) ) ) )
+#endif
+#ifndef heapFFS
+	#define heapFFS( x )		( ( UBaseType_t ) __builtin_ctz( ( unsigned int ) ( x ) ) )
+#endif
+
+/* The block header.  Only the first two members are present in a block that
+belongs to the application, the free list links use the start of the space
+that is otherwise handed to the application. */
+typedef struct A_BLOCK_LINK
+{
+	struct A_BLOCK_LINK *pxPrevPhysBlock;	/*<< The block before this one in memory, NULL for the first block of a region. */
+	size_t xBlockSize;						/*<< The size of the block, including this header, plus the heapBLOCK_ state bits. */
+	struct A_BLOCK_LINK *pxNextFreeBlock;	/*<< The next block in the free or quick list. */
+	struct A_BLOCK_LINK *pxPrevFreeBlock;	/*<< The previous block in the free list. */
+} BlockLink_t;
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Called automatically to add ucHeap to the heap on the first call to
+ * pvPortMalloc() or vPortDefineHeapRegions().
+ */
+static void prvHeapInit( void );
+
+/*
+ * Turns the memory from pucStartAddress into a single free block followed by
+ * an end marker block.
+ */
+static void prvAddRegion( uint8_t *pucStartAddress, size_t xSizeInBytes );
+
+/*
+ * Insert a free block into, or remove it from, the free list that matches its
+ * size.
+ */
+static void prvInsertFreeBlock( BlockLink_t *pxBlock );
+static void prvRemoveFreeBlock( BlockLink_t *pxBlock );
+
+/*
+ * Return the first block from the smallest non-empty free list that only
+ * holds blocks of at least xWantedSize bytes.  When there is none, the list
+ * xWantedSize itself maps to is searched for a block that is large enough,
+ * NULL is returned if that fails as well.
+ */
+static BlockLink_t *prvFindFreeBlock( size_t xWantedSize );
+
+/*
+ * Merge a block that is no longer in use with the blocks before and after it
+ * if they are free, then insert the result into the free lists.
+ */
+static void prvReleaseBlock( BlockLink_t *pxBlock );
+
+/*
+ * Hand every block on the quick lists back to the free lists.
+ */
+static void prvFlushQuickLists( void );
+
+/*-----------------------------------------------------------*/
+
+/* Allocate the memory for the heap. */
+#if( configAPPLICATION_ALLOCATED_HEAP == 1 )
+	/* The application writer has already defined the array used for the RTOS
+	heap - probably so it can be placed in a special segment or address. */
+	extern uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#else
+	static uint8_t ucHeap[ configTOTAL_HEAP_SIZE ];
+#endif /* configAPPLICATION_ALLOCATED_HEAP */
+
+/* The size of the header placed at the beginning of each allocated memory
+block must by correctly byte aligned. */
+static const size_t xHeapStructSize	= ( offsetof( BlockLink_t, pxNextFreeBlock ) + ( ( size_t ) ( portBYTE_ALIGNMENT - 1 ) ) ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+/* The free lists and the bitmaps of the non-empty ones. */
+static BlockLink_t *pxFreeLists[ heapFL_COUNT ][ heapSL_COUNT ];
+static uint32_t ulFLBitmap = 0;
+static uint32_t ulSLBitmap[ heapFL_COUNT ];
+
+/* The quick lists, indexed by block size / portBYTE_ALIGNMENT. */
+static BlockLink_t *pxQuickLists[ heapQUICK_LIST_COUNT ];
+static size_t xQuickBytes = 0U;
+
+static BaseType_t xHeapInitialised = pdFALSE;
+
+/* Keeps track of the number of calls to allocate and free memory as well as the
+number of free bytes remaining, including the blocks on the quick lists. */
+static size_t xFreeBytesRemaining = 0U;
+static size_t xMinimumEverFreeBytesRemaining = 0U;
+static size_t xNumberOfSuccessfulAllocations = 0;
+static size_t xNumberOfSuccessfulFrees = 0;
+
+/*-----------------------------------------------------------*/
+
+static void prvMapSize( size_t xSize, UBaseType_t *puxFL, UBaseType_t *puxSL )
+{
+UBaseType_t uxBit;
+
+	if( xSize < heapSMALL_BLOCK )
+	{
+		*puxFL = 0;
+		*puxSL = ( UBaseType_t ) ( xSize / portBYTE_ALIGNMENT );
+	}
+	else
+	{
+		uxBit = heapFLS( xSize );
+		*puxFL = uxBit - heapFLS( heapSMALL_BLOCK ) + 1;
+		*puxSL = ( UBaseType_t ) ( xSize >> ( uxBit - heapSL_LOG2 ) ) & ( heapSL_COUNT - 1 );
+	}
+}
+/*-----------------------------------------------------------*/
+
+void *pvPortMalloc( size_t xWantedSize )
+{
+BlockLink_t *pxBlock, *pxNewBlockLink, *pxNextBlock;
+void *pvReturn = NULL;
+size_t xBlockSize;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		/* Requests too large for the free lists fail, this also catches the
+		wrap around when the header is added. */
+		if( ( xWantedSize > 0 ) && ( xWantedSize < heapMAXIMUM_BLOCK_SIZE - xHeapStructSize ) )
+		{
+			/* The wanted size is increased so it can contain the header in
+			addition to the requested amount of bytes, and rounded up so that
+			blocks are always aligned to the required number of bytes. */
+			xWantedSize += xHeapStructSize;
+			xWantedSize = ( xWantedSize + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+			if( xWantedSize < heapMINIMUM_BLOCK_SIZE )
+			{
+				xWantedSize = heapMINIMUM_BLOCK_SIZE;
+			}
+
+			/* Reuse a block of exactly this size if one is on the quick
+			list. */
+			if( ( xWantedSize <= configHEAP_QUICK_LIST_MAX_SIZE ) && ( pxQuickLists[ xWantedSize / portBYTE_ALIGNMENT ] != NULL ) )
+			{
+				pxBlock = pxQuickLists[ xWantedSize / portBYTE_ALIGNMENT ];
+				pxQuickLists[ xWantedSize / portBYTE_ALIGNMENT ] = pxBlock->pxNextFreeBlock;
+				xQuickBytes -= xWantedSize;
+			}
+			else
+			{
+				pxBlock = prvFindFreeBlock( xWantedSize );
+
+				if( ( pxBlock == NULL ) && ( xQuickBytes != 0U ) )
+				{
+					/* The memory may be held on the quick lists. */
+					prvFlushQuickLists();
+					pxBlock = prvFindFreeBlock( xWantedSize );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				if( pxBlock != NULL )
+				{
+					prvRemoveFreeBlock( pxBlock );
+					xBlockSize = heapBLOCK_SIZE( pxBlock );
+
+					/* If the block is larger than required it can be split into
+					two. */
+					if( ( xBlockSize - xWantedSize ) >= heapMINIMUM_BLOCK_SIZE )
+					{
+						/* The block following the bytes requested becomes a
+						free block of its own.  It can not be merged with the
+						block after it as free blocks never border each other.
+						The void cast is used to prevent byte alignment warnings
+						from the compiler. */
+						pxNewBlockLink = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xWantedSize );
+						pxNewBlockLink->xBlockSize = ( xBlockSize - xWantedSize ) | heapBLOCK_FREE;
+						pxNewBlockLink->pxPrevPhysBlock = pxBlock;
+
+						pxNextBlock = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+						pxNextBlock->pxPrevPhysBlock = pxNewBlockLink;
+
+						pxBlock->xBlockSize = xWantedSize;
+						prvInsertFreeBlock( pxNewBlockLink );
+					}
+					else
+					{
+						pxBlock->xBlockSize = xBlockSize;
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+
+			if( pxBlock != NULL )
+			{
+				/* The block is being returned - it is allocated and owned by
+				the application. */
+				pxBlock->xBlockSize &= ~heapBLOCK_STATE_MASK;
+				xFreeBytesRemaining -= pxBlock->xBlockSize;
+
+				if( xFreeBytesRemaining < xMinimumEverFreeBytesRemaining )
+				{
+					xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				/* Return the memory space pointed to - jumping over the header
+				at its start. */
+				pvReturn = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xHeapStructSize );
+				xNumberOfSuccessfulAllocations++;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		traceMALLOC( pvReturn, xWantedSize );
+	}
+	( void ) xTaskResumeAll();
+
+	#if( configUSE_MALLOC_FAILED_HOOK == 1 )
+	{
+		if( pvReturn == NULL )
+		{
+			extern void vApplicationMallocFailedHook( void );
+			vApplicationMallocFailedHook();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif
+
+	configASSERT( ( ( ( size_t ) pvReturn ) & ( size_t ) portBYTE_ALIGNMENT_MASK ) == 0 );
+	return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vPortFree( void *pv )
+{
+uint8_t *puc = ( uint8_t * ) pv;
+BlockLink_t *pxLink;
+size_t xBlockSize;
+
+	if( pv != NULL )
+	{
+		/* The memory being freed will have a header immediately before it. */
+		puc -= xHeapStructSize;
+
+		/* This casting is to keep the compiler from issuing warnings. */
+		pxLink = ( void * ) puc;
+
+		/* Check the block is actually allocated. */
+		configASSERT( ( pxLink->xBlockSize & heapBLOCK_STATE_MASK ) == 0 );
+
+		if( ( pxLink->xBlockSize & heapBLOCK_STATE_MASK ) == 0 )
+		{
+			xBlockSize = pxLink->xBlockSize;
+
+			vTaskSuspendAll();
+			{
+				xFreeBytesRemaining += xBlockSize;
+				traceFREE( pv, xBlockSize );
+
+				if( xBlockSize <= configHEAP_QUICK_LIST_MAX_SIZE )
+				{
+					/* Keep the block for the next request of the same size. */
+					pxLink->xBlockSize |= heapBLOCK_QUICK;
+					pxLink->pxNextFreeBlock = pxQuickLists[ xBlockSize / portBYTE_ALIGNMENT ];
+					pxQuickLists[ xBlockSize / portBYTE_ALIGNMENT ] = pxLink;
+					xQuickBytes += xBlockSize;
+				}
+				else
+				{
+					prvReleaseBlock( pxLink );
+				}
+
+				xNumberOfSuccessfulFrees++;
+			}
+			( void ) xTaskResumeAll();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetFreeHeapSize( void )
+{
+	return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetMinimumEverFreeHeapSize( void )
+{
+	return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+size_t xPortGetHeapFragmentation( void )
+{
+HeapStats_t xHeapStats;
+
+	vPortGetHeapStats( &xHeapStats );
+
+	if( xHeapStats.xAvailableHeapSpaceInBytes == 0 )
+	{
+		return 0;
+	}
+
+	return 100 - ( ( xHeapStats.xSizeOfLargestFreeBlockInBytes * 100 ) / xHeapStats.xAvailableHeapSpaceInBytes );
+}
+/*-----------------------------------------------------------*/
+
+void vPortInitialiseBlocks( void )
+{
+	/* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvInsertFreeBlock( BlockLink_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMapSize( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	pxBlock->pxPrevFreeBlock = NULL;
+	pxBlock->pxNextFreeBlock = pxFreeLists[ uxFL ][ uxSL ];
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock;
+	}
+	pxFreeLists[ uxFL ][ uxSL ] = pxBlock;
+
+	ulFLBitmap |= 1UL << uxFL;
+	ulSLBitmap[ uxFL ] |= 1UL << uxSL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvRemoveFreeBlock( BlockLink_t *pxBlock )
+{
+UBaseType_t uxFL, uxSL;
+
+	prvMapSize( heapBLOCK_SIZE( pxBlock ), &uxFL, &uxSL );
+
+	if( pxBlock->pxNextFreeBlock != NULL )
+	{
+		pxBlock->pxNextFreeBlock->pxPrevFreeBlock = pxBlock->pxPrevFreeBlock;
+	}
+
+	if( pxBlock->pxPrevFreeBlock != NULL )
+	{
+		pxBlock->pxPrevFreeBlock->pxNextFreeBlock = pxBlock->pxNextFreeBlock;
+	}
+	else
+	{
+		/* The block was the head of its list. */
+		pxFreeLists[ uxFL ][ uxSL ] = pxBlock->pxNextFreeBlock;
+
+		if( pxFreeLists[ uxFL ][ uxSL ] == NULL )
+		{
+			ulSLBitmap[ uxFL ] &= ~( 1UL << uxSL );
+
+			if( ulSLBitmap[ uxFL ] == 0 )
+			{
+				ulFLBitmap &= ~( 1UL << uxFL );
+			}
+		}
+	}
+}
+/*-----------------------------------------------------------*/
+
+static BlockLink_t *prvFindFreeBlock( size_t xWantedSize )
+{
+BlockLink_t *pxBlock;
+UBaseType_t uxFL, uxSL;
+uint32_t ulMap = 0;
+size_t xRoundedSize = xWantedSize;
+
+	/* Round the size up to the next list boundary, so that every block in the
+	list found is large enough. */
+	if( xWantedSize >= heapSMALL_BLOCK )
+	{
+		xRoundedSize += ( ( size_t ) 1 << ( heapFLS( xWantedSize ) - heapSL_LOG2 ) ) - 1;
+	}
+
+	prvMapSize( xRoundedSize, &uxFL, &uxSL );
+
+	if( uxFL < heapFL_COUNT )
+	{
+		ulMap = ulSLBitmap[ uxFL ] & ( ~0UL << uxSL );
+
+		if( ulMap == 0 )
+		{
+			/* Nothing left in this power of two, take the smallest larger one. */
+			ulMap = ( uxFL + 1 < heapFL_COUNT ) ? ( ulFLBitmap & ( ~0UL << ( uxFL + 1 ) ) ) : 0;
+
+			if( ulMap != 0 )
+			{
+				uxFL = heapFFS( ulMap );
+				ulMap = ulSLBitmap[ uxFL ];
+			}
+		}
+	}
+
+	if( ulMap != 0 )
+	{
+		uxSL = heapFFS( ulMap );
+		return pxFreeLists[ uxFL ][ uxSL ];
+	}
+
+	/* The request would fail otherwise: the list of the size itself may hold
+	a block that is large enough.  This is the only search of a list, and it
+	only happens when the heap is almost exhausted. */
+	prvMapSize( xWantedSize, &uxFL, &uxSL );
+
+	if( uxFL >= heapFL_COUNT )
+	{
+		return NULL;
+	}
+
+	for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+	{
+		if( heapBLOCK_SIZE( pxBlock ) >= xWantedSize )
+		{
+			break;
+		}
+	}
+
+	return pxBlock;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReleaseBlock( BlockLink_t *pxBlock )
+{
+BlockLink_t *pxNeighbour;
+size_t xBlockSize = heapBLOCK_SIZE( pxBlock );
+
+	/* Merge with the block before it in memory. */
+	pxNeighbour = pxBlock->pxPrevPhysBlock;
+	if( ( pxNeighbour != NULL ) && ( ( pxNeighbour->xBlockSize & heapBLOCK_FREE ) != 0 ) )
+	{
+		prvRemoveFreeBlock( pxNeighbour );
+		xBlockSize += heapBLOCK_SIZE( pxNeighbour );
+		pxBlock = pxNeighbour;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	/* Merge with the block after it in memory.  The end marker of a region
+	is never free, so this does not run off the end of the region. */
+	pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+	if( ( pxNeighbour->xBlockSize & heapBLOCK_FREE ) != 0 )
+	{
+		prvRemoveFreeBlock( pxNeighbour );
+		xBlockSize += heapBLOCK_SIZE( pxNeighbour );
+		pxNeighbour = ( void * ) ( ( ( uint8_t * ) pxBlock ) + xBlockSize );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	pxNeighbour->pxPrevPhysBlock = pxBlock;
+	pxBlock->xBlockSize = xBlockSize | heapBLOCK_FREE;
+	prvInsertFreeBlock( pxBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvFlushQuickLists( void )
+{
+BlockLink_t *pxBlock;
+UBaseType_t x;
+
+	for( x = 0; x < heapQUICK_LIST_COUNT; x++ )
+	{
+		while( pxQuickLists[ x ] != NULL )
+		{
+			pxBlock = pxQuickLists[ x ];
+			pxQuickLists[ x ] = pxBlock->pxNextFreeBlock;
+			pxBlock->xBlockSize &= ~heapBLOCK_STATE_MASK;
+			prvReleaseBlock( pxBlock );
+		}
+	}
+
+	xQuickBytes = 0U;
+}
+/*-----------------------------------------------------------*/
+
+static void prvAddRegion( uint8_t *pucStartAddress, size_t xSizeInBytes )
+{
+BlockLink_t *pxFirstBlock, *pxEndMarker;
+size_t xAddress, xEndAddress;
+
+	/* Ensure the region starts and ends on a correctly aligned boundary. */
+	xAddress = ( ( size_t ) pucStartAddress + portBYTE_ALIGNMENT_MASK ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+	xEndAddress = ( ( size_t ) pucStartAddress + xSizeInBytes ) & ~( ( size_t ) portBYTE_ALIGNMENT_MASK );
+
+	/* The region must have room for one block and the end marker. */
+	if( ( xEndAddress <= xAddress ) || ( ( xEndAddress - xAddress ) < ( xHeapStructSize + heapMINIMUM_BLOCK_SIZE ) ) )
+	{
+		return;
+	}
+
+	/* Larger regions have to be passed in as several regions. */
+	configASSERT( ( xEndAddress - xAddress ) < heapMAXIMUM_BLOCK_SIZE );
+
+	/* The end marker is a header that looks like an allocated block, so the
+	block before it is never merged past the end of the region. */
+	pxEndMarker = ( BlockLink_t * ) ( xEndAddress - xHeapStructSize );
+
+	/* To start with there is a single free block in this region that is
+	sized to take up the entire region minus the space taken by the end
+	marker. */
+	pxFirstBlock = ( BlockLink_t * ) xAddress;
+	pxFirstBlock->pxPrevPhysBlock = NULL;
+	pxFirstBlock->xBlockSize = ( ( size_t ) pxEndMarker - xAddress ) | heapBLOCK_FREE;
+
+	pxEndMarker->pxPrevPhysBlock = pxFirstBlock;
+	pxEndMarker->xBlockSize = xHeapStructSize;
+
+	prvInsertFreeBlock( pxFirstBlock );
+
+	xFreeBytesRemaining += heapBLOCK_SIZE( pxFirstBlock );
+	xMinimumEverFreeBytesRemaining += heapBLOCK_SIZE( pxFirstBlock );
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit( void )
+{
+	xHeapInitialised = pdTRUE;
+	prvAddRegion( ucHeap, configTOTAL_HEAP_SIZE );
+
+	/* Check something was actually defined before it is accessed. */
+	configASSERT( xFreeBytesRemaining );
+}
+/*-----------------------------------------------------------*/
+
+void vPortDefineHeapRegions( const HeapRegion_t * const pxHeapRegions )
+{
+const HeapRegion_t *pxHeapRegion;
+
+	vTaskSuspendAll();
+	{
+		if( xHeapInitialised == pdFALSE )
+		{
+			prvHeapInit();
+		}
+
+		for( pxHeapRegion = pxHeapRegions; pxHeapRegion->xSizeInBytes > 0; pxHeapRegion++ )
+		{
+			prvAddRegion( pxHeapRegion->pucStartAddress, pxHeapRegion->xSizeInBytes );
+		}
+	}
+	( void ) xTaskResumeAll();
+}
+/*-----------------------------------------------------------*/
+
+void vPortGetHeapStats( HeapStats_t *pxHeapStats )
+{
+BlockLink_t *pxBlock;
+size_t xBlocks = 0, xMaxSize = 0, xMinSize = portMAX_DELAY; /* portMAX_DELAY used as a portable way of getting the maximum value. */
+UBaseType_t uxFL, uxSL;
+
+	vTaskSuspendAll();
+	{
+		for( uxFL = 0; uxFL < heapFL_COUNT; uxFL++ )
+		{
+			for( uxSL = 0; uxSL < heapSL_COUNT; uxSL++ )
+			{
+				for( pxBlock = pxFreeLists[ uxFL ][ uxSL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+				{
+					xBlocks++;
+
+					if( heapBLOCK_SIZE( pxBlock ) > xMaxSize )
+					{
+						xMaxSize = heapBLOCK_SIZE( pxBlock );
+					}
+
+					if( heapBLOCK_SIZE( pxBlock ) < xMinSize )
+					{
+						xMinSize = heapBLOCK_SIZE( pxBlock );
+					}
+				}
+			}
+		}
+
+		/* Blocks on the quick lists are free too, but can only be handed out
+		at their own size. */
+		for( uxFL = 0; uxFL < heapQUICK_LIST_COUNT; uxFL++ )
+		{
+			for( pxBlock = pxQuickLists[ uxFL ]; pxBlock != NULL; pxBlock = pxBlock->pxNextFreeBlock )
+			{
+				xBlocks++;
+
+				if( heapBLOCK_SIZE( pxBlock ) < xMinSize )
+				{
+					xMinSize = heapBLOCK_SIZE( pxBlock );
+				}
+			}
+		}
+	}
+	xTaskResumeAll();
+
+	pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+	pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xMinSize;
+	pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+
+	taskENTER_CRITICAL();
+	{
+		pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+		pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+		pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+		pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+	}
+	taskEXIT_CRITICAL();
+}
@@ -198,6 +198,15 @@ static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvIte
  */
 static void prvCopyDataFromQueue( Queue_t * const pxQueue, void * const pvBuffer ) PRIVILEGED_FUNCTION;
 
+/*
+ * Unblocks up to uxCount tasks from an event list of a queue, the highest
+ * priority ones first.  Called from within a critical section.
+ *
+ * @return pdTRUE if an unblocked task has a priority above the calling task,
+ * otherwise pdFALSE.
+ */
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxCount ) PRIVILEGED_FUNCTION;
+
 #if ( configUSE_QUEUE_SETS == 1 )
 	/*
 	 * Checks to see if a queue is a member of a queue set, and if so, notifies
@@ -947,6 +956,179 @@ Queue_t * const pxQueue = xQueue;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xQueueSendMultiple( QueueHandle_t xQueue, const void * const pvItemsToQueue, UBaseType_t uxItemCount, TickType_t xTicksToWait )
+{
+BaseType_t xEntryTimeSet = pdFALSE, xYieldRequired;
+TimeOut_t xTimeOut;
+Queue_t * const pxQueue = xQueue;
+const int8_t *pcNextItem = ( const int8_t * ) pvItemsToQueue; /*lint !e9079 Byte arithmetic on the items. */
+UBaseType_t uxSent = 0, uxCount, ux;
+
+	configASSERT( pxQueue );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+	configASSERT( !( ( pvItemsToQueue == NULL ) && ( uxItemCount != ( UBaseType_t ) 0U ) ) );
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	/*lint -save -e904 This function relaxes the coding standard somewhat to
+	allow return statements within the function itself.  This is done in the
+	interest of execution time efficiency. */
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			/* Copy as many of the remaining items as there is room for. */
+			uxCount = pxQueue->uxLength - pxQueue->uxMessagesWaiting;
+
+			if( uxCount > ( uxItemCount - uxSent ) )
+			{
+				uxCount = uxItemCount - uxSent;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			if( uxCount > ( UBaseType_t ) 0 )
+			{
+				xYieldRequired = pdFALSE;
+
+				for( ux = 0; ux < uxCount; ux++ )
+				{
+					traceQUEUE_SEND( pxQueue );
+					( void ) prvCopyDataToQueue( pxQueue, pcNextItem, queueSEND_TO_BACK );
+					pcNextItem += pxQueue->uxItemSize;
+
+					#if ( configUSE_QUEUE_SETS == 1 )
+					{
+						/* The queue set holds one entry for each item. */
+						if( pxQueue->pxQueueSetContainer != NULL )
+						{
+							if( prvNotifyQueueSetContainer( pxQueue ) != pdFALSE )
+							{
+								xYieldRequired = pdTRUE;
+							}
+							else
+							{
+								mtCOVERAGE_TEST_MARKER();
+							}
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					#endif /* configUSE_QUEUE_SETS */
+				}
+
+				uxSent += uxCount;
+
+				/* Each new item can satisfy one task that was waiting for data
+				to arrive on the queue, unblock them in one go.  Tasks waiting
+				on a queue set were notified through the set above. */
+				#if ( configUSE_QUEUE_SETS == 1 )
+				if( pxQueue->pxQueueSetContainer == NULL )
+				#endif /* configUSE_QUEUE_SETS */
+				{
+					if( prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToReceive ), uxCount ) != pdFALSE )
+					{
+						xYieldRequired = pdTRUE;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+
+				if( xYieldRequired != pdFALSE )
+				{
+					/* Yes it is ok to do this from within the critical section
+					- the kernel takes care of that. */
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			if( uxSent == uxItemCount )
+			{
+				taskEXIT_CRITICAL();
+				return ( BaseType_t ) uxSent;
+			}
+			else if( xTicksToWait == ( TickType_t ) 0 )
+			{
+				/* The queue is full and no block time is specified (or the
+				block time has expired) so leave now. */
+				taskEXIT_CRITICAL();
+				traceQUEUE_SEND_FAILED( pxQueue );
+				return ( BaseType_t ) uxSent;
+			}
+			else if( xEntryTimeSet == pdFALSE )
+			{
+				/* The queue is full and a block time was specified so
+				configure the timeout structure. */
+				vTaskInternalSetTimeOutState( &xTimeOut );
+				xEntryTimeSet = pdTRUE;
+			}
+			else
+			{
+				/* Entry time was already set. */
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		/* Interrupts and other tasks can send to and receive from the queue
+		now the critical section has been exited. */
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		/* Update the timeout state to see if it has expired yet. */
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			if( prvIsQueueFull( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_SEND( pxQueue );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToSend ), xTicksToWait );
+
+				/* See xQueueGenericSend(). */
+				prvUnlockQueue( pxQueue );
+
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+			}
+			else
+			{
+				/* Try again. */
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			/* The timeout has expired. */
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			traceQUEUE_SEND_FAILED( pxQueue );
+			return ( BaseType_t ) uxSent;
+		}
+	} /*lint -restore */
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xQueueGenericSendFromISR( QueueHandle_t xQueue, const void * const pvItemToQueue, BaseType_t * const pxHigherPriorityTaskWoken, const BaseType_t xCopyPosition )
 {
 BaseType_t xReturn;
@@ -1415,6 +1597,144 @@ Queue_t * const pxQueue = xQueue;
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t xQueueReceiveMultiple( QueueHandle_t xQueue, void * const pvBuffer, UBaseType_t uxMaxItems, TickType_t xTicksToWait )
+{
+BaseType_t xEntryTimeSet = pdFALSE;
+TimeOut_t xTimeOut;
+Queue_t * const pxQueue = xQueue;
+int8_t *pcNextItem;
+UBaseType_t uxCount, ux;
+
+	configASSERT( pxQueue );
+	configASSERT( pxQueue->uxItemSize != ( UBaseType_t ) 0U );
+	configASSERT( pvBuffer );
+	configASSERT( uxMaxItems > ( UBaseType_t ) 0 );
+
+	/* Cannot block if the scheduler is suspended. */
+	#if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
+	{
+		configASSERT( !( ( xTaskGetSchedulerState() == taskSCHEDULER_SUSPENDED ) && ( xTicksToWait != 0 ) ) );
+	}
+	#endif
+
+	/*lint -save -e904  This function relaxes the coding standard somewhat to
+	allow return statements within the function itself.  This is done in the
+	interest of execution time efficiency. */
+	for( ;; )
+	{
+		taskENTER_CRITICAL();
+		{
+			const UBaseType_t uxMessagesWaiting = pxQueue->uxMessagesWaiting;
+
+			if( uxMessagesWaiting > ( UBaseType_t ) 0 )
+			{
+				/* Data available, remove what is there up to uxMaxItems. */
+				uxCount = ( uxMessagesWaiting < uxMaxItems ) ? uxMessagesWaiting : uxMaxItems;
+				pcNextItem = ( int8_t * ) pvBuffer; /*lint !e9079 Byte arithmetic on the items. */
+
+				for( ux = 0; ux < uxCount; ux++ )
+				{
+					prvCopyDataFromQueue( pxQueue, pcNextItem );
+					traceQUEUE_RECEIVE( pxQueue );
+					pcNextItem += pxQueue->uxItemSize;
+				}
+
+				pxQueue->uxMessagesWaiting = uxMessagesWaiting - uxCount;
+
+				/* There is now space for uxCount items, unblock as many of the
+				tasks waiting to post to the queue in one go. */
+				if( prvUnblockWaitingTasks( &( pxQueue->xTasksWaitingToSend ), uxCount ) != pdFALSE )
+				{
+					queueYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				taskEXIT_CRITICAL();
+				return ( BaseType_t ) uxCount;
+			}
+			else
+			{
+				if( xTicksToWait == ( TickType_t ) 0 )
+				{
+					/* The queue was empty and no block time is specified (or
+					the block time has expired) so leave now. */
+					taskEXIT_CRITICAL();
+					traceQUEUE_RECEIVE_FAILED( pxQueue );
+					return 0;
+				}
+				else if( xEntryTimeSet == pdFALSE )
+				{
+					/* The queue was empty and a block time was specified so
+					configure the timeout structure. */
+					vTaskInternalSetTimeOutState( &xTimeOut );
+					xEntryTimeSet = pdTRUE;
+				}
+				else
+				{
+					/* Entry time was already set. */
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		taskEXIT_CRITICAL();
+
+		/* Interrupts and other tasks can send to and receive from the queue
+		now the critical section has been exited. */
+
+		vTaskSuspendAll();
+		prvLockQueue( pxQueue );
+
+		/* Update the timeout state to see if it has expired yet. */
+		if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) == pdFALSE )
+		{
+			/* The timeout has not expired.  If the queue is still empty place
+			the task on the list of tasks waiting to receive from the queue. */
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				traceBLOCKING_ON_QUEUE_RECEIVE( pxQueue );
+				vTaskPlaceOnEventList( &( pxQueue->xTasksWaitingToReceive ), xTicksToWait );
+				prvUnlockQueue( pxQueue );
+				if( xTaskResumeAll() == pdFALSE )
+				{
+					portYIELD_WITHIN_API();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				/* The queue contains data again.  Loop back to try and read the
+				data. */
+				prvUnlockQueue( pxQueue );
+				( void ) xTaskResumeAll();
+			}
+		}
+		else
+		{
+			/* Timed out.  If there is no data in the queue exit, otherwise loop
+			back and attempt to read the data. */
+			prvUnlockQueue( pxQueue );
+			( void ) xTaskResumeAll();
+
+			if( prvIsQueueEmpty( pxQueue ) != pdFALSE )
+			{
+				traceQUEUE_RECEIVE_FAILED( pxQueue );
+				return 0;
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+	} /*lint -restore */
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t xQueueSemaphoreTake( QueueHandle_t xQueue, TickType_t xTicksToWait )
 {
 BaseType_t xEntryTimeSet = pdFALSE;
@@ -2071,6 +2391,28 @@ Queue_t * const pxQueue = xQueue;
 #endif /* configUSE_MUTEXES */
 /*-----------------------------------------------------------*/
 
+static BaseType_t prvUnblockWaitingTasks( List_t * const pxEventList, UBaseType_t uxCount )
+{
+BaseType_t xYieldRequired = pdFALSE;
+
+	while( ( uxCount > ( UBaseType_t ) 0 ) && ( listLIST_IS_EMPTY( pxEventList ) == pdFALSE ) )
+	{
+		if( xTaskRemoveFromEventList( pxEventList ) != pdFALSE )
+		{
+			xYieldRequired = pdTRUE;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		uxCount--;
+	}
+
+	return xYieldRequired;
+}
+/*-----------------------------------------------------------*/
+
 static BaseType_t prvCopyDataToQueue( Queue_t * const pxQueue, const void *pvItemToQueue, const BaseType_t xPosition )
 {
 BaseType_t xReturn = pdFALSE;
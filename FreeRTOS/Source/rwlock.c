@@ -0,0 +1,396 @@
+/*
+ * FreeRTOS Kernel V10.3.0
+ * Copyright (C) 2020 Amazon.com, Inc. or its affiliates.  All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * http://www.FreeRTOS.org
+ * http://aws.amazon.com/freertos
+ *
+ * 1 tab == 4 spaces!
+ */
+
+/* Standard includes. */
+#include <string.h>
+
+/* Defining MPU_WRAPPERS_INCLUDED_FROM_API_FILE prevents task.h from redefining
+all the API functions to use the MPU wrappers.  That should only be done when
+task.h is included from an application file. */
+#define MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+/* FreeRTOS includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "rwlock.h"
+
+#undef MPU_WRAPPERS_INCLUDED_FROM_API_FILE
+
+#if( configUSE_MUTEXES != 1 )
+	#error configUSE_MUTEXES must be set to 1 to build rwlock.c
+#endif
+
+/* Bits that can be set in xRWLOCK->ucFlags. */
+#define rwlockFLAGS_IS_STATICALLY_ALLOCATED	( ( uint8_t ) 1 )
+
+/* The top bit of xRWLOCK->uxState is set while a writer holds the lock or waits
+for the readers, the other bits count the readers that hold it. */
+#define rwlockWRITER						( ( UBaseType_t ) 1 << ( ( sizeof( UBaseType_t ) * 8U ) - 1U ) )
+#define rwlockREADERS_MASK					( ~rwlockWRITER )
+
+/*lint -save -e9058 Style convention uses tag. */
+typedef struct RWLockDefinition
+{
+	volatile UBaseType_t uxState;			/* rwlockWRITER and the number of readers. */
+	volatile TaskHandle_t xWriter;			/* The task holding the lock for writing, else NULL. */
+	SemaphoreHandle_t xWriterMutex;			/* Held by the writer while it holds or waits for the lock. */
+	SemaphoreHandle_t xReadersDone;			/* Given by the last reader out while a writer waits. */
+	uint8_t ucFlags;
+} RWLock_t;
+
+/* What StaticRWLock_t holds, the semaphores follow the lock structure. */
+typedef struct RWLockStatic
+{
+	RWLock_t xRWLock;
+	StaticSemaphore_t xWriterMutexBuffer;
+	StaticSemaphore_t xReadersDoneBuffer;
+} RWLockStatic_t;
+/*lint -restore */
+
+/*-----------------------------------------------------------*/
+
+/*
+ * Counts the caller in as a reader unless a writer holds the lock or waits for
+ * it.  Returns pdFALSE if a writer does.
+ */
+static BaseType_t prvTryTakeRead( RWLock_t * const pxRWLock ) PRIVILEGED_FUNCTION;
+
+/*
+ * Counts a reader out.  Returns pdTRUE if it was the last reader a writer was
+ * waiting for, in which case the caller gives xReadersDone.  Sets *pxReturn to
+ * pdFAIL if no reader held the lock.
+ */
+static BaseType_t prvGiveRead( RWLock_t * const pxRWLock, BaseType_t * const pxReturn ) PRIVILEGED_FUNCTION;
+
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+
+	RWLockHandle_t xRWLockCreateStatic( StaticRWLock_t *pxStaticRWLock )
+	{
+	RWLockStatic_t * const pxStatic = ( RWLockStatic_t * ) pxStaticRWLock; /*lint !e740 !e9087 RWLockStatic_t and StaticRWLock_t are guaranteed to have the same size and alignment requirement - checked by configASSERT(). */
+	RWLockHandle_t xReturn = NULL;
+
+		configASSERT( pxStaticRWLock );
+
+		#if( configASSERT_DEFINED == 1 )
+		{
+			/* Sanity check that the size of the structure used to declare a
+			variable of type StaticRWLock_t equals the size of the real
+			structure. */
+			volatile size_t xSize = sizeof( StaticRWLock_t );
+			configASSERT( xSize == sizeof( RWLockStatic_t ) );
+		} /*lint !e529 xSize is referenced is configASSERT() is defined. */
+		#endif /* configASSERT_DEFINED */
+
+		if( pxStatic != NULL )
+		{
+			( void ) memset( &( pxStatic->xRWLock ), 0x00, sizeof( RWLock_t ) );
+			pxStatic->xRWLock.xWriterMutex = xSemaphoreCreateMutexStatic( &( pxStatic->xWriterMutexBuffer ) );
+			pxStatic->xRWLock.xReadersDone = xSemaphoreCreateBinaryStatic( &( pxStatic->xReadersDoneBuffer ) );
+			pxStatic->xRWLock.ucFlags = rwlockFLAGS_IS_STATICALLY_ALLOCATED;
+			xReturn = &( pxStatic->xRWLock );
+		}
+
+		return xReturn;
+	}
+
+#endif /* configSUPPORT_STATIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+
+	RWLockHandle_t xRWLockCreate( void )
+	{
+	RWLock_t *pxRWLock;
+
+		pxRWLock = ( RWLock_t * ) pvPortMalloc( sizeof( RWLock_t ) ); /*lint !e9079 malloc() only returns void*. */
+
+		if( pxRWLock != NULL )
+		{
+			( void ) memset( pxRWLock, 0x00, sizeof( RWLock_t ) );
+			pxRWLock->xWriterMutex = xSemaphoreCreateMutex();
+			pxRWLock->xReadersDone = xSemaphoreCreateBinary();
+
+			if( ( pxRWLock->xWriterMutex == NULL ) || ( pxRWLock->xReadersDone == NULL ) )
+			{
+				if( pxRWLock->xWriterMutex != NULL )
+				{
+					vSemaphoreDelete( pxRWLock->xWriterMutex );
+				}
+
+				if( pxRWLock->xReadersDone != NULL )
+				{
+					vSemaphoreDelete( pxRWLock->xReadersDone );
+				}
+
+				vPortFree( pxRWLock );
+				pxRWLock = NULL;
+			}
+		}
+
+		return pxRWLock;
+	}
+
+#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+/*-----------------------------------------------------------*/
+
+void vRWLockDelete( RWLockHandle_t xRWLock )
+{
+RWLock_t * const pxRWLock = xRWLock;
+
+	configASSERT( pxRWLock );
+	configASSERT( pxRWLock->uxState == 0 );
+
+	vSemaphoreDelete( pxRWLock->xWriterMutex );
+	vSemaphoreDelete( pxRWLock->xReadersDone );
+
+	if( ( pxRWLock->ucFlags & rwlockFLAGS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) pdFALSE )
+	{
+		#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
+		{
+			vPortFree( ( void * ) pxRWLock ); /*lint !e9087 Standard free() semantics require void *, plus pxRWLock was allocated by pvPortMalloc(). */
+		}
+		#else
+		{
+			/* Should not be possible to get here, ucFlags must be corrupt.
+			Force an assert. */
+			configASSERT( xRWLock == ( RWLockHandle_t ) ~0 );
+		}
+		#endif
+	}
+	else
+	{
+		/* The structure was statically allocated, so just clear it. */
+		( void ) memset( pxRWLock, 0x00, sizeof( RWLock_t ) );
+	}
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockTakeRead( RWLockHandle_t xRWLock, TickType_t xTicksToWait )
+{
+RWLock_t * const pxRWLock = xRWLock;
+BaseType_t xReturn = pdPASS;
+
+	configASSERT( pxRWLock );
+
+	if( prvTryTakeRead( pxRWLock ) == pdFALSE )
+	{
+		/* A writer holds the lock or waits for it, and with it the writer
+		mutex.  Waiting on the mutex lends the writer the priority of this task
+		if that is higher.  Once this task holds the mutex no writer can, so it
+		is counted in without checking for one. */
+		if( xSemaphoreTake( pxRWLock->xWriterMutex, xTicksToWait ) == pdPASS )
+		{
+			( void ) __atomic_fetch_add( &( pxRWLock->uxState ), 1U, __ATOMIC_ACQUIRE );
+			( void ) xSemaphoreGive( pxRWLock->xWriterMutex );
+		}
+		else
+		{
+			xReturn = pdFAIL;
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockTakeReadFromISR( RWLockHandle_t xRWLock )
+{
+RWLock_t * const pxRWLock = xRWLock;
+
+	configASSERT( pxRWLock );
+
+	return ( prvTryTakeRead( pxRWLock ) != pdFALSE ) ? pdPASS : pdFAIL;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockGiveRead( RWLockHandle_t xRWLock )
+{
+RWLock_t * const pxRWLock = xRWLock;
+BaseType_t xReturn;
+
+	configASSERT( pxRWLock );
+
+	if( prvGiveRead( pxRWLock, &xReturn ) != pdFALSE )
+	{
+		( void ) xSemaphoreGive( pxRWLock->xReadersDone );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockGiveReadFromISR( RWLockHandle_t xRWLock, BaseType_t *pxHigherPriorityTaskWoken )
+{
+RWLock_t * const pxRWLock = xRWLock;
+BaseType_t xReturn;
+
+	configASSERT( pxRWLock );
+
+	if( prvGiveRead( pxRWLock, &xReturn ) != pdFALSE )
+	{
+		( void ) xSemaphoreGiveFromISR( pxRWLock->xReadersDone, pxHigherPriorityTaskWoken );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockTakeWrite( RWLockHandle_t xRWLock, TickType_t xTicksToWait )
+{
+RWLock_t * const pxRWLock = xRWLock;
+BaseType_t xReturn = pdFAIL;
+UBaseType_t uxState;
+TimeOut_t xTimeOut;
+
+	configASSERT( pxRWLock );
+	configASSERT( pxRWLock->xWriter != xTaskGetCurrentTaskHandle() );
+
+	vTaskSetTimeOutState( &xTimeOut );
+
+	if( xSemaphoreTake( pxRWLock->xWriterMutex, xTicksToWait ) == pdPASS )
+	{
+		/* Keep new readers out, then wait for those inside to leave.  The
+		last one gives xReadersDone.  The semaphore may also hold a give left
+		over from a writer that timed out, so the readers are counted again
+		each time it is taken. */
+		uxState = __atomic_or_fetch( &( pxRWLock->uxState ), rwlockWRITER, __ATOMIC_ACQUIRE );
+
+		while( ( uxState & rwlockREADERS_MASK ) != 0U )
+		{
+			if( xTaskCheckForTimeOut( &xTimeOut, &xTicksToWait ) != pdFALSE )
+			{
+				break;
+			}
+
+			( void ) xSemaphoreTake( pxRWLock->xReadersDone, xTicksToWait );
+			uxState = __atomic_load_n( &( pxRWLock->uxState ), __ATOMIC_ACQUIRE );
+		}
+
+		if( ( uxState & rwlockREADERS_MASK ) == 0U )
+		{
+			pxRWLock->xWriter = xTaskGetCurrentTaskHandle();
+			xReturn = pdPASS;
+		}
+		else
+		{
+			/* Timed out waiting for the readers, let new ones in again. */
+			( void ) __atomic_fetch_and( &( pxRWLock->uxState ), rwlockREADERS_MASK, __ATOMIC_RELEASE );
+			( void ) xSemaphoreGive( pxRWLock->xWriterMutex );
+		}
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+BaseType_t xRWLockGiveWrite( RWLockHandle_t xRWLock )
+{
+RWLock_t * const pxRWLock = xRWLock;
+BaseType_t xReturn = pdFAIL;
+
+	configASSERT( pxRWLock );
+
+	if( pxRWLock->xWriter == xTaskGetCurrentTaskHandle() )
+	{
+		pxRWLock->xWriter = NULL;
+		( void ) __atomic_fetch_and( &( pxRWLock->uxState ), rwlockREADERS_MASK, __ATOMIC_RELEASE );
+
+		/* Readers and writers that waited for the lock wait for the mutex,
+		giving it lets the highest priority of them in and drops any priority
+		this task inherited. */
+		( void ) xSemaphoreGive( pxRWLock->xWriterMutex );
+		xReturn = pdPASS;
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	return xReturn;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvTryTakeRead( RWLock_t * const pxRWLock )
+{
+UBaseType_t uxState;
+
+	uxState = __atomic_load_n( &( pxRWLock->uxState ), __ATOMIC_RELAXED );
+
+	while( ( uxState & rwlockWRITER ) == 0U )
+	{
+		/* On failure uxState is updated to the current value. */
+		if( __atomic_compare_exchange_n( &( pxRWLock->uxState ), &uxState, uxState + 1U, pdFALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED ) != pdFALSE )
+		{
+			return pdTRUE;
+		}
+	}
+
+	return pdFALSE;
+}
+/*-----------------------------------------------------------*/
+
+static BaseType_t prvGiveRead( RWLock_t * const pxRWLock, BaseType_t * const pxReturn )
+{
+UBaseType_t uxState;
+
+	uxState = __atomic_load_n( &( pxRWLock->uxState ), __ATOMIC_RELAXED );
+
+	do
+	{
+		if( ( uxState & rwlockREADERS_MASK ) == 0U )
+		{
+			*pxReturn = pdFAIL;
+			return pdFALSE;
+		}
+	} while( __atomic_compare_exchange_n( &( pxRWLock->uxState ), &uxState, uxState - 1U, pdFALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) == pdFALSE );
+
+	*pxReturn = pdPASS;
+
+	/* Only the reader that takes the count to zero while the writer bit is set
+	sees exactly rwlockWRITER here. */
+	return ( ( uxState - 1U ) == rwlockWRITER ) ? pdTRUE : pdFALSE;
+}
+/*-----------------------------------------------------------*/
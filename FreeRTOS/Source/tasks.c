@@ -191,6 +191,20 @@ configIDLE_TASK_NAME in FreeRTOSConfig.h. */
 
 #endif /* configUSE_PORT_OPTIMISED_TASK_SELECTION */
 
+#if( configNUM_CORES > 1 )
+
+	/* With more than one core the ready lists are walked to skip the tasks
+	that are running on the other cores or are not allowed on this one.  The
+	ready priorities are still recorded as above. */
+	#undef taskSELECT_HIGHEST_PRIORITY_TASK
+	#define taskSELECT_HIGHEST_PRIORITY_TASK() prvSelectHighestPriorityTask( ( BaseType_t ) portGET_CORE_ID() )
+
+	#if( configSUPPORT_DYNAMIC_ALLOCATION == 0 )
+		#error The idle tasks of the cores other than core 0 are allocated dynamically, configSUPPORT_DYNAMIC_ALLOCATION must be 1.
+	#endif
+
+#endif /* configNUM_CORES */
+
 /*-----------------------------------------------------------*/
 
 /* pxDelayedTaskList and pxOverflowDelayedTaskList are switched when the tick
@@ -230,6 +244,30 @@ count overflows. */
  */
 #define prvGetTCBFromHandle( pxHandle ) ( ( ( pxHandle ) == NULL ) ? pxCurrentTCB : ( pxHandle ) )
 
+/* Values that can be assigned to the xTaskRunState member of the TCB.  A
+running task holds the number of the core it runs on. */
+#define taskTASK_NOT_RUNNING			( ( BaseType_t ) -1 )
+
+#if( configNUM_CORES > 1 )
+
+	#define taskTASK_IS_RUNNING( pxTCB )	( ( pxTCB )->xTaskRunState != taskTASK_NOT_RUNNING )
+
+	/* Whether readying pxTCB means the calling core should switch to it.
+	Another core running a lower priority task is interrupted instead, in
+	which case the calling core does not switch. */
+	#define taskYIELD_REQUIRED( pxTCB, xYieldEqualPriority ) prvYieldForTask( ( pxTCB ), ( xYieldEqualPriority ) )
+
+#else
+
+	#define taskTASK_IS_RUNNING( pxTCB )	( ( pxTCB ) == pxCurrentTCB )
+
+	#define taskYIELD_REQUIRED( pxTCB, xYieldEqualPriority )						\
+		( ( ( xYieldEqualPriority ) != pdFALSE ) ?									\
+			( ( pxTCB )->uxPriority >= pxCurrentTCB->uxPriority ) :				\
+			( ( pxTCB )->uxPriority > pxCurrentTCB->uxPriority ) )
+
+#endif /* configNUM_CORES */
+
 /* The item value of the event list item is normally used to hold the priority
 of the task to which it belongs (coded to allow it to be held in reverse
 priority order).  However, it is occasionally borrowed for other purposes.  It
@@ -290,7 +328,7 @@ typedef struct tskTaskControlBlock 			/* The old naming convention is used to pr
 	#endif
 
 	#if( configGENERATE_RUN_TIME_STATS == 1 )
-		uint32_t		ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
+		configRUN_TIME_COUNTER_TYPE	ulRunTimeCounter;	/*< Stores the amount of time the task has spent in the Running state. */
 	#endif
 
 	#if ( configUSE_NEWLIB_REENTRANT == 1 )
@@ -326,6 +364,11 @@ typedef struct tskTaskControlBlock 			/* The old naming convention is used to pr
 		int iTaskErrno;
 	#endif
 
+	#if( configNUM_CORES > 1 )
+		volatile BaseType_t xTaskRunState;	/*< The core the task is running on, or taskTASK_NOT_RUNNING. */
+		UBaseType_t		uxCoreAffinityMask;	/*< Bit n set if the task may run on core n. */
+	#endif
+
 } tskTCB;
 
 /* The old tskTCB name is maintained above then typedefed to the new TCB_t name
@@ -334,7 +377,16 @@ typedef tskTCB TCB_t;
 
 /*lint -save -e956 A manual analysis and inspection has been used to determine
 which static variables must be declared volatile. */
-PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#if( configNUM_CORES > 1 )
+	/* The task running on each core.  A task can be moved to another core
+	between reading the core number and indexing the array, so outside this
+	file's critical sections the running task is read through
+	xTaskGetCurrentTaskHandle(). */
+	PRIVILEGED_DATA TCB_t * volatile pxCurrentTCBs[ configNUM_CORES ] = { NULL };
+	#define pxCurrentTCB xTaskGetCurrentTaskHandle()
+#else
+	PRIVILEGED_DATA TCB_t * volatile pxCurrentTCB = NULL;
+#endif
 
 /* Lists for ready and blocked tasks. --------------------
 xDelayedTaskList1 and xDelayedTaskList2 could be move to function scople but
@@ -372,11 +424,21 @@ PRIVILEGED_DATA static volatile TickType_t xTickCount 				= ( TickType_t ) confi
 PRIVILEGED_DATA static volatile UBaseType_t uxTopReadyPriority 		= tskIDLE_PRIORITY;
 PRIVILEGED_DATA static volatile BaseType_t xSchedulerRunning 		= pdFALSE;
 PRIVILEGED_DATA static volatile TickType_t xPendedTicks 			= ( TickType_t ) 0U;
-PRIVILEGED_DATA static volatile BaseType_t xYieldPending 			= pdFALSE;
+#if( configNUM_CORES > 1 )
+	PRIVILEGED_DATA static volatile BaseType_t xYieldPendings[ configNUM_CORES ] = { pdFALSE };
+	#define xYieldPending xYieldPendings[ portGET_CORE_ID() ]
+#else
+	PRIVILEGED_DATA static volatile BaseType_t xYieldPending 		= pdFALSE;
+#endif
 PRIVILEGED_DATA static volatile BaseType_t xNumOfOverflows 			= ( BaseType_t ) 0;
 PRIVILEGED_DATA static UBaseType_t uxTaskNumber 					= ( UBaseType_t ) 0U;
 PRIVILEGED_DATA static volatile TickType_t xNextTaskUnblockTime		= ( TickType_t ) 0U; /* Initialised to portMAX_DELAY before the scheduler starts. */
-PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandle					= NULL;			/*< Holds the handle of the idle task.  The idle task is created automatically when the scheduler is started. */
+#if( configNUM_CORES > 1 )
+	PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandles[ configNUM_CORES ] = { NULL };	/*< One idle task per core, each only allowed on its own core. */
+	#define xIdleTaskHandle xIdleTaskHandles[ portGET_CORE_ID() ]
+#else
+	PRIVILEGED_DATA static TaskHandle_t xIdleTaskHandle				= NULL;			/*< Holds the handle of the idle task.  The idle task is created automatically when the scheduler is started. */
+#endif
 
 /* Context switches are held pending while the scheduler is suspended.  Also,
 interrupts must not manipulate the xStateListItem of a TCB, or any of the
@@ -392,8 +454,13 @@ PRIVILEGED_DATA static volatile UBaseType_t uxSchedulerSuspended	= ( UBaseType_t
 
 	/* Do not move these variables to function scope as doing so prevents the
 	code working with debuggers that need to remove the static qualifier. */
-	PRIVILEGED_DATA static uint32_t ulTaskSwitchedInTime = 0UL;	/*< Holds the value of a timer/counter the last time a task was switched in. */
-	PRIVILEGED_DATA static uint32_t ulTotalRunTime = 0UL;		/*< Holds the total amount of execution time as defined by the run time counter clock. */
+	#if( configNUM_CORES > 1 )
+		PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTimes[ configNUM_CORES ] = { 0UL };	/*< Per core, only accessed by the core itself with interrupts masked. */
+		#define ulTaskSwitchedInTime ulTaskSwitchedInTimes[ portGET_CORE_ID() ]
+	#else
+		PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTaskSwitchedInTime = 0UL;	/*< Holds the value of a timer/counter the last time a task was switched in. */
+	#endif
+	PRIVILEGED_DATA static configRUN_TIME_COUNTER_TYPE ulTotalRunTime = 0UL;		/*< Holds the total amount of execution time as defined by the run time counter clock. */
 
 #endif
 
@@ -563,6 +630,35 @@ static void prvInitialiseNewTask( 	TaskFunction_t pxTaskCode,
  */
 static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB ) PRIVILEGED_FUNCTION;
 
+#if( configNUM_CORES > 1 )
+
+	/*
+	 * Makes xCoreID reschedule.  Returns pdTRUE if xCoreID is the calling core,
+	 * which then has to yield itself, otherwise interrupts the other core and
+	 * returns pdFALSE.  Must be called from a critical section.
+	 */
+	static BaseType_t prvYieldCore( BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Called when pxTCB has been made ready.  Finds the core running the lowest
+	 * priority task that pxTCB should preempt, preferring the calling core, and
+	 * makes it reschedule with prvYieldCore().  xYieldEqualPriority set means a
+	 * core running a task of the same priority as pxTCB is preempted too.  Must
+	 * be called from a critical section or with the scheduler suspended.
+	 */
+	static BaseType_t prvYieldForTask( const TCB_t * const pxTCB, const BaseType_t xYieldEqualPriority ) PRIVILEGED_FUNCTION;
+
+	/*
+	 * Selects the next task to run on xCoreID: the highest priority ready task
+	 * that is not running on another core and whose affinity allows xCoreID.
+	 * The outgoing task, if still ready, is offered to the other cores with
+	 * prvYieldForTask().  Called from vTaskSwitchContext() with both scheduler
+	 * locks held.
+	 */
+	static void prvSelectHighestPriorityTask( const BaseType_t xCoreID ) PRIVILEGED_FUNCTION;
+
+#endif /* configNUM_CORES */
+
 /*
  * freertos_tasks_c_additions_init() should only be called if the user definable
  * macro FREERTOS_TASKS_C_ADDITIONS_INIT() is defined, as that is the only macro
@@ -1009,6 +1105,13 @@ UBaseType_t x;
 	}
 	#endif
 
+	#if( configNUM_CORES > 1 )
+	{
+		pxNewTCB->xTaskRunState = taskTASK_NOT_RUNNING;
+		pxNewTCB->uxCoreAffinityMask = tskNO_AFFINITY;
+	}
+	#endif
+
 	/* Initialize the TCB stack to look as if the task was already running,
 	but had been interrupted by the scheduler.  The return address is set
 	to the start of the task function. Once the stack has been initialised
@@ -1081,17 +1184,13 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 	taskENTER_CRITICAL();
 	{
 		uxCurrentNumberOfTasks++;
-		if( pxCurrentTCB == NULL )
-		{
-			/* There are no other tasks, or all the other tasks are in
-			the suspended state - make this the current task. */
-			pxCurrentTCB = pxNewTCB;
 
+		#if( configNUM_CORES > 1 )
+		{
+			/* The first task of each core is selected when the scheduler is
+			started, so there is no current task to update here. */
 			if( uxCurrentNumberOfTasks == ( UBaseType_t ) 1 )
 			{
-				/* This is the first task to be created so do the preliminary
-				initialisation required.  We will not recover if this call
-				fails, but we will report the failure. */
 				prvInitialiseTaskLists();
 			}
 			else
@@ -1099,16 +1198,20 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 				mtCOVERAGE_TEST_MARKER();
 			}
 		}
-		else
+		#else /* configNUM_CORES */
 		{
-			/* If the scheduler is not already running, make this task the
-			current task if it is the highest priority task to be created
-			so far. */
-			if( xSchedulerRunning == pdFALSE )
+			if( pxCurrentTCB == NULL )
 			{
-				if( pxCurrentTCB->uxPriority <= pxNewTCB->uxPriority )
+				/* There are no other tasks, or all the other tasks are in
+				the suspended state - make this the current task. */
+				pxCurrentTCB = pxNewTCB;
+
+				if( uxCurrentNumberOfTasks == ( UBaseType_t ) 1 )
 				{
-					pxCurrentTCB = pxNewTCB;
+					/* This is the first task to be created so do the preliminary
+					initialisation required.  We will not recover if this call
+					fails, but we will report the failure. */
+					prvInitialiseTaskLists();
 				}
 				else
 				{
@@ -1117,9 +1220,27 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 			}
 			else
 			{
-				mtCOVERAGE_TEST_MARKER();
+				/* If the scheduler is not already running, make this task the
+				current task if it is the highest priority task to be created
+				so far. */
+				if( xSchedulerRunning == pdFALSE )
+				{
+					if( pxCurrentTCB->uxPriority <= pxNewTCB->uxPriority )
+					{
+						pxCurrentTCB = pxNewTCB;
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
 			}
 		}
+		#endif /* configNUM_CORES */
 
 		uxTaskNumber++;
 
@@ -1134,26 +1255,53 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 		prvAddTaskToReadyList( pxNewTCB );
 
 		portSETUP_TCB( pxNewTCB );
+
+		#if( configNUM_CORES > 1 )
+		{
+			/* Decided inside the critical section as it depends on the tasks
+			the other cores are running.  The yield itself is held until the
+			critical section is exited. */
+			if( xSchedulerRunning != pdFALSE )
+			{
+				if( taskYIELD_REQUIRED( pxNewTCB, pdFALSE ) != pdFALSE )
+				{
+					taskYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		#endif /* configNUM_CORES */
 	}
 	taskEXIT_CRITICAL();
 
-	if( xSchedulerRunning != pdFALSE )
+	#if( configNUM_CORES == 1 )
 	{
-		/* If the created task is of a higher priority than the current task
-		then it should run now. */
-		if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+		if( xSchedulerRunning != pdFALSE )
 		{
-			taskYIELD_IF_USING_PREEMPTION();
+			/* If the created task is of a higher priority than the current task
+			then it should run now. */
+			if( pxCurrentTCB->uxPriority < pxNewTCB->uxPriority )
+			{
+				taskYIELD_IF_USING_PREEMPTION();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
 		}
 		else
 		{
 			mtCOVERAGE_TEST_MARKER();
 		}
 	}
-	else
-	{
-		mtCOVERAGE_TEST_MARKER();
-	}
+	#endif /* configNUM_CORES */
 }
 /*-----------------------------------------------------------*/
 
@@ -1195,7 +1343,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 			not return. */
 			uxTaskNumber++;
 
-			if( pxTCB == pxCurrentTCB )
+			if( taskTASK_IS_RUNNING( pxTCB ) )
 			{
 				/* A task is deleting itself.  This cannot complete within the
 				task itself, as a context switch to another task is required.
@@ -1219,6 +1367,22 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 				hence xYieldPending is used to latch that a context switch is
 				required. */
 				portPRE_TASK_DELETE_HOOK( pxTCB, &xYieldPending );
+
+				#if( configNUM_CORES > 1 )
+				{
+					/* The task may be running on another core, which has to
+					switch away from it.  The idle task does not free it
+					before that has happened. */
+					if( pxTCB->xTaskRunState != ( BaseType_t ) portGET_CORE_ID() )
+					{
+						( void ) prvYieldCore( pxTCB->xTaskRunState );
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configNUM_CORES */
 			}
 			else
 			{
@@ -1391,9 +1555,10 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 
 		configASSERT( pxTCB );
 
-		if( pxTCB == pxCurrentTCB )
+		if( taskTASK_IS_RUNNING( pxTCB ) )
 		{
-			/* The task calling this function is querying its own state. */
+			/* The task calling this function is querying its own state, or
+			the task is running on another core. */
 			eReturn = eRunning;
 		}
 		else
@@ -1575,44 +1740,48 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 
 			if( uxCurrentBasePriority != uxNewPriority )
 			{
-				/* The priority change may have readied a task of higher
-				priority than the calling task. */
-				if( uxNewPriority > uxCurrentBasePriority )
+				#if( configNUM_CORES == 1 )
 				{
-					if( pxTCB != pxCurrentTCB )
+					/* The priority change may have readied a task of higher
+					priority than the calling task. */
+					if( uxNewPriority > uxCurrentBasePriority )
 					{
-						/* The priority of a task other than the currently
-						running task is being raised.  Is the priority being
-						raised above that of the running task? */
-						if( uxNewPriority >= pxCurrentTCB->uxPriority )
+						if( pxTCB != pxCurrentTCB )
 						{
-							xYieldRequired = pdTRUE;
+							/* The priority of a task other than the currently
+							running task is being raised.  Is the priority being
+							raised above that of the running task? */
+							if( uxNewPriority >= pxCurrentTCB->uxPriority )
+							{
+								xYieldRequired = pdTRUE;
+							}
+							else
+							{
+								mtCOVERAGE_TEST_MARKER();
+							}
 						}
 						else
 						{
-							mtCOVERAGE_TEST_MARKER();
+							/* The priority of the running task is being raised,
+							but the running task must already be the highest
+							priority task able to run so no yield is required. */
 						}
 					}
+					else if( pxTCB == pxCurrentTCB )
+					{
+						/* Setting the priority of the running task down means
+						there may now be another task of higher priority that
+						is ready to execute. */
+						xYieldRequired = pdTRUE;
+					}
 					else
 					{
-						/* The priority of the running task is being raised,
-						but the running task must already be the highest
-						priority task able to run so no yield is required. */
+						/* Setting the priority of any other task down does not
+						require a yield as the running task must be above the
+						new priority of the task being modified. */
 					}
 				}
-				else if( pxTCB == pxCurrentTCB )
-				{
-					/* Setting the priority of the running task down means
-					there may now be another task of higher priority that
-					is ready to execute. */
-					xYieldRequired = pdTRUE;
-				}
-				else
-				{
-					/* Setting the priority of any other task down does not
-					require a yield as the running task must be above the
-					new priority of the task being modified. */
-				}
+				#endif /* configNUM_CORES */
 
 				/* Remember the ready list the task might be referenced from
 				before its uxPriority member is changed so the
@@ -1679,6 +1848,35 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 					mtCOVERAGE_TEST_MARKER();
 				}
 
+				#if( configNUM_CORES > 1 )
+				{
+					if( taskTASK_IS_RUNNING( pxTCB ) )
+					{
+						/* Setting the priority of a running task down means
+						there may now be another task of higher priority that
+						should run on its core instead.  Raising it needs no
+						yield. */
+						if( uxNewPriority < uxCurrentBasePriority )
+						{
+							xYieldRequired = prvYieldCore( pxTCB->xTaskRunState );
+						}
+						else
+						{
+							mtCOVERAGE_TEST_MARKER();
+						}
+					}
+					else if( uxNewPriority > uxCurrentBasePriority )
+					{
+						/* The task may now preempt one of the running tasks. */
+						xYieldRequired = taskYIELD_REQUIRED( pxTCB, pdTRUE );
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				#endif /* configNUM_CORES */
+
 				if( xYieldRequired != pdFALSE )
 				{
 					taskYIELD_IF_USING_PREEMPTION();
@@ -1699,6 +1897,92 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 #endif /* INCLUDE_vTaskPrioritySet */
 /*-----------------------------------------------------------*/
 
+#if( configNUM_CORES > 1 )
+
+	void vTaskCoreAffinitySet( const TaskHandle_t xTask, UBaseType_t uxCoreAffinityMask )
+	{
+	TCB_t *pxTCB;
+	BaseType_t xCoreID;
+
+		/* The task must be allowed on at least one core. */
+		configASSERT( ( uxCoreAffinityMask & ( ( ( UBaseType_t ) 1U << configNUM_CORES ) - 1U ) ) != 0U );
+
+		taskENTER_CRITICAL();
+		{
+			/* If null is passed in here then it is the affinity of the calling
+			task that is being changed. */
+			pxTCB = prvGetTCBFromHandle( xTask );
+			pxTCB->uxCoreAffinityMask = uxCoreAffinityMask;
+
+			if( taskTASK_IS_RUNNING( pxTCB ) )
+			{
+				/* The core the task is running on may no longer be allowed,
+				in which case it has to switch to another task whether or not
+				preemption is used. */
+				xCoreID = pxTCB->xTaskRunState;
+
+				if( ( uxCoreAffinityMask & ( ( UBaseType_t ) 1U << xCoreID ) ) == 0U )
+				{
+					if( prvYieldCore( xCoreID ) != pdFALSE )
+					{
+						portYIELD_WITHIN_API();
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else if( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxTCB->uxPriority ] ), &( pxTCB->xStateListItem ) ) != pdFALSE )
+			{
+				/* A ready task may now be allowed on a core running a task of
+				lower priority. */
+				if( taskYIELD_REQUIRED( pxTCB, pdFALSE ) != pdFALSE )
+				{
+					taskYIELD_IF_USING_PREEMPTION();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		taskEXIT_CRITICAL();
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	UBaseType_t uxTaskCoreAffinityGet( const TaskHandle_t xTask )
+	{
+	TCB_t const *pxTCB;
+	UBaseType_t uxReturn;
+
+		taskENTER_CRITICAL();
+		{
+			/* If null is passed in here then it is the affinity of the calling
+			task that is being queried. */
+			pxTCB = prvGetTCBFromHandle( xTask );
+			uxReturn = pxTCB->uxCoreAffinityMask;
+		}
+		taskEXIT_CRITICAL();
+
+		return uxReturn;
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( INCLUDE_vTaskSuspend == 1 )
 
 	void vTaskSuspend( TaskHandle_t xTaskToSuspend )
@@ -1746,6 +2030,20 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 				}
 			}
 			#endif
+
+			#if( configNUM_CORES > 1 )
+			{
+				/* A task running on another core is switched out there. */
+				if( taskTASK_IS_RUNNING( pxTCB ) && ( pxTCB->xTaskRunState != ( BaseType_t ) portGET_CORE_ID() ) )
+				{
+					( void ) prvYieldCore( pxTCB->xTaskRunState );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			#endif /* configNUM_CORES */
 		}
 		taskEXIT_CRITICAL();
 
@@ -1774,21 +2072,27 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 			}
 			else
 			{
-				/* The scheduler is not running, but the task that was pointed
-				to by pxCurrentTCB has just been suspended and pxCurrentTCB
-				must be adjusted to point to a different task. */
-				if( listCURRENT_LIST_LENGTH( &xSuspendedTaskList ) == uxCurrentNumberOfTasks ) /*lint !e931 Right has no side effect, just volatile. */
-				{
-					/* No other tasks are ready, so set pxCurrentTCB back to
-					NULL so when the next task is created pxCurrentTCB will
-					be set to point to it no matter what its relative priority
-					is. */
-					pxCurrentTCB = NULL;
-				}
-				else
+				/* With more than one core no task is current before the
+				scheduler has started, so this is a single core path. */
+				#if( configNUM_CORES == 1 )
 				{
-					vTaskSwitchContext();
+					/* The scheduler is not running, but the task that was pointed
+					to by pxCurrentTCB has just been suspended and pxCurrentTCB
+					must be adjusted to point to a different task. */
+					if( listCURRENT_LIST_LENGTH( &xSuspendedTaskList ) == uxCurrentNumberOfTasks ) /*lint !e931 Right has no side effect, just volatile. */
+					{
+						/* No other tasks are ready, so set pxCurrentTCB back to
+						NULL so when the next task is created pxCurrentTCB will
+						be set to point to it no matter what its relative priority
+						is. */
+						pxCurrentTCB = NULL;
+					}
+					else
+					{
+						vTaskSwitchContext();
+					}
 				}
+				#endif /* configNUM_CORES */
 			}
 		}
 		else
@@ -1871,7 +2175,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 					prvAddTaskToReadyList( pxTCB );
 
 					/* A higher priority task may have just been resumed. */
-					if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+					if( taskYIELD_REQUIRED( pxTCB, pdTRUE ) != pdFALSE )
 					{
 						/* This yield may not cause the task just resumed to run,
 						but will leave the lists in the correct state for the
@@ -1939,7 +2243,7 @@ static void prvAddNewTaskToReadyList( TCB_t *pxNewTCB )
 				{
 					/* Ready lists can be accessed so move the task from the
 					suspended list to the ready list directly. */
-					if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+					if( taskYIELD_REQUIRED( pxTCB, pdTRUE ) != pdFALSE )
 					{
 						xYieldRequired = pdTRUE;
 					}
@@ -2015,6 +2319,33 @@ BaseType_t xReturn;
 	}
 	#endif /* configSUPPORT_STATIC_ALLOCATION */
 
+	#if( configNUM_CORES > 1 )
+	{
+	BaseType_t xCoreID;
+
+		/* Each core needs a task it can always run.  The idle task created
+		above is the one of core 0 (the core starting the scheduler), the
+		other cores get their own, and each idle task is pinned to its core. */
+		for( xCoreID = 1; ( xCoreID < ( BaseType_t ) configNUM_CORES ) && ( xReturn == pdPASS ); xCoreID++ )
+		{
+			xReturn = xTaskCreate(	prvIdleTask,
+									configIDLE_TASK_NAME,
+									configMINIMAL_STACK_SIZE,
+									( void * ) NULL,
+									portPRIVILEGE_BIT,
+									&( xIdleTaskHandles[ xCoreID ] ) );
+		}
+
+		if( xReturn == pdPASS )
+		{
+			for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUM_CORES; xCoreID++ )
+			{
+				xIdleTaskHandles[ xCoreID ]->uxCoreAffinityMask = ( ( UBaseType_t ) 1U << xCoreID );
+			}
+		}
+	}
+	#endif /* configNUM_CORES */
+
 	#if ( configUSE_TIMERS == 1 )
 	{
 		if( xReturn == pdPASS )
@@ -2046,6 +2377,19 @@ BaseType_t xReturn;
 		starts to run. */
 		portDISABLE_INTERRUPTS();
 
+		#if( configNUM_CORES > 1 )
+		{
+		BaseType_t xCoreID;
+
+			/* Give each core its first task.  The other cores are not running
+			yet, they select again when they start. */
+			for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUM_CORES; xCoreID++ )
+			{
+				prvSelectHighestPriorityTask( xCoreID );
+			}
+		}
+		#endif /* configNUM_CORES */
+
 		#if ( configUSE_NEWLIB_REENTRANT == 1 )
 		{
 			/* Switch Newlib's _impure_ptr variable to point to the _reent
@@ -2118,9 +2462,36 @@ void vTaskSuspendAll( void )
 	do not otherwise exhibit real time behaviour. */
 	portSOFTWARE_BARRIER();
 
-	/* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
-	is used to allow calls to vTaskSuspendAll() to nest. */
-	++uxSchedulerSuspended;
+	#if( configNUM_CORES > 1 )
+	{
+		if( xSchedulerRunning != pdFALSE )
+		{
+		UBaseType_t uxSavedInterruptStatus;
+
+			/* The task lock is held until the matching xTaskResumeAll(), so
+			the other cores wait for it at their next critical section or
+			context switch.  Interrupts on the other cores still run, they
+			see uxSchedulerSuspended under the ISR lock and hold back as they
+			would on a single core. */
+			uxSavedInterruptStatus = uxPortDisableInterrupts();
+			portGET_TASK_LOCK();
+			portGET_ISR_LOCK();
+			++uxSchedulerSuspended;
+			portRELEASE_ISR_LOCK();
+			vPortRestoreInterrupts( uxSavedInterruptStatus );
+		}
+		else
+		{
+			++uxSchedulerSuspended;
+		}
+	}
+	#else /* configNUM_CORES */
+	{
+		/* The scheduler is suspended if uxSchedulerSuspended is non-zero.  An increment
+		is used to allow calls to vTaskSuspendAll() to nest. */
+		++uxSchedulerSuspended;
+	}
+	#endif /* configNUM_CORES */
 
 	/* Enforces ordering for ports and optimised compilers that may otherwise place
 	the above increment elsewhere. */
@@ -2134,6 +2505,7 @@ void vTaskSuspendAll( void )
 	{
 	TickType_t xReturn;
 	UBaseType_t uxHigherPriorityReadyTasks = pdFALSE;
+	BaseType_t xOtherCoresBusy = pdFALSE;
 
 		/* uxHigherPriorityReadyTasks takes care of the case where
 		configUSE_PREEMPTION is 0, so there may be tasks above the idle priority
@@ -2162,15 +2534,40 @@ void vTaskSuspendAll( void )
 		}
 		#endif
 
+		#if( configNUM_CORES > 1 )
+		{
+		BaseType_t xCoreID;
+
+			/* Only core 0 takes the tick interrupt, and it can only stop it
+			while the tasks of the other cores do not depend on it either. */
+			if( portGET_CORE_ID() != 0U )
+			{
+				xOtherCoresBusy = pdTRUE;
+			}
+
+			for( xCoreID = 1; xCoreID < ( BaseType_t ) configNUM_CORES; xCoreID++ )
+			{
+				if( pxCurrentTCBs[ xCoreID ] != xIdleTaskHandles[ xCoreID ] )
+				{
+					xOtherCoresBusy = pdTRUE;
+				}
+			}
+		}
+		#endif /* configNUM_CORES */
+
 		if( pxCurrentTCB->uxPriority > tskIDLE_PRIORITY )
 		{
 			xReturn = 0;
 		}
-		else if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > 1 )
+		else if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUM_CORES )
+		{
+			/* There are other idle priority tasks than the idle tasks in the
+			ready state.  If time slicing is used then the very next tick
+			interrupt must be processed. */
+			xReturn = 0;
+		}
+		else if( xOtherCoresBusy != pdFALSE )
 		{
-			/* There are other idle priority tasks in the ready state.  If
-			time slicing is used then the very next tick interrupt must be
-			processed. */
 			xReturn = 0;
 		}
 		else if( uxHigherPriorityReadyTasks != pdFALSE )
@@ -2209,6 +2606,17 @@ BaseType_t xAlreadyYielded = pdFALSE;
 	{
 		--uxSchedulerSuspended;
 
+		#if( configNUM_CORES > 1 )
+		{
+			/* Drop the hold vTaskSuspendAll() took on the task lock, the
+			critical section keeps its own. */
+			if( xSchedulerRunning != pdFALSE )
+			{
+				portRELEASE_TASK_LOCK();
+			}
+		}
+		#endif /* configNUM_CORES */
+
 		if( uxSchedulerSuspended == ( UBaseType_t ) pdFALSE )
 		{
 			if( uxCurrentNumberOfTasks > ( UBaseType_t ) 0U )
@@ -2224,7 +2632,7 @@ BaseType_t xAlreadyYielded = pdFALSE;
 
 					/* If the moved task has a priority higher than the current
 					task then a yield must be performed. */
-					if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+					if( taskYIELD_REQUIRED( pxTCB, pdTRUE ) != pdFALSE )
 					{
 						xYieldPending = pdTRUE;
 					}
@@ -2502,7 +2910,7 @@ TCB_t *pxTCB;
 
 #if ( configUSE_TRACE_FACILITY == 1 )
 
-	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, uint32_t * const pulTotalRunTime )
+	UBaseType_t uxTaskGetSystemState( TaskStatus_t * const pxTaskStatusArray, const UBaseType_t uxArraySize, configRUN_TIME_COUNTER_TYPE * const pulTotalRunTime )
 	{
 	UBaseType_t uxTask = 0, uxQueue = configMAX_PRIORITIES;
 
@@ -2678,7 +3086,7 @@ BaseType_t xYieldRequired = pdFALSE;
 					/* Preemption is on, but a context switch should only be
 					performed if the unblocked task has a priority that is
 					equal to or higher than the currently executing task. */
-					if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+					if( taskYIELD_REQUIRED( pxTCB, pdFALSE ) != pdFALSE )
 					{
 						/* Pend the yield to be performed when the scheduler
 						is unsuspended. */
@@ -2710,6 +3118,14 @@ TCB_t * pxTCB;
 TickType_t xItemValue;
 BaseType_t xSwitchRequired = pdFALSE;
 
+	#if( configNUM_CORES > 1 )
+		UBaseType_t uxSavedInterruptStatus;
+
+		/* The other cores access the same lists from their own tasks and
+		interrupts. */
+		uxSavedInterruptStatus = portSET_INTERRUPT_MASK_FROM_ISR();
+	#endif /* configNUM_CORES */
+
 	/* Called by the portable layer each time a tick interrupt occurs.
 	Increments the tick then checks to see if the new tick value will cause any
 	tasks to be unblocked. */
@@ -2801,7 +3217,7 @@ BaseType_t xSwitchRequired = pdFALSE;
 						only be performed if the unblocked task has a
 						priority that is equal to or higher than the
 						currently executing task. */
-						if( pxTCB->uxPriority >= pxCurrentTCB->uxPriority )
+						if( taskYIELD_REQUIRED( pxTCB, pdTRUE ) != pdFALSE )
 						{
 							xSwitchRequired = pdTRUE;
 						}
@@ -2818,7 +3234,41 @@ BaseType_t xSwitchRequired = pdFALSE;
 		/* Tasks of equal priority to the currently running task will share
 		processing time (time slice) if preemption is on, and the application
 		writer has not explicitly turned time slicing off. */
-		#if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
+		#if ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) && ( configNUM_CORES > 1 ) )
+		{
+		BaseType_t xCoreID, xOtherCoreID;
+		UBaseType_t uxPriority, uxRunning;
+
+			/* Only one core takes the tick, so it slices the others too.  A
+			core is sliced if its priority has more ready tasks than there
+			are cores running tasks of that priority. */
+			for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUM_CORES; xCoreID++ )
+			{
+				uxPriority = pxCurrentTCBs[ xCoreID ]->uxPriority;
+				uxRunning = 0U;
+
+				for( xOtherCoreID = 0; xOtherCoreID < ( BaseType_t ) configNUM_CORES; xOtherCoreID++ )
+				{
+					if( pxCurrentTCBs[ xOtherCoreID ]->uxPriority == uxPriority )
+					{
+						uxRunning++;
+					}
+				}
+
+				if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ uxPriority ] ) ) > uxRunning )
+				{
+					if( prvYieldCore( xCoreID ) != pdFALSE )
+					{
+						xSwitchRequired = pdTRUE;
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+		}
+		#elif ( ( configUSE_PREEMPTION == 1 ) && ( configUSE_TIME_SLICING == 1 ) )
 		{
 			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ pxCurrentTCB->uxPriority ] ) ) > ( UBaseType_t ) 1 )
 			{
@@ -2872,6 +3322,12 @@ BaseType_t xSwitchRequired = pdFALSE;
 		#endif
 	}
 
+	#if( configNUM_CORES > 1 )
+	{
+		portCLEAR_INTERRUPT_MASK_FROM_ISR( uxSavedInterruptStatus );
+	}
+	#endif /* configNUM_CORES */
+
 	return xSwitchRequired;
 }
 /*-----------------------------------------------------------*/
@@ -2988,6 +3444,16 @@ BaseType_t xSwitchRequired = pdFALSE;
 
 void vTaskSwitchContext( void )
 {
+	#if( configNUM_CORES > 1 )
+	{
+		/* Called with interrupts masked.  The locks keep the other cores out
+		of the lists while this core selects its next task.  If this core
+		has the scheduler suspended it already holds the task lock. */
+		portGET_TASK_LOCK();
+		portGET_ISR_LOCK();
+	}
+	#endif /* configNUM_CORES */
+
 	if( uxSchedulerSuspended != ( UBaseType_t ) pdFALSE )
 	{
 		/* The scheduler is currently suspended - do not allow a context
@@ -3058,6 +3524,13 @@ void vTaskSwitchContext( void )
 		}
 		#endif /* configUSE_NEWLIB_REENTRANT */
 	}
+
+	#if( configNUM_CORES > 1 )
+	{
+		portRELEASE_ISR_LOCK();
+		portRELEASE_TASK_LOCK();
+	}
+	#endif /* configNUM_CORES */
 }
 /*-----------------------------------------------------------*/
 
@@ -3183,7 +3656,7 @@ BaseType_t xReturn;
 		vListInsertEnd( &( xPendingReadyList ), &( pxUnblockedTCB->xEventListItem ) );
 	}
 
-	if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+	if( taskYIELD_REQUIRED( pxUnblockedTCB, pdFALSE ) != pdFALSE )
 	{
 		/* Return true if the task removed from the event list has a higher
 		priority than the calling task.  This allows the calling task to know if
@@ -3240,7 +3713,7 @@ TCB_t *pxUnblockedTCB;
 	( void ) uxListRemove( &( pxUnblockedTCB->xStateListItem ) );
 	prvAddTaskToReadyList( pxUnblockedTCB );
 
-	if( pxUnblockedTCB->uxPriority > pxCurrentTCB->uxPriority )
+	if( taskYIELD_REQUIRED( pxUnblockedTCB, pdFALSE ) != pdFALSE )
 	{
 		/* The unblocked task has a priority above that of the calling task, so
 		a context switch is required.  This function is called with the
@@ -3340,6 +3813,169 @@ void vTaskMissedYield( void )
 }
 /*-----------------------------------------------------------*/
 
+#if( configNUM_CORES > 1 )
+
+	void vTaskYieldWithinAPI( void )
+	{
+		if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+		{
+			portYIELD();
+		}
+		else
+		{
+			/* The core must not switch tasks while it holds the scheduler
+			locks, vTaskExitCritical() yields once they are released. */
+			xYieldPending = pdTRUE;
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	static BaseType_t prvYieldCore( BaseType_t xCoreID )
+	{
+	BaseType_t xReturn;
+
+		if( xCoreID == ( BaseType_t ) portGET_CORE_ID() )
+		{
+			xReturn = pdTRUE;
+		}
+		else
+		{
+			/* Marks the core as about to reschedule, so prvYieldForTask()
+			looks for another core for the next task made ready. */
+			xYieldPendings[ xCoreID ] = pdTRUE;
+			portYIELD_CORE( ( UBaseType_t ) xCoreID );
+			xReturn = pdFALSE;
+		}
+
+		return xReturn;
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	static BaseType_t prvYieldForTask( const TCB_t * const pxTCB, const BaseType_t xYieldEqualPriority )
+	{
+	BaseType_t xCoreID, xLowestCoreID = -1;
+	const BaseType_t xThisCoreID = ( BaseType_t ) portGET_CORE_ID();
+	UBaseType_t uxCorePriority, uxLowestPriority = 0U, uxThreshold;
+	BaseType_t xReturn = pdFALSE;
+
+		/* A core is preempted if the priority of its task is below
+		uxThreshold. */
+		uxThreshold = pxTCB->uxPriority;
+		if( xYieldEqualPriority != pdFALSE )
+		{
+			uxThreshold++;
+		}
+
+		if( ( xSchedulerRunning != pdFALSE ) && ( taskTASK_IS_RUNNING( pxTCB ) == pdFALSE ) )
+		{
+			for( xCoreID = 0; xCoreID < ( BaseType_t ) configNUM_CORES; xCoreID++ )
+			{
+				/* Skip the cores the task may not run on, and the other cores
+				that are already rescheduling as they pick the highest priority
+				task anyway.  A further yield request of this core does no
+				harm. */
+				if( ( ( pxTCB->uxCoreAffinityMask & ( ( UBaseType_t ) 1U << xCoreID ) ) != 0U ) &&
+					( ( xYieldPendings[ xCoreID ] == pdFALSE ) || ( xCoreID == xThisCoreID ) ) )
+				{
+					uxCorePriority = pxCurrentTCBs[ xCoreID ]->uxPriority;
+
+					if( uxCorePriority < uxThreshold )
+					{
+						if( ( xLowestCoreID < 0 ) ||
+							( uxCorePriority < uxLowestPriority ) ||
+							( ( uxCorePriority == uxLowestPriority ) && ( xCoreID == xThisCoreID ) ) )
+						{
+							xLowestCoreID = xCoreID;
+							uxLowestPriority = uxCorePriority;
+						}
+					}
+				}
+			}
+
+			if( xLowestCoreID >= 0 )
+			{
+				xReturn = prvYieldCore( xLowestCoreID );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+
+		return xReturn;
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	static void prvSelectHighestPriorityTask( const BaseType_t xCoreID )
+	{
+	TCB_t *pxTCB = NULL, *pxCandidate;
+	TCB_t * const pxPreviousTCB = pxCurrentTCBs[ xCoreID ];
+	UBaseType_t uxPriority = ( UBaseType_t ) configMAX_PRIORITIES;
+	UBaseType_t uxEntries;
+	List_t *pxList;
+
+		/* The outgoing task can be selected again, by this core or another. */
+		if( pxPreviousTCB != NULL )
+		{
+			pxPreviousTCB->xTaskRunState = taskTASK_NOT_RUNNING;
+		}
+
+		/* The idle task of the core is always a candidate, so this finds a
+		task. */
+		while( pxTCB == NULL )
+		{
+			configASSERT( uxPriority > 0U );
+			uxPriority--;
+			pxList = &( pxReadyTasksLists[ uxPriority ] );
+
+			/* listGET_OWNER_OF_NEXT_ENTRY() continues from the task last
+			selected at this priority, so tasks of equal priority still take
+			turns.  A full lap leaves the index where it was. */
+			for( uxEntries = listCURRENT_LIST_LENGTH( pxList ); uxEntries > 0U; uxEntries-- )
+			{
+				listGET_OWNER_OF_NEXT_ENTRY( pxCandidate, pxList ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
+
+				if( ( pxCandidate->xTaskRunState == taskTASK_NOT_RUNNING ) &&
+					( ( pxCandidate->uxCoreAffinityMask & ( ( UBaseType_t ) 1U << xCoreID ) ) != 0U ) )
+				{
+					pxTCB = pxCandidate;
+					break;
+				}
+			}
+		}
+
+		pxTCB->xTaskRunState = xCoreID;
+		pxCurrentTCBs[ xCoreID ] = pxTCB;
+
+		/* An outgoing task that is still ready was preempted by a task only
+		allowed on this core, or its own affinity no longer allows this core.
+		Another core running a task of lower priority has to take it. */
+		if( ( pxPreviousTCB != NULL ) && ( pxPreviousTCB != pxTCB ) &&
+			( listIS_CONTAINED_WITHIN( &( pxReadyTasksLists[ pxPreviousTCB->uxPriority ] ), &( pxPreviousTCB->xStateListItem ) ) != pdFALSE ) )
+		{
+			( void ) prvYieldForTask( pxPreviousTCB, pdFALSE );
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( configUSE_TRACE_FACILITY == 1 )
 
 	UBaseType_t uxTaskGetTaskNumber( TaskHandle_t xTask )
@@ -3427,9 +4063,10 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 
 			A critical region is not required here as we are just reading from
 			the list, and an occasional incorrect value will not matter.  If
-			the ready list at the idle priority contains more than one task
-			then a task other than the idle task is ready to execute. */
-			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) 1 )
+			the ready list at the idle priority contains more tasks than there
+			are idle tasks (one per core) then a task other than an idle task
+			is ready to execute. */
+			if( listCURRENT_LIST_LENGTH( &( pxReadyTasksLists[ tskIDLE_PRIORITY ] ) ) > ( UBaseType_t ) configNUM_CORES )
 			{
 				taskYIELD();
 			}
@@ -3510,8 +4147,8 @@ static portTASK_FUNCTION( prvIdleTask, pvParameters )
 
 	eSleepModeStatus eTaskConfirmSleepModeStatus( void )
 	{
-	/* The idle task exists in addition to the application tasks. */
-	const UBaseType_t uxNonApplicationTasks = 1;
+	/* The idle tasks exist in addition to the application tasks. */
+	const UBaseType_t uxNonApplicationTasks = configNUM_CORES;
 	eSleepModeStatus eReturn = eStandardSleep;
 
 		/* This function must be called from a critical section. */
@@ -3613,8 +4250,18 @@ UBaseType_t uxPriority;
 		vListInitialise( &( pxReadyTasksLists[ uxPriority ] ) );
 	}
 
-	vListInitialise( &xDelayedTaskList1 );
-	vListInitialise( &xDelayedTaskList2 );
+	#if( configUSE_INDEXED_LISTS == 1 )
+	{
+		/* Every delay inserts into these lists inside a critical section. */
+		vListInitialiseIndexed( &xDelayedTaskList1 );
+		vListInitialiseIndexed( &xDelayedTaskList2 );
+	}
+	#else
+	{
+		vListInitialise( &xDelayedTaskList1 );
+		vListInitialise( &xDelayedTaskList2 );
+	}
+	#endif /* configUSE_INDEXED_LISTS */
 	vListInitialise( &xPendingReadyList );
 
 	#if ( INCLUDE_vTaskDelete == 1 )
@@ -3652,12 +4299,30 @@ static void prvCheckTasksWaitingTermination( void )
 			taskENTER_CRITICAL();
 			{
 				pxTCB = listGET_OWNER_OF_HEAD_ENTRY( ( &xTasksWaitingTermination ) ); /*lint !e9079 void * is used as this macro is used with timers and co-routines too.  Alignment is known to be fine as the type of the pointer stored and retrieved is the same. */
-				( void ) uxListRemove( &( pxTCB->xStateListItem ) );
-				--uxCurrentNumberOfTasks;
-				--uxDeletedTasksWaitingCleanUp;
+
+				#if( configNUM_CORES > 1 )
+				if( taskTASK_IS_RUNNING( pxTCB ) )
+				{
+					/* Deleted by another task while running on another core,
+					which has not switched away from it yet. */
+					pxTCB = NULL;
+				}
+				else
+				#endif /* configNUM_CORES */
+				{
+					( void ) uxListRemove( &( pxTCB->xStateListItem ) );
+					--uxCurrentNumberOfTasks;
+					--uxDeletedTasksWaitingCleanUp;
+				}
 			}
 			taskEXIT_CRITICAL();
 
+			if( pxTCB == NULL )
+			{
+				/* Try again on the next iteration of the idle task. */
+				break;
+			}
+
 			prvDeleteTCB( pxTCB );
 		}
 	}
@@ -3705,7 +4370,7 @@ static void prvCheckTasksWaitingTermination( void )
 		state is just set to whatever is passed in. */
 		if( eState != eInvalid )
 		{
-			if( pxTCB == pxCurrentTCB )
+			if( taskTASK_IS_RUNNING( pxTCB ) )
 			{
 				pxTaskStatus->eCurrentState = eRunning;
 			}
@@ -3964,21 +4629,35 @@ TCB_t *pxTCB;
 }
 /*-----------------------------------------------------------*/
 
-#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) )
+#if ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUM_CORES > 1 ) || ( configUSE_TIMER_DIRECT_COMMANDS == 1 ) )
 
 	TaskHandle_t xTaskGetCurrentTaskHandle( void )
 	{
 	TaskHandle_t xReturn;
 
-		/* A critical section is not required as this is not called from
-		an interrupt and the current TCB will always be the same for any
-		individual execution thread. */
-		xReturn = pxCurrentTCB;
+		#if( configNUM_CORES > 1 )
+		{
+		UBaseType_t uxSavedInterruptStatus;
+
+			/* The calling task must not move to another core between reading
+			the core number and reading the entry of that core. */
+			uxSavedInterruptStatus = uxPortDisableInterrupts();
+			xReturn = pxCurrentTCBs[ portGET_CORE_ID() ];
+			vPortRestoreInterrupts( uxSavedInterruptStatus );
+		}
+		#else
+		{
+			/* A critical section is not required as this is not called from
+			an interrupt and the current TCB will always be the same for any
+			individual execution thread. */
+			xReturn = pxCurrentTCB;
+		}
+		#endif /* configNUM_CORES */
 
 		return xReturn;
 	}
 
-#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) ) */
+#endif /* ( ( INCLUDE_xTaskGetCurrentTaskHandle == 1 ) || ( configUSE_MUTEXES == 1 ) || ( configNUM_CORES > 1 ) || ( configUSE_TIMER_DIRECT_COMMANDS == 1 ) ) */
 /*-----------------------------------------------------------*/
 
 #if ( ( INCLUDE_xTaskGetSchedulerState == 1 ) || ( configUSE_TIMERS == 1 ) )
@@ -4347,6 +5026,160 @@ TCB_t *pxTCB;
 #endif /* portCRITICAL_NESTING_IN_TCB */
 /*-----------------------------------------------------------*/
 
+#if( configNUM_CORES > 1 )
+
+	void vTaskEnterCritical( void )
+	{
+		portDISABLE_INTERRUPTS();
+
+		if( xSchedulerRunning != pdFALSE )
+		{
+			/* The outermost critical section of the core takes both locks,
+			keeping the other cores out of the kernel and out of the interrupt
+			safe API. */
+			if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+			{
+				traceCRITICAL_ENTER();
+				portGET_TASK_LOCK();
+				portGET_ISR_LOCK();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			portINCREMENT_CRITICAL_NESTING_COUNT();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	void vTaskExitCritical( void )
+	{
+		if( xSchedulerRunning != pdFALSE )
+		{
+			if( portGET_CRITICAL_NESTING_COUNT() > 0U )
+			{
+				portDECREMENT_CRITICAL_NESTING_COUNT();
+
+				if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+				{
+				BaseType_t xYieldCurrentTask;
+
+					/* Yields requested inside the critical section were held
+					back until the locks are released. */
+					xYieldCurrentTask = xYieldPending;
+
+					portRELEASE_ISR_LOCK();
+					portRELEASE_TASK_LOCK();
+					traceCRITICAL_EXIT();
+					portENABLE_INTERRUPTS();
+
+					if( xYieldCurrentTask != pdFALSE )
+					{
+						portYIELD();
+					}
+					else
+					{
+						mtCOVERAGE_TEST_MARKER();
+					}
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	UBaseType_t uxTaskEnterCriticalFromISR( void )
+	{
+	UBaseType_t uxSavedInterruptStatus = 0U;
+
+		if( xSchedulerRunning != pdFALSE )
+		{
+			uxSavedInterruptStatus = uxPortDisableInterrupts();
+
+			/* Only the ISR lock, as the interrupt safe API does not use the
+			data the task lock guards.  A task critical section on this core
+			already holds it, and cannot be interrupted anyway. */
+			if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+			{
+				portGET_ISR_LOCK();
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+
+			portINCREMENT_CRITICAL_NESTING_COUNT();
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+
+		return uxSavedInterruptStatus;
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
+#if( configNUM_CORES > 1 )
+
+	void vTaskExitCriticalFromISR( UBaseType_t uxSavedInterruptStatus )
+	{
+		if( xSchedulerRunning != pdFALSE )
+		{
+			if( portGET_CRITICAL_NESTING_COUNT() > 0U )
+			{
+				portDECREMENT_CRITICAL_NESTING_COUNT();
+
+				if( portGET_CRITICAL_NESTING_COUNT() == 0U )
+				{
+					portRELEASE_ISR_LOCK();
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+
+				vPortRestoreInterrupts( uxSavedInterruptStatus );
+			}
+			else
+			{
+				mtCOVERAGE_TEST_MARKER();
+			}
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+
+#endif /* configNUM_CORES */
+/*-----------------------------------------------------------*/
+
 #if ( ( configUSE_TRACE_FACILITY == 1 ) && ( configUSE_STATS_FORMATTING_FUNCTIONS > 0 ) )
 
 	static char *prvWriteNameToBuffer( char *pcBuffer, const char *pcTaskName )
@@ -4478,7 +5311,7 @@ TCB_t *pxTCB;
 	{
 	TaskStatus_t *pxTaskStatusArray;
 	UBaseType_t uxArraySize, x;
-	uint32_t ulTotalTime, ulStatsAsPercentage;
+	configRUN_TIME_COUNTER_TYPE ulTotalTime, ulStatsAsPercentage;
 
 		#if( configUSE_TRACE_FACILITY != 1 )
 		{
@@ -4551,7 +5384,7 @@ TCB_t *pxTCB;
 					{
 						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
 						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter, ulStatsAsPercentage );
+							sprintf( pcWriteBuffer, "\t%lu\t\t%lu%%\r\n", ( unsigned long ) pxTaskStatusArray[ x ].ulRunTimeCounter, ( unsigned long ) ulStatsAsPercentage );
 						}
 						#else
 						{
@@ -4567,7 +5400,7 @@ TCB_t *pxTCB;
 						consumed less than 1% of the total run time. */
 						#ifdef portLU_PRINTF_SPECIFIER_REQUIRED
 						{
-							sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", pxTaskStatusArray[ x ].ulRunTimeCounter );
+							sprintf( pcWriteBuffer, "\t%lu\t\t<1%%\r\n", ( unsigned long ) pxTaskStatusArray[ x ].ulRunTimeCounter );
 						}
 						#else
 						{
@@ -4868,7 +5701,7 @@ TickType_t uxReturn;
 				}
 				#endif
 
-				if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+				if( taskYIELD_REQUIRED( pxTCB, pdFALSE ) != pdFALSE )
 				{
 					/* The notified task has a priority above the currently
 					executing task so a yield is required. */
@@ -4993,7 +5826,7 @@ TickType_t uxReturn;
 					vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
 				}
 
-				if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+				if( taskYIELD_REQUIRED( pxTCB, pdFALSE ) != pdFALSE )
 				{
 					/* The notified task has a priority above the currently
 					executing task so a yield is required. */
@@ -5081,7 +5914,7 @@ TickType_t uxReturn;
 					vListInsertEnd( &( xPendingReadyList ), &( pxTCB->xEventListItem ) );
 				}
 
-				if( pxTCB->uxPriority > pxCurrentTCB->uxPriority )
+				if( taskYIELD_REQUIRED( pxTCB, pdFALSE ) != pdFALSE )
 				{
 					/* The notified task has a priority above the currently
 					executing task so a yield is required. */
@@ -5166,7 +5999,7 @@ TickType_t uxReturn;
 
 #if( ( configGENERATE_RUN_TIME_STATS == 1 ) && ( INCLUDE_xTaskGetIdleTaskHandle == 1 ) )
 
-	uint32_t ulTaskGetIdleRunTimeCounter( void )
+	configRUN_TIME_COUNTER_TYPE ulTaskGetIdleRunTimeCounter( void )
 	{
 		return xIdleTaskHandle->ulRunTimeCounter;
 	}
@@ -141,6 +141,13 @@ PRIVILEGED_DATA static List_t *pxOverflowTimerList;
 PRIVILEGED_DATA static QueueHandle_t xTimerQueue = NULL;
 PRIVILEGED_DATA static TaskHandle_t xTimerTaskHandle = NULL;
 
+#if( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+	/* Set while prvSwitchTimerLists() calls the callbacks of the timers left
+	in the old list.  Commands issued from those callbacks are queued, as they
+	would otherwise be inserted before the lists are switched. */
+	PRIVILEGED_DATA static BaseType_t xSwitchingTimerLists = pdFALSE;
+#endif
+
 /*lint -restore */
 
 /*-----------------------------------------------------------*/
@@ -174,6 +181,12 @@ static portTASK_FUNCTION_PROTO( prvTimerTask, pvParameters ) PRIVILEGED_FUNCTION
  */
 static void prvProcessReceivedCommands( void ) PRIVILEGED_FUNCTION;
 
+/*
+ * Carry out one timer command, either received on the timer queue or, with
+ * configUSE_TIMER_DIRECT_COMMANDS, issued by the timer service task itself.
+ */
+static void prvProcessTimerCommand( Timer_t * const pxTimer, const BaseType_t xCommandID, const TickType_t xMessageValue ) PRIVILEGED_FUNCTION;
+
 /*
  * Insert the timer into either xActiveTimerList1, or xActiveTimerList2,
  * depending on if the expire time causes a timer counter overflow.
@@ -385,6 +398,34 @@ DaemonTaskMessage_t xMessage;
 
 	configASSERT( xTimer );
 
+	#if( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+	{
+		/* Only the timer service task accesses the active timer lists once
+		the scheduler has started, so start, reset, stop and change period
+		commands issued by the timer service task itself (from a timer
+		callback or a pended function), or before the scheduler starts, are
+		carried out here instead of going through the timer queue.  They take
+		effect ahead of any commands other tasks still have queued.  Deleting
+		is always queued, as the callback of the deleted timer may still be
+		running, and so is tmrCOMMAND_START_DONT_TRACE, which the timer
+		service task uses when it cannot insert a timer yet. */
+		if( ( xTimerQueue != NULL ) &&
+			( xCommandID > tmrCOMMAND_START_DONT_TRACE ) &&
+			( xCommandID < tmrCOMMAND_DELETE ) &&
+			( xSwitchingTimerLists == pdFALSE ) &&
+			( ( xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED ) || ( xTaskGetCurrentTaskHandle() == xTimerTaskHandle ) ) )
+		{
+			traceTIMER_COMMAND_SEND( xTimer, xCommandID, xOptionalValue, pdPASS );
+			prvProcessTimerCommand( xTimer, xCommandID, xOptionalValue );
+			return pdPASS;
+		}
+		else
+		{
+			mtCOVERAGE_TEST_MARKER();
+		}
+	}
+	#endif /* configUSE_TIMER_DIRECT_COMMANDS */
+
 	/* Send a message to the timer service task to perform a particular action
 	on a particular timer definition. */
 	if( xTimerQueue != NULL )
@@ -733,148 +774,165 @@ BaseType_t xProcessTimerNow = pdFALSE;
 
 static void	prvProcessReceivedCommands( void )
 {
-DaemonTaskMessage_t xMessage;
-Timer_t *pxTimer;
-BaseType_t xTimerListsWereSwitched, xResult;
-TickType_t xTimeNow;
-
-	while( xQueueReceive( xTimerQueue, &xMessage, tmrNO_DELAY ) != pdFAIL ) /*lint !e603 xMessage does not have to be initialised as it is passed out, not in, and it is not used unless xQueueReceive() returns pdTRUE. */
+DaemonTaskMessage_t xMessages[ configTIMER_COMMAND_BATCH_LENGTH ];
+DaemonTaskMessage_t *pxMessage;
+BaseType_t xReceived, xIndex;
+
+	/* Up to configTIMER_COMMAND_BATCH_LENGTH commands are taken from the queue
+	under one critical section, and the tasks that were waiting for space in
+	the queue are unblocked at once. */
+	while( ( xReceived = xQueueReceiveMultiple( xTimerQueue, xMessages, ( UBaseType_t ) configTIMER_COMMAND_BATCH_LENGTH, tmrNO_DELAY ) ) > 0 )
 	{
-		#if ( INCLUDE_xTimerPendFunctionCall == 1 )
+		for( xIndex = 0; xIndex < xReceived; xIndex++ )
 		{
-			/* Negative commands are pended function calls rather than timer
-			commands. */
-			if( xMessage.xMessageID < ( BaseType_t ) 0 )
+			pxMessage = &( xMessages[ xIndex ] );
+
+			#if ( INCLUDE_xTimerPendFunctionCall == 1 )
 			{
-				const CallbackParameters_t * const pxCallback = &( xMessage.u.xCallbackParameters );
+				/* Negative commands are pended function calls rather than timer
+				commands. */
+				if( pxMessage->xMessageID < ( BaseType_t ) 0 )
+				{
+					const CallbackParameters_t * const pxCallback = &( pxMessage->u.xCallbackParameters );
+
+					/* The timer uses the xCallbackParameters member to request a
+					callback be executed.  Check the callback is not NULL. */
+					configASSERT( pxCallback );
 
-				/* The timer uses the xCallbackParameters member to request a
-				callback be executed.  Check the callback is not NULL. */
-				configASSERT( pxCallback );
+					/* Call the function. */
+					pxCallback->pxCallbackFunction( pxCallback->pvParameter1, pxCallback->ulParameter2 );
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
+			}
+			#endif /* INCLUDE_xTimerPendFunctionCall */
 
-				/* Call the function. */
-				pxCallback->pxCallbackFunction( pxCallback->pvParameter1, pxCallback->ulParameter2 );
+			/* Commands that are positive are timer commands rather than pended
+			function calls.  The messages uses the xTimerParameters member to
+			work on a software timer. */
+			if( pxMessage->xMessageID >= ( BaseType_t ) 0 )
+			{
+				prvProcessTimerCommand( pxMessage->u.xTimerParameters.pxTimer, pxMessage->xMessageID, pxMessage->u.xTimerParameters.xMessageValue );
 			}
 			else
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
 		}
-		#endif /* INCLUDE_xTimerPendFunctionCall */
+	}
+}
+/*-----------------------------------------------------------*/
 
-		/* Commands that are positive are timer commands rather than pended
-		function calls. */
-		if( xMessage.xMessageID >= ( BaseType_t ) 0 )
-		{
-			/* The messages uses the xTimerParameters member to work on a
-			software timer. */
-			pxTimer = xMessage.u.xTimerParameters.pxTimer;
+static void prvProcessTimerCommand( Timer_t * const pxTimer, const BaseType_t xCommandID, const TickType_t xMessageValue )
+{
+BaseType_t xTimerListsWereSwitched, xResult;
+TickType_t xTimeNow;
+
+	if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
+	{
+		/* The timer is in a list, remove it. */
+		( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+	}
+	else
+	{
+		mtCOVERAGE_TEST_MARKER();
+	}
+
+	traceTIMER_COMMAND_RECEIVED( pxTimer, xCommandID, xMessageValue );
 
-			if( listIS_CONTAINED_WITHIN( NULL, &( pxTimer->xTimerListItem ) ) == pdFALSE ) /*lint !e961. The cast is only redundant when NULL is passed into the macro. */
+	/* In this case the xTimerListsWereSwitched parameter is not used, but
+	it must be present in the function call.  prvSampleTimeNow() must be
+	called after the message is received from xTimerQueue so there is no
+	possibility of a higher priority task adding a message to the message
+	queue with a time that is ahead of the timer daemon task (because it
+	pre-empted the timer daemon task after the xTimeNow value was set). */
+	xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
+
+	switch( xCommandID )
+	{
+		case tmrCOMMAND_START :
+		case tmrCOMMAND_START_FROM_ISR :
+		case tmrCOMMAND_RESET :
+		case tmrCOMMAND_RESET_FROM_ISR :
+		case tmrCOMMAND_START_DONT_TRACE :
+			/* Start or restart a timer. */
+			pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+			if( prvInsertTimerInActiveList( pxTimer,  xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessageValue ) != pdFALSE )
 			{
-				/* The timer is in a list, remove it. */
-				( void ) uxListRemove( &( pxTimer->xTimerListItem ) );
+				/* The timer expired before it was added to the active
+				timer list.  Process it now. */
+				pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
+				traceTIMER_EXPIRED( pxTimer );
+
+				if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
+				{
+					xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xMessageValue + pxTimer->xTimerPeriodInTicks, NULL, tmrNO_DELAY );
+					configASSERT( xResult );
+					( void ) xResult;
+				}
+				else
+				{
+					mtCOVERAGE_TEST_MARKER();
+				}
 			}
 			else
 			{
 				mtCOVERAGE_TEST_MARKER();
 			}
-
-			traceTIMER_COMMAND_RECEIVED( pxTimer, xMessage.xMessageID, xMessage.u.xTimerParameters.xMessageValue );
-
-			/* In this case the xTimerListsWereSwitched parameter is not used, but
-			it must be present in the function call.  prvSampleTimeNow() must be
-			called after the message is received from xTimerQueue so there is no
-			possibility of a higher priority task adding a message to the message
-			queue with a time that is ahead of the timer daemon task (because it
-			pre-empted the timer daemon task after the xTimeNow value was set). */
-			xTimeNow = prvSampleTimeNow( &xTimerListsWereSwitched );
-
-			switch( xMessage.xMessageID )
+			break;
+
+		case tmrCOMMAND_STOP :
+		case tmrCOMMAND_STOP_FROM_ISR :
+			/* The timer has already been removed from the active list. */
+			pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+			break;
+
+		case tmrCOMMAND_CHANGE_PERIOD :
+		case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR :
+			pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
+			pxTimer->xTimerPeriodInTicks = xMessageValue;
+			configASSERT( ( pxTimer->xTimerPeriodInTicks > 0 ) );
+
+			/* The new period does not really have a reference, and can
+			be longer or shorter than the old one.  The command time is
+			therefore set to the current time, and as the period cannot
+			be zero the next expiry time can only be in the future,
+			meaning (unlike for the xTimerStart() case above) there is
+			no fail case that needs to be handled here. */
+			( void ) prvInsertTimerInActiveList( pxTimer, ( xTimeNow + pxTimer->xTimerPeriodInTicks ), xTimeNow, xTimeNow );
+			break;
+
+		case tmrCOMMAND_DELETE :
+			#if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
 			{
-				case tmrCOMMAND_START :
-				case tmrCOMMAND_START_FROM_ISR :
-				case tmrCOMMAND_RESET :
-				case tmrCOMMAND_RESET_FROM_ISR :
-				case tmrCOMMAND_START_DONT_TRACE :
-					/* Start or restart a timer. */
-					pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
-					if( prvInsertTimerInActiveList( pxTimer,  xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, xTimeNow, xMessage.u.xTimerParameters.xMessageValue ) != pdFALSE )
-					{
-						/* The timer expired before it was added to the active
-						timer list.  Process it now. */
-						pxTimer->pxCallbackFunction( ( TimerHandle_t ) pxTimer );
-						traceTIMER_EXPIRED( pxTimer );
-
-						if( ( pxTimer->ucStatus & tmrSTATUS_IS_AUTORELOAD ) != 0 )
-						{
-							xResult = xTimerGenericCommand( pxTimer, tmrCOMMAND_START_DONT_TRACE, xMessage.u.xTimerParameters.xMessageValue + pxTimer->xTimerPeriodInTicks, NULL, tmrNO_DELAY );
-							configASSERT( xResult );
-							( void ) xResult;
-						}
-						else
-						{
-							mtCOVERAGE_TEST_MARKER();
-						}
-					}
-					else
-					{
-						mtCOVERAGE_TEST_MARKER();
-					}
-					break;
-
-				case tmrCOMMAND_STOP :
-				case tmrCOMMAND_STOP_FROM_ISR :
-					/* The timer has already been removed from the active list. */
+				/* The timer has already been removed from the active list,
+				just free up the memory if the memory was dynamically
+				allocated. */
+				if( ( pxTimer->ucStatus & tmrSTATUS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) 0 )
+				{
+					vPortFree( pxTimer );
+				}
+				else
+				{
 					pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
-					break;
-
-				case tmrCOMMAND_CHANGE_PERIOD :
-				case tmrCOMMAND_CHANGE_PERIOD_FROM_ISR :
-					pxTimer->ucStatus |= tmrSTATUS_IS_ACTIVE;
-					pxTimer->xTimerPeriodInTicks = xMessage.u.xTimerParameters.xMessageValue;
-					configASSERT( ( pxTimer->xTimerPeriodInTicks > 0 ) );
-
-					/* The new period does not really have a reference, and can
-					be longer or shorter than the old one.  The command time is
-					therefore set to the current time, and as the period cannot
-					be zero the next expiry time can only be in the future,
-					meaning (unlike for the xTimerStart() case above) there is
-					no fail case that needs to be handled here. */
-					( void ) prvInsertTimerInActiveList( pxTimer, ( xTimeNow + pxTimer->xTimerPeriodInTicks ), xTimeNow, xTimeNow );
-					break;
-
-				case tmrCOMMAND_DELETE :
-					#if ( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
-					{
-						/* The timer has already been removed from the active list,
-						just free up the memory if the memory was dynamically
-						allocated. */
-						if( ( pxTimer->ucStatus & tmrSTATUS_IS_STATICALLY_ALLOCATED ) == ( uint8_t ) 0 )
-						{
-							vPortFree( pxTimer );
-						}
-						else
-						{
-							pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
-						}
-					}
-					#else
-					{
-						/* If dynamic allocation is not enabled, the memory
-						could not have been dynamically allocated. So there is
-						no need to free the memory - just mark the timer as
-						"not active". */
-						pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
-					}
-					#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
-					break;
-
-				default	:
-					/* Don't expect to get here. */
-					break;
+				}
 			}
-		}
+			#else
+			{
+				/* If dynamic allocation is not enabled, the memory
+				could not have been dynamically allocated. So there is
+				no need to free the memory - just mark the timer as
+				"not active". */
+				pxTimer->ucStatus &= ~tmrSTATUS_IS_ACTIVE;
+			}
+			#endif /* configSUPPORT_DYNAMIC_ALLOCATION */
+			break;
+
+		default	:
+			/* Don't expect to get here. */
+			break;
 	}
 }
 /*-----------------------------------------------------------*/
@@ -890,6 +948,12 @@ BaseType_t xResult;
 	If there are any timers still referenced from the current timer list
 	then they must have expired and should be processed before the lists
 	are switched. */
+	#if( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+	{
+		xSwitchingTimerLists = pdTRUE;
+	}
+	#endif
+
 	while( listLIST_IS_EMPTY( pxCurrentTimerList ) == pdFALSE )
 	{
 		xNextExpireTime = listGET_ITEM_VALUE_OF_HEAD_ENTRY( pxCurrentTimerList );
@@ -935,6 +999,12 @@ BaseType_t xResult;
 	pxTemp = pxCurrentTimerList;
 	pxCurrentTimerList = pxOverflowTimerList;
 	pxOverflowTimerList = pxTemp;
+
+	#if( configUSE_TIMER_DIRECT_COMMANDS == 1 )
+	{
+		xSwitchingTimerLists = pdFALSE;
+	}
+	#endif
 }
 /*-----------------------------------------------------------*/
 
@@ -947,8 +1017,17 @@ static void prvCheckForValidListAndQueue( void )
 	{
 		if( xTimerQueue == NULL )
 		{
-			vListInitialise( &xActiveTimerList1 );
-			vListInitialise( &xActiveTimerList2 );
+			#if( configUSE_INDEXED_LISTS == 1 )
+			{
+				vListInitialiseIndexed( &xActiveTimerList1 );
+				vListInitialiseIndexed( &xActiveTimerList2 );
+			}
+			#else
+			{
+				vListInitialise( &xActiveTimerList1 );
+				vListInitialise( &xActiveTimerList2 );
+			}
+			#endif /* configUSE_INDEXED_LISTS */
 			pxCurrentTimerList = &xActiveTimerList1;
 			pxOverflowTimerList = &xActiveTimerList2;
 